@@ -23,7 +23,6 @@ static CPointQuadTree			*g_covers = 0;
 typedef xr_vector<CCoverPoint*>	COVERS;
 
 // -------------------------------- Ray pick
-typedef Fvector	RayCache[3];
 
 /*
 IC bool RayPick(CDB::COLLIDER* DB, Fvector& P, Fvector& D, float r, RayCache& C)
@@ -52,9 +51,9 @@ IC bool RayPick(CDB::COLLIDER* DB, Fvector& P, Fvector& D, float r, RayCache& C)
 }
 */
 
-IC float getLastRP_Scale(CDB::COLLIDER* DB, RayCache& C)
+// the hits of one ray, an opaque one is cached as the first occluder to try next time
+IC float getLastRP_Scale(CDB::RESULT* hits, u32 tris_count, u32& C)
 {
-	u32	tris_count		= DB->r_count();
 	float	scale		= 1.f;
 	Fvector B;
 
@@ -62,7 +61,7 @@ IC float getLastRP_Scale(CDB::COLLIDER* DB, RayCache& C)
 	{
 		for (u32 I=0; I<tris_count; I++)
 		{
-			CDB::RESULT& rpinf = DB->r_begin()[I];
+			CDB::RESULT& rpinf = hits[I];
 			// Access to texture
 //			CDB::TRI& clT								= 
 				Level.get_tris()	[rpinf.id];
@@ -80,9 +79,7 @@ IC float getLastRP_Scale(CDB::COLLIDER* DB, RayCache& C)
 			if (T.pSurface.Empty())	T.bHasAlpha = FALSE;
 			if (!T.bHasAlpha)	{
 				// Opaque poly - cache it
-				C[0].set	(rpinf.verts[0]);
-				C[1].set	(rpinf.verts[1]);
-				C[2].set	(rpinf.verts[2]);
+				C			= rpinf.id;
 				return		0;
 			}
 
@@ -115,30 +112,6 @@ IC float getLastRP_Scale(CDB::COLLIDER* DB, RayCache& C)
 	return scale;
 }
 
-// IC bool RayPick(CDB::COLLIDER* DB, Fvector& P, Fvector& D, float r, RayCache& C)	//, Face* skip)
-IC float rayTrace	(CDB::COLLIDER* DB, Fvector& P, Fvector& D, float R, RayCache& C)
-{
-	R_ASSERT	(DB);
-
-	// 1. Check cached polygon
-	float _u,_v,range;
-	bool res = CDB::TestRayTri(P,D,C,_u,_v,range,false);
-	if (res) {
-		if (range>0 && range<R) return 0;
-	}
-
-	// 2. Polygon doesn't pick - real database query
-	DB->ray_query	(&Level,P,D,R);
-
-	// 3. Analyze polygons and cache nearest if possible
-	if (0==DB->r_count()) {
-		return 1;
-	} else {
-		return getLastRP_Scale(DB,C);
-	}
-//	return 0;
-}
-
 IC int	calcSphereSector(Fvector& dir)
 {
 	Fvector2			flat;
@@ -226,22 +199,70 @@ public:
 			q_Marks[*it]	= false;
 	}
 };
-struct	RC { RayCache	C; };
+// Every cover node traces a fan of rays to the nodes around it, the fan goes down the tree in
+// packets. A ray tries the last opaque occluder seen towards its target node first.
+struct	cover_stats
+{
+	u64					rays;
+	u64					cached;
+	u64					packets;
+};
 
-class	CoverThread : public CThread
+class	CoverWorker
 {
-	u32					Nstart, Nend;
-	xr_vector<RC>		cache;
+	xr_vector<u32>		cache;						// target node -> last opaque occluder
 	CDB::COLLIDER		DB;
 	Query				Q;
+	CDB::RAY_PACKET		packet;
+	u32					target	[CDB::rpMaxRays];
+	int					sector	[CDB::rpMaxRays];
+	float				c_passed[8];
 
 	typedef float	Cover[4];
 
 public:
-	CoverThread			(u32 ID, u32 _start, u32 _end) : CThread(ID)
+	cover_stats			stats;
+
+	CoverWorker			()
+	{
+		DB.ray_options	(CDB::OPT_CULL);
+		cache.assign	(g_nodes.size(),u32(-1));
+		Q.Begin			(g_nodes.size());
+		ZeroMemory		(&stats,sizeof(stats));
+	}
+
+	void				flush				()
+	{
+		if (0==packet.count)	return;
+		DB.ray_packet	(&Level,packet);
+		stats.packets	++;
+		for (u32 r=0; r<packet.count; r++)
+			c_passed[sector[r]]	+= getLastRP_Scale(DB.r_begin()+packet.first[r],packet.hits[r],cache[target[r]]);
+		packet.clear	();
+	}
+
+	void				trace				(const Fvector& P, const Fvector& D, float range, u32 ID, int s)
 	{
-		Nstart	= _start;
-		Nend	= _end;
+		stats.rays		++;
+
+		// 1. Check cached polygon
+		u32		T		= cache[ID];
+		if (T!=u32(-1)) {
+			Fvector*	V		= Level.get_verts();
+			CDB::TRI&	tri		= Level.get_tris()[T];
+			Fvector*	p[3]	= { V+tri.verts[0], V+tri.verts[1], V+tri.verts[2] };
+			float _u,_v,r;
+			if (CDB::TestRayTri(P,D,p,_u,_v,r,false) && r>0 && r<range) {
+				stats.cached	++;
+				return;
+			}
+		}
+
+		// 2. Polygon doesn't pick - the ray goes with the others
+		u32		i		= packet.add(P,D,range);
+		target[i]		= ID;
+		sector[i]		= s;
+		if (packet.full())	flush();
 	}
 
 	void				compute_cover_value	(u32 const &N, vertex &BaseNode, float const &cover_height, Cover &cover)
@@ -250,7 +271,7 @@ public:
 		Fvector		TestPos = BasePos; TestPos.y+=cover_height;
 		
 		float	c_total	[8]	= {0,0,0,0,0,0,0,0};
-		float	c_passed[8]	= {0,0,0,0,0,0,0,0};
+		for (int dirs=0; dirs<8; dirs++)	c_passed[dirs] = 0;
 		
 		// perform volumetric query
 		Q.Init			(BasePos);
@@ -273,8 +294,9 @@ public:
 			// raytrace
 			int			sector		=	calcSphereSector(Dir);
 			c_total		[sector]	+=	1.f;
-			c_passed	[sector]	+=	rayTrace (&DB, TestPos, Dir, range, cache[ID].C); //
+			trace		(TestPos, Dir, range, ID, sector);
 		}
+		flush			();
 		Q.Clear			();
 		
 		// analyze probabilities
@@ -286,54 +308,40 @@ public:
 			clamp(value[dirs],0.f,1.f);
 		}
 
-		if (value[0] < .999f) {
-			value[0] = value[0];
-		}
-		
 		cover	[0]	= (value[2]+value[3]+value[4]+value[5])/4.f; clamp(cover[0],0.f,1.f);	// left
 		cover	[1]	= (value[0]+value[1]+value[2]+value[3])/4.f; clamp(cover[1],0.f,1.f);	// forward
 		cover	[2]	= (value[6]+value[7]+value[0]+value[1])/4.f; clamp(cover[2],0.f,1.f);	// right
 		cover	[3]	= (value[4]+value[5]+value[6]+value[7])/4.f; clamp(cover[3],0.f,1.f);	// back
 	}
 
-	virtual void		Execute()
+	void				node				(u32 N)
 	{
-		DB.ray_options		(CDB::OPT_CULL);
-		{
-			RC				rc;	
-			rc.C[0].set		(0,0,0); 
-			rc.C[1].set		(0,0,0); 
-			rc.C[2].set		(0,0,0);
-			
-			cache.assign	(g_nodes.size()*2,rc);
+		vertex&		BaseNode= g_nodes[N];
+
+		if (!g_cover_nodes[N]) {
+			BaseNode.high_cover[0]	= flt_max;
+			BaseNode.high_cover[1]	= flt_max;
+			BaseNode.high_cover[2]	= flt_max;
+			BaseNode.high_cover[3]	= flt_max;
+			BaseNode.low_cover[0]	= flt_max;
+			BaseNode.low_cover[1]	= flt_max;
+			BaseNode.low_cover[2]	= flt_max;
+			BaseNode.low_cover[3]	= flt_max;
+			return;
 		}
 
-		FPU::m24r		();
-
-		Q.Begin			(g_nodes.size());
-		for (u32 N=Nstart; N<Nend; N++) {
-			// initialize process
-			thProgress	= float(N-Nstart)/float(Nend-Nstart);
-			vertex&		BaseNode= g_nodes[N];
-
-			if (!g_cover_nodes[N]) {
-				BaseNode.high_cover[0]	= flt_max;
-				BaseNode.high_cover[1]	= flt_max;
-				BaseNode.high_cover[2]	= flt_max;
-				BaseNode.high_cover[3]	= flt_max;
-				BaseNode.low_cover[0]	= flt_max;
-				BaseNode.low_cover[1]	= flt_max;
-				BaseNode.low_cover[2]	= flt_max;
-				BaseNode.low_cover[3]	= flt_max;
-				continue;
-			}
-
-			compute_cover_value	(N, BaseNode, high_cover_height, BaseNode.high_cover);
-			compute_cover_value	(N, BaseNode, low_cover_height,  BaseNode.low_cover);
-		}
+		compute_cover_value	(N, BaseNode, high_cover_height, BaseNode.high_cover);
+		compute_cover_value	(N, BaseNode, low_cover_height,  BaseNode.low_cover);
 	}
 };
 
+static void	cover_task	(u32 task, u32 worker, void* param)
+{
+	CoverWorker*	W	= ((CoverWorker**)param)[worker];
+	FPU::m24r			();
+	W->node				(task);
+}
+
 bool valid_vertex_id		(const u32 &vertex_id)
 {
 	return					(vertex_id != InvalidNode);
@@ -444,6 +452,96 @@ bool vertex_in_direction	(const u32 &start_vertex_id, const u32 &target_vertex_i
 	}
 }
 
+typedef std::pair<float,CCoverPoint*>	COVER_PAIR;
+typedef xr_vector<COVER_PAIR>			COVER_PAIRS;
+
+struct	non_cover_scratch
+{
+	COVERS				nearest;
+	COVER_PAIRS			cover_pairs;
+};
+
+// a node out of the covers takes the values of the covers it sees around, weighted by the distance
+static void	non_cover_task	(u32 task, u32 worker, void* param)
+{
+	if (g_cover_nodes[task])
+		return;
+
+	COVERS&			nearest		= ((non_cover_scratch*)param)[worker].nearest;
+	COVER_PAIRS&	cover_pairs	= ((non_cover_scratch*)param)[worker].cover_pairs;
+	vertex&			V			= g_nodes[task];
+
+	g_covers->nearest	(V.Pos,cover_distance,nearest);
+	if (nearest.empty()) {
+		for (int i=0; i<4; ++i) {
+			VERIFY		(V.high_cover[i] == flt_max);
+			V.high_cover[i]	= 1.f;
+
+			VERIFY		(V.low_cover[i] == flt_max);
+			V.low_cover[i]	= 1.f;
+		}
+		return;
+	}
+
+	cover_pairs.clear_not_free		();
+	cover_pairs.reserve				(nearest.size());
+
+	float				cumulative_weight = 0.f;
+	{
+		COVERS::const_iterator		i = nearest.begin();
+		COVERS::const_iterator		e = nearest.end();
+		for ( ; i != e; ++i) {
+			if (!vertex_in_direction(task,(*i)->level_vertex_id()))
+				continue;
+
+			float					weight = 1.f/(*i)->position().distance_to(V.Pos);
+			cumulative_weight		+= weight;
+			cover_pairs.push_back	(
+				std::make_pair(
+					weight,
+					*i
+				)
+			);
+		}
+	}
+
+	// this is incorrect
+	if (cover_pairs.empty()) {
+		for (int i=0; i<4; ++i) {
+			VERIFY		(V.high_cover[i] == flt_max);
+			V.high_cover[i]	= 1.f;
+
+			VERIFY		(V.low_cover[i] == flt_max);
+			V.low_cover[i]	= 1.f;
+		}
+		return;
+	}
+	
+	for (int j=0; j<4; ++j) {
+		VERIFY						(V.high_cover[j] == flt_max);
+		V.high_cover[j]			= 0.f;
+
+		VERIFY						(V.low_cover[j] == flt_max);
+		V.low_cover[j]			= 0.f;
+	}
+
+	COVER_PAIRS::const_iterator		i = cover_pairs.begin();
+	COVER_PAIRS::const_iterator		e = cover_pairs.end();
+	for ( ; i != e; ++i) {
+		vertex						&current = g_nodes[(*i).second->level_vertex_id()];
+		float						factor = (*i).first/cumulative_weight;
+		for (int j=0; j<4; ++j) {
+			V.high_cover[j]		+= factor*current.high_cover[j];
+			V.low_cover[j]		+= factor*current.low_cover[j];
+		}
+	}
+
+	for (int i=0; i<4; ++i) {
+		clamp						(V.high_cover[i], 0.f, 1.f);
+		clamp						(V.low_cover[i], 0.f, 1.f);
+	}
+}
+
 void compute_non_covers		()
 {
 	VERIFY					(g_covers);
@@ -478,115 +576,47 @@ void compute_non_covers		()
 		VERIFY					(g_covers->size());
 	}
 
-	typedef std::pair<float,CCoverPoint*>	COVER_PAIR;
-	typedef xr_vector<COVER_PAIR>			COVER_PAIRS;
-	COVER_PAIRS				cover_pairs;
-
-	Nodes::iterator			B = g_nodes.begin(), I = B;
-	Nodes::iterator			E = g_nodes.end();
-	COVER_NODES::iterator	J = g_cover_nodes.begin();
-	for ( ; I != E; ++I, ++J) {
-		if (*J)
-			continue;
-
-		g_covers->nearest	((*I).Pos,cover_distance,nearest);
-		if (nearest.empty()) {
-			for (int i=0; i<4; ++i) {
-				VERIFY		((*I).high_cover[i] == flt_max);
-				(*I).high_cover[i]	= 1.f;
-
-				VERIFY		((*I).low_cover[i] == flt_max);
-				(*I).low_cover[i]	= 1.f;
-			}
-			continue;
-		}
-
-		cover_pairs.clear_not_free		();
-		cover_pairs.reserve				(nearest.size());
-
-		float				cumulative_weight = 0.f;
-		{
-			COVERS::const_iterator		i = nearest.begin();
-			COVERS::const_iterator		e = nearest.end();
-			for ( ; i != e; ++i) {
-				if (!vertex_in_direction(u32(I - B),(*i)->level_vertex_id()))
-					continue;
-
-				float					weight = 1.f/(*i)->position().distance_to((*I).Pos);
-				cumulative_weight		+= weight;
-				cover_pairs.push_back	(
-					std::make_pair(
-						weight,
-						*i
-					)
-				);
-			}
-		}
-
-		// this is incorrect
-		if (cover_pairs.empty()) {
-			for (int i=0; i<4; ++i) {
-				VERIFY		((*I).high_cover[i] == flt_max);
-				(*I).high_cover[i]	= 1.f;
-
-				VERIFY		((*I).low_cover[i] == flt_max);
-				(*I).low_cover[i]	= 1.f;
-			}
-			continue;
-		}
-		
-		for (int j=0; j<4; ++j) {
-			VERIFY						((*I).high_cover[j] == flt_max);
-			(*I).high_cover[j]			= 0.f;
-
-			VERIFY						((*I).low_cover[j] == flt_max);
-			(*I).low_cover[j]			= 0.f;
-		}
-
-		COVER_PAIRS::const_iterator		i = cover_pairs.begin();
-		COVER_PAIRS::const_iterator		e = cover_pairs.end();
-		for ( ; i != e; ++i) {
-			vertex						&current = g_nodes[(*i).second->level_vertex_id()];
-			float						factor = (*i).first/cumulative_weight;
-			for (int j=0; j<4; ++j) {
-				(*I).high_cover[j]		+= factor*current.high_cover[j];
-				(*I).low_cover[j]		+= factor*current.low_cover[j];
-			}
-		}
-
-		for (int i=0; i<4; ++i) {
-			clamp						((*I).high_cover[i], 0.f, 1.f);
-			clamp						((*I).low_cover[i], 0.f, 1.f);
-		}
-	}
+	// the covers are read only from here, every other node is on its own
+	xr_vector<non_cover_scratch>	scratch	(CTaskPool::workers());
+	CTaskPool::run			("non-cover nodes",g_nodes.size(),non_cover_task,&*scratch.begin());
 }
 
-#define NUM_THREADS	3
 extern	void mem_Optimize();
 void	xrCover	(bool pure_covers)
 {
 	Status("Calculating...");
 
+	CTimer		T;
+	T.Start		();
 	if (!pure_covers)
 		compute_cover_nodes	();
 	else
 		g_cover_nodes.assign(g_nodes.size(),true);
-
-	// Start threads, wait, continue --- perform all the work
-	u32	start_time		= timeGetTime();
-	CThreadManager		Threads;
-	u32	stride			= g_nodes.size()/NUM_THREADS;
-	u32	last			= g_nodes.size()-stride*(NUM_THREADS-1);
-	for (u32 thID=0; thID<NUM_THREADS; thID++) {
-		Threads.start(xr_new<CoverThread>(thID,thID*stride,thID*stride+((thID==(NUM_THREADS-1))?last:stride)));
-//		CoverThread(thID,thID*stride,thID*stride+((thID==(NUM_THREADS-1))?last:stride)).Execute();
-//		Threads.wait		();
+	Msg("* cover nodes: %f seconds",T.GetElapsed_sec());
+
+	// every node is a task, the workers keep their occluder caches between the nodes
+	T.Start					();
+	xr_vector<CoverWorker*>	workers;
+	for (u32 w=0; w<CTaskPool::workers(); w++)
+		workers.push_back	(xr_new<CoverWorker>());
+	CTaskPool::run			("cover rays",g_nodes.size(),cover_task,&*workers.begin());
+
+	cover_stats				stats;
+	ZeroMemory				(&stats,sizeof(stats));
+	for (u32 w=0; w<workers.size(); w++) {
+		stats.rays			+= workers[w]->stats.rays;
+		stats.cached		+= workers[w]->stats.cached;
+		stats.packets		+= workers[w]->stats.packets;
+		xr_delete			(workers[w]);
 	}
-	Threads.wait			();
-	Msg("%d seconds elapsed.",(timeGetTime()-start_time)/1000);
+	float	sec				= T.GetElapsed_sec();
+	Msg("* cover rays: %f seconds, %I64u rays (%.1f%% by the cached occluder), %I64u packets, %.2f M rays/sec",
+		sec,stats.rays,stats.rays ? 100.f*float(stats.cached)/float(stats.rays) : 0.f,stats.packets,float(stats.rays)/(_max(sec,EPS_S)*1000000.f));
 
 	if (!pure_covers) {
+		T.Start				();
 		compute_non_covers	();
+		Msg("* non-cover nodes: %f seconds",T.GetElapsed_sec());
 
 		COVERS				nearest;
 		VERIFY				(g_covers);
@@ -599,6 +629,7 @@ void	xrCover	(bool pure_covers)
 	// Smooth
 	Status			("Smoothing coverage mask...");
 	mem_Optimize	();
+	T.Start			();
 	Nodes	Old		= g_nodes;
 	for (u32 N=0; N<g_nodes.size(); N++)
 	{
@@ -622,4 +653,5 @@ void	xrCover	(bool pure_covers)
 			Dest.low_cover[dir]		=  val2/cnt;
 		}
 	}
+	Msg("* smoothing: %f seconds",T.GetElapsed_sec());
 }
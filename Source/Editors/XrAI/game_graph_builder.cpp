@@ -17,6 +17,7 @@
 #include "xrCrossTable.h"
 #include "guid_generator.h"
 #include "graph_engine.h"
+#include "xrThread.h"
 
 CGameGraphBuilder::CGameGraphBuilder		()
 {
@@ -172,151 +173,74 @@ IC	bool sort_predicate_greater(const T &first, const T &second)
 	return					(first.first > second.first);
 }
 
-void CGameGraphBuilder::mark_vertices		(u32 level_vertex_id)
+// a level vertex keeps the nearest game vertex, the lower id on the equal distances; the floods
+// run concurrently and meet only here, a vertex goes to the fringe only if this flood improved it
+bool CGameGraphBuilder::merge_distance		(const u32 &level_vertex_id, const u32 &distance, const u32 &game_vertex_id)
 {
-	CLevelGraph::const_iterator			I, E;
-	m_mark_stack.reserve				(8192);
-	m_mark_stack.push_back				(level_vertex_id);
-
-	for ( ; !m_mark_stack.empty(); ) {
-		level_vertex_id					= m_mark_stack.back();
-		m_mark_stack.resize				(m_mark_stack.size() - 1);
-		CLevelGraph::CVertex			*node = level_graph().vertex(level_vertex_id);
-		level_graph().begin				(level_vertex_id,I,E);
-		m_marks[level_vertex_id]		= true;
-		for ( ; I != E; ++I) {
-			u32							next_level_vertex_id = node->link(I);
-			if (!level_graph().valid_vertex_id(next_level_vertex_id))
-				continue;
-			
-			if (!m_marks[next_level_vertex_id])
-				m_mark_stack.push_back	(next_level_vertex_id);
-		}
+	volatile LONGLONG					*nearest = (volatile LONGLONG*)&m_nearest[level_vertex_id];
+	u64									value = (u64(distance) << 32) | game_vertex_id;
+	u64									current = u64(InterlockedCompareExchange64(nearest,0,0));
+	for (;;) {
+		if (current <= value)
+			return						(false);
+
+		u64								previous = u64(InterlockedCompareExchange64(nearest,LONGLONG(value),LONGLONG(current)));
+		if (previous == current)
+			return						(true);
+
+		current							= previous;
 	}
 }
 
-void CGameGraphBuilder::fill_marks			(const float &start, const float &amount)
+void CGameGraphBuilder::flood_distances		(const u32 &game_vertex_id, CFloodWorker &worker)
 {
-	Progress							(start);
-
-	m_marks.assign						(level_graph().header().vertex_count(),false);
-	graph_type::const_vertex_iterator	I = graph().vertices().begin();
-	graph_type::const_vertex_iterator	E = graph().vertices().end();
-	for ( ; I != E; ++I)
-		mark_vertices					((*I).second->data().level_vertex_id());
-	m_marks.flip						();
-	
-	Progress							(start + amount);
-}
-
-void CGameGraphBuilder::fill_distances		(const float &start, const float &amount)
-{
-	Progress							(start);
-
-	m_distances.resize					(graph().vertices().size());
-	{
-		DISTANCES::iterator				I = m_distances.begin();
-		DISTANCES::iterator				E = m_distances.end();
-		for ( ; I != E; I++) {
-			(*I).resize					(level_graph().header().vertex_count());
-			xr_vector<u32>::iterator	i = (*I).begin();
-			xr_vector<u32>::iterator	e = (*I).end();
-			for ( ; i != e; i++)
-				*i						= u32(-1);
-		}
-	}
-
-	Progress							(start + amount);
-}
+	u32									level_vertex_id = graph().vertex(game_vertex_id)->data().level_vertex_id();
+	if (!merge_distance(level_vertex_id,0,game_vertex_id))
+		return;
 
-void CGameGraphBuilder::recursive_update	(const u32 &game_vertex_id, const float &start, const float &amount)
-{
-	Progress					(start);
+	xr_vector<u32>						&current_fringe = worker.m_current_fringe;
+	xr_vector<u32>						&next_fringe = worker.m_next_fringe;
+	current_fringe.clear				();
+	next_fringe.clear					();
+	current_fringe.push_back			(level_vertex_id);
 
-	u32							level_vertex_id = graph().vertex(game_vertex_id)->data().level_vertex_id();
-	xr_vector<u32>				&distances = m_distances[game_vertex_id];
-	m_distances[m_results[level_vertex_id]][level_vertex_id]	= u32(-1);
-
-	m_current_fringe.reserve	(distances.size());
-	m_next_fringe.reserve		(distances.size());
-	distances.assign			(distances.size(),u32(-1));
-	m_current_fringe.push_back	(level_vertex_id);
-	u32							curr_dist = 0;
-	u32							total_count = 0;
-
-	u32							vertex_count = graph().header().vertex_count();
-
-	float						amount_i = 
-		amount
-		/
-		(
-			float(vertex_count)*
-			float(level_graph().header().vertex_count())
-		);
-
-	Progress					(start);
-	for ( ; !m_current_fringe.empty(); ) {
-		xr_vector<u32>::iterator			I = m_current_fringe.begin();
-		xr_vector<u32>::iterator			E = m_current_fringe.end();
+	for (u32 curr_dist = 1; !current_fringe.empty(); ++curr_dist) {
+		xr_vector<u32>::const_iterator	I = current_fringe.begin();
+		xr_vector<u32>::const_iterator	E = current_fringe.end();
 		for ( ; I != E; ++I) {
-			u32								*result = &m_results[*I];
-			VERIFY							(curr_dist < m_distances[*result][*I]);
-			*result							= game_vertex_id;
-
-			distances[*I]					= curr_dist;
-			CLevelGraph::const_iterator		i, e;
-			CLevelGraph::CVertex			*node = level_graph().vertex(*I);
-			level_graph().begin				(*I,i,e);
+			CLevelGraph::const_iterator	i, e;
+			CLevelGraph::CVertex		*node = level_graph().vertex(*I);
+			level_graph().begin			(*I,i,e);
 			for ( ; i != e; ++i) {
-				u32							dwNexNodeID = node->link(i);
+				u32						dwNexNodeID = node->link(i);
 				if (!level_graph().valid_vertex_id(dwNexNodeID))
 					continue;
-				
-				if (m_marks[dwNexNodeID])
-					continue;
-				
-				if (distances[dwNexNodeID] <= curr_dist)
-					continue;
 
-				if (m_distances[m_results[dwNexNodeID]][dwNexNodeID] <= (curr_dist + 1))
-					continue;
-
-				m_next_fringe.push_back		(dwNexNodeID);
-				m_marks[dwNexNodeID]		= true;
+				if (merge_distance(dwNexNodeID,curr_dist,game_vertex_id))
+					next_fringe.push_back	(dwNexNodeID);
 			}
 		}
-		
-		I = m_current_fringe.begin();
-		E = m_current_fringe.end();
-		for ( ; I != E; ++I)
-			m_marks[*I]		= false;
 
-		total_count			+= m_current_fringe.size();
-		m_current_fringe	= m_next_fringe;
-		m_next_fringe.clear	();
-		++curr_dist;
-
-		Progress			(start + amount_i*float(total_count));
+		current_fringe.swap				(next_fringe);
+		next_fringe.clear				();
 	}
+}
 
-	Progress				(start + amount);
+void CGameGraphBuilder::flood_task			(u32 task, u32 worker, void *param)
+{
+	CGameGraphBuilder					*self = (CGameGraphBuilder*)param;
+	self->flood_distances				(task,self->m_flood_workers[worker]);
 }
 
 void CGameGraphBuilder::iterate_distances	(const float &start, const float &amount)
 {
 	Progress							(start);
 
-	m_results.assign					(level_graph().header().vertex_count(),0);
-	
-	float								amount_i = amount/float(graph().vertices().size());
-	for (int i=0, n=(int)graph().vertices().size(); i<n; ++i) {
-		if (i) {
-			for (int k=0, kn=(int)level_graph().header().vertex_count(); k<kn; ++k)
-				m_distances[i][k]		= m_distances[i - 1][k];
-		}
-
-		recursive_update				(i,start + amount_i*float(i),amount_i);
-	}
+	// the unreachable vertices stay at the game vertex 0 and the distance u32(-1)
+	m_nearest.assign					(level_graph().header().vertex_count(),u64(u32(-1)) << 32);
+	m_flood_workers.resize				(CTaskPool::workers());
+	CTaskPool::run						("cross table",graph().vertices().size(),flood_task,this,start,amount);
+	m_flood_workers.clear				();
 
 	Progress							(start + amount);
 }
@@ -347,9 +271,9 @@ void CGameGraphBuilder::save_cross_table	(const float &start, const float &amoun
 
 	for (int i=0, n=level_graph().header().vertex_count(); i<n; i++) {
 		CGameLevelCrossTable::CCell	tCrossTableCell;
-		tCrossTableCell.tGraphIndex = (GameGraph::_GRAPH_ID)m_results[i];
+		tCrossTableCell.tGraphIndex = (GameGraph::_GRAPH_ID)(m_nearest[i] & u32(-1));
 		VERIFY						(graph().header().vertex_count() > tCrossTableCell.tGraphIndex);
-		tCrossTableCell.fDistance	= float(m_distances[tCrossTableCell.tGraphIndex][i])*level_graph().header().cell_size();
+		tCrossTableCell.fDistance	= float(u32(m_nearest[i] >> 32))*level_graph().header().cell_size();
 		tMemoryStream.w				(&tCrossTableCell,sizeof(tCrossTableCell));
 	}
 
@@ -363,11 +287,7 @@ void CGameGraphBuilder::save_cross_table	(const float &start, const float &amoun
 
 //	Msg						("Freiing cross table resources");
 
-	m_marks.clear			();
-	m_mark_stack.clear		();
-	m_distances.clear		();
-	m_current_fringe.clear	();
-	m_next_fringe.clear		();
+	m_nearest.clear			();
 
 //	Msg						("CT:SAVE : %f",timer.GetElapsed_sec());
 	Progress				(start + amount);
@@ -382,11 +302,7 @@ void CGameGraphBuilder::build_cross_table	(const float &start, const float &amou
 //	CTimer					timer;
 //	timer.Start				();
 
-	fill_marks				(start + 0.000000f*amount,0.018725f*amount);
-//	Msg						("CT : %f",timer.GetElapsed_sec());
-	fill_distances			(start + 0.018725f*amount,0.183732f*amount);
-//	Msg						("CT : %f",timer.GetElapsed_sec());
-	iterate_distances		(start + 0.202457f*amount,0.757202f*amount);
+	iterate_distances		(start + 0.000000f*amount,0.959659f*amount);
 //	Msg						("CT : %f",timer.GetElapsed_sec());
 	save_cross_table		(start + 0.959659f*amount,0.040327f*amount);
 //	Msg						("CT : %f",timer.GetElapsed_sec());
@@ -408,29 +324,32 @@ void CGameGraphBuilder::load_cross_table	(const float &start, const float &amoun
 	Progress				(start + amount);
 }
 
-void CGameGraphBuilder::fill_neighbours		(const u32 &game_vertex_id)
+// the level vertices are stamped with the game vertex being filled, so the marks are never cleared
+void CGameGraphBuilder::fill_neighbours		(const u32 &game_vertex_id, CEdgeWorker &worker)
 {
-	m_marks.assign						(level_graph().header().vertex_count(),false);
-	m_current_fringe.clear				();
+	xr_vector<u32>						&stamps = worker.m_stamps;
+	xr_vector<u32>						&mark_stack = worker.m_mark_stack;
+	xr_vector<u32>						&neighbours = worker.m_neighbours;
+	neighbours.clear					();
 
 	u32									level_vertex_id = graph().vertex(game_vertex_id)->data().level_vertex_id();
 
 	CLevelGraph::const_iterator			I, E;
-	m_mark_stack.reserve				(8192);
-	m_mark_stack.push_back				(level_vertex_id);
+	mark_stack.reserve					(8192);
+	mark_stack.push_back				(level_vertex_id);
 
-	for ( ; !m_mark_stack.empty(); ) {
-		level_vertex_id					= m_mark_stack.back();
-		m_mark_stack.resize				(m_mark_stack.size() - 1);
+	for ( ; !mark_stack.empty(); ) {
+		level_vertex_id					= mark_stack.back();
+		mark_stack.resize				(mark_stack.size() - 1);
 		CLevelGraph::CVertex			*node = level_graph().vertex(level_vertex_id);
 		level_graph().begin				(level_vertex_id,I,E);
-		m_marks[level_vertex_id]		= true;
+		stamps[level_vertex_id]			= game_vertex_id;
 		for ( ; I != E; ++I) {
 			u32							next_level_vertex_id = node->link(I);
 			if (!level_graph().valid_vertex_id(next_level_vertex_id))
 				continue;
 			
-			if (m_marks[next_level_vertex_id])
+			if (stamps[next_level_vertex_id] == game_vertex_id)
 				continue;
 
 			GameGraph::_GRAPH_ID		next_game_vertex_id = cross().vertex(next_level_vertex_id).game_vertex_id();
@@ -438,27 +357,27 @@ void CGameGraphBuilder::fill_neighbours		(const u32 &game_vertex_id)
 			if (next_game_vertex_id != (GameGraph::_GRAPH_ID)game_vertex_id) {
 				if	(
 						std::find(
-							m_current_fringe.begin(),
-							m_current_fringe.end(),
+							neighbours.begin(),
+							neighbours.end(),
 							next_game_vertex_id
 						)
 						==
-						m_current_fringe.end()
+						neighbours.end()
 					)
-					m_current_fringe.push_back	(next_game_vertex_id);
+					neighbours.push_back	(next_game_vertex_id);
 				continue;
 			}
 
-			m_mark_stack.push_back		(next_level_vertex_id);
+			mark_stack.push_back		(next_level_vertex_id);
 		}
 	}
 }
 
-float CGameGraphBuilder::path_distance		(const u32 &game_vertex_id0, const u32 &game_vertex_id1)
+float CGameGraphBuilder::path_distance		(const u32 &game_vertex_id0, const u32 &game_vertex_id1, CEdgeWorker &worker)
 {
 //	return					(graph().vertex(game_vertex_id0)->data().level_point().distance_to(graph().vertex(game_vertex_id1)->data().level_point()));
 
-	VERIFY					(m_graph_engine);
+	VERIFY					(worker.m_graph_engine);
 
 	graph_type::CVertex		&vertex0 = *graph().vertex(game_vertex_id0);
 	graph_type::CVertex		&vertex1 = *graph().vertex(game_vertex_id1);
@@ -475,11 +394,11 @@ float CGameGraphBuilder::path_distance		(const u32 &game_vertex_id0, const u32 &
 		return				(pure_distance);
 
 	bool					successfull = 
-		m_graph_engine->search(
+		worker.m_graph_engine->search(
 			level_graph(),
 			vertex0.data().level_vertex_id(),
 			vertex1.data().level_vertex_id(),
-			&m_path,
+			&worker.m_path,
 			parameters
 		);
 
@@ -492,17 +411,28 @@ float CGameGraphBuilder::path_distance		(const u32 &game_vertex_id0, const u32 &
 	return					(flt_max);
 }
 
-void CGameGraphBuilder::generate_edges		(const u32 &game_vertex_id)
+void CGameGraphBuilder::generate_edges		(const u32 &game_vertex_id, CEdgeWorker &worker)
 {
-	graph_type::CVertex		*vertex = graph().vertex(game_vertex_id);
+	xr_vector<EDGE>			&edges = m_edges[game_vertex_id];
 
-	xr_vector<u32>::const_iterator	I = m_current_fringe.begin();
-	xr_vector<u32>::const_iterator	E = m_current_fringe.end();
-	for ( ; I != E; ++I) {
-		VERIFY				(!vertex->edge(*I));
-		float				distance = path_distance(game_vertex_id,*I);
-		graph().add_edge	(game_vertex_id,*I,distance);
+	xr_vector<u32>::const_iterator	I = worker.m_neighbours.begin();
+	xr_vector<u32>::const_iterator	E = worker.m_neighbours.end();
+	for ( ; I != E; ++I)
+		edges.push_back		(std::make_pair(*I,path_distance(game_vertex_id,*I,worker)));
+}
+
+// every worker has its own graph engine, created with the first vertex it takes
+void CGameGraphBuilder::edge_task			(u32 task, u32 worker, void *param)
+{
+	CGameGraphBuilder		*self = (CGameGraphBuilder*)param;
+	CEdgeWorker				&edge_worker = self->m_edge_workers[worker];
+	if (!edge_worker.m_graph_engine) {
+		edge_worker.m_graph_engine	= xr_new<CGraphEngine>(self->level_graph().header().vertex_count());
+		edge_worker.m_stamps.assign	(self->level_graph().header().vertex_count(),u32(-1));
 	}
+
+	self->fill_neighbours	(task,edge_worker);
+	self->generate_edges	(task,edge_worker);
 }
 
 void CGameGraphBuilder::generate_edges		(const float &start, const float &amount)
@@ -510,13 +440,38 @@ void CGameGraphBuilder::generate_edges		(const float &start, const float &amount
 	Progress				(start);
 
 	Msg						("Generating edges");
-	
+
+	m_edges.assign			(graph().vertices().size(),xr_vector<EDGE>());
+	m_edge_workers.resize	(CTaskPool::workers());
+	{
+		xr_vector<CEdgeWorker>::iterator	I = m_edge_workers.begin();
+		xr_vector<CEdgeWorker>::iterator	E = m_edge_workers.end();
+		for ( ; I != E; ++I)
+			(*I).m_graph_engine	= 0;
+	}
+
+	CTaskPool::run			("edges",graph().vertices().size(),edge_task,this,start,amount);
+
+	{
+		xr_vector<CEdgeWorker>::iterator	I = m_edge_workers.begin();
+		xr_vector<CEdgeWorker>::iterator	E = m_edge_workers.end();
+		for ( ; I != E; ++I)
+			xr_delete		((*I).m_graph_engine);
+	}
+	m_edge_workers.clear	();
+
 	graph_type::const_vertex_iterator	I = graph().vertices().begin();
 	graph_type::const_vertex_iterator	E = graph().vertices().end();
 	for ( ; I != E; ++I) {
-		fill_neighbours		((*I).second->vertex_id());
-		generate_edges		((*I).second->vertex_id());
+		u32					game_vertex_id = (*I).second->vertex_id();
+		xr_vector<EDGE>::const_iterator	i = m_edges[game_vertex_id].begin();
+		xr_vector<EDGE>::const_iterator	e = m_edges[game_vertex_id].end();
+		for ( ; i != e; ++i) {
+			VERIFY			(!(*I).second->edge((*i).first));
+			graph().add_edge(game_vertex_id,(*i).first,(*i).second);
+		}
 	}
+	m_edges.clear			();
 
 	Msg						("%d edges built",graph().edge_count());
 
@@ -700,15 +655,7 @@ void CGameGraphBuilder::build_graph			(const float &start, const float &amount)
 	CTimer					timer;
 	timer.Start				();
 
-	m_graph_engine			= xr_new<CGraphEngine>(level_graph().header().vertex_count());
-	Progress				(start + 0.000000f*amount + amount*0.067204f);
-//	Msg						("BG : %f",timer.GetElapsed_sec());
-
-	generate_edges			(start + 0.067204f*amount, amount*0.922647f);
-//	Msg						("BG : %f",timer.GetElapsed_sec());
-
-	xr_delete				(m_graph_engine);
-	Progress				(start + 0.989851f*amount + amount*0.002150f);
+	generate_edges			(start + 0.000000f*amount, amount*0.992001f);
 //	Msg						("BG : %f",timer.GetElapsed_sec());
 
 	connectivity_check		(start + 0.992001f*amount, amount*0.000030f);
@@ -33,7 +33,8 @@ class CGameGraphBuilder {
 private:
 	typedef GameGraph::CVertex						vertex_type;
 	typedef CGraphAbstract<vertex_type,float,u32>	graph_type;
-	typedef xr_vector<xr_vector<u32> >				DISTANCES;
+	typedef std::pair<u32,float>					EDGE;
+	typedef xr_vector<xr_vector<EDGE> >				EDGES;
 	typedef std::pair<u32,u32>						PAIR;
 	typedef std::pair<float,PAIR>					TRIPPLE;
 	typedef xr_vector<TRIPPLE>						TRIPPLES;
@@ -50,17 +51,30 @@ private:
 	graph_type				*m_graph;
 	xrGUID					m_graph_guid;
 	// cross table generation stuff
-	xr_vector<bool>			m_marks;
-	xr_vector<u32>			m_mark_stack;
-	DISTANCES				m_distances;
-	xr_vector<u32>			m_current_fringe;
-	xr_vector<u32>			m_next_fringe;
-	xr_vector<u32>			m_results;
+	// distance to the nearest game vertex in the high dword, its id in the low one
+	xr_vector<u64>			m_nearest;
 	// cross table itself
 	CGameLevelCrossTable	*m_cross_table;
 	TRIPPLES				m_tripples;
-	xr_vector<u32>			m_path;
-	CGraphEngine			*m_graph_engine;
+	// graph generation stuff, the edges are found per vertex and added in the vertex order
+	EDGES					m_edges;
+
+private:
+	struct CFloodWorker {
+		xr_vector<u32>		m_current_fringe;
+		xr_vector<u32>		m_next_fringe;
+	};
+
+	struct CEdgeWorker {
+		CGraphEngine		*m_graph_engine;
+		xr_vector<u32>		m_path;
+		xr_vector<u32>		m_stamps;
+		xr_vector<u32>		m_mark_stack;
+		xr_vector<u32>		m_neighbours;
+	};
+
+	xr_vector<CFloodWorker>	m_flood_workers;
+	xr_vector<CEdgeWorker>	m_edge_workers;
 
 private:
 			void		create_graph				(const float &start, const float &amount);
@@ -69,19 +83,19 @@ private:
 			void		load_graph_points			(const float &start, const float &amount);
 
 private:
-			void		mark_vertices				(u32 level_vertex_id);
-			void		fill_marks					(const float &start, const float &amount);
-			void		fill_distances				(const float &start, const float &amount);
-			void		recursive_update			(const u32 &index, const float &start, const float &amount);
+			bool		merge_distance				(const u32 &level_vertex_id, const u32 &distance, const u32 &game_vertex_id);
+			void		flood_distances				(const u32 &game_vertex_id, CFloodWorker &worker);
+	static	void		flood_task					(u32 task, u32 worker, void *param);
 			void		iterate_distances			(const float &start, const float &amount);
 			void		save_cross_table			(const float &start, const float &amount);
 			void		build_cross_table			(const float &start, const float &amount);
 			void		load_cross_table			(const float &start, const float &amount);
 			
 private:
-			void		fill_neighbours				(const u32 &game_vertex_id);
-			float		path_distance				(const u32 &game_vertex_id0, const u32 &game_vertex_id1);
-			void		generate_edges				(const u32 &vertex_id);
+			void		fill_neighbours				(const u32 &game_vertex_id, CEdgeWorker &worker);
+			float		path_distance				(const u32 &game_vertex_id0, const u32 &game_vertex_id1, CEdgeWorker &worker);
+			void		generate_edges				(const u32 &vertex_id, CEdgeWorker &worker);
+	static	void		edge_task					(u32 task, u32 worker, void *param);
 			void		generate_edges				(const float &start, const float &amount);
 			void		connectivity_check			(const float &start, const float &amount);
 			void		create_tripples				(const float &start, const float &amount);
@@ -55,3 +55,78 @@ void	CThreadManager::wait	(u32	sleep_time)
 		if (threads[thID]->thDestroyOnComplete)	xr_delete(threads[thID]);
 	threads.clear	();
 }
+
+//--------------------------------------------------- task pool
+struct	task_run
+{
+	LPCSTR				phase;
+	u32					count;
+	CTaskPool::task_func*	func;
+	void*				param;
+	volatile LONG		next;
+	volatile LONG		done;
+	volatile LONG		finished;
+	u32					workers;
+	HANDLE				ev_finished;
+};
+struct	task_worker
+{
+	task_run*			run;
+	u32					id;
+};
+
+u32		CTaskPool::workers	()
+{
+	return	_max(CPU::ID.n_threads,u32(1));
+}
+
+static void	task_worker_proc	(void* P)
+{
+	task_worker&	W	= *(task_worker*)P;
+	task_run&		R	= *W.run;
+
+	FPU::m64r			();
+	SetThreadPriority	(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+
+	for (;;)
+	{
+		u32	task		= u32(InterlockedIncrement(&R.next)-1);
+		if (task>=R.count)	break;
+		R.func			(task,W.id,R.param);
+		InterlockedIncrement	(&R.done);
+	}
+	if (u32(InterlockedIncrement(&R.finished))==R.workers)
+		SetEvent		(R.ev_finished);
+}
+
+void	CTaskPool::run	(LPCSTR phase, u32 count, task_func* func, void* param, float start, float amount, u32 sleep_time)
+{
+	if (0==count)		return;
+
+	task_run			R;
+	R.phase				= phase;
+	R.count				= count;
+	R.func				= func;
+	R.param				= param;
+	R.next				= 0;
+	R.done				= 0;
+	R.finished			= 0;
+	R.workers			= _min(workers(),count);
+	R.ev_finished		= CreateEvent	(NULL,TRUE,FALSE,NULL);
+
+	xr_vector<task_worker>	W	(R.workers);
+	CTimer		start_time;	start_time.Start();
+	for (u32 w=0; w<R.workers; w++)
+	{
+		W[w].run		= &R;
+		W[w].id			= w;
+		thread_spawn	(task_worker_proc,"worker-thread",1024*1024,&W[w]);
+	}
+
+	while (WAIT_TIMEOUT==WaitForSingleObject(R.ev_finished,sleep_time))
+		Progress		(start + amount*float(R.done)/float(count));
+	CloseHandle			(R.ev_finished);
+	Progress			(start + amount);
+
+	clMsg	("* %s: %d tasks on %d workers, %f seconds",phase,count,R.workers,start_time.GetElapsed_sec());
+}
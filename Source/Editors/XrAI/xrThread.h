@@ -35,4 +35,16 @@ class ENGINE_API CThreadManager
 public:
 	void				start	(CThread*	T);
 	void				wait	(u32		sleep_time=1000);
+};
+
+// Task pool, one worker per hardware thread. The workers take the tasks in order from a shared
+// counter, so an expensive stretch of tasks doesn't keep one worker busy while the others wait.
+// run() returns when all the tasks are done, the progress goes from start to start+amount.
+class CTaskPool
+{
+public:
+	typedef void		task_func	(u32 task, u32 worker, void* param);
+
+	static u32			workers		();
+	static void			run			(LPCSTR phase, u32 count, task_func* func, void* param, float start=0.f, float amount=1.f, u32 sleep_time=500);
 };
\ No newline at end of file
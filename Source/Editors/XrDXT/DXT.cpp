@@ -2,15 +2,10 @@
 //
 
 #include "stdafx.h"
+#include "DXTBlocks.h"
 
-int DXTCompressImage	(LPCSTR out_name, u8* raw_data, u32 w, u32 h, u32 pitch, STextureParams* fmt, u32 depth)
+static RedImageTool::RedTexturePixelFormat DXTFormat(STextureParams* fmt)
 {
-	CTimer T; T.Start();
-
-	Msg("DXT: Compressing Image: %s %uX%u", out_name, w, h);
-
-	R_ASSERT(0 != w && 0 != h);
-	RedImageTool::RedImage Image;
 	RedImageTool::RedTexturePixelFormat Format = RedImageTool::RedTexturePixelFormat::R8G8B8A8;
 	switch (fmt->fmt)
 	{
@@ -25,10 +20,13 @@ int DXTCompressImage	(LPCSTR out_name, u8* raw_data, u32 w, u32 h, u32 pitch, ST
 		case STextureParams::tfRGB: 	Format = RedImageTool::RedTexturePixelFormat::R8G8B8;  break;
 		case STextureParams::tfRGBA: 	Format = RedImageTool::RedTexturePixelFormat::R8G8B8A8;break;
 	}
+	return Format;
+}
 
-	Image.Create(w, h, 1, 1, RedImageTool::RedTexturePixelFormat::R8G8B8A8);
-	memcpy(*Image, raw_data, w * h * 4);
-	Image.SwapRB();
+// Image is R8G8B8A8 with R first
+static int DXTSaveImage(LPCSTR out_name, RedImageTool::RedImage& Image, STextureParams* fmt, bool bParallel)
+{
+	RedImageTool::RedTexturePixelFormat Format = DXTFormat(fmt);
 	RedImageTool::RedResizeFilter ResizeFilter = RedImageTool::RedResizeFilter::Default;
 	switch (fmt->mip_filter)
 	{
@@ -37,9 +35,162 @@ int DXTCompressImage	(LPCSTR out_name, u8* raw_data, u32 w, u32 h, u32 pitch, ST
 	case STextureParams::kMIPFilterKaiser:     ResizeFilter = RedImageTool::RedResizeFilter::Catmullrom;   break;
 	}
 	Image.GenerateMipmap(ResizeFilter);
-	Image.Convert(Format);
+	if (RedImageTool::RedTextureUtils::isCompressor(Format))
+		DXTCompressBlocks(Image, Format, DXTQuality(), bParallel);
+	else
+		Image.Convert(Format);
+	return Image.SaveToDds(out_name);
+}
+
+int DXTCompressImage	(LPCSTR out_name, u8* raw_data, u32 w, u32 h, u32 pitch, STextureParams* fmt, u32 depth)
+{
+	CTimer T; T.Start();
+
+	Msg("DXT: Compressing Image: %s %uX%u", out_name, w, h);
+
+	R_ASSERT(0 != w && 0 != h);
+	RedImageTool::RedImage Image;
+	Image.Create(w, h, 1, 1, RedImageTool::RedTexturePixelFormat::R8G8B8A8);
+	memcpy(*Image, raw_data, w * h * 4);
+	Image.SwapRB();
+	int res = DXTSaveImage(out_name, Image, fmt, true);
 	Msg("DXT: Compressing Image: 2 [Closing File]. Time from start %f ms", T.GetElapsed_sec() * 1000.f);
-	return Image.SaveToDds(out_name);;
+	return res;
+}
+
+//--------------------------------------------------- Batch
+// Every image file of src_dir goes to dst_dir as .dds with the same params, one image per worker
+struct	dxt_batch
+{
+	string_path				src_dir;
+	string_path				dst_dir;
+	STextureParams*			fmt;
+	xr_vector<shared_str>	files;
+	volatile LONG			failed;
+};
+
+static void	DXTFindImages	(LPCSTR dir, xr_vector<shared_str>& files)
+{
+	LPCSTR	masks[]		= {"*.tga","*.png","*.jpg","*.bmp",0};
+	for (LPCSTR* mask=masks; *mask; mask++)
+	{
+		string_path			wildcard;
+		strconcat			(sizeof(wildcard),wildcard,dir,"\\",*mask);
+		WIN32_FIND_DATA		data;
+		HANDLE	hFind		= FindFirstFile(wildcard,&data);
+		if (INVALID_HANDLE_VALUE==hFind)	continue;
+		do
+		{
+			if (!(data.dwFileAttributes&FILE_ATTRIBUTE_DIRECTORY))
+				files.push_back	(data.cFileName);
+		}
+		while (FindNextFile(hFind,&data));
+		FindClose			(hFind);
+	}
+}
+
+static bool	DXTLoadImage	(LPCSTR name, RedImageTool::RedImage& Image)
+{
+	if (!Image.LoadFromFile(name) || Image.Empty())	return false;
+	if (RedImageTool::RedTexturePixelFormat::R8G8B8A8!=Image.GetFormat())
+		Image.Convert		(RedImageTool::RedTexturePixelFormat::R8G8B8A8);
+	return	true;
+}
+
+static void	DXTBatchTask	(u32 task, void* param)
+{
+	dxt_batch&	B			= *(dxt_batch*)param;
+	string_path				src_name, dst_name;
+	strconcat				(sizeof(src_name),src_name,B.src_dir,"\\",*B.files[task]);
+	strconcat				(sizeof(dst_name),dst_name,B.dst_dir,"\\",*B.files[task]);
+	if (strext(dst_name))	*strext(dst_name) = 0;
+	xr_strcat				(dst_name,".dds");
+
+	RedImageTool::RedImage	Image;
+	if (!DXTLoadImage(src_name,Image) || !DXTSaveImage(dst_name,Image,B.fmt,false))
+	{
+		Msg					("! DXT: can't compress '%s'",src_name);
+		InterlockedIncrement(&B.failed);
+	}
+}
+
+extern "C" __declspec(dllexport)
+int		DXTCompressBatch	(LPCSTR src_dir, LPCSTR dst_dir, STextureParams* fmt)
+{
+	CTimer T; T.Start();
+
+	dxt_batch				B;
+	xr_strcpy				(B.src_dir,src_dir);
+	xr_strcpy				(B.dst_dir,dst_dir);
+	B.fmt					= fmt;
+	B.failed				= 0;
+	DXTFindImages			(src_dir,B.files);
+	DXTRunTasks				(u32(B.files.size()),DXTBatchTask,&B);
+
+	Msg("DXT: batch '%s': %d images, %d failed, %f sec", src_dir, u32(B.files.size()), u32(B.failed), T.GetElapsed_sec());
+	return	int(B.files.size())-int(B.failed);
+}
+
+//--------------------------------------------------- Benchmark
+// The images of src_dir are compressed to BC1, BC3 and BC5 by the single threaded RedImage path
+// and by the block engine at every quality; MPixels/s counts all the mips, the error is the RMSE
+// of the decoded mips against the uncompressed ones
+extern "C" __declspec(dllexport)
+void	DXTBenchmark		(LPCSTR src_dir)
+{
+	using namespace RedImageTool;
+	xr_vector<shared_str>	files;
+	DXTFindImages			(src_dir,files);
+	xr_vector<RedImage>		images;
+	for (u32 i=0; i<files.size(); i++)
+	{
+		string_path			name;
+		strconcat			(sizeof(name),name,src_dir,"\\",*files[i]);
+		images.push_back	(RedImage());
+		if (DXTLoadImage(name,images.back()))	images.back().GenerateMipmap();
+		else				images.pop_back();
+	}
+	if (images.empty())
+	{
+		Msg					("! DXT bench: no images in '%s'",src_dir);
+		return;
+	}
+
+	RedTexturePixelFormat	formats[]	= {RedTexturePixelFormat::BC1,RedTexturePixelFormat::BC3,RedTexturePixelFormat::BC5};
+	LPCSTR					format_names[]	= {"BC1","BC3","BC5"};
+	u32						channels[]	= {3,4,2};
+	LPCSTR					mode_names[]	= {"current","high","normal","fast"};
+	for (u32 f=0; f<3; f++)
+	{
+		for (u32 mode=0; mode<4; mode++)
+		{
+			float		seconds	= 0;
+			double		pixels	= 0;
+			double		error	= 0;
+			for (u32 i=0; i<images.size(); i++)
+			{
+				RedImage	Image	(images[i]);
+				CTimer		T;		T.Start();
+				if (0==mode)		Image.Convert		(formats[f]);
+				else				DXTCompressBlocks	(Image,formats[f],EDXTQuality(dxtqHigh-(mode-1)));
+				seconds				+= T.GetElapsed_sec();
+
+				Image.Convert		(RedTexturePixelFormat::R8G8B8A8);
+				const u8*	a		= (const u8*)*Image;
+				const u8*	b		= (const u8*)*images[i];
+				size_t		count	= RedTextureUtils::GetSizeInMemory(Image.GetWidth(),Image.GetHeight(),Image.GetMips(),RedTexturePixelFormat::R8G8B8A8)/4;
+				for (size_t p=0; p<count; p++, a+=4, b+=4)
+					for (u32 k=0; k<channels[f]; k++)
+					{
+						double	d	= double(int(a[k])-int(b[k]));
+						error		+= d*d;
+					}
+				pixels				+= double(count);
+			}
+			Msg	("* DXT bench: %s %-7s %8.2f MPixels/s, RMSE %.3f",format_names[f],mode_names[mode],
+				pixels/1000000.0/_max(seconds,EPS_S),_sqrt(float(error/(pixels*channels[f]))));
+		}
+	}
 }
 
 extern int DXTCompressBump(LPCSTR out_name, u8* raw_data, u8* normal_map, u32 w, u32 h, u32 pitch, STextureParams* fmt, u32 depth);
@@ -0,0 +1,277 @@
+#include "stdafx.h"
+#include "DXTBlocks.h"
+#include "ispc_texcomp/ispc_texcomp.h"
+
+using namespace RedImageTool;
+
+static const u32	band_rows		= 32;		// pixel rows in a band
+static const float	refine_error	= 24.f;		// dxtqNormal: mean squared error per channel to try the RedImage encoder
+
+EDXTQuality	DXTQuality	()
+{
+	if (strstr(Core.Params,"-dxt_fast"))	return dxtqFast;
+	if (strstr(Core.Params,"-dxt_high"))	return dxtqHigh;
+	return	dxtqNormal;
+}
+
+//--------------------------------------------------- Tasks
+struct	dxt_run
+{
+	DXTTaskFunc*		func;
+	void*				param;
+	u32					count;
+	u32					workers;
+	volatile LONG		next;
+	volatile LONG		finished;
+	HANDLE				ev_finished;
+};
+
+static void	dxt_worker	(void* P)
+{
+	dxt_run&	R		= *(dxt_run*)P;
+	for (;;)
+	{
+		u32	task		= u32(InterlockedIncrement(&R.next)-1);
+		if (task>=R.count)	break;
+		R.func			(task,R.param);
+	}
+	if (u32(InterlockedIncrement(&R.finished))==R.workers)
+		SetEvent		(R.ev_finished);
+}
+
+void	DXTRunTasks	(u32 count, DXTTaskFunc* func, void* param, bool bParallel)
+{
+	u32		workers		= bParallel?_min(_max(CPU::ID.n_threads,u32(1)),count):1;
+	if (workers<=1)
+	{
+		for (u32 task=0; task<count; task++)
+			func		(task,param);
+		return;
+	}
+
+	dxt_run	R;
+	R.func				= func;
+	R.param				= param;
+	R.count				= count;
+	R.workers			= workers;
+	R.next				= 0;
+	R.finished			= 0;
+	R.ev_finished		= CreateEvent	(NULL,TRUE,FALSE,NULL);
+	for (u32 w=0; w<workers; w++)
+		thread_spawn	(dxt_worker,"X-RAY DXT worker",0,&R);
+	WaitForSingleObject	(R.ev_finished,INFINITE);
+	CloseHandle			(R.ev_finished);
+}
+
+//--------------------------------------------------- Block decoding, for the error of dxtqNormal
+static void	decode_color	(const u8* block, u8 (&rgba)[16][4])
+{
+	u32		c0			= block[0]|(block[1]<<8);
+	u32		c1			= block[2]|(block[3]<<8);
+	int		pal[4][3];
+	for (u32 i=0; i<2; i++)
+	{
+		u32	c			= i?c1:c0;
+		u32	r			= (c>>11)&31, g = (c>>5)&63, b = c&31;
+		pal[i][0]		= (r<<3)|(r>>2);
+		pal[i][1]		= (g<<2)|(g>>4);
+		pal[i][2]		= (b<<3)|(b>>2);
+	}
+	for (u32 k=0; k<3; k++)
+	{
+		if (c0>c1)
+		{
+			pal[2][k]	= (2*pal[0][k]+pal[1][k])/3;
+			pal[3][k]	= (pal[0][k]+2*pal[1][k])/3;
+		}
+		else
+		{
+			pal[2][k]	= (pal[0][k]+pal[1][k])/2;
+			pal[3][k]	= 0;
+		}
+	}
+	u32		bits		= block[4]|(block[5]<<8)|(block[6]<<16)|(block[7]<<24);
+	for (u32 i=0; i<16; i++)
+	{
+		u32	index		= (bits>>(2*i))&3;
+		for (u32 k=0; k<3; k++)
+			rgba[i][k]	= u8(pal[index][k]);
+	}
+}
+
+static void	decode_alpha	(const u8* block, u8 (&rgba)[16][4], u32 channel)
+{
+	int		a0			= block[0], a1 = block[1];
+	int		pal[8];
+	pal[0]				= a0;
+	pal[1]				= a1;
+	if (a0>a1)
+	{
+		for (int k=2; k<8; k++)	pal[k]	= ((8-k)*a0+(k-1)*a1)/7;
+	}
+	else
+	{
+		for (int k=2; k<6; k++)	pal[k]	= ((6-k)*a0+(k-1)*a1)/5;
+		pal[6]			= 0;
+		pal[7]			= 255;
+	}
+	u64		bits		= 0;
+	for (u32 b=0; b<6; b++)
+		bits			|= u64(block[2+b])<<(8*b);
+	for (u32 i=0; i<16; i++)
+		rgba[i][channel]= u8(pal[(bits>>(3*i))&7]);
+}
+
+static float	block_error	(RedTexturePixelFormat format, const u8* block, const u8 (&src)[16][4])
+{
+	u8		rgba[16][4];
+	u32		channels;
+	switch (format)
+	{
+	case RedTexturePixelFormat::BC1:	decode_color(block,rgba);								channels = 3;	break;
+	case RedTexturePixelFormat::BC3:	decode_alpha(block,rgba,3);	decode_color(block+8,rgba);	channels = 4;	break;
+	case RedTexturePixelFormat::BC5:	decode_alpha(block,rgba,0);	decode_alpha(block+8,rgba,1);	channels = 2;	break;
+	default:							NODEFAULT;	return 0;
+	}
+	float	error		= 0;
+	for (u32 i=0; i<16; i++)
+		for (u32 k=0; k<channels; k++)
+		{
+			float	d	= float(int(rgba[i][k])-int(src[i][k]));
+			error		+= d*d;
+		}
+	return	error/float(16*channels);
+}
+
+//--------------------------------------------------- Bands
+struct	dxt_band
+{
+	u8*					src;		// R8G8B8A8 rows
+	u8*					dst;		// the blocks of these rows
+	u32					w;
+	u32					h;			// a multiple of 4 except for the smallest mips
+};
+
+struct	dxt_job
+{
+	RedTexturePixelFormat	format;
+	EDXTQuality				quality;
+	u32						block_size;
+	xr_vector<dxt_band>		bands;
+};
+
+static bool	simd_format		(RedTexturePixelFormat format)
+{
+	return	(RedTexturePixelFormat::BC1==format) || (RedTexturePixelFormat::BC3==format) || (RedTexturePixelFormat::BC5==format);
+}
+
+// the RedImage encoder on the blocks the SIMD kernel did badly, the better of the two is kept
+static void	refine_band		(dxt_job& J, dxt_band& B)
+{
+	u32		bw			= (B.w+3)/4;
+	u32		bh			= (B.h+3)/4;
+	u8		candidate	[16];
+	for (u32 by=0; by<bh; by++)
+		for (u32 bx=0; bx<bw; bx++)
+		{
+			u8	src[16][4];
+			for (u32 y=0; y<4; y++)
+				for (u32 x=0; x<4; x++)
+				{
+					u32	sx		= _min(bx*4+x,B.w-1);
+					u32	sy		= _min(by*4+y,B.h-1);
+					CopyMemory	(src[y*4+x],B.src+(sy*B.w+sx)*4,4);
+				}
+
+			u8*		block	= B.dst+(by*bw+bx)*J.block_size;
+			float	error	= block_error(J.format,block,src);
+			if (error<=refine_error)	continue;
+
+			RedTextureUtils::Convert	(J.format,RedTexturePixelFormat::R8G8B8A8,candidate,&src[0][0],4,4);
+			if (block_error(J.format,candidate,src)<error)
+				CopyMemory	(block,candidate,J.block_size);
+		}
+}
+
+static void	compress_band	(u32 task, void* param)
+{
+	dxt_job&	J		= *(dxt_job*)param;
+	dxt_band&	B		= J.bands[task];
+
+	if (dxtqHigh==J.quality || !simd_format(J.format))
+	{
+		RedTextureUtils::Convert	(J.format,RedTexturePixelFormat::R8G8B8A8,B.dst,B.src,B.w,B.h);
+		return;
+	}
+
+	// the kernels take whole blocks and R8G8 for BC5, the borders are replicated into the padding
+	u32		pw			= (B.w+3)&~3;
+	u32		ph			= (B.h+3)&~3;
+	u32		bpp			= (RedTexturePixelFormat::BC5==J.format)?2:4;
+	rgba_surface	S;
+	S.ptr				= B.src;
+	S.width				= pw;
+	S.height			= ph;
+	S.stride			= B.w*4;
+
+	xr_vector<u8>	padded;
+	if (4!=bpp || pw!=B.w || ph!=B.h)
+	{
+		padded.resize	(pw*ph*bpp);
+		for (u32 y=0; y<ph; y++)
+			for (u32 x=0; x<pw; x++)
+				CopyMemory	(&padded[(y*pw+x)*bpp],B.src+(_min(y,B.h-1)*B.w+_min(x,B.w-1))*4,bpp);
+		S.ptr			= &padded.front();
+		S.stride		= pw*bpp;
+	}
+
+	switch (J.format)
+	{
+	case RedTexturePixelFormat::BC1:	CompressBlocksBC1(&S,B.dst);	break;
+	case RedTexturePixelFormat::BC3:	CompressBlocksBC3(&S,B.dst);	break;
+	case RedTexturePixelFormat::BC5:	CompressBlocksBC5(&S,B.dst);	break;
+	default:							NODEFAULT;
+	}
+
+	if (dxtqNormal==J.quality)
+		refine_band		(J,B);
+}
+
+void	DXTCompressBlocks	(RedImage& Image, RedTexturePixelFormat Format, EDXTQuality Quality, bool bParallel)
+{
+	R_ASSERT			(RedTexturePixelFormat::R8G8B8A8==Image.GetFormat());
+	VERIFY				(RedTextureUtils::isCompressor(Format));
+
+	size_t	W			= Image.GetWidth();
+	size_t	H			= Image.GetHeight();
+	size_t	mips		= Image.GetMips();
+	size_t	depth		= Image.GetDepth();
+	RedImage	Result	(W,H,mips,depth,Format);
+
+	dxt_job	J;
+	J.format			= Format;
+	J.quality			= Quality;
+	J.block_size		= u32(RedTextureUtils::GetSizeBlock(Format));
+	for (size_t d=0; d<depth; d++)
+	{
+		for (size_t m=0; m<mips; m++)
+		{
+			u32		w	= u32(RedTextureUtils::GetMip(W,m));
+			u32		h	= u32(RedTextureUtils::GetMip(H,m));
+			u8*		src	= RedTextureUtils::GetImage((u8*)*Image,W,H,mips,d,m,RedTexturePixelFormat::R8G8B8A8);
+			u8*		dst	= RedTextureUtils::GetImage((u8*)*Result,W,H,mips,d,m,Format);
+			for (u32 y=0; y<h; y+=band_rows)
+			{
+				dxt_band	B;
+				B.src		= src+y*w*4;
+				B.dst		= dst+(y/4)*RedTextureUtils::GetCountBlock(w)*J.block_size;
+				B.w			= w;
+				B.h			= _min(band_rows,h-y);
+				J.bands.push_back	(B);
+			}
+		}
+	}
+
+	DXTRunTasks			(u32(J.bands.size()),compress_band,&J,bParallel);
+	Image.Swap			(Result);
+}
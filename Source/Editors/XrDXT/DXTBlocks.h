@@ -0,0 +1,24 @@
+#pragma once
+
+// Block compression of a whole mip chain. Every mip is cut into bands of block rows and the bands
+// of all the mips are compressed concurrently. BC1/BC3/BC5 go through the SIMD kernels of
+// ispc_texcomp unless the quality is dxtqHigh, the rest of the formats and dxtqHigh use the
+// RedImage encoders, which are the ones the single threaded path always used.
+enum EDXTQuality
+{
+	dxtqFast	= 0,	// SIMD kernels only
+	dxtqNormal,			// SIMD kernels, the blocks with a large error are tried with the RedImage encoder
+	dxtqHigh,			// RedImage encoders
+};
+
+// -dxt_fast / -dxt_high on the command line, dxtqNormal otherwise
+EDXTQuality	DXTQuality			();
+
+// Image is R8G8B8A8 with the mips already generated, it is replaced with the compressed one
+void		DXTCompressBlocks	(RedImageTool::RedImage& Image, RedImageTool::RedTexturePixelFormat Format, EDXTQuality Quality, bool bParallel=true);
+
+// Runs func(0..count-1,param) on one worker per hardware thread, in place if !bParallel.
+// This is not the CTaskPool of xrLC/xrAI: XrDXT links only xrCore and is itself linked by xrLC,
+// xrLCLight and the editors, so it can't reach their pools; the tools call it from one thread.
+typedef void DXTTaskFunc	(u32 task, void* param);
+void		DXTRunTasks			(u32 count, DXTTaskFunc* func, void* param, bool bParallel=true);
@@ -478,6 +478,9 @@ virtual	const IBoneData&_BCL	GetBoneData(u16 bone_id) const 															{ ret
 	// Main functionality
 	virtual void				CalculateBones(BOOL bForceExact	= FALSE) 												{ } // Recalculate skeleton
 	virtual void				CalculateBones_Invalidate()																{ }
+	virtual void				LL_SetUpdateBudget(u32 interval)														{ }
+	virtual u32					LL_GetUpdateBudget()																	{ return 0; }
+	virtual void				LL_SetBoneRequired(u16 bone_id, BOOL val)												{ }
 	virtual void				Callback(UpdateCallback C, void* Param) 												{ VERIFY(false); }
 
 	//	Callback: data manipulation
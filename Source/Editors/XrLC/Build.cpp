@@ -255,6 +255,7 @@ void CBuild::Run	(LPCSTR P)
 	if(g_build_options.b_net_light)
 	{
 		lc_global_data()->mu_models_calc_materials();
+		SetNetTaskGrid( !!g_build_options.b_net_grid );
 		RunNetCompileDataPrepare( );
 	}
 	StartMu						();
@@ -283,6 +284,8 @@ void CBuild::Run	(LPCSTR P)
 	lc_global_data()->vertices_isolate_and_pool_reload();
 	//****************************************** All lighting + lmaps building and saving
 #ifdef NET_CMP
+	// the MU models are lit before the lightmaps here, so their pool must not wait for Light()
+	SetLightingPoolsCompleted	();
 	mu_base.wait				(500);
 	mu_secondary.wait			(500);
 #endif
@@ -26,7 +26,10 @@ struct SBuildOptions
 	BOOL						b_radiosity;
 	BOOL						b_noise;
 	BOOL						b_net_light;
-	SBuildOptions				():b_radiosity(FALSE), b_noise(FALSE), b_net_light(FALSE) 
+	BOOL						b_lm_bench;
+	BOOL						b_lm_cache;
+	BOOL						b_net_grid;
+	SBuildOptions				():b_radiosity(FALSE), b_noise(FALSE), b_net_light(FALSE), b_lm_bench(FALSE), b_lm_cache(FALSE), b_net_grid(FALSE) 
 	{
 
 	}
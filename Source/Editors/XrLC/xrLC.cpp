@@ -4,6 +4,7 @@
 #include "math.h"
 #include "build.h"
 #include "../xrLCLight/xrLC_GlobalData.h"
+#include "../xrLCLight/net_cl_data_prepare.h"
 
 //#pragma comment(linker,"/STACK:0x800000,0x400000")
 //#pragma comment(linker,"/HEAP:0x70000000,0x10000000")
@@ -30,6 +31,10 @@ static const char* h_str =
 	"-? or -h	== this help\n"
 	"-o			== modify build options\n"
 	"-nosun		== disable sun-lighting\n"
+	"-net		== light in worker processes of this machine\n"
+	"-netgrid	== with -net, send the lighting tasks to the hxgrid agents instead\n"
+	"-lmbench	== compare packet and single ray lighting before the lightmaps\n"
+	"-lmcache	== reuse the lightmaps of the previous build where nothing around has changed\n"
 	"-f<NAME>	== compile level in GameData\\Levels\\<NAME>\\\n"
 	"\n"
 	"NOTE: The last key is required for any functionality\n";
@@ -56,6 +61,9 @@ void Startup(LPSTR     lpCmdLine)
 	if (strstr(cmd,"-gi"))								g_build_options.b_radiosity		= TRUE;
 	if (strstr(cmd,"-noise"))							g_build_options.b_noise			= TRUE;
 	if (strstr(cmd,"-net"))								g_build_options.b_net_light		= TRUE;
+	if (strstr(cmd,"-netgrid"))							g_build_options.b_net_grid		= TRUE;
+	if (strstr(cmd,"-lmbench"))							g_build_options.b_lm_bench		= TRUE;
+	if (strstr(cmd,"-lmcache"))							g_build_options.b_lm_cache		= TRUE;
 	VERIFY( lc_global_data() );
 	lc_global_data()->b_nosun_set						( !!strstr(cmd,"-nosun") );
 	//if (strstr(cmd,"-nosun"))							b_nosun			= TRUE;
@@ -167,6 +175,22 @@ int APIENTRY WinMain(HINSTANCE hInst,
 
 	// Initialize debugging
 	Debug._initialize	(false);
+
+	// a worker process of -net, the tasks come over the pipes of the compiler
+	if (strstr(lpCmdLine,"-networker"))
+	{
+		u32		from = 0, to = 0, index = 0;
+		sscanf				(strstr(lpCmdLine,"-networker")+10,"%u %u %u",&from,&to,&index);
+		string64			app;
+		xr_sprintf			(app,"xrLC_worker%d",index);
+		Core._initialize	(app);
+		if(strstr(Core.Params,"-nosmg"))
+			g_using_smooth_groups = false;
+		int		result		= RunNetLocalWorker(lpCmdLine);
+		Core._destroy		();
+		return result;
+	}
+
 	Core._initialize	("xrLC");
 	
 	if(strstr(Core.Params,"-nosmg"))
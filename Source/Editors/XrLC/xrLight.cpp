@@ -11,62 +11,33 @@
 //#include "../xrLCLight/net_task_manager.h"
 #include "../xrLCLight/lcnet_task_manager.h"
 #include "../xrLCLight/mu_model_light.h"
-xrCriticalSection	task_CS
-#ifdef PROFILE_CRITICAL_SECTIONS
-	(MUTEX_PROFILE_ID(task_C_S))
-#endif // PROFILE_CRITICAL_SECTIONS
-;
-
+#include "../xrLCLight/xrLightmapCache.h"
 xr_vector<int>		task_pool;
 
-class CLMThread		: public CThread
+// per worker: the lighting of a deflector needs its own hash, collider and lights
+struct	lm_worker
 {
-private:
 	HASH			H;
 	CDB::COLLIDER	DB;
 	base_lighting	LightsSelected;
-public:
-	CLMThread	(u32 ID) : CThread(ID)
-	{
-		// thMonitor= TRUE;
-		thMessages	= FALSE;
-	}
+	u64				rays;
 
-	virtual void	Execute()
-	{
-		CDeflector* D	= 0;
-
-		for (;;) 
-		{
-			// Get task
-			task_CS.Enter		();
-			thProgress			= 1.f - float(task_pool.size())/float(lc_global_data()->g_deflectors().size());
-			if (task_pool.empty())	
-			{
-				task_CS.Leave		();
-				return;
-			}
-
-			D					= lc_global_data()->g_deflectors()[task_pool.back()];
-			task_pool.pop_back	();
-			task_CS.Leave		();
-
-			// Perform operation
-			try {
-				D->Light	(&DB,&LightsSelected,H);
-			} catch (...)
-			{
-				clMsg("* ERROR: CLMThread::Execute - light");
-			}
-		}
-	}
+	lm_worker		() : rays(0)	{}
 };
 
+static void	lm_task		(u32 task, u32 worker, void* param)
+{
+	lm_worker&	W		= *((lm_worker**)param)[worker];
+	CDeflector* D		= lc_global_data()->g_deflectors()[task_pool[task]];
+	u64			rays	= LightPoint_Rays();
+	D->Light			(&W.DB,&W.LightsSelected,W.H);
+	W.rays				+= LightPoint_Rays()-rays;
+}
 
-
-
-
-
+static bool	cmp_weight	(int d1, int d2)
+{
+	return	lc_global_data()->g_deflectors()[d1]->weight() > lc_global_data()->g_deflectors()[d2]->weight();
+}
 
 void	CBuild::LMapsLocal				()
 {
@@ -74,11 +45,7 @@ void	CBuild::LMapsLocal				()
 		
 		mem_Compact		();
 
-		// Randomize deflectors
-#ifndef NET_CMP
-		std::random_shuffle	(lc_global_data()->g_deflectors().begin(),lc_global_data()->g_deflectors().end());
-#endif
-
+		task_pool.clear	();
 #ifndef NET_CMP	
 for(u32 dit = 0; dit<lc_global_data()->g_deflectors().size(); dit++)	
 		task_pool.push_back(dit);
@@ -86,16 +53,33 @@ for(u32 dit = 0; dit<lc_global_data()->g_deflectors().size(); dit++)
 		task_pool.push_back(14);
 		task_pool.push_back(16);
 #endif
-		
+		// the largest lightmaps first, the small ones fill the gaps at the end
+		std::sort		(task_pool.begin(),task_pool.end(),cmp_weight);
+
+		if (g_build_options.b_lm_bench)	{
+			Status		("Lighting benchmark...");
+			LightPoint_Benchmark	(20000);
+		}
+
+		if (g_build_options.b_lm_cache)	{
+			Status		("Lighting cache...");
+			lm_cache	= xr_new<CLightmapCache>	(pBuild->path);
+		}
 
-		// Main process (4 threads)
+		// Main process
 		Status			("Lighting...");
-		CThreadManager	threads;
-		const	u32	thNUM	= 6;
-		CTimer	start_time;	start_time.Start();				
-		for				(int L=0; L<thNUM; L++)	threads.start(xr_new<CLMThread> (L));
-		threads.wait	(500);
-		clMsg			("%f seconds",start_time.GetElapsed_sec());
+		xr_vector<lm_worker*>	workers	(CTaskPool::workers());
+		for (u32 it=0; it<workers.size(); it++)	workers[it]	= xr_new<lm_worker>	();
+		CTimer			T;	T.Start	();
+		CTaskPool::run	("LIGHT: LMaps",task_pool.size(),lm_task,&*workers.begin());
+		float			sec	= T.GetElapsed_sec();
+		u64				rays= 0;
+		for (u32 it=0; it<workers.size(); it++)	{
+			rays		+= workers[it]->rays;
+			xr_delete	(workers[it]);
+		}
+		clMsg			("* LIGHT: LMaps: %I64u shadow rays, %f seconds, %.0f rays/sec",rays,sec,sec>0?float(rays)/sec:0.f);
+		xr_delete		(lm_cache);
 }
 
 void	CBuild::LMaps					()
@@ -142,8 +126,8 @@ void CBuild::Light()
 
 	LightVertex		();
 
-//
-	
+	// the MU models are lit on the task pool from here on
+	SetLightingPoolsCompleted();
 
 	ImplicitNetWait();
 	WaitMuModelsLocalCalcLightening();
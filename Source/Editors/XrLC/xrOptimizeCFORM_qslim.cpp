@@ -2,12 +2,15 @@
 #include "build.h"
 #include "../XrQSlim/MxStdModel.h"
 #include "../XrQSlim/MxQSlim.h"
+#include "../XrQSlim/MxPartitionSlim.h"
+#include "../xrLCLight/xrThread.h"
 #include "../../xrcdb/xrcdb.h"
 #include "../XrECore/Editor/face_smoth_flags.h"
 
 
 #define MAX_DECIMATE_ERROR 0.0005f
 #define COMPACTNESS_RATIO  0.001f
+#define CFORM_PART_FACES   65536
 
 void SaveAsSMF			(LPCSTR fname, CDB::CollectorPacked& CL)
 {
@@ -63,49 +66,21 @@ bool do_constrain(u32 base_edge_idx, u32 test_edg_idx, face_props& base_fprops,
 
 DEFINE_VECTOR(face_props,FPVec,FPVecIt);
 
-void SimplifyCFORM		(CDB::CollectorPacked& CL)
+// policies, initialize() and the constraints of a cluster or the seam, FPs are the ones of the input faces
+static void cform_setup	(MxEdgeQSlim& slim, const u32* source, void* param)
 {
-	FPVec FPs;
-
-	u32 base_verts_cnt		= u32(CL.getVS());
-	u32 base_faces_cnt		= u32(CL.getTS());
-
-	// save source SMF
-	bool					keep_temp_files = !!strstr(Core.Params,"-keep_temp_files");
-	if (keep_temp_files) {
-		string_path			fn;
-		SaveAsSMF			(strconcat(sizeof(fn),fn,pBuild->path,"cform_source.smf"),CL);
-	}
-
-	// prepare model
-	MxStdModel* mdl			= xr_new<MxStdModel>(base_verts_cnt,base_faces_cnt);
-
-	// transfer vertices
-	for (u32 v_idx=0; v_idx<base_verts_cnt; v_idx++){
-		Fvector* v			= CL.getV()+v_idx;
-		mdl->add_vertex		(v->x,v->y,v->z);
-	}
-	// transfer faces
-	FPs.resize				(base_faces_cnt);
-	for (u32 f_idx=0; f_idx<base_faces_cnt; f_idx++){
-		CDB::TRI& t			= CL.getT(f_idx);
-		mdl->add_face		(t.verts[0],t.verts[1],t.verts[2]);
-		FPs[f_idx].set		(t.material,t.sector,Fvector().mknormal(*(CL.getV()+t.verts[0]),*(CL.getV()+t.verts[1]),*(CL.getV()+t.verts[2])), CL.getfFlags(f_idx));
-	}
-	CL.clear				();
-
-	// create and initialize qslim
-	MxEdgeQSlim* slim		= xr_new<MxEdgeQSlim>(mdl);
-	slim->boundary_weight	= 1000000.f;
-	slim->compactness_ratio	= COMPACTNESS_RATIO;
-	slim->meshing_penalty	= 1000000.f;
-	slim->placement_policy	= MX_PLACE_ENDPOINTS;//MX_PLACE_ENDPOINTS;//MX_PLACE_ENDORMID;//MX_PLACE_OPTIMAL;
-	slim->weighting_policy	= MX_WEIGHT_UNIFORM;//MX_WEIGHT_UNIFORM;//MX_WEIGHT_AREA;
-	slim->initialize		();
+	FPVec& FPs				= *(FPVec*)param;
+	MxStdModel* mdl			= &slim.model();
+	slim.boundary_weight	= 1000000.f;
+	slim.compactness_ratio	= COMPACTNESS_RATIO;
+	slim.meshing_penalty	= 1000000.f;
+	slim.placement_policy	= MX_PLACE_ENDPOINTS;//MX_PLACE_ENDPOINTS;//MX_PLACE_ENDORMID;//MX_PLACE_OPTIMAL;
+	slim.weighting_policy	= MX_WEIGHT_UNIFORM;//MX_WEIGHT_UNIFORM;//MX_WEIGHT_AREA;
+	slim.initialize			();
 
 	// constraint material&sector vertex
 	Ivector2 f_rm[3]={{0,1}, {1,2}, {2,0}};
-	for (u32 f_idx=0; f_idx<slim->valid_faces; f_idx++){
+	for (u32 f_idx=0; f_idx<slim.valid_faces; f_idx++){
 		if (mdl->face_is_valid(f_idx)){
 			MxFace& base_f				= mdl->face(f_idx);
 			for (u32 edge_idx=0; edge_idx<3; edge_idx++){
@@ -118,16 +93,15 @@ void SimplifyCFORM		(CDB::CollectorPacked& CL)
 				for(K=0; K<N0.length(); K++) mdl->face_mark(N0[K], 1);
 				for(K=0; K<N1.length(); K++) mdl->face_mark(N1[K], mdl->face_mark(N1[K])+1);
 				const MxFaceList& N		= (N0.size()<N1.size())?N0:N1;
-				face_props& base_t		= FPs[f_idx];
+				face_props& base_t		= FPs[source[f_idx]];
 				if (N.size()){
 					u32 cnt_pos=0, cnt_neg=0;
 					bool need_constraint= false;
 					for(K=0; K<N.length(); K++){
 						u32 fff			= N[K];
 						MxFace& cur_f	= mdl->face(fff);
-						unsigned char mk= mdl->face_mark(fff);
 						if((f_idx!=N[K])&&(mdl->face_mark(N[K])==2)){
-							face_props& cur_t	= FPs[N[K]];
+							face_props& cur_t	= FPs[source[N[K]]];
 							u32 cur_edge_idx = common_edge_idx( base_f, edge_idx, cur_f );
 							if (do_constrain(edge_idx,cur_edge_idx,base_t,cur_t)){
 								need_constraint	= true;
@@ -139,39 +113,70 @@ void SimplifyCFORM		(CDB::CollectorPacked& CL)
 						}
 					}
 					if (need_constraint||((0==cnt_pos)&&(1==cnt_neg))){
-						slim->constraint_manual	(base_f[I],base_f[J],f_idx);
+						slim.constraint_manual	(base_f[I],base_f[J],f_idx);
 					}
 				}
 			}
 		}
 	}
-	// collect edges
-	slim->collect_edges		();
+}
+
+static void cform_run	(LPCSTR phase, u32 count, MxPartitionSlim::task_func* task, void* param)
+{
+	CTaskPool::run		(phase,count,task,param);
+}
+
+void SimplifyCFORM		(CDB::CollectorPacked& CL)
+{
+	FPVec FPs;
+
+	u32 base_verts_cnt		= u32(CL.getVS());
+	u32 base_faces_cnt		= u32(CL.getTS());
+	if (0==base_faces_cnt)	return;
+
+	// save source SMF
+	bool					keep_temp_files = !!strstr(Core.Params,"-keep_temp_files");
+	if (keep_temp_files) {
+		string_path			fn;
+		SaveAsSMF			(strconcat(sizeof(fn),fn,pBuild->path,"cform_source.smf"),CL);
+	}
 
-	// decimate
-	slim->decimate			(0,MAX_DECIMATE_ERROR);
-	mdl->compact_vertices	();
+	// transfer faces
+	xr_vector<Fvector> verts(CL.getV(),CL.getV()+base_verts_cnt);
+	xr_vector<u32> faces	(base_faces_cnt*3);
+	FPs.resize				(base_faces_cnt);
+	for (u32 f_idx=0; f_idx<base_faces_cnt; f_idx++){
+		CDB::TRI& t			= CL.getT(f_idx);
+		for (u32 k=0; k<3; k++)
+			faces[f_idx*3+k]= t.verts[k];
+		FPs[f_idx].set		(t.material,t.sector,Fvector().mknormal(verts[t.verts[0]],verts[t.verts[1]],verts[t.verts[2]]), CL.getfFlags(f_idx));
+	}
+	CL.clear				();
+
+	// clusters in parallel with their borders locked, then the seam
+	CTimer T;				T.Start();
+	MxPartitionSlim slim;
+	slim.part_faces			= CFORM_PART_FACES;
+	slim.setup				= cform_setup;
+	slim.setup_param		= &FPs;
+	slim.run				= cform_run;
+	slim.decimate			(&verts.front(),base_verts_cnt,&faces.front(),base_faces_cnt,MAX_DECIMATE_ERROR);
+	xr_vector<Fvector>().swap(verts);
+	xr_vector<u32>().swap	(faces);
 
 	// rebuild CDB
-	for (u32 f_idx=0; f_idx<mdl->face_count(); f_idx++){
-		if (mdl->face_is_valid(f_idx)){
-			MxFace& F		= mdl->face(f_idx);
-			face_props& FP	= FPs[f_idx];
-			CL.add_face		(*((Fvector*)&mdl->vertex(F[0])),
-							*((Fvector*)&mdl->vertex(F[1])),
-							*((Fvector*)&mdl->vertex(F[2])),
+	for (u32 f_idx=0; f_idx<u32(slim.out_source.size()); f_idx++){
+		const u32* F		= &slim.out_faces[f_idx*3];
+		face_props& FP		= FPs[slim.out_source[f_idx]];
+		CL.add_face			(slim.out_verts[F[0]],slim.out_verts[F[1]],slim.out_verts[F[2]],
 							FP.material, FP.sector,FP.flags);
-		}
 	}
-
+	clMsg					("* CFORM: %d -> %d faces, %d clusters, %d border vertices, %d seam faces, %f seconds",
+		base_faces_cnt,u32(slim.out_source.size()),slim.parts,slim.border_verts,slim.seam_faces,T.GetElapsed_sec());
 
 	// save source CDB
 	if (keep_temp_files) {
 		string_path			fn;
 		SaveAsSMF			(strconcat(sizeof(fn),fn,pBuild->path,"cform_optimized.smf"),CL);
 	}
-
- 	xr_delete				(slim);
-	xr_delete				(mdl);
 }
-
@@ -7,24 +7,19 @@
 #include "lightthread.h"
 #include "xrLightDoNet.h"
 
-#define NUM_THREADS		3
+// a row of the slots is a task, the thread object only runs it on the worker
+static void	light_row_task	(u32 task, u32 worker, void* param)
+{
+	LightThread				T(worker,task,task+1);
+	T.Execute				();
+}
 
 void	xrLight			()
 {
 	u32	range				= gl_data.slots_data.size_z();
 
-	// Start threads, wait, continue --- perform all the work
-	CThreadManager		Threads;
 	CTimer				start_time;
-	u32	stride			= range/NUM_THREADS;
-	u32	last			= range-stride*	(NUM_THREADS-1);
-	for (u32 thID=0; thID<NUM_THREADS; thID++)	{
-		CThread*	T		= xr_new<LightThread> (thID,thID*stride,thID*stride+((thID==(NUM_THREADS-1))?last:stride));
-		T->thMessages		= FALSE;
-		T->thMonitor		= FALSE;
-		Threads.start		(T);
-	}
-	Threads.wait			();
+	CTaskPool::run			("Lighting nodes",range,light_row_task,0);
 	Msg						("%d seconds elapsed.",(start_time.GetElapsed_ms())/1000);
 }
 
@@ -90,9 +90,8 @@ IC bool RayPick(CDB::COLLIDER& DB, Fvector& P, Fvector& D, float r, R_Light& L)
 	}
 }
 
-float getLastRP_Scale(CDB::COLLIDER* DB, R_Light& L)//, Face* skip)
+float getLastRP_Scale(CDB::RESULT* results, u32 tris_count, R_Light& L)//, Face* skip)
 {
-	u32	tris_count		= DB->r_count();
 	float	scale		= 1.f;
 	Fvector B;
 
@@ -100,7 +99,7 @@ float getLastRP_Scale(CDB::COLLIDER* DB, R_Light& L)//, Face* skip)
 	{
 		for (u32 I=0; I<tris_count; I++)
 		{
-			CDB::RESULT& rpinf = DB->r_begin()[I];
+			CDB::RESULT& rpinf = results[I];
 			// Access to texture
 			CDB::TRI& clT								= gl_data.RCAST_Model.get_tris()[rpinf.id];
 			b_rc_face& F								= gl_data.g_rc_faces[rpinf.id];
@@ -162,6 +161,11 @@ float getLastRP_Scale(CDB::COLLIDER* DB, R_Light& L)//, Face* skip)
 	return scale;
 }
 
+float getLastRP_Scale(CDB::COLLIDER* DB, R_Light& L)//, Face* skip)
+{
+	return	getLastRP_Scale	(DB->r_begin(),DB->r_count(),L);
+}
+
 float rayTrace	(CDB::COLLIDER* DB, R_Light& L, Fvector& P, Fvector& D, float R)//, Face* skip)
 {
 	R_ASSERT	(DB);
@@ -185,8 +189,67 @@ float rayTrace	(CDB::COLLIDER* DB, R_Light& L, Fvector& P, Fvector& D, float R)/
 	return 0;
 }
 
+// The shadow rays of a point go as one packet, a light adds 'k*visibility*m' when it comes back
+struct	dp_ray
+{
+	R_Light*		L;
+	float*			dest;			// rgb (with the diffuse), sun or hemi
+	BOOL			rgb;
+	float			k,m;
+	int				slot;			// in the packet, -1 - the cached polygon shadows it
+};
+
+struct	dp_packet
+{
+	CDB::RAY_PACKET	rays;
+	dp_ray			list	[CDB::rpMaxRays];
+	u32				count;
+	CDB::COLLIDER*	DB;
+
+	dp_packet		(CDB::COLLIDER* _DB) : count(0), DB(_DB)	{}
+
+	void			trace	(R_Light* L, float* dest, BOOL rgb, float k, float m, const Fvector& P, const Fvector& D, float R)
+	{
+		if (count==CDB::rpMaxRays)	flush	();
+		dp_ray&		r	= list[count++];
+		r.L				= L;
+		r.dest			= dest;
+		r.rgb			= rgb;
+		r.k				= k;
+		r.m				= m;
+		r.slot			= -1;
+
+		// the cached polygon first, as rayTrace does
+		float _u,_v,range;
+		if (CDB::TestRayTri(P,D,L->tri,_u,_v,range,false) && range>0 && range<R)	return;
+		r.slot			= rays.add	(P,D,R);
+	}
+	void			flush	()
+	{
+		if (rays.count)	DB->ray_packet	(&gl_data.RCAST_Model,rays);
+		for (u32 it=0; it<count; it++)
+		{
+			dp_ray&		r	= list[it];
+			float		vis	= 0;
+			if (r.slot>=0)	vis	= rays.hits[r.slot]?getLastRP_Scale(DB->r_begin()+rays.first[r.slot],rays.hits[r.slot],*r.L):1.f;
+
+			float		A	= r.k*vis*r.m;
+			if (r.rgb)	{
+				r.dest[0]	+= A * r.L->diffuse.x;
+				r.dest[1]	+= A * r.L->diffuse.y;
+				r.dest[2]	+= A * r.L->diffuse.z;
+			} else {
+				r.dest[0]	+= A;
+			}
+		}
+		count			= 0;
+		rays.clear		();
+	}
+};
+
 void LightPoint(CDB::COLLIDER* DB, base_color &C, Fvector &P, Fvector &N, base_lighting& lights, u32 flags)
 {
+	dp_packet	packet	(DB);
 	Fvector		Ldir,Pnew;
 	Pnew.mad	(P,N,0.01f);
 
@@ -201,11 +264,7 @@ void LightPoint(CDB::COLLIDER* DB, base_color &C, Fvector &P, Fvector &N, base_l
 				float D		= Ldir.dotproduct( N );
 				if( D <=0 ) continue;
 
-				// Trace Light
-				float scale	=	D*L->energy*rayTrace(DB,*L,Pnew,Ldir,1000.f);
-				C.rgb.x		+=	scale * L->diffuse.x; 
-				C.rgb.y		+=	scale * L->diffuse.y;
-				C.rgb.z		+=	scale * L->diffuse.z;
+				packet.trace	(L,&C.rgb.x,TRUE,D*L->energy,1.f,Pnew,Ldir,1000.f);
 			} else {
 				// Distance
 				float sqD	=	P.distance_to_sqr	(L->position);
@@ -217,14 +276,8 @@ void LightPoint(CDB::COLLIDER* DB, base_color &C, Fvector &P, Fvector &N, base_l
 				float D		= Ldir.dotproduct( N );
 				if( D <=0 ) continue;
 
-				// Trace Light
 				float R		= _sqrt(sqD);
-				float scale = D*L->energy*rayTrace(DB,*L,Pnew,Ldir,R);
-				float A		= scale / (L->attenuation0 + L->attenuation1*R + L->attenuation2*sqD);
-
-				C.rgb.x += A * L->diffuse.x;
-				C.rgb.y += A * L->diffuse.y;
-				C.rgb.z += A * L->diffuse.z;
+				packet.trace	(L,&C.rgb.x,TRUE,D*L->energy,1/(L->attenuation0 + L->attenuation1*R + L->attenuation2*sqD),Pnew,Ldir,R);
 			}
 		}
 	}
@@ -239,9 +292,7 @@ void LightPoint(CDB::COLLIDER* DB, base_color &C, Fvector &P, Fvector &N, base_l
 				float D		= Ldir.dotproduct( N );
 				if( D <=0 ) continue;
 
-				// Trace Light
-				float scale	=	L->energy*rayTrace(DB,*L,Pnew,Ldir,1000.f);
-				C.sun		+=	scale;
+				packet.trace	(L,&C.sun,FALSE,L->energy,1.f,Pnew,Ldir,1000.f);
 			} else {
 				// Distance
 				float sqD	=	P.distance_to_sqr(L->position);
@@ -253,12 +304,8 @@ void LightPoint(CDB::COLLIDER* DB, base_color &C, Fvector &P, Fvector &N, base_l
 				float D				= Ldir.dotproduct( N );
 				if( D <=0 )			continue;
 
-				// Trace Light
 				float R		=	_sqrt(sqD);
-				float scale =	D*L->energy*rayTrace(DB,*L,Pnew,Ldir,R);
-				float A		=	scale / (L->attenuation0 + L->attenuation1*R + L->attenuation2*sqD);
-
-				C.sun		+=	A;
+				packet.trace	(L,&C.sun,FALSE,D*L->energy,1/(L->attenuation0 + L->attenuation1*R + L->attenuation2*sqD),Pnew,Ldir,R);
 			}
 		}
 	}
@@ -273,10 +320,8 @@ void LightPoint(CDB::COLLIDER* DB, base_color &C, Fvector &P, Fvector &N, base_l
 				float D		= Ldir.dotproduct( N );
 				if( D <=0 ) continue;
 
-				// Trace Light
 				Fvector		PMoved;	PMoved.mad	(Pnew,Ldir,0.001f);
-				float scale	=	L->energy*rayTrace(DB,*L,PMoved,Ldir,1000.f);
-				C.hemi		+=	scale;
+				packet.trace	(L,&C.hemi,FALSE,L->energy,1.f,PMoved,Ldir,1000.f);
 			} else {
 				// Distance
 				float sqD	=	P.distance_to_sqr(L->position);
@@ -288,15 +333,12 @@ void LightPoint(CDB::COLLIDER* DB, base_color &C, Fvector &P, Fvector &N, base_l
 				float D		=	Ldir.dotproduct( N );
 				if( D <=0 ) continue;
 
-				// Trace Light
 				float R		=	_sqrt(sqD);
-				float scale =	D*L->energy*rayTrace(DB,*L,Pnew,Ldir,R);
-				float A		=	scale / (L->attenuation0 + L->attenuation1*R + L->attenuation2*sqD);
-
-				C.hemi		+=	A;
+				packet.trace	(L,&C.hemi,FALSE,D*L->energy,1/(L->attenuation0 + L->attenuation1*R + L->attenuation2*sqD),Pnew,Ldir,R);
 			}
 		}
 	}
+	packet.flush	();
 }
 
 
@@ -8,6 +8,8 @@
 #include "net_global_data_cleanup.h"
 
 #include "net_exec_pool.h"
+#include "net_exec_local.h"
+#include "xrThread.h"
 
 namespace	lc_net{
 
@@ -30,7 +32,7 @@ namespace	lc_net{
 
 	task_manager:: task_manager( ):
 	 _user(0), tasks_completed( 0 ), current_pool( 0 ), 
-	start( 0 ), session_id( DWORD(-1) ), _release( false )
+	start( 0 ), session_id( DWORD(-1) ), _release( false ), _grid( false )
 	{
 		for(u8 i = 0; i < num_pools; ++i )
 			 pools[i] = 0;
@@ -93,20 +95,28 @@ namespace	lc_net{
 	{
 		start_time.Start();
 		tasks_completed  = 0;
-		//create_user( );
-		thread_spawn	(task_manager::user_thread_proc,"release-user",1024*1024,this);
-		for(;;)
+		if( !_grid )
 		{
-			Sleep(1);
-			bool user_inited = false;
-			init_lock.Enter();
-			user_inited = !!_user;
-			init_lock.Leave();
-			if( user_inited )
-				break;
+			if( !get_exec_local().running() )
+				get_exec_local().startup( CTaskPool::workers() );
+		}
+		else
+		{
+			//create_user( );
+			thread_spawn	(task_manager::user_thread_proc,"release-user",1024*1024,this);
+			for(;;)
+			{
+				Sleep(1);
+				bool user_inited = false;
+				init_lock.Enter();
+				user_inited = !!_user;
+				init_lock.Leave();
+				if( user_inited )
+					break;
+			}
+
+			R_ASSERT( _user );
 		}
-
-		R_ASSERT( _user );
 		FPU::m64r		();
 		Memory.mem_compact	();
 	}
@@ -169,8 +179,16 @@ namespace	lc_net{
 
 		pool_lock.Leave();
 
+		if( !_grid )
+		{
+			// the workers were stopped by release() of the previous phase
+			if( !get_exec_local().running() )
+				get_exec_local().startup( CTaskPool::workers() );
+			pools[lrun]->run(  0,  lrun );
+			return pools[lrun];
+		}
 		R_ASSERT( _user );
-		pools[lrun]->run(  *_user,  lrun );
+		pools[lrun]->run(  _user,  lrun );
 		return pools[lrun]; 
 		
 	}
@@ -214,6 +232,15 @@ namespace	lc_net{
 	{
 		for(u8 i = 0; i < num_pools; ++i )
 				R_ASSERT( !(pools[i]) || !(pools[i]->is_running()) );
+		if( !_grid )
+		{
+			get_exec_local().release();
+			init_lock.Enter();
+			for(u8 i = 0; i < num_pools; ++i )
+				xr_delete( pools[i] );
+			init_lock.Leave();
+			return;
+		}
 		init_lock.Enter();
 		_release = true;
 		init_lock.Leave();
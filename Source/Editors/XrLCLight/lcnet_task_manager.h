@@ -29,6 +29,7 @@ namespace	lc_net
 		DWORD						session_id;
 		u32							tasks_completed;
 		bool						_release;
+		bool						_grid;
 		xrCriticalSection			pool_lock;
 		xrCriticalSection			log_lock;
 		xrCriticalSection			init_lock;
@@ -51,6 +52,7 @@ virtual bool			run_task		(	 IAgent* agent,
 		void					add_task( net_execution* task );
 		void					startup();
 		void					progress( u32 task );
+		void					use_grid( bool grid )	{ _grid = grid; }
 	private:
 		void					release_user( );
 		void					create_user( );
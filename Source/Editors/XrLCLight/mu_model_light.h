@@ -6,5 +6,6 @@ extern XRLC_LIGHT_API	void	wait_mu_base		();
 extern XRLC_LIGHT_API	void	wait_mu_secondary	();
 extern XRLC_LIGHT_API	void	wait_mu_secondary_thread();
 extern XRLC_LIGHT_API	void	WaitMuModelsLocalCalcLightening();
+extern XRLC_LIGHT_API	void	SetLightingPoolsCompleted();
 extern bool	mu_light_net;
 #endif
\ No newline at end of file
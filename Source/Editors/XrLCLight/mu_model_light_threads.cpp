@@ -19,8 +19,6 @@
 
 
 CThreadManager			mu_base;
-CThreadManager			mu_secondary;
-#define		MU_THREADS	4
 // mu-light
 bool mu_models_local_calc_lightening = false;
 xrCriticalSection		mu_models_local_calc_lightening_wait_lock;
@@ -43,28 +41,24 @@ void SetMuModelsLocalCalcLighteningCompleted()
 	mu_models_local_calc_lightening = true;
 	mu_models_local_calc_lightening_wait_lock.Leave();
 }
-class CMULight	: public CThread
+// the MU pool waits for the implicit, lightmap and vertex pools, so the two never share the hardware threads
+static HANDLE			mu_lighting_pools_done	= NULL;
+void SetLightingPoolsCompleted()
 {
-	u32			low;
-	u32			high;
-public:
-	CMULight	(u32 ID, u32 _low, u32 _high) : CThread(ID)	{	thMessages	= FALSE; low=_low; high=_high;	}
-
-	virtual void	Execute	()
-	{
-		// Priority
-		SetThreadPriority	(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
-		Sleep				(0);
+	if (mu_lighting_pools_done)
+		SetEvent			(mu_lighting_pools_done);
+}
+// every model builds its own collision model, so the models and then the references are independent tasks
+static void	mu_model_task	(u32 task, u32 worker, void* param)
+{
+	inlc_global_data()->mu_models()[task]->calc_materials();
+	inlc_global_data()->mu_models()[task]->calc_lighting	();
+}
 
-		// Light references
-		for (u32 m=low; m<high; m++)
-		{
-		
-			inlc_global_data()->mu_refs()[m]->calc_lighting	();
-			thProgress							= (float(m-low)/float(high-low));
-		}
-	}
-};
+static void	mu_ref_task		(u32 task, u32 worker, void* param)
+{
+	inlc_global_data()->mu_refs()[task]->calc_lighting	();
+}
 
 
 	//void LC_WaitRefModelsNet();
@@ -94,40 +88,35 @@ public:
 			//lc_net::WaitRefModelsNet();
 		} 
 		
-		for (u32 m=0; m<inlc_global_data()->mu_models().size(); m++)
-		{
-			inlc_global_data()->mu_models()[m]->calc_materials();
-			inlc_global_data()->mu_models()[m]->calc_lighting	();
-		}
-
+		// the lightmaps report the progress, the references run along with the merging phases
+		WaitForSingleObject	(mu_lighting_pools_done,INFINITE);
+		CTaskPool::run		("LIGHT: MU models",inlc_global_data()->mu_models().size(),mu_model_task,0,FALSE);
 
 		SetMuModelsLocalCalcLighteningCompleted();
 
 		// Light references
-		u32	stride			= inlc_global_data()->mu_refs().size()/MU_THREADS;
-		u32	last			= inlc_global_data()->mu_refs().size()-stride*(MU_THREADS-1);
-		u32 threads = MU_THREADS;
-		get_intervals( MU_THREADS, inlc_global_data()->mu_refs().size(), threads, stride, last );
-
-		for (u32 thID=0; thID<threads; thID++)
-			mu_secondary.start	( xr_new<CMULight> (thID,thID*stride,thID*stride + stride ) );
-		if(last > 0)
-			mu_secondary.start	( xr_new<CMULight> (threads,threads*stride,threads*stride + last ) );
+		CTaskPool::run		("LIGHT: MU references",inlc_global_data()->mu_refs().size(),mu_ref_task,0,FALSE);
 	}
 };
 
 
 void	run_mu_base( bool net )
 {
-	
+	mu_lighting_pools_done		= CreateEvent	(NULL,TRUE,FALSE,NULL);
 	mu_base.start				(xr_new<CMUThread> (0));
 }
 
 void	wait_mu_base_thread		()
 {
 	mu_base.wait				(500);
+	if (mu_lighting_pools_done)
+	{
+		CloseHandle				(mu_lighting_pools_done);
+		mu_lighting_pools_done	= NULL;
+	}
 }
 void	wait_mu_secondary_thread	()
 {
-	mu_secondary.wait			(500);
+	// the references are lit by the base thread itself now
+	mu_base.wait				(500);
 }
\ No newline at end of file
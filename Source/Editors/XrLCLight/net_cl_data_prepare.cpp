@@ -97,6 +97,11 @@ void		SartupNetTaskManager( )
 	lc_net::get_task_manager().startup();
 }
 
+void		SetNetTaskGrid( bool grid )
+{
+	lc_net::get_task_manager().use_grid( grid );
+}
+
 extern u32		vertises_has_lighting;
 u32 CalcAllTranslucency();
 
@@ -3,6 +3,8 @@
 	XRLC_LIGHT_API  void				SetGlobalCompileDataInitialized( );
 	XRLC_LIGHT_API  void				SetGlobalLightmapsDataInitialized( );
 	XRLC_LIGHT_API  void				SartupNetTaskManager( );
+	XRLC_LIGHT_API  void				SetNetTaskGrid( bool grid );
+	XRLC_LIGHT_API  int					RunNetLocalWorker( LPCSTR params );
 	XRLC_LIGHT_API  void				RunNetCompileDataPrepare( );
 	XRLC_LIGHT_API  void				WaitNetCompileDataPrepare( );
 					void				SetRefModelLightDataInitialized( );
@@ -0,0 +1,498 @@
+#include "stdafx.h"
+#include "net_exec_local.h"
+
+#include "net_stream.h"
+#include "lightstab_interface.h"
+#include "net_cl_data_prepare.h"
+
+namespace lc_net
+{
+	void __cdecl Finalize				( IGenericStream* inStream );
+	void __cdecl data_cleanup_callback	( const char* dataDesc, IGenericStream** stream );
+
+	static const DWORD	local_session	= 1;
+	static bool			is_local_worker	= false;
+	static const u32	reply_timeout	= 30*60*1000;	// ms, a worker silent for longer is hung
+
+	enum
+	{
+		lm_task,
+		lm_data,
+		lm_result,
+		lm_quit
+	};
+	enum
+	{
+		lr_done,
+		lr_refused,
+		lr_broken
+	};
+
+	static bool	pipe_write	( HANDLE h, const void* p, u32 size )
+	{
+		const u8	*b = (const u8*)p;
+		while( size )
+		{
+			DWORD	n	= 0;
+			if( !WriteFile( h, b, size, &n, 0 ) )
+				return false;
+			b			+= n;
+			size		-= n;
+		}
+		return true;
+	}
+	static bool	pipe_read	( HANDLE h, void* p, u32 size )
+	{
+		u8			*b = (u8*)p;
+		while( size )
+		{
+			DWORD	n	= 0;
+			if( !ReadFile( h, b, size, &n, 0 ) || n==0 )
+				return false;
+			b			+= n;
+			size		-= n;
+		}
+		return true;
+	}
+	static bool	pipe_write_stream( HANDLE h, IGenericStream* s )
+	{
+		u32			size = s ? s->GetLength() : 0;
+		return		pipe_write( h, &size, sizeof(size) ) && ( !size || pipe_write( h, s->GetBasePointer(), size ) );
+	}
+	static IGenericStream*	pipe_read_stream( HANDLE h )
+	{
+		u32			size = 0;
+		if( !pipe_read( h, &size, sizeof(size) ) )
+			return 0;
+		IGenericStream	*s = new CGenStreamOnMemory();
+		s->SetLength	( size );
+		if( size && !pipe_read( h, s->GetBasePointer(), size ) )
+		{
+			s->Release	();
+			return 0;
+		}
+		s->Seek			( 0 );
+		return s;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// master side
+	struct exec_local::worker
+	{
+		exec_local				*owner;
+		u32						index;
+		HANDLE					process;
+		HANDLE					to;
+		HANDLE					from;
+		HANDLE					ev_exited;
+		string_path				dir;
+		xr_map<shared_str,u64>	copied;				// data file -> write time of the copy
+
+		worker( exec_local* _owner, u32 _index ): owner(_owner), index(_index), process(0), to(0), from(0)
+		{
+			ev_exited			= CreateEvent( NULL, TRUE, FALSE, NULL );
+			string64			name;
+			xr_sprintf			( name, "lc_net_local\\%d\\", index );
+			FS.update_path		( dir, "$app_root$", name );
+			VerifyPath			( dir );
+		}
+		~worker( )
+		{
+			CloseHandle			( ev_exited );
+		}
+
+		bool spawn( )
+		{
+			SECURITY_ATTRIBUTES	sa = { sizeof(sa), 0, TRUE };
+			HANDLE	task_read, task_write, result_read, result_write;
+			if( !CreatePipe( &task_read, &task_write, &sa, 0 ) )
+				return false;
+			if( !CreatePipe( &result_read, &result_write, &sa, 0 ) )
+			{
+				CloseHandle		( task_read );
+				CloseHandle		( task_write );
+				return false;
+			}
+			SetHandleInformation( task_write, HANDLE_FLAG_INHERIT, 0 );
+			SetHandleInformation( result_read, HANDLE_FLAG_INHERIT, 0 );
+
+			string_path			exe;
+			GetModuleFileName	( 0, exe, sizeof(exe) );
+			string_path			cmd;
+			// an error in the worker ends the process instead of waiting on a message box, the task is retried
+			xr_sprintf			( cmd, "\"%s\" -networker %u %u %u -silent_error_mode%s", exe, u32(size_t(task_read)), u32(size_t(result_write)), index,
+									strstr(Core.Params,"-nosmg") ? " -nosmg" : "" );
+
+			STARTUPINFO			si;
+			ZeroMemory			( &si, sizeof(si) );
+			si.cb				= sizeof(si);
+			PROCESS_INFORMATION	pi;
+			BOOL ok				= CreateProcess( 0, cmd, 0, 0, TRUE, CREATE_NO_WINDOW, 0, 0, &si, &pi );
+			CloseHandle			( task_read );
+			CloseHandle			( result_write );
+			if( !ok )
+			{
+				CloseHandle		( task_write );
+				CloseHandle		( result_read );
+				return false;
+			}
+			CloseHandle			( pi.hThread );
+			process				= pi.hProcess;
+			to					= task_write;
+			from				= result_read;
+			// the new process decompresses its data again
+			copied.clear		( );
+			return true;
+		}
+
+		void kill( )
+		{
+			TerminateProcess	( process, 1 );
+			WaitForSingleObject	( process, INFINITE );
+			free_handles		( );
+		}
+
+		void close( )
+		{
+			if( !process )
+				return;
+			u32	msg				= lm_quit;
+			pipe_write			( to, &msg, sizeof(msg) );
+			if( WaitForSingleObject( process, 10000 ) != WAIT_OBJECT_0 )
+				TerminateProcess( process, 1 );
+			free_handles		( );
+		}
+
+		void free_handles( )
+		{
+			CloseHandle			( process );
+			CloseHandle			( to );
+			CloseHandle			( from );
+			process				= 0;
+			to					= 0;
+			from				= 0;
+		}
+
+		void copy_files( LPCSTR list )
+		{
+			string_path			name;
+			int		count		= _GetItemCount( list );
+			for( int i = 0; i < count; ++i )
+			{
+				_GetItem		( list, i, name );
+				if( !name[0] )
+					continue;
+				string_path		src, dst;
+				FS.update_path	( src, "$app_root$", name );
+				WIN32_FILE_ATTRIBUTE_DATA	attr;
+				if( !GetFileAttributesEx( src, GetFileExInfoStandard, &attr ) )
+					continue;
+				u64		age		= (u64(attr.ftLastWriteTime.dwHighDateTime)<<32) | attr.ftLastWriteTime.dwLowDateTime;
+				shared_str		key( name );
+				xr_map<shared_str,u64>::iterator it = copied.find( key );
+				if( it != copied.end() && it->second == age )
+					continue;
+				strconcat		( sizeof(dst), dst, dir, name );
+				R_ASSERT3		( CopyFile( src, dst, FALSE ), "can't copy net data file", dst );
+				copied[key]		= age;
+			}
+		}
+
+		// the anonymous pipes have no timeouts: poll them, a process which is gone or silent past reply_timeout is lost
+		bool wait_reply( )
+		{
+			CTimer	T;
+			T.Start				( );
+			u32		sleep		= 1;
+			for(;;)
+			{
+				DWORD	avail	= 0;
+				if( !PeekNamedPipe( from, 0, 0, 0, &avail, 0 ) )
+					return false;
+				if( avail )
+					return true;
+				if( T.GetElapsed_ms() > reply_timeout )
+				{
+					clMsg		( "! net local worker %d: no reply for %d s", index, reply_timeout/1000 );
+					return false;
+				}
+				WaitForSingleObject( process, sleep );
+				sleep			= _min( sleep*2, u32(64) );
+			}
+		}
+
+		u32	transact( IGenericStream* stream )
+		{
+			u32	msg				= lm_task;
+			if( !pipe_write( to, &msg, sizeof(msg) ) || !pipe_write_stream( to, stream ) )
+				return lr_broken;
+			for(;;)
+			{
+				if( !wait_reply() || !pipe_read( from, &msg, sizeof(msg) ) )
+					return lr_broken;
+				if( msg == lm_data )
+				{
+					string_path	desc;
+					u32	len		= 0;
+					if( !pipe_read( from, &len, sizeof(len) ) || len >= sizeof(desc) || !pipe_read( from, desc, len ) )
+						return lr_broken;
+					desc[len]	= 0;
+					IGenericStream	*data = 0;
+					data_cleanup_callback( desc, &data );
+					bool	sent	= pipe_write_stream( to, data );
+					if( data )
+						data->Release();
+					if( !sent )
+						return lr_broken;
+					continue;
+				}
+				// anything else is a corrupted worker, it is killed and the task goes to another one
+				if( msg != lm_result )
+					return lr_broken;
+				u32	ok			= 0;
+				if( !pipe_read( from, &ok, sizeof(ok) ) )
+					return lr_broken;
+				IGenericStream	*result = pipe_read_stream( from );
+				if( !result )
+					return lr_broken;
+				if( ok )
+					Finalize	( result );
+				result->Release	( );
+				return ok ? lr_done : lr_refused;
+			}
+		}
+	};
+
+	exec_local::exec_local( ): ev_tasks(0), shutdown(FALSE)
+	{
+	}
+
+	void	exec_local::startup( u32 count )
+	{
+		R_ASSERT			( !running() );
+		R_ASSERT			( count>0 );
+		shutdown			= FALSE;
+		ev_tasks			= CreateSemaphore( NULL, 0, LONG_MAX, NULL );
+		for( u32 i = 0; i < count; ++i )
+		{
+			worker	*w		= xr_new<worker>( this, i );
+			workers.push_back( w );
+			thread_spawn	( worker_thread, "net-local-worker", 1024*1024, w );
+		}
+		clMsg				( "net tasks: %d local workers", count );
+	}
+
+	void	exec_local::release( )
+	{
+		if( !running() )
+			return;
+		shutdown			= TRUE;
+		ReleaseSemaphore	( ev_tasks, workers.size(), NULL );
+		for( u32 i = 0; i < workers.size(); ++i )
+		{
+			WaitForSingleObject	( workers[i]->ev_exited, INFINITE );
+			xr_delete		( workers[i] );
+		}
+		workers.clear		( );
+		CloseHandle			( ev_tasks );
+		ev_tasks			= 0;
+		R_ASSERT			( tasks.empty() );
+	}
+
+	void	exec_local::run_task( IGenericStream* outStream, u32 id, LPCSTR files )
+	{
+		R_ASSERT			( running() );
+		task	t;
+		t.stream			= outStream;
+		t.id				= id;
+		t.tries				= 0;
+		xr_strcpy			( t.files, files );
+		lock.Enter			( );
+		tasks.push_back		( t );
+		lock.Leave			( );
+		ReleaseSemaphore	( ev_tasks, 1, NULL );
+	}
+
+	bool	exec_local::take( task &t )
+	{
+		bool	result		= false;
+		lock.Enter			( );
+		if( !tasks.empty() )
+		{
+			t				= tasks.front();
+			tasks.pop_front	( );
+			result			= true;
+		}
+		lock.Leave			( );
+		return result;
+	}
+
+	// a failed task goes to the front, the other workers are not waiting for it behind the whole queue
+	void	exec_local::retry( task &t )
+	{
+		++t.tries;
+		if( t.tries >= max_tries )
+			Debug.fatal		( DEBUG_INFO, "* FATAL: net task %d failed %d times on the local workers", t.id, t.tries );
+		clMsg				( "net task %d: retry %d", t.id, t.tries );
+		lock.Enter			( );
+		tasks.push_front	( t );
+		lock.Leave			( );
+		ReleaseSemaphore	( ev_tasks, 1, NULL );
+	}
+
+	void	exec_local::process( worker &w )
+	{
+		for(;;)
+		{
+			WaitForSingleObject	( ev_tasks, INFINITE );
+			task	t;
+			if( !take( t ) )
+			{
+				if( shutdown )
+					break;
+				continue;
+			}
+			if( !w.process && !w.spawn() )
+			{
+				clMsg		( "! net local worker %d: can't start the process", w.index );
+				retry		( t );
+				continue;
+			}
+			w.copy_files	( t.files );
+			switch( w.transact( t.stream ) )
+			{
+			case lr_done:
+				t.stream->Release();
+				break;
+			case lr_refused:
+				retry		( t );
+				break;
+			case lr_broken:
+				clMsg		( "! net local worker %d: process lost on task %d", w.index, t.id );
+				w.kill		( );
+				retry		( t );
+				break;
+			}
+		}
+		w.close				( );
+		SetEvent			( w.ev_exited );
+	}
+
+	void	exec_local::worker_thread( void *_worker )
+	{
+		worker	&w			= *((worker*)_worker);
+		w.owner->process	( w );
+	}
+
+	static exec_local	g_exec_local;
+	exec_local	&get_exec_local( )
+	{
+		return g_exec_local;
+	}
+
+	IGenericStream	*create_stream( )
+	{
+		if( g_exec_local.running() || is_local_worker )
+			return new CGenStreamOnMemory();
+		return CreateGenericStream();
+	}
+
+	bool	local_worker( )
+	{
+		return is_local_worker;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// worker side, the agent asks the master for the data over the same pipes
+	class local_agent: public IAgent
+	{
+		HANDLE					from;
+		HANDLE					to;
+		string_path				dir;
+		CRITICAL_SECTION		section;
+	public:
+		local_agent( HANDLE _from, HANDLE _to, u32 index ): from(_from), to(_to)
+		{
+			string64			name;
+			xr_sprintf			( name, "lc_net_local\\%d\\", index );
+			FS.update_path		( dir, "$app_root$", name );
+			InitializeCriticalSection( &section );
+		}
+		~local_agent( )
+		{
+			DeleteCriticalSection( &section );
+		}
+		bool	read	( void* p, u32 size )		{ return pipe_read( from, p, size ); }
+		bool	write	( const void* p, u32 size )	{ return pipe_write( to, p, size ); }
+IGenericStream*	read_stream	( )						{ return pipe_read_stream( from ); }
+		bool	write_stream( IGenericStream* s )	{ return pipe_write_stream( to, s ); }
+	private:
+	 //======== BEGIN COM INTERFACE =======
+	IUNKNOWN_METHODS_IMPLEMENTATION_INSTANCE()
+
+	virtual HRESULT __stdcall GetData( DWORD sessionId, const char* dataDesc, IGenericStream** stream )
+	{
+		u32	msg					= lm_data;
+		u32	len					= xr_strlen( dataDesc );
+		if( !write( &msg, sizeof(msg) ) || !write( &len, sizeof(len) ) || !write( dataDesc, len ) )
+			return S_FALSE;
+		*stream					= read_stream( );
+		if( *stream && !(*stream)->GetLength() )
+		{
+			(*stream)->Release	( );
+			*stream				= 0;
+		}
+		return *stream ? S_OK : S_FALSE;
+	}
+	virtual HRESULT __stdcall FreeCachedData( DWORD sessionId, const char* dataDesc )
+	{
+		return S_OK;
+	}
+	virtual HRESULT __stdcall GetSessionCacheDirectory( DWORD sessionId, char* cacheDir )
+	{
+		xr_strcpy				( cacheDir, sizeof(string_path), dir );
+		return S_OK;
+	}
+	virtual HRESULT __stdcall GetGlobalCriticalSection( LPCRITICAL_SECTION* gcs )
+	{
+		*gcs					= &section;
+		return S_OK;
+	}
+	// the master is gone when the pipe is
+	virtual HRESULT __stdcall TestConnection( DWORD sessionId )
+	{
+		DWORD	avail			= 0;
+		return PeekNamedPipe( from, 0, 0, 0, &avail, 0 ) ? S_OK : S_FALSE;
+	}
+	};
+}
+
+int			RunNetLocalWorker( LPCSTR params )
+{
+	u32	from = 0, to = 0, index = 0;
+	LPCSTR	key				= strstr( params, "-networker" );
+	R_ASSERT				( key );
+	sscanf					( key + xr_strlen("-networker"), "%u %u %u", &from, &to, &index );
+	lc_net::is_local_worker	= true;
+	FPU::m64r				();
+
+	lc_net::local_agent		agent( HANDLE(size_t(from)), HANDLE(size_t(to)), index );
+	for(;;)
+	{
+		u32	msg				= lc_net::lm_quit;
+		if( !agent.read( &msg, sizeof(msg) ) || msg != lc_net::lm_task )
+			break;
+		IGenericStream	*inStream	= agent.read_stream();
+		if( !inStream )
+			break;
+		IGenericStream	*outStream	= new CGenStreamOnMemory();
+		u32	ok				= lc_net::g_net_task_interface->run_task( &agent, lc_net::local_session, inStream, outStream ) ? 1 : 0;
+		inStream->Release	();
+		msg					= lc_net::lm_result;
+		bool	sent		= agent.write( &msg, sizeof(msg) ) && agent.write( &ok, sizeof(ok) ) && agent.write_stream( outStream );
+		outStream->Release	();
+		if( !sent )
+			break;
+	}
+	return 0;
+}
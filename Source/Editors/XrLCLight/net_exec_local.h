@@ -0,0 +1,45 @@
+#ifndef _NET_EXEC_LOCAL_H_
+#define _NET_EXEC_LOCAL_H_
+#include "hxgrid/Interface/IAgent.h"
+#include "hxgrid/Interface/hxgridinterface.h"
+
+namespace lc_net
+{
+	// The net tasks without the grid: every worker is an xrLC process started with -networker,
+	// the task and result streams go over a pair of anonymous pipes, the global data files are
+	// copied to the worker directory the way the grid agents get them in the session cache
+	class exec_local
+	{
+		struct task
+		{
+			IGenericStream			*stream;
+			u32						id;
+			u32						tries;
+			string_path				files;
+		};
+		struct worker;
+		static const u32			max_tries	= 3;
+
+		xr_deque<task>				tasks;
+		xr_vector<worker*>			workers;
+		xrCriticalSection			lock;
+		HANDLE						ev_tasks;
+		volatile BOOL				shutdown;
+	public:
+							exec_local		( );
+		void				startup			( u32 count );
+		void				release			( );
+		bool				running			( ) const	{ return !workers.empty(); }
+		void				run_task		( IGenericStream* outStream, u32 id, LPCSTR files );
+	private:
+		bool				take			( task &t );
+		void				retry			( task &t );
+		void				process			( worker &w );
+static	void				worker_thread	( void *_worker );
+	};
+
+	exec_local				&get_exec_local	( );
+	IGenericStream			*create_stream	( );
+	bool					local_worker	( );
+}
+#endif
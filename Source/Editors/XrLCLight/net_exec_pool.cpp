@@ -8,6 +8,7 @@
 #include "net_execution_factory.h"
 #include "net_global_data_cleanup.h"
 #include "lcnet_task_manager.h"
+#include "net_exec_local.h"
 #define LOG_ALL_NET_TASKS
 
 
@@ -136,7 +137,7 @@ namespace lc_net
 		run_lock.Leave();
 		return running;
 	}
-	exec_pool&	exec_pool::run( IGridUser &user, u8 pool_id )
+	exec_pool&	exec_pool::run( IGridUser *user, u8 pool_id )
 	{
 		start_time.Start();
 		R_ASSERT( !_running );
@@ -151,12 +152,12 @@ namespace lc_net
 	}
 	void __cdecl Finalize(IGenericStream* outStream);
 	xrCriticalSection run_task_lock;
-	void	exec_pool::send_task( IGridUser& user, IGenericStream* Stream, u8 pool_id, u32 id  )
+	void	exec_pool::send_task( IGridUser* user, IGenericStream* Stream, u8 pool_id, u32 id  )
 	{
 		
 		R_ASSERT( _running );
 		R_ASSERT( has( id ) );
-		IGenericStream* outStream  = CreateGenericStream();
+		IGenericStream* outStream  = create_stream();
 		//////////////////////////////////////////////////////
 		write_task_pool( outStream, pool_id );////////////////////
 		//////////////////////////////////////////////////////
@@ -178,6 +179,12 @@ namespace lc_net
 		DWORD t_id = id;
 		string_path data;
 		string_path files;
+		// no grid, the workers of this machine
+		if( !user )
+		{
+			get_exec_local().run_task( outStream, id, e->data_files(files) );
+			return;
+		}
 		strconcat( sizeof(data),data,libraries,e->data_files(files));
 		run_task_lock.Enter();
 		bool ok = false;
@@ -186,7 +193,7 @@ namespace lc_net
 		__try
 		{
 			
-			user.RunTask( data ,"RunTask",outStream,Finalize,&t_id,true);
+			user->RunTask( data ,"RunTask",outStream,Finalize,&t_id,true);
 
 			ok = true;
 		}
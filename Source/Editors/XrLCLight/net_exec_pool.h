@@ -30,9 +30,9 @@ namespace lc_net
 		void		wait();
 		void		set_name( LPCSTR	name ){ xr_strcpy( _name , name ); }
 		bool		is_running()	;
-	exec_pool&		run( IGridUser &user, u8 pool_id );
+	exec_pool&		run( IGridUser *user, u8 pool_id );
 
-		void		send_task( IGridUser& user,IGenericStream* outStream, u8 pool_id, u32 id   );
+		void		send_task( IGridUser* user,IGenericStream* outStream, u8 pool_id, u32 id   );
 		void		receive_result	( IGenericStream* inStream  );
 		void		remove_task		( net_execution *e );
 		void		send_result		( IGenericStream* outStream, net_execution &e  );
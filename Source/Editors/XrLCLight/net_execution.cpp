@@ -15,7 +15,7 @@ namespace lc_net
 		return false;
 	}
 */
-	void net_execution::send_task( IGridUser& user, IGenericStream* outStream, u32  id )
+	void net_execution::send_task( IGridUser* user, IGenericStream* outStream, u32  id )
 	{
 		_id = id;
 	}
@@ -16,7 +16,7 @@ namespace lc_net
 					u32						id				( ) const { return _id ;}	
 		virtual		u32 					type			( )	=0;
 
-		virtual		void					send_task		( IGridUser& user, IGenericStream* outStream, u32  id )	=0;
+		virtual		void					send_task		( IGridUser* user, IGenericStream* outStream, u32  id )	=0;
 		virtual		void					receive_result	( IGenericStream* outStream )	=0;
 		virtual		bool					receive_task	( IAgent* agent, DWORD sessionId, IGenericStream* inStream ) = 0;
 		virtual		void					send_result		( IGenericStream* outStream )	=0;
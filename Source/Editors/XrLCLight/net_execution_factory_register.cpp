@@ -42,7 +42,7 @@ namespace lc_net{
 			return execution_impl;
 		};
 
-		virtual		void					send_task		( IGridUser& user, IGenericStream* outStream, u32  id )	 
+		virtual		void					send_task		( IGridUser* user, IGenericStream* outStream, u32  id )	 
 		{
 			const xr_vector<e_net_globals>& v = exe_gl_reg().get_globals(etype);
 			u32 size = v.size();
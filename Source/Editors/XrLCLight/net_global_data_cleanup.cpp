@@ -2,6 +2,7 @@
 
 #include "net_global_data_cleanup.h"
 #include "serialize.h"
+#include "net_exec_local.h"
 namespace lc_net
 {
 	global_data_cleanup _cleanup;
@@ -24,7 +25,7 @@ namespace lc_net
 
 	void __cdecl data_cleanup_callback( const char* dataDesc, IGenericStream** stream )
 	{
-		 *stream  = CreateGenericStream();
+		 *stream  = create_stream();
 		 u8 buff[data_cleanup_callback_read_write_buff_size];
 		 w_pod_vector( INetMemoryBuffWriter( *stream,  sizeof(buff), buff ), _cleanup.vec_cleanup );  
 		// w_pod_vector( INetIWriterGenStream( *stream, 512 ), _cleanup.vec_cleanup );  
@@ -53,7 +54,10 @@ namespace lc_net
 		 r_pod_vector( INetBlockReader( globalDataStream, buff, sizeof(buff) ), vec_cleanup );
 		//  r_pod_vector( INetReaderGenStream( globalDataStream ), vec_cleanup );
 
-		 free(globalDataStream->GetCurPointer());
+		 if( local_worker() )
+			 globalDataStream->Release();
+		 else
+			 free(globalDataStream->GetCurPointer());
 		 id_state = state;
 #ifdef CL_NET_LOG
 		 Msg("cleanup call");
@@ -450,6 +450,55 @@ DWORD __stdcall CGenStreamOnFile::Read(void* Data, DWORD count)
 	return count;
 }
 
+CGenStreamOnMemory::CGenStreamOnMemory( ): data(0), length(0), capacity(0), position(0)
+{
+}
+CGenStreamOnMemory::~CGenStreamOnMemory( )
+{
+	free( data );
+}
+void	CGenStreamOnMemory::reserve( u32 size )
+{
+	if( size <= capacity )
+		return;
+	capacity				= _max( size, capacity*2 );
+	data					= (u8*) realloc( data, capacity );
+	R_ASSERT( data );
+}
+void __stdcall CGenStreamOnMemory::Write(const void* Data, DWORD count)
+{
+	reserve					( position + count );
+	CopyMemory				( data + position, Data, count );
+	position				+= count;
+	length					= _max( length, position );
+}
+DWORD __stdcall CGenStreamOnMemory::Read(void* Data, DWORD count)
+{
+	R_ASSERT				( position + count <= length );
+	CopyMemory				( Data, data + position, count );
+	position				+= count;
+	return count;
+}
+void __stdcall CGenStreamOnMemory::Clear()
+{
+	free					( data );
+	data					= 0;
+	length					= 0;
+	capacity				= 0;
+	position				= 0;
+}
+void __stdcall CGenStreamOnMemory::GrowToPos(int DestSize)
+{
+	if( DestSize >= 0 )
+		reserve				( u32(DestSize) );
+}
+void __stdcall CGenStreamOnMemory::SetLength(DWORD newLength)
+{
+	reserve					( newLength );
+	length					= newLength;
+	position				= _min( position, length );
+}
+
 
 
 INetIWriterGenStream::INetIWriterGenStream( IGenericStream	 *_stream, u32 inital_size ):
@@ -311,4 +311,39 @@ private:
 	}
 };
 
+// growing stream in the process memory, the local net tasks go over the pipes in these
+class CGenStreamOnMemory: public IGenericStream
+{
+	u8						*data;
+	u32						length;
+	u32						capacity;
+	u32						position;
+public:
+			CGenStreamOnMemory( );
+			~CGenStreamOnMemory( );
+private:
+	 //======== BEGIN COM INTERFACE =======
+  IUNKNOWN_METHODS_IMPLEMENTATION_INSTANCE()
+
+  virtual BYTE* __stdcall GetBasePointer(){ return (BYTE*) data ;}
+  virtual BYTE* __stdcall GetCurPointer(){ return (BYTE*) data + position ;}
+  virtual bool __stdcall isReadOnly(){ return false ;}
+  virtual DWORD __stdcall GetLength(){ return length ;}
+  virtual void __stdcall Write(const void* Data, DWORD count);
+  virtual DWORD __stdcall Read(void* Data, DWORD count);
+  virtual void __stdcall Seek(DWORD pos){ R_ASSERT(pos<=length); position = pos ;}
+  virtual DWORD __stdcall GetPos(){ return position ;}
+  virtual void __stdcall Clear();
+  virtual void __stdcall FastClear(){ length = 0; position = 0 ;}
+  virtual void __stdcall GrowToPos(int DestSize=-1);
+  virtual void __stdcall Skip(DWORD count){ Seek( position + count ) ;}
+  virtual void __stdcall SetLength(DWORD newLength);
+  virtual void __stdcall Compact(){}
+  virtual DWORD __stdcall GetVersion() const
+	{
+		return CGenStreamOnMemory::VERSION;
+	}
+		void				reserve			( u32 size );
+};
+
 
@@ -9,6 +9,7 @@
 #include "light_point.h"
 #include "xrface.h"
 #include "net_task.h"
+#include "xrLightmapCache.h"
 //const	u32	rms_discard			= 8;
 //extern	BOOL		gl_linear	;
 
@@ -347,9 +348,17 @@ BOOL ApplyBorders( lm_layer &lm, u32 ref )
 }
 
 
-float getLastRP_Scale(CDB::COLLIDER* DB, CDB::MODEL* MDL, R_Light& L, Face* skip, BOOL bUseFaceDisable)
+// Shadow rays resolved since the thread started, the lighting phases sum them per worker
+static __declspec(thread)	u64	lp_rays		= 0;
+static BOOL						lp_packets	= TRUE;
+
+u64	LightPoint_Rays	()
+{
+	return	lp_rays;
+}
+
+float getLastRP_Scale(CDB::MODEL* MDL, R_Light& L, CDB::RESULT* results, u32 tris_count, Face* skip)
 {
-	u32		tris_count	= DB->r_count();
 	float	scale		= 1.f;
 	Fvector B;
 
@@ -357,7 +366,7 @@ float getLastRP_Scale(CDB::COLLIDER* DB, CDB::MODEL* MDL, R_Light& L, Face* skip
 	{
 		for (u32 I=0; I<tris_count; I++)
 		{
-			CDB::RESULT& rpinf = DB->r_begin()[I];
+			CDB::RESULT& rpinf = results[I];
 
 			// Access to texture
 			CDB::TRI& clT										= MDL->get_tris()[rpinf.id];
@@ -418,9 +427,15 @@ float getLastRP_Scale(CDB::COLLIDER* DB, CDB::MODEL* MDL, R_Light& L, Face* skip
 	return scale;
 }
 
+float getLastRP_Scale(CDB::COLLIDER* DB, CDB::MODEL* MDL, R_Light& L, Face* skip, BOOL bUseFaceDisable)
+{
+	return	getLastRP_Scale	(MDL,L,DB->r_begin(),DB->r_count(),skip);
+}
+
 float rayTrace	(CDB::COLLIDER* DB, CDB::MODEL* MDL, R_Light& L, Fvector& P, Fvector& D, float R, Face* skip, BOOL bUseFaceDisable)
 {
 	R_ASSERT	(DB);
+	lp_rays		++;
 
 	// 1. Check cached polygon
 	float _u,_v,range;
@@ -441,8 +456,215 @@ float rayTrace	(CDB::COLLIDER* DB, CDB::MODEL* MDL, R_Light& L, Fvector& P, Fvec
 	return 0;
 }
 
+// The shadow rays of a point are gathered over all its lights and traced as packets,
+// the light adds 'k*visibility*m + c' when its packet comes back
+struct	lp_ray
+{
+	R_Light*		L;
+	float*			dest;			// rgb (with the diffuse), sun or hemi
+	BOOL			rgb;
+	float			k,m,c;
+	int				slot;			// in the packet, -1 - no trace needed or the cached polygon shadows it
+	BOOL			shadow;
+};
+
+struct	lp_packet
+{
+	CDB::RAY_PACKET	rays;
+	lp_ray			list	[CDB::rpMaxRays];
+	u32				count;
+	CDB::COLLIDER*	DB;
+	CDB::MODEL*		MDL;
+	Face*			skip;
+
+	lp_packet		(CDB::COLLIDER* _DB, CDB::MODEL* _MDL, Face* _skip) : count(0), DB(_DB), MDL(_MDL), skip(_skip)	{}
+
+	void			add		(R_Light* L, float* dest, BOOL rgb, float k, float m, float c)
+	{
+		if (count==CDB::rpMaxRays)	flush	();
+		lp_ray&		r	= list[count++];
+		r.L				= L;
+		r.dest			= dest;
+		r.rgb			= rgb;
+		r.k				= k;
+		r.m				= m;
+		r.c				= c;
+		r.slot			= -1;
+		r.shadow		= FALSE;
+	}
+	void			trace	(R_Light* L, float* dest, BOOL rgb, float k, float m, float c, const Fvector& P, const Fvector& D, float R)
+	{
+		add				(L,dest,rgb,k,m,c);
+		lp_ray&		r	= list[count-1];
+		lp_rays			++;
+
+		// the cached polygon first, as rayTrace does
+		float _u,_v,range;
+		if (CDB::TestRayTri(P,D,L->tri,_u,_v,range,false) && range>0 && range<R)	{
+			r.shadow	= TRUE;
+			return;
+		}
+		r.slot			= rays.add	(P,D,R);
+	}
+	void			flush	()
+	{
+		if (rays.count)	DB->ray_packet	(MDL,rays);
+		for (u32 it=0; it<count; it++)
+		{
+			lp_ray&		r	= list[it];
+			float		vis	= r.shadow?0.f:1.f;
+			if (r.slot>=0 && rays.hits[r.slot])
+				vis			= getLastRP_Scale(MDL,*r.L,DB->r_begin()+rays.first[r.slot],rays.hits[r.slot],skip);
+
+			float		A	= r.k*vis*r.m + r.c;
+			if (r.rgb)	{
+				r.dest[0]	+= A * r.L->diffuse.x;
+				r.dest[1]	+= A * r.L->diffuse.y;
+				r.dest[2]	+= A * r.L->diffuse.z;
+			} else {
+				r.dest[0]	+= A;
+			}
+		}
+		count			= 0;
+		rays.clear		();
+	}
+};
+
+static void LightPoint_Packet(CDB::COLLIDER* DB, CDB::MODEL* MDL, base_color_c &C, Fvector &P, Fvector &N, base_lighting& lights, u32 flags, Face* skip)
+{
+	Fvector		Ldir,Pnew;
+	Pnew.mad	(P,N,0.01f);
+
+	lp_packet	packet	(DB,MDL,skip);
+	DB->ray_options		(0);
+
+	if (0==(flags&LP_dont_rgb))
+	{
+		R_Light	*L	= &*lights.rgb.begin(), *E = &*lights.rgb.end();
+		for (;L!=E; L++)
+		{
+			switch (L->type)
+			{
+			case LT_DIRECT:
+				{
+					// Cos
+					Ldir.invert	(L->direction);
+					float D		= Ldir.dotproduct( N );
+					if( D <=0 ) continue;
+
+					packet.trace	(L,&C.rgb.x,TRUE,D*L->energy,1.f,0.f,Pnew,Ldir,1000.f);
+				}
+				break;
+			case LT_POINT:
+				{
+					// Distance
+					float sqD	=	P.distance_to_sqr	(L->position);
+					if (sqD > L->range2) continue;
+
+					// Dir
+					Ldir.sub			(L->position,P);
+					Ldir.normalize_safe	();
+					float D				= Ldir.dotproduct( N );
+					if( D <=0 )			continue;
+
+					// linear attenuation doesn't look at the shadow
+					float R		= _sqrt(sqD);
+					if ( inlc_global_data()->gl_linear() )
+						packet.add		(L,&C.rgb.x,TRUE,0.f,0.f,1-R/L->range);
+					else
+						//	Igor: let A equal 0 at the light boundary
+						packet.trace	(L,&C.rgb.x,TRUE,D*L->energy,1/(L->attenuation0 + L->attenuation1*R + L->attenuation2*sqD) - R*L->falloff,0.f,Pnew,Ldir,R);
+				}
+				break;
+			case LT_SECONDARY:
+				{
+					// Distance
+					float sqD	=	P.distance_to_sqr	(L->position);
+					if (sqD > L->range2) continue;
+
+					// Dir
+					Ldir.sub	(L->position,P);
+					Ldir.normalize_safe();
+					float	D	=	Ldir.dotproduct		( N );
+					if( D <=0 ) continue;
+							D	*=	-Ldir.dotproduct	(L->direction);
+					if( D <=0 ) continue;
+
+					// the single ray version jitters the light after the direction is taken, the ray is the same
+					float R			= _sqrt(sqD);
+					packet.trace	(L,&C.rgb.x,TRUE,powf(D, 1.f/8.f)*L->energy,1-R/L->range,0.f,Pnew,Ldir,R);
+				}
+				break;
+			}
+		}
+	}
+	if (0==(flags&LP_dont_sun))
+	{
+		R_Light	*L		= &*(lights.sun.begin()), *E = &*(lights.sun.end());
+		for (;L!=E; L++)
+		{
+			if (L->type==LT_DIRECT) {
+				// Cos
+				Ldir.invert	(L->direction);
+				float D		= Ldir.dotproduct( N );
+				if( D <=0 ) continue;
+
+				packet.trace	(L,&C.sun,FALSE,L->energy,1.f,0.f,Pnew,Ldir,1000.f);
+			} else {
+				// Distance
+				float sqD	=	P.distance_to_sqr(L->position);
+				if (sqD > L->range2) continue;
+
+				// Dir
+				Ldir.sub			(L->position,P);
+				Ldir.normalize_safe	();
+				float D				= Ldir.dotproduct( N );
+				if( D <=0 )			continue;
+
+				float R		=	_sqrt(sqD);
+				packet.trace	(L,&C.sun,FALSE,D*L->energy,1/(L->attenuation0 + L->attenuation1*R + L->attenuation2*sqD),0.f,Pnew,Ldir,R);
+			}
+		}
+	}
+	if (0==(flags&LP_dont_hemi))
+	{
+		R_Light	*L	= &*lights.hemi.begin(), *E = &*lights.hemi.end();
+		for (;L!=E; L++)
+		{
+			if (L->type==LT_DIRECT) {
+				// Cos
+				Ldir.invert	(L->direction);
+				float D		= Ldir.dotproduct( N );
+				if( D <=0 ) continue;
+
+				Fvector		PMoved;	PMoved.mad	(Pnew,Ldir,0.001f);
+				packet.trace	(L,&C.hemi,FALSE,L->energy,1.f,0.f,PMoved,Ldir,1000.f);
+			}else{
+				// Distance
+				float sqD	=	P.distance_to_sqr(L->position);
+				if (sqD > L->range2) continue;
+
+				// Dir
+				Ldir.sub			(L->position,P);
+				Ldir.normalize_safe	();
+				float D		=	Ldir.dotproduct( N );
+				if( D <=0 ) continue;
+
+				float R		=	_sqrt(sqD);
+				packet.trace	(L,&C.hemi,FALSE,D*L->energy,1/(L->attenuation0 + L->attenuation1*R + L->attenuation2*sqD),0.f,Pnew,Ldir,R);
+			}
+		}
+	}
+	packet.flush	();
+}
+
 void LightPoint(CDB::COLLIDER* DB, CDB::MODEL* MDL, base_color_c &C, Fvector &P, Fvector &N, base_lighting& lights, u32 flags, Face* skip)
 {
+	if (lp_packets)	{
+		LightPoint_Packet	(DB,MDL,C,P,N,lights,flags,skip);
+		return;
+	}
+
 	Fvector		Ldir,Pnew;
 	Pnew.mad	(P,N,0.01f);
 
@@ -606,6 +828,54 @@ void LightPoint(CDB::COLLIDER* DB, CDB::MODEL* MDL, base_color_c &C, Fvector &P,
 	}
 }
 
+// Lights points spread over the level both ways: the packets have to give the colors of the single rays
+void	LightPoint_Benchmark	(u32 samples)
+{
+	CDB::MODEL*		MDL		= inlc_global_data()->RCAST_Model();
+	base_lighting&	lights	= inlc_global_data()->L_static();
+	u32				flags	= inlc_global_data()->b_nosun()?LP_dont_sun:0;
+	u32				tris	= MDL->get_tris_count();
+	if (0==tris || 0==samples)	return;
+
+	u32				step	= _max(tris/samples,u32(1));
+	Fvector*		verts	= MDL->get_verts();
+	CDB::COLLIDER	DB;
+	base_color_c	total	[2];
+	for (u32 mode=0; mode<2; mode++)
+	{
+		lp_packets			= mode;
+		u64		rays		= lp_rays;
+		u32		points		= 0;
+		CTimer	T;			T.Start	();
+		for (u32 it=0; it<tris; it+=step)
+		{
+			CDB::TRI&	tri	= MDL->get_tris()[it];
+			if (0==tri.pointer)	continue;
+
+			Fvector		P,N;
+			Fvector&	v0	= verts[tri.verts[0]];
+			Fvector&	v1	= verts[tri.verts[1]];
+			Fvector&	v2	= verts[tri.verts[2]];
+			P.add		(v0,v1).add(v2).div(3.f);
+			N.mknormal	(v0,v1,v2);
+
+			base_color_c	C;
+			LightPoint		(&DB,MDL,C,P,N,lights,flags,0);
+			total[mode].add	(C);
+			points			++;
+		}
+		float	sec			= T.GetElapsed_sec();
+		rays				= lp_rays-rays;
+		clMsg	("* LIGHT bench: %s, %d points, %I64u rays, %f seconds, %.0f rays/sec",
+			mode?"packets":"single rays",points,rays,sec,sec>0?float(rays)/sec:0.f);
+	}
+	lp_packets				= TRUE;
+
+	Fvector	d;				d.sub(total[1].rgb,total[0].rgb);
+	clMsg	("* LIGHT bench: difference rgb[%f,%f,%f], sun %f, hemi %f",
+		d.x,d.y,d.z,total[1].sun-total[0].sun,total[1].hemi-total[0].hemi);
+}
+
 IC u32	rms_diff	(u32 a, u32 b)
 {
 	if (a>b)	return a-b;
@@ -803,6 +1073,19 @@ void CDeflector::Light(CDB::COLLIDER* DB, base_lighting* LightsSelected, HASH& H
 	// Convert lights to local form
 	LightsSelected->select(inlc_global_data()->L_static(),Sphere.P,Sphere.R);
 
+	// The previous build has lit the same deflector in the same surrounding
+	if (lm_cache)
+	{
+		u64		key		= lm_cache->key	(*this,*LightsSelected);
+		if (!lm_cache->read(key,layer))	L_Lightmap	(DB,LightsSelected,H);
+		lm_cache->write	(key,layer);
+		return;
+	}
+	L_Lightmap			(DB,LightsSelected,H);
+}
+
+void CDeflector::L_Lightmap(CDB::COLLIDER* DB, base_lighting* LightsSelected, HASH& H)
+{
 	// Calculate and fill borders
 	L_Calculate			(DB,LightsSelected,H);
 	if(_net_session && !_net_session->test_connection())
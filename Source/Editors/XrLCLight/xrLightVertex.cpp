@@ -60,34 +60,7 @@ void	g_trans_register	(Vertex* V)
 }
 
 //////////////////////////////////////////////////////////////////////////
-const u32				VLT_END		= u32(-1);
-class CVertexLightTasker
-{
-	xrCriticalSection	cs;
-	volatile u32		index;	
-public:
-	CVertexLightTasker	() : index(0)
-#ifdef PROFILE_CRITICAL_SECTIONS
-		,cs(MUTEX_PROFILE_ID(CVertexLightTasker))
-#endif // PROFILE_CRITICAL_SECTIONS
-	{};
-	
-	void	init		()
-	{
-		index			= 0;
-	}
-
-	u32		get			()
-	{
-		cs.Enter		();
-		u32 _res		=	index;
-		if (_res>=lc_global_data()->g_vertices().size())	_res	=	VLT_END;
-		else							index	+=	1;
-		cs.Leave		();
-		return			_res;
-	}
-};
-CVertexLightTasker		VLT;
+const u32				VLT_CHUNK	= 256;			// vertices per task
 
 bool GetTranslucency(const Vertex* V,float &v_trans )
 {
@@ -106,51 +79,39 @@ bool GetTranslucency(const Vertex* V,float &v_trans )
 	return bVertexLight;
 }
 
-class CVertexLightThread : public CThread
+static void	vertex_light_task	(u32 task, u32 worker, void* param)
 {
-public:
-	CVertexLightThread(u32 ID) : CThread(ID)
-	{
-		thMessages	= FALSE;
-	}
-	virtual void		Execute	()
-	{
-		u32	counter		= 0;
-		for (;; counter++)
-		{
-			u32 id				= VLT.get();
-			if (id==VLT_END)	break;
-
-			Vertex* V		= lc_global_data()->g_vertices()[id];
+	CDB::COLLIDER	DB;
+	DB.ray_options	(0);
 
-			R_ASSERT		(V);
+	u32	count		= lc_global_data()->g_vertices().size();
+	for (u32 id=task*VLT_CHUNK; id<_min(task*VLT_CHUNK+VLT_CHUNK,count); id++)
+	{
+		Vertex* V		= lc_global_data()->g_vertices()[id];
 
-			float		v_trans		= 0.f;
+		R_ASSERT		(V);
 
-			if (GetTranslucency( V, v_trans ))	
-			{
-				base_color_c		vC, old;
-				V->C._get			(old);
+		float		v_trans		= 0.f;
 
-				CDB::COLLIDER	DB;
-				DB.ray_options	(0);
-				LightPoint			(&DB, lc_global_data()->RCAST_Model(), vC, V->P, V->N, lc_global_data()->L_static(), (lc_global_data()->b_nosun()?LP_dont_sun:0)|LP_dont_hemi, 0);
-				vC._tmp_			= v_trans;
-				vC.mul				(.5f);
-				vC.hemi				= old.hemi;			// preserve pre-calculated hemisphere
-				V->C._set			(vC);
+		if (GetTranslucency( V, v_trans ))	
+		{
+			base_color_c		vC, old;
+			V->C._get			(old);
 
-				g_trans_register	(V);
-			}
+			LightPoint			(&DB, lc_global_data()->RCAST_Model(), vC, V->P, V->N, lc_global_data()->L_static(), (lc_global_data()->b_nosun()?LP_dont_sun:0)|LP_dont_hemi, 0);
+			vC._tmp_			= v_trans;
+			vC.mul				(.5f);
+			vC.hemi				= old.hemi;			// preserve pre-calculated hemisphere
+			V->C._set			(vC);
 
-			thProgress			= float(counter) / float(lc_global_data()->g_vertices().size());
+			g_trans_register	(V);
 		}
 	}
-};
+}
+
 namespace lc_net{
 void RunLightVertexNet();
 }
-#define NUM_THREADS			4
 void LightVertex	( bool net )
 {
 	g_trans				= xr_new<mapVert>	();
@@ -159,12 +120,8 @@ void LightVertex	( bool net )
 	Status				("Calculating...");
 	if( !net )
 	{
-		CThreadManager		Threads;
-		VLT.init			();
-		CTimer	start_time;	start_time.Start();				
-		for (u32 thID=0; thID<NUM_THREADS; thID++)	Threads.start(xr_new<CVertexLightThread>(thID));
-		Threads.wait		();
-		clMsg				("%f seconds",start_time.GetElapsed_sec());
+		u32	count			= lc_global_data()->g_vertices().size();
+		CTaskPool::run		("LIGHT: Vertex",(count+VLT_CHUNK-1)/VLT_CHUNK,vertex_light_task,0);
 	} else
 	{
 		lc_net::RunLightVertexNet();
@@ -3,38 +3,23 @@
 #include "xrThread.h"
 #include "xrLight_Implicit.h"
 #include "xrlight_implicitdeflector.h"
-class ImplicitThread : public CThread
-{
-public:
-
-	ImplicitExecute		execute;
-	ImplicitThread		(u32 ID, ImplicitDeflector* _DATA, u32 _y_start, u32 _y_end) :
-	CThread (ID), execute( _y_start, _y_end )
-	{
-		
-	}
-	virtual void		Execute	();
-	
-
-};
-
-void	ImplicitThread ::	Execute	()
-	{
-		// Priority
-		SetThreadPriority		(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
-		Sleep					(0);
-		execute.Execute(0);
-	}
 
+// bands of rows are the tasks, several per worker so the stealing has something to balance
+static u32	implicit_rows	(ImplicitDeflector& defl)
+{
+	return	_max(u32(1),defl.Height()/(CTaskPool::workers()*8));
+}
 
+static void	implicit_task	(u32 task, u32 worker, void* param)
+{
+	ImplicitDeflector&	defl	= *(ImplicitDeflector*)param;
+	u32		rows		= implicit_rows(defl);
+	ImplicitExecute		execute	(task*rows,_min(task*rows+rows,defl.Height()));
+	execute.Execute		(0);
+}
 
-#define	NUM_THREADS	8
 void RunImplicitMultithread(ImplicitDeflector& defl)
 {
-		// Start threads
-		CThreadManager			tmanager;
-		u32	stride				= defl.Height()/NUM_THREADS;
-		for (u32 thID=0; thID<NUM_THREADS; thID++)
-			tmanager.start		(xr_new<ImplicitThread> (thID,&defl,thID*stride,thID*stride+stride));
-		tmanager.wait			();
+		u32	rows				= implicit_rows(defl);
+		CTaskPool::run			("LIGHT: Implicit",(defl.Height()+rows-1)/rows,implicit_task,&defl);
 }
@@ -0,0 +1,287 @@
+#include "stdafx.h"
+
+#include "xrLightmapCache.h"
+#include "xrDeflector.h"
+#include "xrLC_GlobalData.h"
+#include "xrFace.h"
+#include "base_lighting.h"
+#include "net_stream.h"
+
+CLightmapCache*			lm_cache		= NULL;
+
+static const u32		lmc_version		= 2;
+static const float		lmc_cell		= 16.f;		// occluder grid
+static const float		lmc_ray_range	= 1000.f;	// the shadow rays of the directional lights, as LightPoint traces them
+
+// FNV-1a, 64 bit
+struct	lmc_hash
+{
+	u64				value;
+
+					lmc_hash		() : value(14695981039346656037ull)	{}
+	void			add				(const void* data, u32 size)
+	{
+		const u8*	it	= (const u8*)data;
+		for (u32 i=0; i<size; i++)	{
+			value		^= it[i];
+			value		*= 1099511628211ull;
+		}
+	}
+	template <typename T>
+	IC void			add				(const T& v)	{ add(&v,sizeof(T)); }
+};
+
+// lm_layer reads from the net streams only
+class	lmc_reader	: public INetReader
+{
+	IReader&		F;
+public:
+					lmc_reader		(IReader& _F) : F(_F)	{}
+	virtual			~lmc_reader		()						{}
+private:
+	virtual	void	r				(void *p,int cnt)		{ F.r(p,cnt); }
+};
+
+CLightmapCache::CLightmapCache	(LPCSTR level_path)
+{
+	strconcat			(sizeof(name),name,level_path,"build.lmcache");
+	strconcat			(sizeof(name_new),name_new,level_path,"build.lmcache.new");
+	hits				= 0;
+	misses				= 0;
+
+	lmc_hash			H;
+	H.add				(lmc_version);
+	H.add				(inlc_global_data()->g_params());
+	H.add				(inlc_global_data()->b_nosun());
+	H.add				(inlc_global_data()->gl_linear());
+	global				= H.value;
+
+	// Index of the previous build
+	prev				= FS.r_open		(name);
+	if (prev && (prev->length()<int(sizeof(u32)) || prev->r_u32()!=lmc_version))	FS.r_close(prev);
+	if (prev)
+	{
+		while (!prev->eof())
+		{
+			// a truncated file (the previous build was killed while writing it) is dropped as a whole
+			if (prev->elapsed()<int(sizeof(u64)+sizeof(u32)))	break;
+			u64		k		= prev->r_u64	();
+			u32		size	= prev->r_u32	();
+			if (size>u32(prev->elapsed()))					break;
+			prev_index.insert	(mk_pair(k,u32(prev->tell())));
+			prev->advance	(size);
+		}
+		if (!prev->eof())
+		{
+			clMsg			("! LIGHT: cache '%s' is broken, not used",name);
+			prev_index.clear	();
+			FS.r_close		(prev);
+		}
+	}
+
+	next				= FS.w_open		(name_new);
+	next->w_u32			(lmc_version);
+
+	build_grid			();
+	clMsg				("* LIGHT: cache '%s', %d lightmaps of the previous build",name,prev_index.size());
+}
+
+CLightmapCache::~CLightmapCache	()
+{
+	clMsg				("* LIGHT: cache, %d lightmaps reused, %d lit",hits,misses);
+	if (prev)			FS.r_close	(prev);
+	FS.w_close			(next);
+	FS.file_rename		(name_new,name,true);
+}
+
+void	CLightmapCache::build_grid	()
+{
+	CDB::MODEL*		MDL		= inlc_global_data()->RCAST_Model();
+	CDB::TRI*		tris	= MDL->get_tris();
+	Fvector*		verts	= MDL->get_verts();
+
+	Fbox			bb;		bb.invalidate	();
+	for (int it=0; it<MDL->get_verts_count(); it++)	bb.modify	(verts[it]);
+	if (bb.is_empty())		bb.set	(0,0,0,0,0,0);
+	grid.origin.set			(bb.min);
+	grid.size_x				= iFloor((bb.max.x-bb.min.x)/lmc_cell)+1;
+	grid.size_y				= iFloor((bb.max.y-bb.min.y)/lmc_cell)+1;
+	grid.size_z				= iFloor((bb.max.z-bb.min.z)/lmc_cell)+1;
+	grid.cells.assign		(grid.size_x*grid.size_y*grid.size_z,0);
+
+	// alpha-tested shadows read the texture, it is hashed once
+	xr_vector<b_BuildTexture>&	textures	= inlc_global_data()->textures();
+	xr_vector<u64>				tex_hash	(textures.size(),0);
+	for (u32 it=0; it<textures.size(); it++)
+	{
+		b_BuildTexture&	T	= textures[it];
+		lmc_hash		H;
+		H.add			(T.dwWidth);
+		H.add			(T.dwHeight);
+		if (!T.pSurface.Empty())	H.add	(static_cast<u32*>(*T.pSurface),T.dwWidth*T.dwHeight*sizeof(u32));
+		tex_hash[it]	= H.value;
+	}
+
+	for (int it=0; it<MDL->get_tris_count(); it++)
+	{
+		CDB::TRI&	T		= tris[it];
+		lmc_hash	H;
+		Fbox		tb;		tb.invalidate	();
+		for (int v=0; v<3; v++)	{
+			H.add			(verts[T.verts[v]]);
+			tb.modify		(verts[T.verts[v]]);
+		}
+
+		// what getLastRP_Scale looks at
+		base_Face*	F		= (base_Face*)T.pointer;
+		if (F)
+		{
+			u32		cast	= F->Shader().flags.bLIGHT_CastShadow;
+			u32		opaque	= F->flags.bOpaque;
+			H.add			(cast);
+			H.add			(opaque);
+			if (cast && !opaque)	{
+				H.add		(F->getTC0(),3*sizeof(Fvector2));
+				H.add		(tex_hash[inlc_global_data()->materials()[F->dwMaterial].surfidx]);
+			}
+		}
+
+		// the order of the triangles in the model doesn't matter
+		int		x0	= iFloor((tb.min.x-grid.origin.x)/lmc_cell),	x1	= iFloor((tb.max.x-grid.origin.x)/lmc_cell);
+		int		y0	= iFloor((tb.min.y-grid.origin.y)/lmc_cell),	y1	= iFloor((tb.max.y-grid.origin.y)/lmc_cell);
+		int		z0	= iFloor((tb.min.z-grid.origin.z)/lmc_cell),	z1	= iFloor((tb.max.z-grid.origin.z)/lmc_cell);
+		clamp	(x0,0,grid.size_x-1);	clamp	(x1,0,grid.size_x-1);
+		clamp	(y0,0,grid.size_y-1);	clamp	(y1,0,grid.size_y-1);
+		clamp	(z0,0,grid.size_z-1);	clamp	(z1,0,grid.size_z-1);
+		for (int z=z0; z<=z1; z++)
+			for (int y=y0; y<=y1; y++)
+				for (int x=x0; x<=x1; x++)
+					grid.cells[(z*grid.size_y+y)*grid.size_x+x]	+= H.value;
+	}
+}
+
+static void	key_lights	(lmc_hash& H, xr_vector<R_Light>& lights, Fbox& region, xr_vector<Fvector>& directions)
+{
+	u32		count		= lights.size();
+	H.add				(count);
+	for (u32 it=0; it<count; it++)
+	{
+		R_Light&	L	= lights[it];
+		H.add			(&L,offsetof(R_Light,tri));		// not the ray cache
+		if (L.type==LT_DIRECT)	directions.push_back	(Fvector().invert(L.direction));
+		else					region.modify			(L.position);
+	}
+}
+
+void	CLightmapCache::grid_cells	(const Fbox& box, xr_vector<u32>& cells)
+{
+	int		x0	= iFloor((box.min.x-grid.origin.x)/lmc_cell),	x1	= iFloor((box.max.x-grid.origin.x)/lmc_cell);
+	int		y0	= iFloor((box.min.y-grid.origin.y)/lmc_cell),	y1	= iFloor((box.max.y-grid.origin.y)/lmc_cell);
+	int		z0	= iFloor((box.min.z-grid.origin.z)/lmc_cell),	z1	= iFloor((box.max.z-grid.origin.z)/lmc_cell);
+	clamp	(x0,0,grid.size_x-1);	clamp	(x1,0,grid.size_x-1);
+	clamp	(y0,0,grid.size_y-1);	clamp	(y1,0,grid.size_y-1);
+	clamp	(z0,0,grid.size_z-1);	clamp	(z1,0,grid.size_z-1);
+	for (int z=z0; z<=z1; z++)
+		for (int y=y0; y<=y1; y++)
+			for (int x=x0; x<=x1; x++)
+				cells.push_back	((z*grid.size_y+y)*grid.size_x+x);
+}
+
+// the cells the box passes moving along dir over the ray range, the level is convex for this: once the
+// box has left the grid it doesn't come back
+void	CLightmapCache::sweep_cells	(const Fbox& box, const Fvector& dir, xr_vector<u32>& cells)
+{
+	Fbox	level;
+	level.min.set			(grid.origin);
+	level.max.set			(float(grid.size_x),float(grid.size_y),float(grid.size_z)).mul(lmc_cell).add(grid.origin);
+
+	u32		steps			= iCeil(lmc_ray_range/lmc_cell);
+	Fbox	from			= box;
+	for (u32 s=1; s<=steps; s++)
+	{
+		float	dist		= _min(float(s)*lmc_cell,lmc_ray_range);
+		Fbox	to;
+		to.min.mad			(box.min,dir,dist);
+		to.max.mad			(box.max,dir,dist);
+		Fbox	step		= from;
+		step.merge			(to);
+		if (!step.intersect(level))	break;
+		grid_cells			(step,cells);
+		from				= to;
+	}
+}
+
+u64		CLightmapCache::key		(CDeflector& D, base_lighting& selected)
+{
+	lmc_hash	H;
+	H.add		(global);
+
+	// Geometry of the deflector
+	Fbox		region;		region.invalidate	();
+	H.add		(D.layer.width);
+	H.add		(D.layer.height);
+	for (u32 it=0; it<D.UVpolys.size(); it++)
+	{
+		UVtri&	T	= D.UVpolys[it];
+		Face*	F	= T.owner;
+		H.add		(T.uv,sizeof(T.uv));
+		H.add		(F->N);
+		for (int v=0; v<3; v++)	{
+			H.add			(F->v[v]->P);
+			H.add			(F->v[v]->N);
+			region.modify	(F->v[v]->P);
+		}
+	}
+
+	// Lights, the shadow rays of the point lights stay inside the box of the deflector and the light,
+	// the ones of the sun and hemi go the whole ray range from the deflector
+	Fbox				bounds	= region;
+	xr_vector<Fvector>	directions;
+	key_lights	(H,selected.rgb,region,directions);
+	key_lights	(H,selected.sun,region,directions);
+	key_lights	(H,selected.hemi,region,directions);
+	region.grow	(EPS_L);
+	bounds.grow	(EPS_L);
+
+	// Occluders, every cell once
+	xr_vector<u32>		cells;
+	grid_cells	(region,cells);
+	for (u32 it=0; it<directions.size(); it++)
+		sweep_cells		(bounds,directions[it],cells);
+	std::sort	(cells.begin(),cells.end());
+	cells.erase	(std::unique(cells.begin(),cells.end()),cells.end());
+	for (u32 it=0; it<cells.size(); it++)
+		H.add	(grid.cells[cells[it]]);
+
+	return		H.value;
+}
+
+BOOL	CLightmapCache::read	(u64 key, lm_layer& dest)
+{
+	BOOL	found	= FALSE;
+	lock.Enter		();
+	xr_map<u64,u32>::iterator	it	= prev_index.find(key);
+	if (it!=prev_index.end())
+	{
+		prev->seek		(it->second);
+		lmc_reader		R	(*prev);
+		dest.read		(R);
+		found			= TRUE;
+		hits			++;
+	}
+	else				misses	++;
+	lock.Leave		();
+	return	found;
+}
+
+void	CLightmapCache::write	(u64 key, const lm_layer& src)
+{
+	CMemoryWriter	W;
+	src.write		(W);
+
+	lock.Enter		();
+	next->w_u64		(key);
+	next->w_u32		(W.size());
+	next->w			(W.pointer(),W.size());
+	lock.Leave		();
+}
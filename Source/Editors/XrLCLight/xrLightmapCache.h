@@ -0,0 +1,42 @@
+#pragma once
+
+class	CDeflector;
+class	base_lighting;
+struct	lm_layer;
+
+// Lightmaps of the previous builds of the level, keyed by everything the lighting of a deflector reads:
+// its geometry, the lights selected for it and the occluders its shadow rays can hit, so only the
+// deflectors around a change (or in its shadow) are lit again
+class XRLC_LIGHT_API CLightmapCache
+{
+	struct	cell_grid
+	{
+		Fvector				origin;
+		int					size_x, size_y, size_z;
+		xr_vector<u64>		cells;			// sum of the hashes of the triangles overlapping the cell
+	};
+
+	xrCriticalSection		lock;
+	string_path				name;
+	string_path				name_new;
+	IReader*				prev;
+	xr_map<u64,u32>			prev_index;		// key -> record in 'prev'
+	IWriter*				next;
+	cell_grid				grid;
+	u64						global;			// build params and lighting options
+	u32						hits;
+	u32						misses;
+
+	void					build_grid		();
+	void					grid_cells		(const Fbox& box, xr_vector<u32>& cells);
+	void					sweep_cells		(const Fbox& box, const Fvector& dir, xr_vector<u32>& cells);
+public:
+							CLightmapCache	(LPCSTR level_path);
+							~CLightmapCache	();
+
+	u64						key				(CDeflector& D, base_lighting& selected);
+	BOOL					read			(u64 key, lm_layer& dest);
+	void					write			(u64 key, const lm_layer& src);
+};
+
+extern XRLC_LIGHT_API CLightmapCache*	lm_cache;
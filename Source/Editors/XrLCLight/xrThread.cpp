@@ -57,3 +57,142 @@ void	CThreadManager::wait	(u32	sleep_time)
 		if (threads[thID]->thDestroyOnComplete)	xr_delete(threads[thID]);
 	threads.clear	();
 }
+
+//////////////////////////////////////////////////////////////////////////
+struct	task_run;
+struct	task_worker
+{
+	task_run*			run;
+	u32					id;
+	xrCriticalSection	lock;
+	volatile u32		begin;				// run of the positions in task_run::order
+	volatile u32		end;
+};
+
+struct	task_run
+{
+	LPCSTR				phase;
+	CTaskPool::task_func*	func;
+	void*				param;
+	xr_vector<u32>		order;				// position -> task
+	xr_vector<task_worker*>	workers;
+	volatile LONG		done;
+	volatile LONG		stolen;
+	volatile LONG		finished;
+	HANDLE				ev_finished;
+};
+
+u32		CTaskPool::workers	()
+{
+	return	_max(CPU::ID.n_threads,u32(1));
+}
+
+static BOOL	task_take	(task_worker& W, u32& pos)
+{
+	BOOL	result		= FALSE;
+	W.lock.Enter		();
+	if (W.begin<W.end)	{ pos = W.begin++; result = TRUE; }
+	W.lock.Leave		();
+	return	result;
+}
+
+static BOOL	task_steal	(task_worker& W, u32& pos)
+{
+	task_run&	R		= *W.run;
+	for (;;)
+	{
+		// the longest run, read without locking: it is only a hint
+		task_worker*	victim	= 0;
+		u32				best	= 0;
+		for (u32 it=0; it<R.workers.size(); it++)
+		{
+			task_worker*	V	= R.workers[it];
+			u32		left		= (V->end>V->begin) ? V->end-V->begin : 0;
+			if (V!=&W && left>best)	{ best = left; victim = V; }
+		}
+		if (0==victim)	return FALSE;
+
+		victim->lock.Enter	();
+		u32		left		= (victim->end>victim->begin) ? victim->end-victim->begin : 0;
+		if (0==left)		{ victim->lock.Leave(); continue; }
+		u32		take		= (left+1)/2;
+		victim->end			-= take;
+		u32		from		= victim->end;
+		victim->lock.Leave	();
+
+		W.lock.Enter		();
+		W.begin				= from+1;
+		W.end				= from+take;
+		W.lock.Leave		();
+		InterlockedIncrement(&R.stolen);
+		pos					= from;
+		return	TRUE;
+	}
+}
+
+static void	task_worker_proc	(void* P)
+{
+	task_worker&	W	= *(task_worker*)P;
+	task_run&		R	= *W.run;
+
+	FPU::m64r			();
+	SetThreadPriority	(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+
+	u32		pos;
+	while (task_take(W,pos) || task_steal(W,pos))
+	{
+		u32	task		= R.order[pos];
+		try {
+			R.func		(task,W.id,R.param);
+		} catch (...)
+		{
+			clMsg		("* ERROR: %s - task %d",R.phase,task);
+		}
+		InterlockedIncrement	(&R.done);
+	}
+	if (u32(InterlockedIncrement(&R.finished))==R.workers.size())
+		SetEvent			(R.ev_finished);
+}
+
+void	CTaskPool::run	(LPCSTR phase, u32 count, task_func* func, void* param, BOOL report, u32 sleep_time)
+{
+	if (0==count)		return;
+
+	task_run			R;
+	R.phase				= phase;
+	R.func				= func;
+	R.param				= param;
+	R.done				= 0;
+	R.stolen			= 0;
+	R.finished			= 0;
+	R.ev_finished		= CreateEvent	(NULL,TRUE,FALSE,NULL);
+
+	// deal the tasks to the runs in turn: every run starts with its most expensive ones
+	u32		W			= _min(workers(),count);
+	R.order.resize		(count);
+	u32		pos			= 0;
+	for (u32 w=0; w<W; w++)
+	{
+		task_worker*	T	= xr_new<task_worker>	();
+		T->run			= &R;
+		T->id			= w;
+		T->begin		= pos;
+		for (u32 task=w; task<count; task+=W)	R.order[pos++] = task;
+		T->end			= pos;
+		R.workers.push_back	(T);
+	}
+
+	CTimer		start_time;	start_time.Start();
+	for (u32 w=0; w<W; w++)
+		thread_spawn	(task_worker_proc,"worker-thread",1024*1024,R.workers[w]);
+
+	while (WAIT_TIMEOUT==WaitForSingleObject(R.ev_finished,sleep_time))
+	{
+		if (report)		Progress(float(R.done)/float(count));
+	}
+	CloseHandle			(R.ev_finished);
+
+	clMsg	("* %s: %d tasks on %d workers, %d steals, %f seconds",phase,count,W,R.stolen,start_time.GetElapsed_sec());
+	for (u32 w=0; w<W; w++)
+		xr_delete		(R.workers[w]);
+}
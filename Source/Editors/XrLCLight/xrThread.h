@@ -37,6 +37,19 @@ public:
 	void				wait	(u32		sleep_time=1000);
 };
 
+// Work-stealing task pool, one worker per hardware thread.
+// Every worker owns a run of the tasks and takes them from the front, a worker without tasks
+// steals the back half of the longest run left. The tasks are dealt to the runs in turn, so
+// the caller lists the expensive ones first. run() returns when all the tasks are done.
+class XRLC_LIGHT_API CTaskPool
+{
+public:
+	typedef void		task_func	(u32 task, u32 worker, void* param);
+
+	static u32			workers		();
+	static void			run			(LPCSTR phase, u32 count, task_func* func, void* param, BOOL report=TRUE, u32 sleep_time=500);
+};
+
 
 IC void get_intervals( u32 max_threads, u32 num_items, u32 &threads, u32 &stride, u32 &rest )
 {
@@ -0,0 +1,278 @@
+/************************************************************************
+
+  Partitioned edge contraction, see MxPartitionSlim.h
+
+ ************************************************************************/
+#include "stdafx.h"
+#pragma hdrstop
+
+#include "MxPartitionSlim.h"
+
+struct centroid_less
+{
+	const xr_vector<Fvector>&	C;
+	int							axis;
+	centroid_less	(const xr_vector<Fvector>& _C, int _axis) : C(_C), axis(_axis)	{}
+	bool	operator()	(u32 a, u32 b) const	{ return C[a][axis]<C[b][axis]; }
+};
+
+MxPartitionSlim::MxPartitionSlim()
+{
+	part_faces		= 65536;
+	setup			= NULL;
+	setup_param		= NULL;
+	run				= NULL;
+	parts			= 0;
+	border_verts	= 0;
+	seam_faces		= 0;
+	m_max_error		= 0;
+}
+
+// median splits across the longest side of the centroids' box until a cluster fits in part_faces
+void MxPartitionSlim::split(u32 face_count)
+{
+	xr_vector<Fvector>	C(face_count);
+	xr_vector<u32>		order(face_count);
+	for (u32 f=0; f<face_count; f++)
+	{
+		const u32*	F	= &m_faces[f*3];
+		C[f].add		(m_verts[F[0]],m_verts[F[1]]).add(m_verts[F[2]]).div(3.f);
+		order[f]		= f;
+	}
+
+	m_parts.clear		();
+	xr_vector<std::pair<u32,u32> >	ranges;
+	ranges.push_back	(std::make_pair(u32(0),face_count));
+	while (!ranges.empty())
+	{
+		u32	b			= ranges.back().first;
+		u32	e			= ranges.back().second;
+		ranges.pop_back	();
+		if (e-b<=part_faces || 0==part_faces)
+		{
+			m_parts.push_back		(submesh());
+			m_parts.back().faces.assign	(order.begin()+b,order.begin()+e);
+			continue;
+		}
+
+		Fbox	bb;		bb.invalidate();
+		for (u32 i=b; i<e; i++)	bb.modify(C[order[i]]);
+		Fvector	size;	bb.getsize(size);
+		int	axis		= (size.x>=size.y && size.x>=size.z)?0:((size.y>=size.z)?1:2);
+		u32	mid			= b+(e-b)/2;
+		std::nth_element(order.begin()+b,order.begin()+mid,order.begin()+e,centroid_less(C,axis));
+		ranges.push_back(std::make_pair(b,mid));
+		ranges.push_back(std::make_pair(mid,e));
+	}
+}
+
+// a vertex used by more than one cluster is not moved by any of them
+void MxPartitionSlim::lock_borders()
+{
+	xr_vector<u32>	owner(m_verts.size(),u32(-1));
+	for (u32 p=0; p<(u32)m_parts.size(); p++)
+	{
+		xr_vector<u32>&	faces	= m_parts[p].faces;
+		for (u32 i=0; i<(u32)faces.size(); i++)
+			for (u32 k=0; k<3; k++)
+			{
+				u32&	o		= owner[m_faces[faces[i]*3+k]];
+				if (u32(-1)==o)	o	= p;
+				else if (o!=p)	o	= u32(-2);
+			}
+	}
+	for (u32 v=0; v<(u32)m_verts.size(); v++)
+	{
+		m_locked[v]		= u8(u32(-2)==owner[v]);
+		border_verts	+= m_locked[v];
+	}
+}
+
+void MxPartitionSlim::simplify(submesh& S)
+{
+	if (S.faces.empty())	return;
+
+	// local vertices, sorted by the working mesh id
+	xr_vector<u32>	remap;
+	remap.reserve		(S.faces.size()*3);
+	for (u32 i=0; i<(u32)S.faces.size(); i++)
+		for (u32 k=0; k<3; k++)
+			remap.push_back	(m_faces[S.faces[i]*3+k]);
+	std::sort			(remap.begin(),remap.end());
+	remap.erase			(std::unique(remap.begin(),remap.end()),remap.end());
+
+	MxStdModel*		mdl	= xr_new<MxStdModel>((u32)remap.size(),(u32)S.faces.size());
+	for (u32 v=0; v<(u32)remap.size(); v++)
+	{
+		const Fvector&	P	= m_verts[remap[v]];
+		mdl->add_vertex		(P.x,P.y,P.z);
+		if (m_locked[remap[v]])
+			mdl->vertex_mark_locked	(v);
+	}
+	xr_vector<u32>	source(S.faces.size());
+	for (u32 i=0; i<(u32)S.faces.size(); i++)
+	{
+		u32	id[3];
+		for (u32 k=0; k<3; k++)
+			id[k]		= u32(std::lower_bound(remap.begin(),remap.end(),m_faces[S.faces[i]*3+k])-remap.begin());
+		mdl->add_face	(id[0],id[1],id[2]);
+		source[i]		= m_source[S.faces[i]];
+	}
+
+	MxEdgeQSlim*	slim	= xr_new<MxEdgeQSlim>(mdl);
+	if (setup)		setup	(*slim,&source.front(),setup_param);
+	else			slim->initialize();
+	slim->collect_edges		();
+	slim->decimate			(0,m_max_error);
+
+	// the surviving faces, the vertices in the order they are met
+	xr_vector<u32>	local(remap.size(),u32(-1));
+	for (u32 f=0; f<mdl->face_count(); f++)
+	{
+		if (!mdl->face_is_valid(f))	continue;
+		MxFace&		F	= mdl->face(f);
+		for (u32 k=0; k<3; k++)
+		{
+			u32&	L	= local[F[k]];
+			if (u32(-1)==L)
+			{
+				L		= (u32)S.verts.size();
+				S.verts.push_back	(*((Fvector*)&mdl->vertex(F[k])));
+				S.ids.push_back		(mdl->vertex_is_locked(F[k])?remap[F[k]]:u32(-1));
+			}
+			S.tris.push_back		(L);
+		}
+		S.source.push_back			(source[f]);
+	}
+
+	xr_delete		(slim);
+	xr_delete		(mdl);
+}
+
+u32 MxPartitionSlim::out_vertex(xr_vector<u32>& remap, u32 v)
+{
+	if (u32(-1)==remap[v])
+	{
+		remap[v]		= (u32)out_verts.size();
+		out_verts.push_back	(m_verts[v]);
+		m_out_locked.push_back	(m_locked[v]);
+	}
+	return remap[v];
+}
+
+// the faces kept from the working mesh and the results of the submeshes, the locked vertices are shared
+void MxPartitionSlim::merge(const xr_vector<u8>* keep)
+{
+	xr_vector<u32>	remap(m_verts.size(),u32(-1));
+	out_verts.clear		();
+	out_faces.clear		();
+	out_source.clear	();
+	m_out_locked.clear	();
+
+	if (keep)
+	{
+		for (u32 f=0; f<(u32)m_source.size(); f++)
+		{
+			if (!(*keep)[f])	continue;
+			for (u32 k=0; k<3; k++)
+				out_faces.push_back	(out_vertex(remap,m_faces[f*3+k]));
+			out_source.push_back	(m_source[f]);
+		}
+	}
+
+	for (u32 p=0; p<(u32)m_parts.size(); p++)
+	{
+		submesh&		S	= m_parts[p];
+		xr_vector<u32>	local(S.verts.size());
+		for (u32 v=0; v<(u32)S.verts.size(); v++)
+		{
+			if (u32(-1)!=S.ids[v])
+			{
+				local[v]	= out_vertex(remap,S.ids[v]);
+				continue;
+			}
+			local[v]		= (u32)out_verts.size();
+			out_verts.push_back		(S.verts[v]);
+			m_out_locked.push_back	(0);
+		}
+		for (u32 i=0; i<(u32)S.tris.size(); i++)
+			out_faces.push_back		(local[S.tris[i]]);
+		out_source.insert	(out_source.end(),S.source.begin(),S.source.end());
+	}
+}
+
+// the faces at the cluster borders, only the vertices they share with the rest of the mesh are locked now
+void MxPartitionSlim::lock_seam(submesh& S, xr_vector<u8>& keep)
+{
+	u32	face_count		= (u32)m_source.size();
+	keep.assign			(face_count,1);
+	for (u32 f=0; f<face_count; f++)
+	{
+		const u32*	F	= &m_faces[f*3];
+		if (m_locked[F[0]] || m_locked[F[1]] || m_locked[F[2]])
+		{
+			S.faces.push_back	(f);
+			keep[f]		= 0;
+		}
+	}
+
+	m_locked.assign		(m_verts.size(),0);
+	for (u32 f=0; f<face_count; f++)
+	{
+		if (!keep[f])	continue;
+		for (u32 k=0; k<3; k++)
+			m_locked[m_faces[f*3+k]]	= 1;
+	}
+}
+
+void MxPartitionSlim::part_task(u32 task, u32 worker, void* param)
+{
+	MxPartitionSlim*	P	= (MxPartitionSlim*)param;
+	P->simplify			(P->m_parts[task]);
+}
+
+void MxPartitionSlim::decimate(const Fvector* verts, u32 vert_count, const u32* faces, u32 face_count, float max_error)
+{
+	m_verts.assign		(verts,verts+vert_count);
+	m_faces.assign		(faces,faces+face_count*3);
+	m_source.resize		(face_count);
+	for (u32 f=0; f<face_count; f++)	m_source[f]	= f;
+	m_locked.assign		(vert_count,0);
+	m_max_error			= max_error;
+	parts				= 0;
+	border_verts		= 0;
+	seam_faces			= 0;
+
+	// clusters
+	split				(face_count);
+	parts				= (u32)m_parts.size();
+	if (parts>1)		lock_borders();
+	if (run && parts>1)	run	("qslim clusters",parts,part_task,this);
+	else
+		for (u32 p=0; p<parts; p++)	simplify(m_parts[p]);
+	merge				(NULL);
+	m_parts.clear		();
+
+	// seam
+	if (border_verts)
+	{
+		m_verts.swap		(out_verts);
+		m_faces.swap		(out_faces);
+		m_source.swap		(out_source);
+		m_locked.swap		(m_out_locked);
+
+		xr_vector<u8>		keep;
+		m_parts.resize		(1);
+		lock_seam			(m_parts[0],keep);
+		seam_faces			= (u32)m_parts[0].faces.size();
+		simplify			(m_parts[0]);
+		merge				(&keep);
+		m_parts.clear		();
+	}
+
+	m_verts.clear		();
+	m_faces.clear		();
+	m_source.clear		();
+	m_locked.clear		();
+	m_out_locked.clear	();
+}
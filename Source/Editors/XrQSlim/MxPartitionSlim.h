@@ -0,0 +1,82 @@
+#ifndef MXPARTITIONSLIM_INCLUDED // -*- C++ -*-
+#define MXPARTITIONSLIM_INCLUDED
+#if !defined(__GNUC__)
+#  pragma once
+#endif
+
+/************************************************************************
+
+  Partitioned edge contraction for the large meshes.
+
+  The faces are split by their centroids into clusters of part_faces,
+  every cluster is simplified as a model of its own with the vertices
+  it shares with the other clusters locked, so the clusters can go in
+  parallel and still give a closed mesh. The faces around the cluster
+  borders are then simplified once more with the vertices they share
+  with the rest of the mesh locked.
+
+ ************************************************************************/
+
+#include "MxQSlim.h"
+
+class MxPartitionSlim
+{
+public:
+	// policies, initialize() and the constraints of a submesh, source maps its faces to the input faces
+	typedef void	setup_func	(MxEdgeQSlim& slim, const u32* source, void* param);
+	typedef void	task_func	(u32 task, u32 worker, void* param);
+	// runs task(0..count-1), NULL runs them in place
+	typedef void	run_func	(LPCSTR phase, u32 count, task_func* task, void* param);
+
+	u32					part_faces;
+	setup_func*			setup;
+	void*				setup_param;
+	run_func*			run;
+
+	// the result: 3 ids per face and the input face of every face
+	xr_vector<Fvector>	out_verts;
+	xr_vector<u32>		out_faces;
+	xr_vector<u32>		out_source;
+
+	// statistics of the last decimate
+	u32					parts;
+	u32					border_verts;
+	u32					seam_faces;
+
+private:
+	struct submesh
+	{
+		xr_vector<u32>		faces;		// in the working mesh
+		xr_vector<Fvector>	verts;
+		xr_vector<u32>		ids;		// working mesh vertex of the locked ones, u32(-1) for the rest
+		xr_vector<u32>		tris;
+		xr_vector<u32>		source;
+	};
+
+	// the working mesh
+	xr_vector<Fvector>	m_verts;
+	xr_vector<u32>		m_faces;
+	xr_vector<u32>		m_source;
+	xr_vector<u8>		m_locked;
+	xr_vector<u8>		m_out_locked;
+
+	xr_vector<submesh>	m_parts;
+	float				m_max_error;
+
+	void		split			(u32 face_count);
+	void		lock_borders	();
+	void		simplify		(submesh& S);
+	u32			out_vertex		(xr_vector<u32>& remap, u32 v);
+	void		merge			(const xr_vector<u8>* keep);
+	void		lock_seam		(submesh& S, xr_vector<u8>& keep);
+	static void	part_task		(u32 task, u32 worker, void* param);
+
+public:
+	MxPartitionSlim				();
+
+	// verts: the positions, faces: 3 ids per face; stops at max_error as MxEdgeQSlim::decimate(0,max_error) does
+	void		decimate		(const Fvector* verts, u32 vert_count, const u32* faces, u32 face_count, float max_error);
+};
+
+// MXPARTITIONSLIM_INCLUDED
+#endif
@@ -444,14 +444,16 @@ void MxEdgeQSlim::collect_edges()
 
 		for(unsigned int j=0; j<(unsigned int)star.length(); j++)
 			if( i < star(j) )  // Only add particular edge once
-				create_edge(i, star(j));
+				if( !m->vertex_is_locked(i) && !m->vertex_is_locked(star(j)) )
+					create_edge(i, star(j));
 	}
 }
 
 void MxEdgeQSlim::collect_edges(const MxEdge *edges, unsigned int count)
 {
 	for(unsigned int i=0; i<count; i++)
-		create_edge(edges[i].v1, edges[i].v2);
+		if( !m->vertex_is_locked(edges[i].v1) && !m->vertex_is_locked(edges[i].v2) )
+			create_edge(edges[i].v1, edges[i].v2);
 }
 
 void MxEdgeQSlim::update_pre_contract(const MxPairContraction& conx)
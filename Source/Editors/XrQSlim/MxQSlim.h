@@ -84,6 +84,7 @@ public:
     virtual ~MxEdgeQSlim();
 
     void initialize			();
+	// no edge is made at a locked vertex, so it is never moved or removed
 	void collect_edges		();
 	void collect_edges		(const MxEdge *edges, unsigned int count);
     bool decimate			(unsigned int target, float max_error, void* cb_params=0);
@@ -5,6 +5,7 @@
 #include "process.h"
 
 #include "../xrlclight/xrlc_light.h"
+#include "../xrlclight/net_cl_data_prepare.h"
 //#pragma comment(linker,"/STACK:0x800000,0x400000")
 
 
@@ -18,6 +19,8 @@ static const char* h_str =
 	"-? or -h	== this help\n"
 	"-f<NAME>	== compile level in gamedata\\levels\\<NAME>\\\n"
 	"-o			== modify build options\n"
+	"-net		== light in worker processes of this machine\n"
+	"-netgrid	== with -net, send the lighting tasks to the hxgrid agents instead\n"
 	"\n"
 	"NOTE: The last key is required for any functionality\n";
 
@@ -36,6 +39,7 @@ void Startup(LPSTR     lpCmdLine)
 //	if (strstr(cmd,"-o"))								bModifyOptions = TRUE;
 	if ( strstr(cmd,"-net") )						
 														bNet = true;
+	SetNetTaskGrid		( !!strstr(cmd,"-netgrid") );
 	// Give a LOG-thread a chance to startup
 	InitCommonControls	();
 	thread_spawn		(logThread,	"log-update", 1024*1024,0);
@@ -75,6 +79,20 @@ int APIENTRY WinMain(HINSTANCE hInstance,
 {
 	// Initialize debugging
 	Debug._initialize	(false);
+
+	// a worker process of -net, the tasks come over the pipes of the compiler
+	if (strstr(lpCmdLine,"-networker"))
+	{
+		u32		from = 0, to = 0, index = 0;
+		sscanf				(strstr(lpCmdLine,"-networker")+10,"%u %u %u",&from,&to,&index);
+		string64			app;
+		xr_sprintf			(app,"xrDO_worker%d",index);
+		Core._initialize	(app);
+		int		result		= RunNetLocalWorker(lpCmdLine);
+		Core._destroy		();
+		return result;
+	}
+
 	Core._initialize	("xrDO");
 	Startup				(lpCmdLine);
 	
@@ -176,4 +176,6 @@ RESULT& COLLIDER::r_add	()
 void COLLIDER::r_free	()
 {
 	rd.clear_and_free	();
+	rp_sort.clear_and_free	();
+	rp_ray.clear_and_free	();
 }
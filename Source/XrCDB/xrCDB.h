@@ -138,6 +138,32 @@ namespace CDB
 		OPT_FULL_TEST   = (1<<3)		// for box & frustum queries - enable class III test(s)
 	};
 
+	// Ray packet - up to 16 rays go down the tree together, a node is opened once for all of them
+	const u32		rpMaxRays		= 16;
+	struct XRCDB_API RAY_PACKET
+	{
+		u32				count;
+		Fvector			start	[rpMaxRays];
+		Fvector			dir		[rpMaxRays];
+		float			range	[rpMaxRays];
+
+		// results of the ray 'i' are r_begin()[first[i]] .. r_begin()[first[i]+hits[i]-1]
+		u32				first	[rpMaxRays];
+		u32				hits	[rpMaxRays];
+
+		RAY_PACKET		()		{ count = 0; }
+		IC void			clear	()	{ count = 0;	}
+		IC BOOL			full	()	{ return count==rpMaxRays;	}
+		IC u32			add		(const Fvector& P, const Fvector& D, float R)
+		{
+			VERIFY			(count<rpMaxRays);
+			start[count].set(P);
+			dir	[count].set	(D);
+			range[count]	= R;
+			return			count++;
+		}
+	};
+
 	// Collider itself
 	class XRCDB_API COLLIDER
 	{
@@ -148,12 +174,15 @@ namespace CDB
 
 		// Result management
 		xr_vector<RESULT>	rd;
+		xr_vector<RESULT>	rp_sort;
+		xr_vector<u8>		rp_ray;
 	public:
 		COLLIDER		();
 		~COLLIDER		();
 
 		ICF void		ray_options		(u32 f)	{	ray_mode = f;		}
 		void			ray_query		(const MODEL *m_def, const Fvector& r_start,  const Fvector& r_dir, float r_range = 10000.f);
+		void			ray_packet		(const MODEL *m_def, RAY_PACKET& P);		// OPT_CULL, OPT_ONLYFIRST (any-hit, per ray)
 
 		ICF void		box_options		(u32 f)	{	box_mode = f;		}
 		void			box_query		(const MODEL *m_def, const Fvector& b_center, const Fvector& b_dim);
@@ -463,3 +463,249 @@ void	COLLIDER::ray_query	(const MODEL *m_def, const Fvector& r_start,  const Fve
 	}
 }
 
+
+//--------------------------------------------------------------------------------------------
+// Ray packet: the rays are kept as SoA groups of four, one slab test opens a node for a group
+template <bool bCull>
+ICF bool	isect_tri	(const Fvector& pos, const Fvector& dir, const Fvector* verts, const u32* p, float& u, float& v, float& range)
+{
+	Fvector edge1, edge2, tvec, pvec, qvec;
+	float	det,inv_det;
+
+	const Fvector&		p0	= verts[ p[0] ];
+	const Fvector&		p1	= verts[ p[1] ];
+	const Fvector&		p2	= verts[ p[2] ];
+	edge1.sub			(p1, p0);
+	edge2.sub			(p2, p0);
+	pvec.crossproduct	(dir, edge2);
+	det = edge1.dotproduct(pvec);
+	if (bCull)
+	{
+		if (det < EPS)  return false;
+		tvec.sub(pos, p0);
+		u = tvec.dotproduct(pvec);
+		if (u < 0.f || u > det) return false;
+		qvec.crossproduct(tvec, edge1);
+		v = dir.dotproduct(qvec);
+		if (v < 0.f || u + v > det) return false;
+		range = edge2.dotproduct(qvec);
+		inv_det = 1.0f / det;
+		range	*= inv_det;
+		u		*= inv_det;
+		v		*= inv_det;
+	}
+	else
+	{
+		if (det > -EPS && det < EPS) return false;
+		inv_det = 1.0f / det;
+		tvec.sub(pos, p0);
+		u = tvec.dotproduct(pvec)*inv_det;
+		if (u < 0.0f || u > 1.0f)    return false;
+		qvec.crossproduct(tvec, edge1);
+		v = dir.dotproduct(qvec)*inv_det;
+		if (v < 0.0f || u + v > 1.0f) return false;
+		range = edge2.dotproduct(qvec)*inv_det;
+	}
+	return true;
+}
+
+template <bool bCull, bool bFirst>
+class _MM_ALIGN16	ray_packet_collider
+{
+public:
+	__m128			pos_x	[rpMaxRays/4], pos_y	[rpMaxRays/4], pos_z	[rpMaxRays/4];
+	__m128			inv_x	[rpMaxRays/4], inv_y	[rpMaxRays/4], inv_z	[rpMaxRays/4];
+	__m128			range	[rpMaxRays/4];
+
+	COLLIDER*		dest;
+	xr_vector<u8>*	owner;			// ray of every result
+	TRI*			tris;
+	Fvector*		verts;
+	RAY_PACKET*		P;
+	u32				groups;
+	u32				live;			// a bit per ray still traced
+
+	IC void			_init		(COLLIDER* CL, xr_vector<u8>* O, Fvector* V, TRI* T, RAY_PACKET& RP)
+	{
+		dest			= CL;
+		owner			= O;
+		tris			= T;
+		verts			= V;
+		P				= &RP;
+		groups			= (RP.count+3)/4;
+		live			= (1<<RP.count)-1;
+
+		_MM_ALIGN16 float	px[4],py[4],pz[4],ix[4],iy[4],iz[4],rr[4];
+		for (u32 g=0; g<groups; g++)
+		{
+			for (u32 l=0; l<4; l++)
+			{
+				// the tail repeats the last ray, its bit is never set
+				u32		r	= _min(g*4+l,RP.count-1);
+				px[l]		= RP.start[r].x;		ix[l]	= 1.f/RP.dir[r].x;
+				py[l]		= RP.start[r].y;		iy[l]	= 1.f/RP.dir[r].y;
+				pz[l]		= RP.start[r].z;		iz[l]	= 1.f/RP.dir[r].z;
+				rr[l]		= RP.range[r];
+			}
+			pos_x[g]	= loadps(px);	inv_x[g]	= loadps(ix);
+			pos_y[g]	= loadps(py);	inv_y[g]	= loadps(iy);
+			pos_z[g]	= loadps(pz);	inv_z[g]	= loadps(iz);
+			range[g]	= loadps(rr);
+		}
+	}
+
+	// same NaN filtering as isect_sse, four rays at once
+	ICF u32			_box		(const AABBNoLeafNode* node, u32 mask)
+	{
+		const Fvector&	C	= (const Fvector&)node->mAABB.mCenter;
+		const Fvector&	E	= (const Fvector&)node->mAABB.mExtents;
+		const __m128
+			plus_inf	= loadps(ps_cst_plus_inf),
+			minus_inf	= loadps(ps_cst_minus_inf),
+			zero		= _mm_setzero_ps(),
+			min_x		= _mm_set1_ps(C.x-E.x),	max_x	= _mm_set1_ps(C.x+E.x),
+			min_y		= _mm_set1_ps(C.y-E.y),	max_y	= _mm_set1_ps(C.y+E.y),
+			min_z		= _mm_set1_ps(C.z-E.z),	max_z	= _mm_set1_ps(C.z+E.z);
+
+		u32		result	= 0;
+		for (u32 g=0; g<groups; g++)
+		{
+			if (0==((mask>>(g*4))&0xf))	continue;
+
+			__m128	l1		= mulps(subps(min_x,pos_x[g]),inv_x[g]);
+			__m128	l2		= mulps(subps(max_x,pos_x[g]),inv_x[g]);
+			__m128	t_far	= maxps(minps(l1,plus_inf),minps(l2,plus_inf));
+			__m128	t_near	= minps(maxps(l1,minus_inf),maxps(l2,minus_inf));
+
+			l1				= mulps(subps(min_y,pos_y[g]),inv_y[g]);
+			l2				= mulps(subps(max_y,pos_y[g]),inv_y[g]);
+			t_far			= minps(t_far, maxps(minps(l1,plus_inf),minps(l2,plus_inf)));
+			t_near			= maxps(t_near,minps(maxps(l1,minus_inf),maxps(l2,minus_inf)));
+
+			l1				= mulps(subps(min_z,pos_z[g]),inv_z[g]);
+			l2				= mulps(subps(max_z,pos_z[g]),inv_z[g]);
+			t_far			= minps(t_far, maxps(minps(l1,plus_inf),minps(l2,plus_inf)));
+			t_near			= maxps(t_near,minps(maxps(l1,minus_inf),maxps(l2,minus_inf)));
+
+			__m128	hit		= _mm_and_ps(_mm_cmpge_ps(t_far,zero),_mm_cmpge_ps(t_far,t_near));
+			hit				= _mm_and_ps(hit,_mm_cmple_ps(t_near,range[g]));
+			result			|= u32(_mm_movemask_ps(hit))<<(g*4);
+		}
+		return	result&mask;
+	}
+
+	void			_prim		(DWORD prim, u32 mask)
+	{
+		for (u32 r=0; mask; r++, mask>>=1)
+		{
+			if (0==(mask&1))	continue;
+
+			float	u,v,t;
+			if (!isect_tri<bCull>(P->start[r],P->dir[r],verts,tris[prim].verts,u,v,t))	continue;
+			if (t<=0 || t>P->range[r])	continue;
+
+			RESULT& R	= dest->r_add();
+			R.id		= prim;
+			R.range		= t;
+			R.u			= u;
+			R.v			= v;
+			R.verts	[0]	= verts[tris[prim].verts[0]];
+			R.verts	[1]	= verts[tris[prim].verts[1]];
+			R.verts	[2]	= verts[tris[prim].verts[2]];
+			R.dummy		= tris[prim].dummy;
+			owner->push_back	(u8(r));
+			if (bFirst)	live	&= ~(1<<r);
+		}
+	}
+
+	void			_stab		(const AABBNoLeafNode* node, u32 mask)
+	{
+		_mm_prefetch( (char *) node->GetNeg() , _MM_HINT_NTA );
+
+		mask			= _box(node,mask&live);
+		if (0==mask)	return;
+
+		// 1st chield
+		if (node->HasLeaf())	_prim	(node->GetPrimitive(),mask);
+		else					_stab	(node->GetPos(),mask);
+
+		// Early exit for "only first" - when every ray of the node has its hit
+		if (bFirst)	{
+			mask		&= live;
+			if (0==mask)	return;
+		}
+
+		// 2nd chield
+		if (node->HasLeaf2())	_prim	(node->GetPrimitive2(),mask);
+		else					_stab	(node->GetNeg(),mask);
+	}
+};
+
+void	COLLIDER::ray_packet	(const MODEL *m_def, RAY_PACKET& P)
+{
+	m_def->syncronize		();
+	VERIFY					(P.count<=rpMaxRays);
+
+	r_clear					();
+	rp_ray.clear_not_free	();
+	rp_sort.clear_not_free	();
+	for (u32 r=0; r<P.count; r++)	{ P.first[r] = 0; P.hits[r] = 0; }
+	if (0==P.count)			return;
+
+	if (0==(CPU::ID.feature&_CPU_FEATURE_SSE))	{
+		// FPU - ray by ray, "nearest" is not a packet option
+		u32		mode		= ray_mode;
+		ray_mode			&= ~OPT_ONLYNEAREST;
+		for (u32 r=0; r<P.count; r++)
+		{
+			ray_query		(m_def,P.start[r],P.dir[r],P.range[r]);
+			P.first[r]		= rp_sort.size();
+			P.hits[r]		= rd.size();
+			rp_sort.insert	(rp_sort.end(),rd.begin(),rd.end());
+		}
+		ray_mode			= mode;
+		rd.swap				(rp_sort);
+		return;
+	}
+
+	// Get nodes
+	const AABBNoLeafTree* T = (const AABBNoLeafTree*)m_def->tree->GetTree();
+	const AABBNoLeafNode* N = T->GetNodes();
+	u32		mask			= (1<<P.count)-1;
+
+	// Binary dispatcher
+	if (ray_mode&OPT_CULL)		{
+		if (ray_mode&OPT_ONLYFIRST)		{
+			ray_packet_collider<true,true>		RC;
+			RC._init(this,&rp_ray,m_def->verts,m_def->tris,P);
+			RC._stab(N,mask);
+		} else {
+			ray_packet_collider<true,false>		RC;
+			RC._init(this,&rp_ray,m_def->verts,m_def->tris,P);
+			RC._stab(N,mask);
+		}
+	} else {
+		if (ray_mode&OPT_ONLYFIRST)		{
+			ray_packet_collider<false,true>		RC;
+			RC._init(this,&rp_ray,m_def->verts,m_def->tris,P);
+			RC._stab(N,mask);
+		} else {
+			ray_packet_collider<false,false>	RC;
+			RC._init(this,&rp_ray,m_def->verts,m_def->tris,P);
+			RC._stab(N,mask);
+		}
+	}
+
+	// Group the results by ray, the order of a ray's hits stays as the tree gave them
+	u32		total			= rd.size();
+	for (u32 it=0; it<total; it++)	P.hits[rp_ray[it]]	++;
+	u32		fill	[rpMaxRays];
+	for (u32 r=0, offset=0; r<P.count; r++)	{
+		P.first[r]			= offset;
+		fill[r]				= offset;
+		offset				+= P.hits[r];
+	}
+	rp_sort.resize			(total);
+	for (u32 it=0; it<total; it++)	rp_sort[fill[rp_ray[it]]++]	= rd[it];
+	rd.swap					(rp_sort);
+}
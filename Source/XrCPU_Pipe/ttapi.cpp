@@ -16,6 +16,7 @@ static DWORD ttapi_workers_count = 0;
 static DWORD ttapi_threads_count = 0;
 static DWORD ttapi_assigned_workers = 0;
 static LPTTAPI_WORKER_PARAMS ttapi_worker_params = NULL;
+static volatile LONG ttapi_owner = 0;
 
 struct {
 	volatile LONG size;
@@ -182,6 +183,22 @@ VOID ttapi_RunAllWorkers()
 	ttapi_assigned_workers = 0;
 }
 
+BOOL ttapi_TryLock()
+{
+	return ( _InterlockedCompareExchange( &ttapi_owner , (LONG) GetCurrentThreadId() , 0 ) == 0 );
+}
+
+VOID ttapi_Lock()
+{
+	while ( ! ttapi_TryLock() )
+		SwitchToThread();
+}
+
+VOID ttapi_Unlock()
+{
+	_InterlockedExchange( &ttapi_owner , 0 );
+}
+
 VOID ttapi_Done()
 {
 	if ( ! ttapi_initialized )
@@ -37,6 +37,15 @@ extern "C"  {
 	// Runs and wait for all workers to complete job
 	VOID TTAPI ttapi_RunAllWorkers();
 
+	// The workers are shared by all the threads, every AddWorker..RunAllWorkers sequence is done under the lock
+	// Returns FALSE if another sequence (this thread's included) holds the workers
+	BOOL TTAPI ttapi_TryLock();
+
+	// Waits for the workers, never from inside a worker function
+	VOID TTAPI ttapi_Lock();
+
+	VOID TTAPI ttapi_Unlock();
+
 }
 
 #endif // _TTAPI_H_INCLUDED_
\ No newline at end of file
@@ -43,6 +43,7 @@ void  xrSkin4W_thread(	vertRender*		D,
 	u32 nStep = ( ( vCount - nSlice ) / nWorkers );
 	u32 nLast = vCount - nStep * ( nWorkers - 1 );
 
+	ttapi_Lock();
 	for ( u32 i = 0 ; i < nWorkers ; ++i ) {
 		sknParams[i].Dest = (LPVOID) ( D + i*nStep );
 		sknParams[i].Src = (LPVOID) ( S + i*nStep ) ;
@@ -53,5 +54,6 @@ void  xrSkin4W_thread(	vertRender*		D,
 	}
 
 	ttapi_RunAllWorkers();
+	ttapi_Unlock();
 }
 
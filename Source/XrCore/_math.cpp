@@ -252,6 +252,7 @@ void	thread_name	(const char* name)
 	__except(EXCEPTION_CONTINUE_EXECUTION)
 	{
 	}
+	trace_profiler::set_thread_name	(name);
 }
 #pragma pack(pop)
 
@@ -272,6 +273,7 @@ void	__cdecl			thread_entry	(void*	_params )	{
 
 	// call
 	entry				(arglist);
+	trace_profiler::thread_exit	();
 }
 
 HANDLE	thread_spawn	(thread_t*	entry, const char*	name, unsigned	stack, void* arglist )
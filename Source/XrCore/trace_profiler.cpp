@@ -0,0 +1,259 @@
+#include "stdafx.h"
+#pragma hdrstop
+
+#include <intrin.h>
+#include "trace_profiler.h"
+
+namespace trace_profiler {
+
+XRCORE_API BOOL					enabled		= TRUE;
+
+struct thread_ring {
+	event						events		[ring_size];
+	volatile u32				head;		// events written so far, the owner thread is the only writer
+	DWORD						thread_id;
+	u32							index;
+	string64					name;
+};
+
+// a thread gets a ring with its first event and gives it back when it ends, the events stay
+// in the ring for dump() until another thread takes it
+static __declspec(thread) thread_ring*	t_ring		= NULL;
+static __declspec(thread) u32			t_no_ring	= 0;		// frame + 1 of the last failed attempt
+static __declspec(thread) string64		t_name		= "";
+static thread_ring*				g_rings		[max_threads];	// allocated with the first use of the slot
+static u32						g_ring_count= 0;				// slots ever used
+static u32						g_free		[max_threads];
+static u32						g_free_count= 0;
+static volatile LONG			g_dropped	= 0;				// events of the threads without a ring
+#ifdef PROFILE_CRITICAL_SECTIONS
+	static xrCriticalSection	g_ring_lock(MUTEX_PROFILE_ID(trace_profiler::g_ring_lock));
+#else // PROFILE_CRITICAL_SECTIONS
+	static xrCriticalSection	g_ring_lock;
+#endif // PROFILE_CRITICAL_SECTIONS
+
+static string64					g_zones		[max_zones];
+static volatile LONG			g_zone_count= 0;
+#ifdef PROFILE_CRITICAL_SECTIONS
+	static xrCriticalSection	g_zone_lock(MUTEX_PROFILE_ID(trace_profiler::g_zone_lock));
+#else // PROFILE_CRITICAL_SECTIONS
+	static xrCriticalSection	g_zone_lock;
+#endif // PROFILE_CRITICAL_SECTIONS
+
+static u64						g_frames	[frame_history];
+static volatile u32				g_frame_count = 0;
+
+static thread_ring*	acquire_ring	()
+{
+	xrCriticalSection::raii		guard(&g_ring_lock);
+	u32							index;
+	if (g_free_count)
+		index					= g_free[--g_free_count];
+	else if (g_ring_count < max_threads) {
+		index					= g_ring_count++;
+		g_rings[index]			= xr_alloc<thread_ring>(1);
+	}
+	else
+		return					(NULL);
+
+	thread_ring*				ring = g_rings[index];
+	ring->head					= 0;
+	ring->thread_id				= GetCurrentThreadId();
+	ring->index					= index;
+	if (t_name[0])
+		xr_strcpy				(ring->name, t_name);
+	else
+		xr_sprintf				(ring->name, "thread %d", ring->thread_id);
+	t_ring						= ring;
+	return						(ring);
+}
+
+void thread_exit				()
+{
+	thread_ring*				ring = t_ring;
+	if (!ring)
+		return;
+
+	xrCriticalSection::raii		guard(&g_ring_lock);
+	g_free[g_free_count++]		= ring->index;
+	t_ring						= NULL;
+}
+
+u32 register_zone				(LPCSTR name)
+{
+	xrCriticalSection::raii		guard(&g_zone_lock);
+	for (LONG i = 0; i < g_zone_count; ++i)
+		if (!xr_strcmp(g_zones[i], name))
+			return				(u32(i));
+
+	R_ASSERT2					(g_zone_count < max_zones, "too many trace zones");
+	xr_strcpy					(g_zones[g_zone_count], name);
+	return						(u32(g_zone_count++));
+}
+
+void push						(u32 zone)
+{
+	thread_ring*				ring = t_ring;
+	if (!ring) {
+		// all the rings are taken: the events are dropped, another ring is looked for once a frame
+		u32 const				frame = g_frame_count + 1;
+		ring					= (t_no_ring == frame) ? NULL : acquire_ring();
+		if (!ring) {
+			t_no_ring			= frame;
+			InterlockedIncrement(&g_dropped);
+			return;
+		}
+	}
+
+	u32 const					head = ring->head;
+	event&						e = ring->events[head & (ring_size - 1)];
+	e.stamp						= CPU::GetCLK();
+	e.zone						= zone;
+	// the reader never looks at the slot being written
+	_ReadWriteBarrier			();
+	ring->head					= head + 1;
+}
+
+void set_thread_name			(LPCSTR name)
+{
+	xr_strcpy					(t_name, name);
+	if (t_ring)
+		xr_strcpy				(t_ring->name, name);
+}
+
+void frame						()
+{
+	g_frames[g_frame_count % frame_history]	= CPU::GetCLK();
+	_ReadWriteBarrier			();
+	++g_frame_count;
+}
+
+u32 frame_count					()
+{
+	return						(g_frame_count);
+}
+
+u64 frame_stamp					(u32 frames_back)
+{
+	u32 const					count = g_frame_count;
+	VERIFY						((frames_back < count) && (frames_back < frame_history));
+	return						(g_frames[(count - 1 - frames_back) % frame_history]);
+}
+
+void zone_times					(u64 from, u64 to, u32 const* zones, u32 zone_count, u64* result)
+{
+	u32							depth[64];
+	u64							start[64];
+	VERIFY						(zone_count <= 64);
+	ZeroMemory					(depth, zone_count*sizeof(u32));
+	ZeroMemory					(result, zone_count*sizeof(u64));
+
+	thread_ring const*			ring = t_ring;
+	if (!ring)
+		return;
+
+	// the calling thread is the writer, so the ring is stable here
+	u32 const					head = ring->head;
+	u32							first = head;
+	for (u32 n = _min(head, u32(ring_size)); n && (s64(ring->events[(first - 1) & (ring_size - 1)].stamp - from) >= 0); --n)
+		--first;
+
+	for (u32 i = first; i != head; ++i) {
+		event const&			e = ring->events[i & (ring_size - 1)];
+		if (s64(e.stamp - to) >= 0)
+			break;
+
+		u32 const				zone = e.zone & ~u32(zone_end);
+		for (u32 j = 0; j < zone_count; ++j) {
+			if (zones[j] != zone)
+				continue;
+
+			// recursive zones are accounted once, from the outermost one
+			if (!(e.zone & zone_end)) {
+				if (!depth[j]++)
+					start[j]	= e.stamp;
+			}
+			else if (depth[j] && !--depth[j])
+				result[j]		+= e.stamp - start[j];
+		}
+	}
+}
+
+IC double to_us					(u64 stamp, u64 origin)
+{
+	return						(double(s64(stamp - origin))*1000000.0/double(CPU::clk_per_second));
+}
+
+bool dump						(LPCSTR file_name, u32 frames)
+{
+	u32 const					frame_count = g_frame_count;
+	if (!frame_count) {
+		Msg						("! trace: no frames captured");
+		return					(false);
+	}
+
+	frames						= _max(u32(1), _min(frames, _min(frame_count, u32(frame_history - 1))));
+	u64 const					origin = g_frames[(frame_count - frames) % frame_history];
+
+	IWriter*					W = FS.w_open(file_name);
+	if (!W) {
+		Msg						("! trace: can't open file [%s]", file_name);
+		return					(false);
+	}
+
+	W->w_printf					("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	W->w_printf					("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"%s\"}}", Core.ApplicationName);
+
+	for (u32 i = frame_count - frames; i < frame_count; ++i)
+		W->w_printf				(",\n{\"name\":\"frame %d\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":%.3f}", i, to_us(g_frames[i % frame_history], origin));
+
+	u32							written = 0;
+	xr_vector<event>			events;
+	xr_vector<u32>				stack;
+	// no ring changes hands while it is copied
+	xrCriticalSection::raii		guard(&g_ring_lock);
+	for (u32 r = 0; r < g_ring_count; ++r) {
+		thread_ring const*		ring = g_rings[r];
+
+		// copy out while the owner keeps writing, then drop what it may have overwritten meanwhile
+		u32 const				head = ring->head;
+		u32 const				count = _min(head, u32(ring_size));
+		events.resize			(count);
+		for (u32 i = 0; i < count; ++i)
+			events[i]			= ring->events[(head - count + i) & (ring_size - 1)];
+
+		u32 const				head_after = ring->head + 1;	// + the slot being written right now
+		u32 const				lost = (head_after - head > ring_size - count) ? head_after - head - (ring_size - count) : 0;
+		u32 const				first = _min(lost, count);
+
+		W->w_printf				(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", ring->thread_id, ring->name);
+
+		stack.clear				();
+		for (u32 i = first; i < count; ++i) {
+			event const&		e = events[i];
+			if (s64(e.stamp - origin) < 0)
+				continue;
+
+			u32 const			zone = e.zone & ~u32(zone_end);
+			if (e.zone & zone_end) {
+				// leaves of the zones entered before the captured range
+				if (stack.empty() || (stack.back() != zone))
+					continue;
+				stack.pop_back	();
+			}
+			else
+				stack.push_back	(zone);
+
+			W->w_printf			(",\n{\"name\":\"%s\",\"ph\":\"%s\",\"pid\":1,\"tid\":%d,\"ts\":%.3f}", g_zones[zone], (e.zone & zone_end) ? "E" : "B", ring->thread_id, to_us(e.stamp, origin));
+			++written;
+		}
+	}
+
+	W->w_printf					("\n]}\n");
+	FS.w_close					(W);
+
+	Msg							("* trace: %d frames, %d events, %d threads saved to [%s], %d events dropped", frames, written, g_ring_count, file_name, g_dropped);
+	return						(true);
+}
+
+} // namespace trace_profiler
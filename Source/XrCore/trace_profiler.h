@@ -0,0 +1,54 @@
+#ifndef TRACE_PROFILER_H
+#define TRACE_PROFILER_H
+#pragma once
+
+// Release instrumentation: zones are registered once per call site, every zone
+// enter/leave is a TSC stamp written to the calling thread's own ring buffer
+// (single writer, no locks). dump() exports the last frames as a chrome trace
+// json (chrome://tracing, ui.perfetto.dev).
+
+namespace trace_profiler {
+	enum {
+		ring_size		= 64*1024,		// events per thread, power of two
+		max_threads		= 64,			// rings of the threads alive at once
+		max_zones		= 1024,
+		frame_history	= 512,
+		zone_end		= 0x80000000,	// set in event::zone for the zone leave
+	};
+
+	struct event {
+		u64						stamp;		// CPU::GetCLK
+		u32						zone;
+		u32						dummy;
+	};
+
+	extern XRCORE_API BOOL		enabled;
+
+	XRCORE_API u32				register_zone	(LPCSTR name);
+	XRCORE_API void				push			(u32 zone);
+	XRCORE_API void				set_thread_name	(LPCSTR name);
+	XRCORE_API void				thread_exit		();							// the ring of the calling thread goes back to the free list
+	XRCORE_API void				frame			();							// frame boundary, main thread only
+	XRCORE_API u32				frame_count		();
+	XRCORE_API u64				frame_stamp		(u32 frames_back);			// 0 - start of the current frame
+	XRCORE_API bool				dump			(LPCSTR file_name, u32 frames);
+
+	// inclusive clocks spent in the zones by the calling thread within [from,to)
+	XRCORE_API void				zone_times		(u64 from, u64 to, u32 const* zones, u32 zone_count, u64* result);
+
+	class scope {
+		u32						m_zone;
+	public:
+		IC						scope			(u32 zone)	{ if (enabled) { m_zone = zone; push(zone); } else m_zone = u32(-1);	}
+		IC						~scope			()			{ if (m_zone != u32(-1)) push(m_zone | zone_end);					}
+	};
+} // namespace trace_profiler
+
+#define TRACE_ZONE_CONCAT2(a,b)	a##b
+#define TRACE_ZONE_CONCAT(a,b)	TRACE_ZONE_CONCAT2(a,b)
+
+#define TRACE_ZONE(name)		\
+	static u32 const TRACE_ZONE_CONCAT(__trace_zone_,__LINE__) = trace_profiler::register_zone(name);	\
+	trace_profiler::scope TRACE_ZONE_CONCAT(__trace_scope_,__LINE__)(TRACE_ZONE_CONCAT(__trace_zone_,__LINE__))
+
+#endif // TRACE_PROFILER_H
@@ -202,6 +202,7 @@ void xrCore::_destroy		()
 		timeBeginPeriod	(1);
 		break;
 	case DLL_THREAD_DETACH:
+		trace_profiler::thread_exit	();
 		break;
 	case DLL_PROCESS_DETACH:
 #ifdef USE_MEMORY_MONITOR
@@ -275,6 +275,7 @@ DEFINE_VECTOR	(xr_rtoken,RTokenVec,RTokenVecIt);
 
 #include "FileSystem.h"
 #include "FTimer.h"
+#include "trace_profiler.h"
 #include "fastdelegate.h"
 #include "intrusive_ptr.h"
 
@@ -141,7 +141,8 @@ void xrDebug::gather_info		(const char *expression, const char *description, con
 void xrDebug::do_exit	(const std::string &message)
 {
 	FlushLog			();
-	MessageBox			(NULL,message.c_str(),"Error",MB_OK|MB_ICONERROR|MB_SYSTEMMODAL);
+	if (!strstr(GetCommandLine(),"-silent_error_mode"))
+		MessageBox		(NULL,message.c_str(),"Error",MB_OK|MB_ICONERROR|MB_SYSTEMMODAL);
 	TerminateProcess	(GetCurrentProcess(),1);
 }
 
@@ -182,6 +183,10 @@ void xrDebug::backend	(const char *expression, const char *description, const ch
 
 	FlushLog			();
 
+	// nobody is there to answer the dialog, the error is in the log already
+	if (strstr(GetCommandLine(),"-silent_error_mode"))
+		TerminateProcess(GetCurrentProcess(),1);
+
 #ifdef XRCORE_STATIC
 	MessageBox			(NULL,assertion_info,"X-Ray error",MB_OK|MB_ICONERROR|MB_SYSTEMMODAL);
 #else
@@ -263,6 +263,8 @@ void CStats::Show()
 		F.OutNext	("*** SOUND:   %2.2fms",Sound.result);
 		F.OutNext	("  TGT/SIM/E: %d/%d/%d",  snd_stat._rendered, snd_stat._simulated, snd_stat._events);
 		F.OutNext	("  HIT/MISS:  %d/%d",  snd_stat._cache_hits, snd_stat._cache_misses);
+		F.OutNext	("  PREFETCH:  %d, stolen %d, waits %d (%dus)",  snd_stat._cache_prefetched, snd_stat._decode_stolen, snd_stat._decode_waits, snd_stat._decode_wait_us);
+		F.OutNext	("  DECODE:    %dus avg, %dus max",  snd_stat._decode_latency_avg, snd_stat._decode_latency_max);
 		F.OutSkip	();
 		F.OutNext	("Input:       %2.2fms",Input.result);
 		F.OutNext	("clRAY:       %2.2fms, %d, %2.0fK",clRAY.result,		clRAY.count,r_ps);
@@ -189,10 +189,13 @@ void 			mt_Thread	(void *ptr)	{
 		// we has granted permission to execute
 		mt_Thread_marker			= Device->dwFrame;
  
-		for (u32 pit=0; pit<Device->seqParallel.size(); pit++)
-			Device->seqParallel[pit]	();
-		Device->seqParallel.clear_not_free	();
-		Device->seqFrameMT.Process	(rp_Frame);
+		{
+			TRACE_ZONE				("Device::mt_Thread");
+			for (u32 pit=0; pit<Device->seqParallel.size(); pit++)
+				Device->seqParallel[pit]	();
+			Device->seqParallel.clear_not_free	();
+			Device->seqFrameMT.Process	(rp_Frame);
+		}
 
 		// now we give control to device - signals that we are ended our work
 		Device->mt_csEnter.Leave	();
@@ -256,6 +259,7 @@ void CRenderDevice::on_idle		()
 			&& g_bLoaded)
 			g_SASH.StartBenchmark();
 
+		trace_profiler::frame			( );
 		FrameMove						( );
 	}
 
@@ -295,6 +299,7 @@ void CRenderDevice::on_idle		()
 	Statistic->RenderTOTAL_Real.Begin		();
 	if (b_is_Active)							{
 		if (Begin())				{
+			TRACE_ZONE								("Device::Render");
 
 			seqRender.Process						(rp_Render);
 			if (psDeviceFlags.test(rsCameraPos) || psDeviceFlags.test(rsStatistic) || Statistic->errors.size())	
@@ -345,6 +350,7 @@ void CRenderDevice::on_idle		()
 	u32 DSUpdateDelta = 1000/g_svDedicateServerUpdateReate;
 	if (FrameTime < DSUpdateDelta)
 	{
+		TRACE_ZONE("Device::Sleep");
 		Sleep(DSUpdateDelta - FrameTime);
 //		Msg("sleep for %d", DSUpdateDelta - FrameTime);
 //		xr_strcat(FPS_str, ", sleeped for ");
@@ -474,6 +480,7 @@ void CRenderDevice::FrameMove()
 	}
 
 	// Frame move
+	TRACE_ZONE						("Device::FrameMove");
 	Statistic->EngineTOTAL.Begin	();
 
 	//	TODO: HACK to test loading screen.
@@ -293,6 +293,7 @@ void CSheduler::Pop					()
 
 void CSheduler::ProcessStep			()
 {
+	TRACE_ZONE						("Sheduler::ProcessStep");
 	// Normal priority
 	u32		dwTime					= Device->dwTimeGlobal;
 	CTimer							eTimer;
@@ -342,8 +343,10 @@ void CSheduler::ProcessStep			()
 		
 
 		m_current_step_obj = T.Object;
+		u64		clocks				= CPU::GetCLK();
 //			try {
 			T.Object->shedule_Update	(clampr(Elapsed,u32(1),u32(_max(u32(T.Object->shedule.t_max),u32(1000)))) );
+			account_cost			(T,CPU::GetCLK()-clocks);
 			if (!m_current_step_obj)
 			{
 #ifdef DEBUG_SCHEDULER
@@ -414,9 +417,34 @@ void CSheduler::Switch				()
 	}
 }
 */
+IC bool cost_greater				(const CSheduler::ItemCost& A, const CSheduler::ItemCost& B)
+{
+	return							A.clocks > B.clocks;
+}
+
+void CSheduler::account_cost		(Item& I, u64 clocks)
+{
+	if (m_costs.size()<cost_top_count)	{
+		m_costs.push_back			(ItemCost());
+		m_costs.back().scheduled_name	= I.scheduled_name;
+		m_costs.back().clocks		= clocks;
+		return;
+	}
+
+	COSTS::iterator	cheapest		= m_costs.begin();
+	for (COSTS::iterator it=m_costs.begin(); it!=m_costs.end(); ++it)
+		if (it->clocks<cheapest->clocks)	cheapest = it;
+
+	if (clocks<=cheapest->clocks)	return;
+	cheapest->scheduled_name		= I.scheduled_name;
+	cheapest->clocks				= clocks;
+}
+
 void CSheduler::Update				()
 {
+	TRACE_ZONE						("Sheduler::Update");
 	R_ASSERT						(Device->Statistic);
+	m_costs.clear_not_free			();
 	// Initialize
 	Device->Statistic->Sheduler.Begin();
 	cycles_start					= CPU::QPC			();
@@ -468,4 +496,7 @@ void CSheduler::Update				()
 	g_bSheduleInProgress			= FALSE;
 	internal_Registration			();
 	Device->Statistic->Sheduler.End	();
+
+	m_costs_last.swap				(m_costs);
+	std::sort						(m_costs_last.begin(),m_costs_last.end(),cost_greater);
 }
@@ -23,6 +23,14 @@ private:
 		BOOL		RT;
 		ISheduled*	Object;
 	};
+public:
+	struct	ItemCost
+	{
+		shared_str	scheduled_name;
+		u64			clocks;					// CPU::GetCLK
+	};
+	enum	{ cost_top_count = 8 };
+	typedef xr_vector<ItemCost>	COSTS;
 private:
 	xr_vector<Item>			ItemsRT			;
 	xr_vector<Item>			Items			;
@@ -30,6 +38,10 @@ private:
 	xr_vector<ItemReg>		Registration	;
 	ISheduled*				m_current_step_obj;
 	bool					m_processing_now;
+	COSTS					m_costs			;	// most expensive objects of the running update
+	COSTS					m_costs_last	;	// the same for the last completed one, sorted
+
+	void			account_cost			(Item& I, u64 clocks);
 
 	IC void			Push	(Item& I);
 	IC void			Pop		();
@@ -47,6 +59,7 @@ public:
 	void			ProcessStep	();
 	void			Process		();
 	void			Update		();
+	const COSTS&	top_costs	() const	{ return m_costs_last; }
 
 #ifdef DEBUG
 	bool			Registered	(ISheduled *object) const;
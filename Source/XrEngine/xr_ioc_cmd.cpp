@@ -200,6 +200,23 @@ public:
 	}
 };
 
+class CCC_TraceDump : public IConsole_Command
+{
+public:
+	CCC_TraceDump(LPCSTR N) : IConsole_Command(N) { bEmptyArgsHandled = TRUE; };
+	virtual void Execute(LPCSTR args) {
+		int frames			= atoi(args);
+		if (frames<=0)		frames = 60;
+
+		string64			t_stamp;
+		string_path			fn;
+		xr_sprintf			(fn,"trace_%s.json",timestamp(t_stamp));
+		FS.update_path		(fn,"$logs$",fn);
+		trace_profiler::dump(fn,u32(frames));
+	}
+	virtual void Info(TInfo& I) { xr_strcpy(I,"[frames], saves the last frames as chrome trace json to $logs$"); }
+};
+
 //-----------------------------------------------------------------------
 class CCC_SaveCFG : public IConsole_Command
 {
@@ -760,6 +777,9 @@ void CCC_Register()
 	CMD4(CCC_Integer,	"texture_lod",			&psTextureLOD,				0,	4	);
 	CMD4(CCC_Integer,	"net_dedicated_sleep",	&psNET_DedicatedSleep,		0,	64	);
 
+	CMD4(CCC_Integer,	"trace_enable",			&trace_profiler::enabled,	0,	1	);
+	CMD1(CCC_TraceDump,	"trace_dump"			);
+
 	// General video control
 	CMD1(CCC_VidMode,	"vid_mode"				);
 
@@ -777,6 +797,7 @@ void CCC_Register()
 	CMD3(CCC_Mask,		"snd_efx",				&psSoundFlags,		ss_EAX		);
 	CMD4(CCC_Integer,	"snd_targets",			&psSoundTargets,	4,32		);
 	CMD4(CCC_Integer,	"snd_cache_size",		&psSoundCacheSizeMB,4,32		);
+	CMD4(CCC_Integer,	"snd_prefetch_lines",	&psSoundPrefetchLines,0,16		);
 
 #ifdef DEBUG
 	CMD3(CCC_Mask,		"snd_stats",			&g_stats_flags,		st_sound	);
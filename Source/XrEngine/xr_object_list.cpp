@@ -187,6 +187,7 @@ void CObjectList::clear_crow_vec(Objects& o)
 
 void CObjectList::Update		(bool bForce)
 {
+	TRACE_ZONE					("ObjectList::Update");
 	if ( !Device->Paused() || bForce )
 	{
 		// Clients
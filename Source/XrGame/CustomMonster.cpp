@@ -60,6 +60,7 @@
 
 void SetActorVisibility(u16 who, float value);
 extern int g_AI_inactive_time;
+int			g_ai_bones_budget	= 100;	// ms between the bone updates of the monsters nobody renders
 
 #ifndef MASTER_GOLD
 	Flags32		psAI_Flags	= {aiObstaclesAvoiding | aiUseSmartCovers};
@@ -752,6 +753,12 @@ BOOL CCustomMonster::net_Spawn	(CSE_Abstract* DC)
 	// Eyes
 	eye_bone					= smart_cast<IKinematics*>(Visual())->LL_BoneID(pSettings->r_string(cNameSect(),"bone_head"));
 
+	// unseen monsters keep the bones of the collision and the eyes only
+	IKinematics					*kinematics = smart_cast<IKinematics*>(Visual());
+	kinematics->LL_SetUpdateBudget	(u32(g_ai_bones_budget));
+	if (u16(eye_bone) != BI_NONE)
+		kinematics->LL_SetBoneRequired	(u16(eye_bone),TRUE);
+
 	// weapons
 	if (Local()) {
 		net_update				N;
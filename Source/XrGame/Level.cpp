@@ -36,6 +36,8 @@
 #include "map_manager.h"
 #include "../xrEngine/CameraManager.h"
 #include "level_sounds.h"
+#include "script_gc_controller.h"
+#include "hitch_detector.h"
 #include "car.h"
 #include "trade_parameters.h"
 #include "game_cl_base_weapon_usage_statistic.h"
@@ -120,6 +122,8 @@ CLevel::CLevel():IPureClient	(Device->GetTimerGlobal())
 	//physics_world()->set_step_time_callback((PhysicsStepTimeCallback*) &PhisStepsCallback);
 	//physics_step_time_callback	= (PhysicsStepTimeCallback*) &PhisStepsCallback;
 	m_seniority_hierarchy_holder= xr_new<CSeniorityHierarchyHolder>();
+	m_script_gc_controller		= xr_new<CScriptGCController>();
+	m_hitch_detector			= g_dedicated_server ? xr_new<CHitchDetector>() : NULL;
 
 	if(!g_dedicated_server)
 	{
@@ -273,6 +277,10 @@ CLevel::~CLevel()
 	xr_delete					(m_client_spawn_manager);
 
 	xr_delete					(m_autosave_manager);
+
+	xr_delete					(m_script_gc_controller);
+
+	xr_delete					(m_hitch_detector);
 	
 #ifdef DEBUG
 	xr_delete					(m_debug_renderer);
@@ -461,6 +469,7 @@ void CLevel::cl_Process_Event				(u16 dest, u16 type, NET_Packet& P)
 
 void CLevel::ProcessGameEvents		()
 {
+	TRACE_ZONE						("Level::ProcessGameEvents");
 	// Game events
 	{
 		NET_Packet			P;
@@ -577,6 +586,7 @@ void CLevel::MakeReconnect()
 
 void CLevel::OnFrame	()
 {
+	TRACE_ZONE							("Level::OnFrame");
 #ifdef DEBUG_MEMORY_MANAGER
 	debug_memory_guard					__guard__;
 #endif // DEBUG_MEMORY_MANAGER
@@ -752,11 +762,8 @@ void CLevel::OnFrame	()
 			m_level_sound_manager->Update	();
 	}
 	// deffer LUA-GC-STEP
-	if (!g_dedicated_server)
-	{
-		if (g_mt_config.test(mtLUA_GC))	Device->seqParallel.push_back	(fastdelegate::FastDelegate0<>(this,&CLevel::script_gc));
-		else							script_gc	()	;
-	}
+	if (g_mt_config.test(mtLUA_GC))	Device->seqParallel.push_back	(fastdelegate::FastDelegate0<>(this,&CLevel::script_gc));
+	else							script_gc	()	;
 	//-----------------------------------------------------
 	if (pStatGraphR)
 	{	
@@ -768,10 +775,10 @@ void CLevel::OnFrame	()
 	};
 }
 
-int		psLUA_GCSTEP					= 10			;
 void	CLevel::script_gc				()
 {
-	lua_gc	(ai().script_engine().lua(), LUA_GCSTEP, psLUA_GCSTEP);
+	m_script_gc_controller->simulation	(true);
+	m_script_gc_controller->update		();
 }
 
 #ifdef DEBUG_PRECISE_PATH
@@ -32,6 +32,8 @@ class	CAutosaveManager;
 class	CPHCommander;
 class	CLevelDebug;
 class	CLevelSoundManager;
+class	CScriptGCController;
+class	CHitchDetector;
 class	CGameTaskManager;
 class	CZoneList;
 class	message_filter;
@@ -79,6 +81,10 @@ protected:
 	CClientSpawnManager			*m_client_spawn_manager;
 	// autosave manager
 	CAutosaveManager			*m_autosave_manager;
+	// lua garbage collector pacing
+	CScriptGCController			*m_script_gc_controller;
+	// dedicated server slow frame reports
+	CHitchDetector				*m_hitch_detector;
 #ifdef DEBUG
 	// debug renderer
 	CDebugRenderer				*m_debug_renderer;
@@ -303,6 +309,8 @@ public:
 	IC CSeniorityHierarchyHolder	&seniority_holder			();
 	IC CClientSpawnManager			&client_spawn_manager		();
 	IC CAutosaveManager				&autosave_manager			();
+	IC CScriptGCController			&script_gc_controller		();
+	IC CHitchDetector				*hitch_detector				() const { return m_hitch_detector; }
 #ifdef DEBUG
 	IC CDebugRenderer				&debug_renderer				();
 #endif
@@ -428,6 +436,12 @@ IC CAutosaveManager &CLevel::autosave_manager()
 	return				(*m_autosave_manager);
 }
 
+IC CScriptGCController &CLevel::script_gc_controller()
+{
+	VERIFY				(m_script_gc_controller);
+	return				(*m_script_gc_controller);
+}
+
 #ifdef DEBUG
 IC CDebugRenderer &CLevel::debug_renderer()
 {
@@ -10,6 +10,7 @@
 #include "space_restriction_manager.h"
 #include "ai_space.h"
 #include "script_engine.h"
+#include "script_gc_controller.h"
 #include "stalker_animation_data_storage.h"
 #include "client_spawn_manager.h"
 #include "seniority_hierarchy_holder.h"
@@ -81,8 +82,9 @@ void CLevel::remove_objects	()
 	psDeviceFlags.set			(rsDisableObjectsAsCrows, b_stored);
 	g_b_ClearGameCaptions		= true;
 
+	script_gc_controller().simulation			(false);
 	if (!g_dedicated_server)
-		ai().script_engine().collect_all_garbage	();
+		script_gc_controller().collect_all_garbage	();
 
 	stalker_animation_data_storage().clear		();
 	
@@ -163,7 +165,7 @@ void CLevel::net_Stop		()
 	}
 
 	if (!g_dedicated_server)
-		ai().script_engine().collect_all_garbage	();
+		script_gc_controller().collect_all_garbage	();
 
 #ifdef DEBUG
 	show_animation_stats		();
@@ -173,6 +175,7 @@ void CLevel::net_Stop		()
 
 void CLevel::ClientSend()
 {
+	TRACE_ZONE("Level::ClientSend");
 	if (GameID() == eGameIDSingle || OnClient())
 	{
 		if ( !net_HasBandwidth() ) return;
@@ -169,7 +169,8 @@ void CAI_Space::load				(LPCSTR level_name)
 #endif
 
 	level_graph().level_id	(current_level.id());
-	m_cover_manager->compute_static_cover	();
+	// the AI-map of the editor scene keeps its guid while it is being edited
+	m_cover_manager->compute_static_cover	(Device->IsEditorMode() ? 0 : level_name);
 	m_moving_objects->on_level_load			();
 
 	VERIFY					(!m_doors_manager);
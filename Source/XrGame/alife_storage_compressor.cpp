@@ -0,0 +1,142 @@
+////////////////////////////////////////////////////////////////////////////
+//	Module 		: alife_storage_compressor.cpp
+//	Created 	: 18.10.2026
+//  Modified 	: 18.10.2026
+//	Description : ALife Simulator saved game block compressor
+////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "alife_storage_compressor.h"
+#include "../xrCPU_Pipe/ttapi.h"
+
+namespace ALife {
+
+struct compressed_block {
+	u8 const					*source;
+	u32							source_count;
+	u8							*dest;
+	u32							dest_count;
+};
+
+struct block_worker_params {
+	compressed_block			*blocks;
+	u32							block_count;
+	u32							first;
+	u32							stride;
+};
+
+static void compress_blocks		(LPVOID parameters)
+{
+	block_worker_params const	&params = *(block_worker_params const*)parameters;
+	for (u32 i = params.first; i < params.block_count; i += params.stride) {
+		compressed_block		&block = params.blocks[i];
+		block.dest_count		= rtc_compress(block.dest, rtc_csize(block.source_count), block.source, block.source_count);
+	}
+}
+
+static void decompress_blocks	(LPVOID parameters)
+{
+	block_worker_params const	&params = *(block_worker_params const*)parameters;
+	for (u32 i = params.first; i < params.block_count; i += params.stride) {
+		compressed_block		&block = params.blocks[i];
+		u32 const				result = rtc_decompress(block.dest, block.dest_count, block.source, block.source_count);
+		R_ASSERT2				(result == block.dest_count, "saved game is corrupted");
+	}
+}
+
+static void run_block_workers	(LPPTTAPI_WORKER_FUNC function, compressed_block *blocks, u32 const block_count)
+{
+	u32 const					worker_count = _max(u32(1), _min(block_count, u32(ttapi_GetWorkersCount())));
+	block_worker_params			*params = (block_worker_params*)_alloca(worker_count*sizeof(block_worker_params));
+	ttapi_Lock					();
+	for (u32 i = 0; i < worker_count; ++i) {
+		params[i].blocks		= blocks;
+		params[i].block_count	= block_count;
+		params[i].first			= i;
+		params[i].stride		= worker_count;
+		ttapi_AddWorker			(function, &params[i]);
+	}
+
+	ttapi_RunAllWorkers			();
+	ttapi_Unlock				();
+}
+
+u32 save_compressed				(IWriter &writer, void const *source, u32 const source_count)
+{
+	u32 const					block_count = (source_count + blocked_save_block_size - 1)/blocked_save_block_size;
+	writer.w_u32				(blocked_save_marker);
+	writer.w_u32				(source_count);
+	writer.w_u32				(blocked_save_block_size);
+	writer.w_u32				(block_count);
+
+	// blocks are compressed in waves of one block per worker, every wave is written out
+	// as soon as it completes, so only one wave of compressed data is held in memory
+	u32 const					wave_size = _max(u32(1), u32(ttapi_GetWorkersCount()));
+	u32 const					dest_block_size = rtc_csize(blocked_save_block_size);
+	u8							*dest = (u8*)xr_malloc(wave_size*dest_block_size);
+	compressed_block			*blocks = (compressed_block*)_alloca(wave_size*sizeof(compressed_block));
+
+	u32							result = 4*sizeof(u32);
+	u8 const					*current = (u8 const*)source;
+	u8 const					*end = current + source_count;
+	while (current < end) {
+		u32						wave_count = 0;
+		for ( ; (wave_count < wave_size) && (current < end); ++wave_count) {
+			compressed_block	&block = blocks[wave_count];
+			block.source		= current;
+			block.source_count	= _min(blocked_save_block_size, u32(end - current));
+			block.dest			= dest + wave_count*dest_block_size;
+			block.dest_count	= 0;
+			current				+= block.source_count;
+		}
+
+		run_block_workers		(&compress_blocks, blocks, wave_count);
+
+		for (u32 i = 0; i < wave_count; ++i) {
+			writer.w_u32		(blocks[i].dest_count);
+			writer.w			(blocks[i].dest, blocks[i].dest_count);
+			result				+= sizeof(u32) + blocks[i].dest_count;
+		}
+	}
+
+	xr_free						(dest);
+	return						(result);
+}
+
+u32 load_compressed				(IReader &stream, void *&result)
+{
+	u32 const					marker = stream.r_u32();
+	if (marker != blocked_save_marker) {
+		u32 const				source_count = marker;
+		result					= xr_malloc(source_count);
+		rtc_decompress			(result, source_count, stream.pointer(), stream.elapsed());
+		return					(source_count);
+	}
+
+	u32 const					source_count = stream.r_u32();
+	u32 const					block_size = stream.r_u32();
+	u32 const					block_count = stream.r_u32();
+	R_ASSERT2					(block_size && (block_count == (source_count + block_size - 1)/block_size), "saved game is corrupted");
+
+	result						= xr_malloc(source_count);
+
+	xr_vector<compressed_block>	blocks(block_count);
+	u8							*dest = (u8*)result;
+	for (u32 i = 0; i < block_count; ++i) {
+		compressed_block		&block = blocks[i];
+		block.source_count		= stream.r_u32();
+		R_ASSERT2				(int(block.source_count) <= stream.elapsed(), "saved game is corrupted");
+		block.source			= (u8 const*)stream.pointer();
+		block.dest				= dest;
+		block.dest_count		= (i + 1 < block_count) ? block_size : source_count - i*block_size;
+		stream.advance			(block.source_count);
+		dest					+= block.dest_count;
+	}
+
+	if (block_count)
+		run_block_workers		(&decompress_blocks, &*blocks.begin(), block_count);
+
+	return						(source_count);
+}
+
+} // namespace ALife
@@ -0,0 +1,26 @@
+////////////////////////////////////////////////////////////////////////////
+//	Module 		: alife_storage_compressor.h
+//	Created 	: 18.10.2026
+//  Modified 	: 18.10.2026
+//	Description : ALife Simulator saved game block compressor
+////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+namespace ALife {
+	// saved game body, following the u32(-1), ALIFE_VERSION header
+	//
+	// legacy layout	: u32 source_count, lzo(source)
+	// blocked layout	: u32 blocked_save_marker, u32 source_count, u32 block_size, u32 block_count,
+	//					  block_count * { u32 compressed_size, lzo(block) }
+	//
+	// the blocks are compressed and decompressed independently on the ttapi workers
+	u32 const	blocked_save_marker		= u32(-2);
+	u32 const	blocked_save_block_size	= 256*1024;
+
+	// writes source as the independently compressed blocks, returns the compressed body size
+	u32		save_compressed		(IWriter &writer, void const *source, u32 source_count);
+
+	// reads both layouts, the result is allocated with xr_malloc, returns its size
+	u32		load_compressed		(IReader &stream, void *&result);
+} // namespace ALife
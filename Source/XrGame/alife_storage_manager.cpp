@@ -22,6 +22,7 @@
 #include "string_table.h"
 #include "../xrEngine/igame_persistent.h"
 #include "autosave_manager.h"
+#include "alife_storage_compressor.h"
 
 XRCORE_API extern string_path g_bug_report_file;
 
@@ -56,39 +57,31 @@ void CALifeStorageManager::save	(LPCSTR save_name_no_check, bool update_name)
 		}
 	}
 
-	u32							source_count;
-	u32							dest_count;
-	void						*dest_data;
-	{
-		CMemoryWriter			stream;
-		header().save			(stream);
-		time_manager().save		(stream);
-		spawns().save			(stream);
-		objects().save			(stream);
-		registry().save			(stream);
-
-		source_count			= stream.tell();
-		void					*source_data = stream.pointer();
-		dest_count				= rtc_csize(source_count);
-		dest_data				= xr_malloc(dest_count);
-		dest_count				= rtc_compress(dest_data,dest_count,source_data,source_count);
-	}
+	CTimer						timer;
+	timer.Start					();
+
+	CMemoryWriter				stream;
+	header().save				(stream);
+	time_manager().save			(stream);
+	spawns().save				(stream);
+	objects().save				(stream);
+	registry().save				(stream);
+
+	u32 const					source_count = stream.tell();
+	float const					serialize_time = timer.GetElapsed_sec();
 
 	string_path					temp;
 	FS.update_path				(temp,"$game_saves$",m_save_name);
 	IWriter						*writer = FS.w_open(temp);
 	writer->w_u32				(u32(-1));
 	writer->w_u32				(ALIFE_VERSION);
-	
-	writer->w_u32				(source_count);
-	writer->w					(dest_data,dest_count);
-	xr_free						(dest_data);
+
+	u32 const					dest_count = save_compressed(*writer,stream.pointer(),source_count);
 	FS.w_close					(writer);
-#ifdef DEBUG
-	Msg							("* Game %s is successfully saved to file '%s' (%d bytes compressed to %d)",m_save_name,temp,source_count,dest_count + 4);
-#else // DEBUG
-	Msg							("* Game %s is successfully saved to file '%s'",m_save_name,temp);
-#endif // DEBUG
+	stream.free					();
+
+	Msg							("* Game %s is successfully saved to file '%s' (%d bytes compressed to %d)",m_save_name,temp,source_count,dest_count + 8);
+	Msg							("* Save time %.3fs (serialize %.3fs, compress and write %.3fs)",timer.GetElapsed_sec(),serialize_time,timer.GetElapsed_sec() - serialize_time);
 
 	if (!update_name)
 		xr_strcpy					(m_save_name,save);
@@ -173,10 +166,11 @@ bool CALifeStorageManager::load	(LPCSTR save_name_no_check)
 	unload						();
 	reload						(m_section);
 
-	u32							source_count = stream->r_u32();
-	void						*source_data = xr_malloc(source_count);
-	rtc_decompress				(source_data,source_count,stream->pointer(),stream->length() - 3*sizeof(u32));
+	float const					read_time = timer.GetElapsed_sec();
+	void						*source_data;
+	u32 const					source_count = load_compressed(*stream,source_data);
 	FS.r_close					(stream);
+	float const					decompress_time = timer.GetElapsed_sec() - read_time;
 	load						(source_data, source_count, file_name);
 	xr_free						(source_data);
 
@@ -184,7 +178,7 @@ bool CALifeStorageManager::load	(LPCSTR save_name_no_check)
 
 	VERIFY						(graph().actor());
 	
-	Msg							("* Game %s is successfully loaded from file '%s' (%.3fs)",save_name, file_name,timer.GetElapsed_sec());
+	Msg							("* Game %s is successfully loaded from file '%s' (%.3fs, decompress %.3fs)",save_name, file_name,timer.GetElapsed_sec(),decompress_time);
 
 	return						(true);
 }
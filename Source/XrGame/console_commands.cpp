@@ -31,6 +31,8 @@
 #include "ai/monsters/BaseMonster/base_monster.h"
 #include "date_time.h"
 #include "mt_config.h"
+#include "script_gc_controller.h"
+#include "hitch_detector.h"
 #include "ui/UIOptConCom.h"
 #include "UIGameSP.h"
 #include "ui/UIActorMenu.h"
@@ -74,7 +76,6 @@ extern	u64		g_qwEStartGameTime;
 ENGINE_API
 extern	float	psHUD_FOV;
 extern	float	psSqueezeVelocity;
-extern	int		psLUA_GCSTEP;
 
 extern	int		x_m_x;
 extern	int		x_m_z;
@@ -98,6 +99,7 @@ extern int		g_upgrades_log;
 extern float	g_smart_cover_animation_speed_factor;
 
 extern	BOOL	g_ai_use_old_vision;
+extern	int		g_ai_bones_budget;
 float			g_aim_predict_time = 0.44f;
 int				g_keypress_on_start	= 1;
 
@@ -1705,6 +1707,36 @@ public:
 
 #endif // DEBUG
 
+class CCC_ScriptGCStats : public IConsole_Command {
+public:
+	CCC_ScriptGCStats(LPCSTR N) : IConsole_Command(N)  { bEmptyArgsHandled = true; };
+	virtual void Execute(LPCSTR args)
+	{
+		if (!g_pGameLevel) {
+			Msg					("! level is not loaded");
+			return;
+		}
+
+		Level().script_gc_controller().dump_stats();
+		if (!xr_strcmp(args,"reset"))
+			Level().script_gc_controller().reset_stats();
+	}
+};
+
+class CCC_HitchHistory : public IConsole_Command {
+public:
+	CCC_HitchHistory(LPCSTR N) : IConsole_Command(N)  { bEmptyArgsHandled = true; };
+	virtual void Execute(LPCSTR args)
+	{
+		if (!g_pGameLevel || !Level().hitch_detector()) {
+			Msg					("! hitch detector runs on a dedicated server level only");
+			return;
+		}
+
+		Level().hitch_detector()->dump_history();
+	}
+};
+
 class CCC_DumpObjects : public IConsole_Command {
 public:
 	CCC_DumpObjects(LPCSTR N) : IConsole_Command(N)  { bEmptyArgsHandled = true; };
@@ -1884,8 +1916,18 @@ void CCC_RegisterCommands()
 	CMD3(CCC_Mask,				"ai_dbg_lua",					&psAI_Flags,			aiLua);
 #endif // MASTER_GOLD
 
+	CMD4(CCC_Integer,			"lua_gc_budget",		&psLUA_GC_BUDGET,		50, 10000);
+	CMD4(CCC_Integer,			"lua_gc_budget_max",	&psLUA_GC_BUDGET_MAX,	50, 20000);
+	CMD4(CCC_Integer,			"lua_gc_frame_target",	&psLUA_GC_FRAME_TARGET,	1, 100);
+	CMD4(CCC_Integer,			"lua_gc_pause",			&psLUA_GC_PAUSE,		10, 1000);
+	CMD1(CCC_ScriptGCStats,		"lua_gc_stats");
+
+	CMD4(CCC_Integer,			"hitch_threshold",		&psHITCH_THRESHOLD,		0, 10000);
+	CMD4(CCC_Integer,			"hitch_log_size",		&psHITCH_LOG_SIZE,		16, 65536);
+	CMD4(CCC_Integer,			"hitch_trace_frames",	&psHITCH_TRACE_FRAMES,	0, 64);
+	CMD1(CCC_HitchHistory,		"hitch_history");
+
 #ifdef DEBUG
-	CMD4(CCC_Integer,			"lua_gcstep",			&psLUA_GCSTEP,	1, 1000);
 	CMD3(CCC_Mask,				"ai_debug",				&psAI_Flags,	aiDebug);
 	CMD3(CCC_Mask,				"ai_dbg_brain",			&psAI_Flags,	aiBrain);
 	CMD3(CCC_Mask,				"ai_dbg_motion",		&psAI_Flags,	aiMotion);
@@ -2211,6 +2253,7 @@ extern BOOL dbg_moving_bones_snd_player;
 	CMD4(CCC_Integer,	"g_sleep_time",			&psActorSleepTime,			1,		24		);
 	
 	CMD4(CCC_Integer,	"ai_use_old_vision",	&g_ai_use_old_vision, 0, 1);
+	CMD4(CCC_Integer,	"ai_bones_budget",		&g_ai_bones_budget, 0, 1000);
 
 	CMD4(CCC_Float,		"ai_aim_predict_time",	&g_aim_predict_time, 0.f, 10.f);
 
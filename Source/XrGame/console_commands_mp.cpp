@@ -204,6 +204,57 @@ public:
 	virtual void	Info	(TInfo& I){xr_strcpy(I,"clear server net statistic"); }
 };
 
+class CCC_Net_SV_InterestBench : public IConsole_Command {
+public:
+						CCC_Net_SV_InterestBench	(LPCSTR N) : IConsole_Command(N)  { bEmptyArgsHandled = true; };
+	virtual void		Execute						(LPCSTR args) 
+	{
+		if (!OnServer() || !Level().Server)
+			return;
+
+		u32 clients		= 64;
+		u32 seconds		= 10;
+		sscanf			(args, "%u %u", &clients, &seconds);
+		clients			= _min(_max(clients, u32(1)), u32(1024));
+		seconds			= _min(_max(seconds, u32(1)), u32(600));
+		Level().Server->InterestBenchmark(clients, seconds);
+	}
+	virtual void	Info	(TInfo& I){xr_strcpy(I,"[clients] [seconds] - entity updates traffic of simulated clients with sv_interest_radius"); }
+};
+
+class CCC_Net_SV_UpdateWriteBench : public IConsole_Command {
+public:
+						CCC_Net_SV_UpdateWriteBench	(LPCSTR N) : IConsole_Command(N)  { bEmptyArgsHandled = true; };
+	virtual void		Execute						(LPCSTR args) 
+	{
+		if (!OnServer() || !Level().Server)
+			return;
+
+		u32 entities	= 512;
+		u32 ticks		= 100;
+		sscanf			(args, "%u %u", &entities, &ticks);
+		entities		= _min(_max(entities, u32(1)), u32(16384));
+		ticks			= _min(_max(ticks, u32(1)), u32(10000));
+		Level().Server->UpdateWriteBenchmark(entities, ticks);
+	}
+	virtual void	Info	(TInfo& I){xr_strcpy(I,"[entities] [ticks] - serial and parallel UPDATE_Write time of synthetic entities"); }
+};
+
+class CCC_Net_UdpBench : public IConsole_Command {
+public:
+						CCC_Net_UdpBench	(LPCSTR N) : IConsole_Command(N)  { bEmptyArgsHandled = true; };
+	virtual void		Execute				(LPCSTR args) 
+	{
+		u32 clients		= 32;
+		u32 seconds		= 10;
+		sscanf			(args, "%u %u", &clients, &seconds);
+		clients			= _min(_max(clients, u32(1)), u32(256));
+		seconds			= _min(_max(seconds, u32(1)), u32(600));
+		NET_UdpTransportBenchmark(clients, seconds);
+	}
+	virtual void	Info	(TInfo& I){xr_strcpy(I,"[clients] [seconds] - messages/sec, bytes per datagram and latency of the udp transport on loopback"); }
+};
+
 #ifdef DEBUG
 class CCC_Dbg_NumObjects : public IConsole_Command {
 public:
@@ -1983,6 +2034,8 @@ void register_mp_console_commands()
 	CMD4(CCC_Integer,	"net_sv_gpmode",	    &psNET_GuaranteedPacketMode,0, 2)	;
 	CMD3(CCC_Mask,		"net_sv_log_data",		&psNET_Flags,		NETFLAG_LOG_SV_PACKETS	);
 	CMD3(CCC_Mask,		"net_cl_log_data",		&psNET_Flags,		NETFLAG_LOG_CL_PACKETS	);
+	CMD3(CCC_Mask,		"net_udp_transport",	&psNET_Flags,		NETFLAG_UDP_TRANSPORT	);
+	CMD1(CCC_Net_UdpBench,	"net_udp_bench");
 #ifdef DEBUG
 	CMD3(CCC_Mask,		"net_dump_size",		&psNET_Flags,		NETFLAG_DBG_DUMPSIZE	);
 	CMD1(CCC_Dbg_NumObjects,"net_dbg_objects"				);
@@ -2166,4 +2219,11 @@ void register_mp_console_commands()
 	CMD1(CCC_GameSpyProfile,				"gs_profile");
 	CMD4(CCC_Integer,						"sv_write_update_bin",				&g_sv_write_updates_bin, 0, 1);
 	CMD4(CCC_Integer,						"sv_traffic_optimization_level",	(int*)&g_sv_traffic_optimization_level, 0, 7);
+	CMD4(CCC_Integer,						"sv_interest_radius",				&g_sv_interest_radius, 0, 10000);
+	CMD4(CCC_Integer,						"sv_interest_near",					&g_sv_interest_near, 0, 10000);
+	CMD4(CCC_Integer,						"sv_interest_far_period",			&g_sv_interest_far_period, 0, 5000);
+	CMD4(CCC_Integer,						"sv_interest_hysteresis",			&g_sv_interest_hysteresis, 0, 100);
+	CMD1(CCC_Net_SV_InterestBench,			"sv_interest_bench");
+	CMD4(CCC_Integer,						"sv_update_write_mt",				&g_sv_parallel_update_write, 0, 1);
+	CMD1(CCC_Net_SV_UpdateWriteBench,		"sv_update_write_bench");
 }
@@ -18,6 +18,16 @@
 #include "smart_cover_object.h"
 
 #define MIN_COVER_VALUE 16
+#define COVER_CACHE_VERSION 1
+
+// $app_data_root$\covers_cache\<level>.cover: crc32 of the rest, the header and the level vertices
+// of the static covers in the level graph order, which is the xz order of the vertices
+struct cover_cache_header {
+	u32						version;
+	xrGUID					guid;
+	u32						vertex_count;
+	u32						count;
+};
 
 CCoverManager::CCoverManager				()
 {
@@ -81,11 +91,8 @@ IC	bool CCoverManager::critical_cover	(u32 index)
 	);
 }
 
-void CCoverManager::compute_static_cover	()
+void CCoverManager::compute_covers			(xr_vector<u32> &vertices)
 {
-	clear					();
-	xr_delete				(m_covers);
-	m_covers				= xr_new<CPointQuadTree>(ai().level_graph().header().box(),ai().level_graph().header().cell_size()*.5f,8*65536,4*65536);
 	m_temp.resize			(ai().level_graph().header().vertex_count());
 
 	ILevelGraph const		&graph = ai().level_graph();
@@ -107,7 +114,98 @@ void CCoverManager::compute_static_cover	()
 
 	for (u32 i=0; i<n; ++i)
 		if (m_temp[i] && critical_cover(i))
-			m_covers->insert(xr_new<CCoverPoint>(ai().level_graph().vertex_position(ai().level_graph().vertex(i)),i));
+			vertices.push_back	(i);
+}
+
+void CCoverManager::insert_covers			(u32 const *vertices, u32 count)
+{
+	for (u32 i=0; i<count; ++i)
+		m_covers->insert	(xr_new<CCoverPoint>(ai().level_graph().vertex_position(vertices[i]),vertices[i]));
+}
+
+bool CCoverManager::load_covers				(LPCSTR file_name)
+{
+	if (!FS.exist(file_name))
+		return				(false);
+
+	IReader					*reader = FS.r_open(file_name);
+	if (!reader)
+		return				(false);
+
+	bool					result = false;
+	ILevelGraph const		&graph = ai().level_graph();
+	if (reader->length() >= sizeof(u32) + sizeof(cover_cache_header)) {
+		u32					crc = reader->r_u32();
+		if (crc == crc32(reader->pointer(),reader->elapsed())) {
+			cover_cache_header	header;
+			reader->r		(&header,sizeof(header));
+			u32 const		*vertices = (u32 const*)reader->pointer();
+			result			= 
+				(header.version == COVER_CACHE_VERSION) &&
+				(header.guid == graph.header().guid()) &&
+				(header.vertex_count == graph.header().vertex_count()) &&
+				(u32(reader->elapsed()) == header.count*sizeof(u32));
+
+			for (u32 i=0; result && (i<header.count); ++i)
+				result		= (vertices[i] < header.vertex_count);
+
+			if (result)
+				insert_covers	(vertices,header.count);
+		}
+	}
+
+	FS.r_close				(reader);
+	return					(result);
+}
+
+void CCoverManager::save_covers				(LPCSTR file_name, xr_vector<u32> const &vertices)
+{
+	cover_cache_header		header;
+	header.version			= COVER_CACHE_VERSION;
+	header.guid				= ai().level_graph().header().guid();
+	header.vertex_count		= ai().level_graph().header().vertex_count();
+	header.count			= u32(vertices.size());
+
+	CMemoryWriter			stream;
+	stream.w				(&header,sizeof(header));
+	if (!vertices.empty())
+		stream.w			(&vertices.front(),vertices.size()*sizeof(u32));
+
+	IWriter					*file = FS.w_open(file_name);
+	if (!file)
+		return;
+
+	file->w_u32				(crc32(stream.pointer(),stream.size()));
+	file->w					(stream.pointer(),stream.size());
+	FS.w_close				(file);
+}
+
+void CCoverManager::compute_static_cover	(LPCSTR level_name)
+{
+	CTimer					timer;
+	timer.Start				();
+
+	clear					();
+	xr_delete				(m_covers);
+	m_covers				= xr_new<CPointQuadTree>(ai().level_graph().header().box(),ai().level_graph().header().cell_size()*.5f,8*65536,4*65536);
+
+	string_path				file_name;
+	if (level_name) {
+		string_path			file;
+		strconcat			(sizeof(file),file,"covers_cache\\",level_name,".cover");
+		FS.update_path		(file_name,"$app_data_root$",file);
+	}
+
+	bool					cached = level_name && load_covers(file_name);
+	if (!cached) {
+		xr_vector<u32>		vertices;
+		compute_covers		(vertices);
+		insert_covers		(vertices.empty() ? 0 : &vertices.front(),u32(vertices.size()));
+		if (level_name)
+			save_covers		(file_name,vertices);
+	}
+
+	Msg						("* Static covers: %d (%s, %.3fs)",u32(m_covers->size()),cached ? "cached" : "computed",timer.GetElapsed_sec());
 
 	VERIFY					(!m_smart_covers_storage);
 	m_smart_covers_storage	= xr_new<smart_cover::storage>();
@@ -59,11 +59,16 @@ private:
 	static	void					clear_covers			(PointVector &covers);
 			void					remove_nearby_covers	(smart_cover::cover  const &cover, smart_cover::object const &object) const;
 			void					actualize_smart_covers	() const;
+			void					compute_covers			(xr_vector<u32> &vertices);
+			void					insert_covers			(u32 const *vertices, u32 count);
+			bool					load_covers				(LPCSTR file_name);
+			void					save_covers				(LPCSTR file_name, xr_vector<u32> const &vertices);
 
 public:
 									CCoverManager			();
 	virtual							~CCoverManager			();
-			void					compute_static_cover	();
+	// the covers of level_name are taken from the cache when it matches the AI-map, computed and cached otherwise
+			void					compute_static_cover	(LPCSTR level_name = 0);
 	IC		CPointQuadTree			&covers					() const;
 	IC		CPointQuadTree			*get_covers				();
 	IC		Storage					*smart_covers_storage	()	const;
@@ -915,6 +915,15 @@ void game_sv_ArtefactHunt::OnCreate(u16 id_who)
 	}
 };
 
+bool game_sv_ArtefactHunt::IsEntityUpdateCritical(CSE_Abstract const* E)
+{
+	if (!m_dwArtefactID) return false;
+	if (E->ID == m_dwArtefactID) return true;
+	//the bearer is shown to everybody
+	CSE_Abstract	*pArtefact	= get_entity_from_eid(m_dwArtefactID);
+	return (pArtefact && pArtefact->ID_Parent == E->ID);
+};
+
 void game_sv_ArtefactHunt::Assign_Artefact_RPoint(CSE_Abstract* E)
 {
 	R_ASSERT					(E);
@@ -106,6 +106,7 @@ public:
 	virtual		BOOL				OnTouch					(u16 eid_who, u16 eid_what, BOOL bForced = FALSE);
 	virtual		void				OnDetach				(u16 eid_who, u16 eid_what);
 	virtual		void				OnCreate				(u16 id_who);
+	virtual		bool				IsEntityUpdateCritical	(CSE_Abstract const* E);
 
 
 	virtual		void				Update					();
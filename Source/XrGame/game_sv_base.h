@@ -161,6 +161,7 @@ public:
 	virtual		void				net_Export_State		(NET_Packet& P, ClientID id_to);				// full state
 	virtual		void				net_Export_Update		(NET_Packet& P, ClientID id_to, ClientID id);		// just incremental update for specific client
 	virtual		void				net_Export_GameTime		(NET_Packet& P);						// update GameTime only for remote clients
+	virtual		bool				IsEntityUpdateCritical	(CSE_Abstract const* E)			{return false;};	// sent to every client regardless of distance
 
 	virtual		bool				change_level			(NET_Packet &net_packet, ClientID sender);
 	virtual		void				save_game				(NET_Packet &net_packet, ClientID sender);
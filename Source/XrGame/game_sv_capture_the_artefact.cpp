@@ -2438,6 +2438,19 @@ void game_sv_CaptureTheArtefact::OnDestroyObject(u16 eid_who)
 	m_item_respawner.check_to_delete(eid_who);
 }
 
+bool game_sv_CaptureTheArtefact::IsEntityUpdateCritical(CSE_Abstract const* E)
+{
+	for (TeamsMap::const_iterator te = teams.begin(), tee = teams.end(); te != tee; ++te)
+	{
+		MyTeam const & team = te->second;
+		if (team.artefact && (team.artefact->ID == E->ID))
+			return true;
+		if (team.artefactOwner && (team.artefactOwner->ID == E->ID))
+			return true;
+	}
+	return false;
+}
+
 void game_sv_CaptureTheArtefact::OnPostCreate(u16 id_who)
 {
 	inherited::OnPostCreate(id_who);
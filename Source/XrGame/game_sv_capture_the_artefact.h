@@ -240,6 +240,7 @@ public:
 	virtual void OnCreate		(u16 eid_who);
 	virtual void OnPostCreate	(u16 id_who);
 	virtual	void OnDestroyObject(u16 eid_who);
+	virtual bool IsEntityUpdateCritical(CSE_Abstract const* E);
 	
 	virtual	void Update();
 	
@@ -0,0 +1,200 @@
+////////////////////////////////////////////////////////////////////////////
+//	Module 		: hitch_detector.cpp
+//	Created 	: 18.10.2026
+//  Modified 	: 18.10.2026
+//	Description : Dedicated server slow frame detector
+////////////////////////////////////////////////////////////////////////////
+
+#include "pch_script.h"
+#include "hitch_detector.h"
+#include "Level.h"
+#include "ai_space.h"
+#include "script_engine.h"
+#include "script_gc_controller.h"
+
+int		psHITCH_THRESHOLD		= 50;
+int		psHITCH_LOG_SIZE		= 1024;
+int		psHITCH_TRACE_FRAMES	= 4;
+
+static LPCSTR const section_zones[CHitchDetector::section_count] = {
+	"Sheduler::Update",
+	"ALife/scheduled",
+	"ALife/switch",
+	"PHWorld::FrameStep",
+	"Level::ClientReceive",
+	"xrServer::SendUpdatesToAll",	// Level::ClientSend sends nothing on a dedicated server
+	"xrServer::Update",
+	"Level::ProcessGameEvents",
+	"Device::Sleep",
+};
+
+static LPCSTR const section_names[CHitchDetector::section_count] = {
+	"scheduler",
+	"alife scheduled",
+	"alife switch",
+	"physics",
+	"net receive",
+	"net send",
+	"server update",
+	"game events",
+	"sleep",
+};
+
+IC	float clocks2ms						(u64 const clocks)
+{
+	return					(float(double(clocks)*1000.0/double(CPU::clk_per_second)));
+}
+
+CHitchDetector::CHitchDetector			()
+{
+	for (u32 i = 0; i < section_count; ++i)
+		m_zones[i]			= trace_profiler::register_zone(section_zones[i]);
+
+	m_history_count			= 0;
+	m_hitches				= 0;
+	m_traces				= 0;
+	m_skip_frame			= true;
+
+	// the previous frame is complete before anybody else updates
+	Device->seqFrame.Add		(this, REG_PRIORITY_HIGH + 2000);
+}
+
+CHitchDetector::~CHitchDetector			()
+{
+	Device->seqFrame.Remove	(this);
+}
+
+void CHitchDetector::measure			(frame_info &info) const
+{
+	u64 const				from = trace_profiler::frame_stamp(1);
+	u64 const				to = trace_profiler::frame_stamp(0);
+
+	u64						clocks[section_count];
+	trace_profiler::zone_times	(from, to, m_zones, section_count, clocks);
+
+	info.frame				= Device->dwFrame - 1;
+	info.total				= clocks2ms(to - from);
+	for (u32 i = 0; i < section_count; ++i)
+		info.sections[i]	= clocks2ms(clocks[i]);
+
+	// the updates are sent from inside xrServer::Update, the sections add up without them
+	info.sections[section_server]	= _max(0.f, info.sections[section_server] - info.sections[section_net_send]);
+	info.work				= _max(0.f, info.total - info.sections[section_sleep]);
+}
+
+void CHitchDetector::OnFrame			()
+{
+	if (!psHITCH_THRESHOLD || (trace_profiler::frame_count() < 2))
+		return;
+
+	// the frame which saved a report is slow by itself
+	if (m_skip_frame) {
+		m_skip_frame		= false;
+		return;
+	}
+
+	frame_info				&info = m_history[m_history_count++ % history_size];
+	measure					(info);
+
+	if (info.work >= float(psHITCH_THRESHOLD))
+		report				(info);
+}
+
+void CHitchDetector::report				(frame_info const &info)
+{
+	++m_hitches;
+	m_skip_frame			= true;
+
+	string4096				text;
+	string256				line;
+	string64				t_stamp;
+	xr_sprintf				(text, "[%s] frame %d : %.2f ms work (threshold %d ms), %.2f ms total\n", timestamp(t_stamp), info.frame, info.work, psHITCH_THRESHOLD, info.total);
+
+	float					accounted = 0.f;
+	for (u32 i = 0; i < section_count; ++i) {
+		if (i != section_sleep)
+			accounted		+= info.sections[i];
+		xr_sprintf			(line, "  %-16s : %8.2f ms\n", section_names[i], info.sections[i]);
+		xr_strcat			(text, line);
+	}
+	xr_sprintf				(line, "  %-16s : %8.2f ms\n", "other", _max(0.f, info.work - accounted));
+	xr_strcat				(text, line);
+
+	CSheduler::COSTS const	&costs = Engine.Sheduler.top_costs();
+	if (!costs.empty()) {
+		xr_strcat			(text, "  top scheduled objects :\n");
+		for (CSheduler::COSTS::const_iterator I = costs.begin(), E = costs.end(); I != E; ++I) {
+			xr_sprintf		(line, "    %-32s : %8.2f ms\n", (*I).scheduled_name.size() ? *(*I).scheduled_name : "<unnamed>", clocks2ms((*I).clocks));
+			xr_strcat		(text, line);
+		}
+	}
+
+	if (ai().script_engine().lua()) {
+		CScriptGCController	&gc = Level().script_gc_controller();
+		xr_sprintf			(line, "  lua gc : heap %d KB, last pause %d us, cycle %s\n", gc.heap(), gc.last_pause(), gc.cycle_active() ? "active" : "idle");
+		xr_strcat			(text, line);
+	}
+
+	xr_strcat				(text, "  previous frames, ms :");
+	u32 const				count = _min(m_history_count, u32(16));
+	for (u32 i = count; i > 1; --i) {
+		xr_sprintf			(line, " %.1f", m_history[(m_history_count - i) % history_size].work);
+		xr_strcat			(text, line);
+	}
+	xr_strcat				(text, "\n");
+
+	string_path				trace_file_name = "";
+	if (psHITCH_TRACE_FRAMES)
+		save_trace			(trace_file_name);
+	if (*trace_file_name) {
+		xr_sprintf			(line, "  trace : %s\n", trace_file_name);
+		xr_strcat			(text, line);
+	}
+
+	write_log				(text);
+	Msg						("! hitch : frame %d took %.2f ms, see hitch.log", info.frame, info.work);
+}
+
+void CHitchDetector::save_trace			(string_path &file_name)
+{
+	string64				name;
+	xr_sprintf				(name, "hitch_trace_%d.json", m_traces++ % trace_files);
+	FS.update_path			(file_name, "$logs$", name);
+	if (!trace_profiler::dump(file_name, u32(psHITCH_TRACE_FRAMES) + 1))
+		*file_name			= 0;
+}
+
+void CHitchDetector::write_log			(LPCSTR text) const
+{
+	string_path				file_name, old_file_name;
+	FS.update_path			(file_name, "$logs$", "hitch.log");
+	FS.update_path			(old_file_name, "$logs$", "hitch.old.log");
+
+	FILE					*file = fopen(file_name, "ab");
+	if (!file)
+		return;
+
+	fwrite					(text, 1, xr_strlen(text), file);
+	long const				size = ftell(file);
+	fclose					(file);
+
+	// keep one previous log
+	if (size > psHITCH_LOG_SIZE*1024) {
+		remove				(old_file_name);
+		rename				(file_name, old_file_name);
+	}
+}
+
+void CHitchDetector::dump_history		() const
+{
+	Msg						("* hitch detector : %d hitches, threshold %d ms", m_hitches, psHITCH_THRESHOLD);
+	u32 const				count = _min(m_history_count, u32(history_size));
+	for (u32 i = count; i > 0; --i) {
+		frame_info const	&info = m_history[(m_history_count - i) % history_size];
+		Msg					("* frame %6d : %6.2f ms (sched %.2f, alife %.2f/%.2f, ph %.2f, net %.2f/%.2f, srv %.2f, ev %.2f)",
+			info.frame, info.work,
+			info.sections[section_scheduler], info.sections[section_alife_scheduled], info.sections[section_alife_switch],
+			info.sections[section_physics], info.sections[section_net_receive], info.sections[section_net_send],
+			info.sections[section_server], info.sections[section_events]);
+	}
+}
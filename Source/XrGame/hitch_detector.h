@@ -0,0 +1,59 @@
+////////////////////////////////////////////////////////////////////////////
+//	Module 		: hitch_detector.h
+//	Created 	: 18.10.2026
+//  Modified 	: 18.10.2026
+//	Description : Dedicated server slow frame detector
+////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+extern int	psHITCH_THRESHOLD;			// frame work time which is reported, ms, 0 - off
+extern int	psHITCH_LOG_SIZE;			// hitch log is rotated after this size, KB
+extern int	psHITCH_TRACE_FRAMES;		// frames saved as a trace on a hitch, 0 - no traces
+
+class CHitchDetector : public pureFrame {
+public:
+	enum {
+		section_scheduler		= 0,
+		section_alife_scheduled,
+		section_alife_switch,
+		section_physics,
+		section_net_receive,
+		section_net_send,
+		section_server,
+		section_events,
+		section_sleep,
+		section_count,
+
+		history_size			= 64,
+		trace_files				= 8,
+	};
+
+	struct frame_info {
+		u32						frame;
+		float					total;						// ms, frame start to frame start
+		float					work;						// ms, total without the dedicated server sleep
+		float					sections[section_count];	// ms
+	};
+
+private:
+	u32							m_zones[section_count];
+	frame_info					m_history[history_size];
+	u32							m_history_count;
+	u32							m_hitches;
+	u32							m_traces;
+	bool						m_skip_frame;
+
+private:
+			void				measure						(frame_info &info) const;
+			void				report						(frame_info const &info);
+			void				write_log					(LPCSTR text) const;
+			void				save_trace					(string_path &file_name);
+
+public:
+								CHitchDetector				();
+	virtual						~CHitchDetector				();
+	virtual	void	_BCL		OnFrame						();
+			void				dump_history				() const;
+	IC		u32					hitches						() const { return m_hitches; }
+};
@@ -53,6 +53,10 @@ void CObjectHandler::reinit			(CAI_Stalker *object)
 	m_r_hand					= kinematics->LL_BoneID(pSettings->r_string(*planner().m_object->cNameSect(),"weapon_bone0"));
 	m_l_finger1					= kinematics->LL_BoneID(pSettings->r_string(*planner().m_object->cNameSect(),"weapon_bone1"));
 	m_r_finger2					= kinematics->LL_BoneID(pSettings->r_string(*planner().m_object->cNameSect(),"weapon_bone2"));
+	// the weapon is placed by these even when nobody renders the stalker
+	if (m_r_hand != BI_NONE)	kinematics->LL_SetBoneRequired(u16(m_r_hand),TRUE);
+	if (m_l_finger1 != BI_NONE)	kinematics->LL_SetBoneRequired(u16(m_l_finger1),TRUE);
+	if (m_r_finger2 != BI_NONE)	kinematics->LL_SetBoneRequired(u16(m_r_finger2),TRUE);
 	m_strap_object_id			= ALife::_OBJECT_ID(-1);
 	m_strap_bone0				= -1;
 	m_strap_bone1				= -1;
@@ -82,12 +82,13 @@ extern Flags32 psAI_Flags;
 
 IC	CProfiler&	profiler();
 		
-#	define START_PROFILE(a) { CProfilePortion	__profile_portion__(a);
+#	define START_PROFILE(a) { TRACE_ZONE(a); CProfilePortion	__profile_portion__(a);
 #	define STOP_PROFILE     }
 
 #	include "profiler_inline.h"
 
 #else // DEBUG
-#	define START_PROFILE(a) {
+	// release builds keep the profile points as trace zones
+#	define START_PROFILE(a) { TRACE_ZONE(a);
 #	define STOP_PROFILE		}
 #endif // DEBUG
\ No newline at end of file
@@ -17,6 +17,7 @@
 #include "alife_simulator.h"
 #include "alife_spawn_registry.h"
 #include "game_graph.h"
+#include "alife_storage_compressor.h"
 
 extern LPCSTR alife_section;
 
@@ -77,9 +78,8 @@ CSavedGameWrapper::CSavedGameWrapper			(LPCSTR saved_game_name)
 		return;
 	}
 
-	u32							source_count = stream->r_u32();
-	void						*source_data = xr_malloc(source_count);
-	rtc_decompress				(source_data,source_count,stream->pointer(),stream->length() - 3*sizeof(u32));
+	void						*source_data;
+	u32 const					source_count = ALife::load_compressed(*stream,source_data);
 	FS.r_close					(stream);
 
 	IReader						reader(source_data,source_count);
@@ -0,0 +1,218 @@
+////////////////////////////////////////////////////////////////////////////
+//	Module 		: script_gc_controller.cpp
+//	Created 	: 18.10.2026
+//  Modified 	: 18.10.2026
+//	Description : Lua garbage collector pacing controller
+////////////////////////////////////////////////////////////////////////////
+
+#include "pch_script.h"
+#include "script_gc_controller.h"
+#include "ai_space.h"
+#include "script_engine.h"
+
+int		psLUA_GC_BUDGET			= 500;
+int		psLUA_GC_BUDGET_MAX		= 3000;
+int		psLUA_GC_FRAME_TARGET	= 16;
+int		psLUA_GC_PAUSE			= 100;
+
+// the automatic collector is only a backstop: it starts a cycle
+// after the heap has grown this much (percents) since the last one
+static int const	backstop_pause		= 400;
+
+static u32 const	pause_buckets[CScriptGCController::pause_histogram_size - 1]	= { 100, 250, 500, 1000, 2000, 4000, 8000 };	// us
+static u32 const	heap_buckets[CScriptGCController::heap_histogram_size - 1]		= { 8, 16, 32, 64, 128, 256, 512 };				// MB
+
+template <int size>
+IC	u32 histogram_bucket				(u32 const (&buckets)[size], u32 const value)
+{
+	u32						i = 0;
+	for ( ; (i < size) && (value >= buckets[i]); ++i);
+	return					(i);
+}
+
+IC	u32 elapsed_us						(CTimerBase const& timer)
+{
+	return					(u32(timer.GetElapsed_ticks()*u64(1000000)/CPU::qpc_freq));
+}
+
+CScriptGCController::CScriptGCController()
+{
+	m_state					= 0;
+	m_last_pause			= 0;
+	m_heap_previous			= 0;
+	m_heap_after_cycle		= 0;
+	m_heap_growth			= 0.f;
+	m_cycle_active			= false;
+	m_simulation			= false;
+	m_full_collect_pending	= false;
+	m_frame_timer.Start		();
+
+	reset_stats				();
+}
+
+void CScriptGCController::attach			()
+{
+	// script engine recreates its virtual machine on reinit
+	m_state					= lua();
+	m_heap_after_cycle		= heap();
+	m_heap_previous			= m_heap_after_cycle;
+	m_heap_growth			= 0.f;
+	m_cycle_active			= false;
+
+	lua_gc					(m_state, LUA_GCSETPAUSE, 100 + backstop_pause);
+}
+
+lua_State *CScriptGCController::lua		()
+{
+	return					(ai().script_engine().lua());
+}
+
+u32 CScriptGCController::heap			() const
+{
+	return					(u32(lua_gc(lua(), LUA_GCCOUNT, 0)));
+}
+
+u32 CScriptGCController::frame_budget	(u32 const heap_size) const
+{
+	u32						budget = u32(psLUA_GC_BUDGET);
+	u32 const				budget_max = _max(budget, u32(psLUA_GC_BUDGET_MAX));
+
+	// falling behind the allocation rate, or finishing a requested full collection
+	if (m_full_collect_pending || (heap_size > 2*m_heap_after_cycle + 1024))
+		return				(budget_max);
+
+	// give away half of the frame slack
+	u32 const				frame_time = elapsed_us(m_frame_timer);
+	u32 const				target = u32(psLUA_GC_FRAME_TARGET)*1000;
+	u32 const				work_time = frame_time > m_last_pause ? frame_time - m_last_pause : 0;
+	if (work_time < target)
+		budget				+= (target - work_time)/2;
+
+	// heap grows faster than one budgeted step reclaims
+	if (m_heap_growth > 0.f)
+		budget				+= iFloor(m_heap_growth)*psLUA_GC_BUDGET/256;
+
+	return					(_min(budget, budget_max));
+}
+
+void CScriptGCController::update			()
+{
+	if (!lua())
+		return;
+
+	if (m_state != lua())
+		attach				();
+
+	u32 const				heap_start = heap();
+	m_heap_growth			= .9f*m_heap_growth + .1f*(float(heap_start) - float(m_heap_previous ? m_heap_previous : heap_start));
+
+	if (!m_cycle_active) {
+		u32 const			trigger = m_heap_after_cycle + m_heap_after_cycle*u32(psLUA_GC_PAUSE)/100;
+		m_cycle_active		= m_full_collect_pending || (heap_start >= trigger);
+	}
+
+	u32						pause = 0;
+	if (m_cycle_active) {
+		u32 const			budget = frame_budget(heap_start);
+
+		CTimerBase			timer;
+		timer.Start			();
+		do {
+			++m_steps;
+			if (lua_gc(lua(), LUA_GCSTEP, 0)) {
+				++m_cycles;
+				m_cycle_active	= false;
+				m_heap_after_cycle	= heap();
+				m_full_collect_pending	= false;
+				break;
+			}
+		}
+		while (elapsed_us(timer) < budget);
+
+		pause				= elapsed_us(timer);
+	}
+
+	m_heap_previous			= heap();
+	m_last_pause			= pause;
+	m_frame_timer.Start		();
+
+	account					(pause, m_heap_previous);
+}
+
+// a pending full collection is left to the caller, remove_objects runs the one of the unload
+void CScriptGCController::simulation		(bool value)
+{
+	m_simulation			= value;
+}
+
+void CScriptGCController::collect_all_garbage	()
+{
+	// the full stop-the-world collection is a load/unload time operation only,
+	// while simulating it is spread over the following frames at the max budget
+	if (m_simulation) {
+		m_full_collect_pending	= true;
+		return;
+	}
+
+	if (!lua())
+		return;
+
+	CTimerBase				timer;
+	timer.Start				();
+
+	ai().script_engine().collect_all_garbage	();
+	m_state					= lua();
+
+	++m_full_collects;
+	m_full_collect_pending	= false;
+	m_cycle_active			= false;
+	m_heap_after_cycle		= heap();
+	m_heap_previous			= m_heap_after_cycle;
+	m_heap_growth			= 0.f;
+
+	Msg						("* [LUA_GC] full collection : %d us, heap %d KB", elapsed_us(timer), m_heap_after_cycle);
+}
+
+void CScriptGCController::account			(u32 const pause, u32 const heap_size)
+{
+	++m_frames;
+	m_max_pause				= _max(m_max_pause, pause);
+	m_max_heap				= _max(m_max_heap, heap_size);
+	++m_pause_histogram[histogram_bucket(pause_buckets, pause)];
+	++m_heap_histogram[histogram_bucket(heap_buckets, heap_size/1024)];
+}
+
+void CScriptGCController::reset_stats		()
+{
+	m_frames				= 0;
+	m_steps					= 0;
+	m_cycles				= 0;
+	m_full_collects			= 0;
+	m_max_pause				= 0;
+	m_max_heap				= 0;
+	ZeroMemory				(m_pause_histogram, sizeof(m_pause_histogram));
+	ZeroMemory				(m_heap_histogram, sizeof(m_heap_histogram));
+}
+
+void CScriptGCController::dump_stats		() const
+{
+	Msg						("* [LUA_GC] frames %d, steps %d, cycles %d, full collections %d", m_frames, m_steps, m_cycles, m_full_collects);
+	Msg						("* [LUA_GC] heap %d KB (max %d KB, after last cycle %d KB), growth %.1f KB/frame", heap(), m_max_heap, m_heap_after_cycle, m_heap_growth);
+	Msg						("* [LUA_GC] pause max %d us, budget %d..%d us", m_max_pause, psLUA_GC_BUDGET, psLUA_GC_BUDGET_MAX);
+
+	Msg						("* [LUA_GC] pause histogram :");
+	for (u32 i = 0; i < pause_histogram_size; ++i) {
+		if (i < pause_histogram_size - 1)
+			Msg				("*   < %5d us : %d", pause_buckets[i], m_pause_histogram[i]);
+		else
+			Msg				("*  >= %5d us : %d", pause_buckets[i - 1], m_pause_histogram[i]);
+	}
+
+	Msg						("* [LUA_GC] heap histogram :");
+	for (u32 i = 0; i < heap_histogram_size; ++i) {
+		if (i < heap_histogram_size - 1)
+			Msg				("*   < %5d MB : %d", heap_buckets[i], m_heap_histogram[i]);
+		else
+			Msg				("*  >= %5d MB : %d", heap_buckets[i - 1], m_heap_histogram[i]);
+	}
+}
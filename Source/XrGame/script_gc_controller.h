@@ -0,0 +1,62 @@
+////////////////////////////////////////////////////////////////////////////
+//	Module 		: script_gc_controller.h
+//	Created 	: 18.10.2026
+//  Modified 	: 18.10.2026
+//	Description : Lua garbage collector pacing controller
+////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+struct lua_State;
+
+extern int	psLUA_GC_BUDGET;			// base incremental budget per frame, us
+extern int	psLUA_GC_BUDGET_MAX;		// hard budget limit per frame, us
+extern int	psLUA_GC_FRAME_TARGET;		// frame time the slack is measured against, ms
+extern int	psLUA_GC_PAUSE;				// heap growth (percents) which starts a new cycle
+
+class CScriptGCController {
+public:
+	enum {
+		pause_histogram_size	= 8,
+		heap_histogram_size		= 8,
+	};
+
+private:
+	lua_State					*m_state;
+	CTimerBase					m_frame_timer;
+	u32							m_last_pause;			// us
+	u32							m_heap_after_cycle;		// KB
+	u32							m_heap_previous;		// KB
+	float						m_heap_growth;			// KB per frame, smoothed
+	bool						m_cycle_active;
+	bool						m_simulation;
+	bool						m_full_collect_pending;
+
+private:
+	u32							m_frames;
+	u32							m_steps;
+	u32							m_cycles;
+	u32							m_full_collects;
+	u32							m_max_pause;
+	u32							m_max_heap;
+	u32							m_pause_histogram[pause_histogram_size];
+	u32							m_heap_histogram[heap_histogram_size];
+
+private:
+	static	lua_State			*lua						();
+			void				attach						();
+			u32					frame_budget				(u32 heap_size) const;
+			void				account						(u32 pause, u32 heap_size);
+
+public:
+								CScriptGCController			();
+			void				update						();
+			void				simulation					(bool value);
+	IC		bool				simulation					() const { return m_simulation; }
+			void				collect_all_garbage			();
+			void				reset_stats					();
+			void				dump_stats					() const;
+	IC		u32					last_pause					() const { return m_last_pause; }
+	IC		bool				cycle_active				() const { return m_cycle_active; }
+			u32					heap						() const;
+};
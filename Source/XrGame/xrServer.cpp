@@ -20,6 +20,7 @@
 #include "file_transfer.h"
 #include "screenshot_server.h"
 #include "xrServer_info.h"
+#include "../xrCPU_Pipe/ttapi.h"
 
 #pragma warning(push)
 #pragma warning(disable:4995)
@@ -61,6 +62,7 @@ xrServer::xrServer() : IPureServer(Device->GetTimerGlobal(), g_dedicated_server)
 	m_server_rules		= NULL;
 	m_last_updates_size	= 0;
 	m_last_update_time	= 0;
+	m_interest_clients	= 0;
 }
 
 xrServer::~xrServer()
@@ -206,6 +208,7 @@ INT g_sv_SendUpdate = 0;
 
 void xrServer::Update	()
 {
+	TRACE_ZONE		("xrServer::Update");
 	if (Level().IsDemoPlayStarted() || Level().IsDemoPlayFinished())
 		return;								//diabling server when demo is playing
 
@@ -280,44 +283,282 @@ void  xrServer::SendGameUpdateTo(IClient* client)
 	SendTo					(xr_client->ID, Packet, net_flags(FALSE,TRUE));
 }
 
-void xrServer::MakeUpdatePackets()
+bool xrServer::IsUpdateRelevant(CSE_Abstract & Test)
 {
-	NET_Packet						tmpPacket;			
-	u32								position;
+	if (0==Test.owner)								return false;
+	if (!Test.net_Ready)							return false;
+	if (Test.s_flags.is(M_SPAWN_OBJECT_PHANTOM))	return false;	// Surely: phantom
+	if (!Test.Net_Relevant() )						return false;
+	return true;
+}
+
+void xrServer::WriteEntityUpdates()
+{
+	TRACE_ZONE						("xrServer::WriteEntityUpdates");
+	m_update_writer.begin			();
 
-	m_updator.begin_updates			();
-	
 	xrS_entities::iterator I	= entities.begin();
 	xrS_entities::iterator E	= entities.end();
 	for (; I!=E; ++I)
 	{//all entities
 		CSE_Abstract&	Test			= *(I->second);
+		if (IsUpdateRelevant(Test))
+			m_update_writer.add			(&Test);
+	}//all entities
 
-		if (0==Test.owner)								continue;
-		if (!Test.net_Ready)							continue;
-		if (Test.s_flags.is(M_SPAWN_OBJECT_PHANTOM))	continue;	// Surely: phantom
-		if (!Test.Net_Relevant() )						continue;
-
-		tmpPacket.B.count				= 0;
-		// write specific data
-		{
-			tmpPacket.w_u16					(Test.ID);
-			tmpPacket.w_chunk_open8			(position);
-			Test.UPDATE_Write				(tmpPacket);
-			u32 ObjectSize					= u32(tmpPacket.w_tell()-position)-sizeof(u8);
-			tmpPacket.w_chunk_close8		(position);
+	m_update_writer.write			(!!g_sv_parallel_update_write);
+}
 
-			if (ObjectSize == 0)			continue;					
+bool xrServer::ReadEntityUpdate(u32 index, NET_Packet & tmpPacket)
+{
+	if (!m_update_writer.read(index, tmpPacket))
+		return false;
 #ifdef DEBUG
-			if (g_Dump_Update_Write) Msg("* %s : %d", Test.name(), ObjectSize);
+	if (g_Dump_Update_Write) Msg("* %s : %d", m_update_writer.entity(index)->name(), tmpPacket.B.count - sizeof(u16) - sizeof(u8));
 #endif
-			m_updator.write_update_for		(Test.ID, tmpPacket);
+	return true;
+}
+
+void xrServer::MakeUpdatePackets()
+{
+	NET_Packet						tmpPacket;			
+
+	WriteEntityUpdates				();
+
+	m_updator.begin_updates			();
+	for (u32 i = 0, ie = m_update_writer.count(); i < ie; ++i)
+	{//all entities, in the serial order
+		if (ReadEntityUpdate(i, tmpPacket))
+			m_updator.write_update_for	(m_update_writer.entity(i)->ID, tmpPacket);
+	}
+
+	m_updator.end_updates			(m_update_begin, m_update_end);
+}
+
+void xrServer::MakeInterestUpdates()
+{
+	NET_Packet						tmpPacket;
+
+	WriteEntityUpdates				();
+
+	m_interest.begin_tick			(Device->dwTimeGlobal);
+	for (u32 i = 0, ie = m_update_writer.count(); i < ie; ++i)
+	{//all entities, serialized once for all the clients
+		if (!ReadEntityUpdate(i, tmpPacket))
+			continue;
+
+		CSE_Abstract&	Test			= *m_update_writer.entity(i);
+
+		// attached objects are where their root parent is
+		CSE_Abstract*	root			= &Test;
+		for (u32 depth = 0; (root->ID_Parent != 0xffff) && (depth < 8); ++depth)
+		{
+			CSE_Abstract*	parent		= ID_to_entity(root->ID_Parent);
+			if (!parent)				break;
+			root						= parent;
 		}
+		m_interest.add_update			(Test.ID, root->ID, root->o_Position, tmpPacket, game->IsEntityUpdateCritical(&Test));
 	}//all entities
 
+	m_interest.end_tick				();
+}
+
+void xrServer::UpdateWriteBenchmark(u32 count, u32 ticks)
+{
+	xr_vector<CSE_Abstract*>		templates;
+	for (xrS_entities::iterator I = entities.begin(), E = entities.end(); I != E; ++I)
+	{
+		if (IsUpdateRelevant(*I->second))
+			templates.push_back		(I->second);
+	}
+	if (templates.empty())
+	{
+		Msg("! update write benchmark : no entities to update");
+		return;
+	}
+
+	// synthetic entities are copies of the live ones, spawn and update state
+	xr_vector<CSE_Abstract*>		synthetic;
+	NET_Packet						tmpPacket;
+	for (u32 i = 0; i < count; ++i)
+	{
+		CSE_Abstract*	source		= templates[i % templates.size()];
+		CSE_Abstract*	entity		= F_entity_Create(*source->s_name);
+		if (!entity)
+			continue;
+
+		source->Spawn_Write			(tmpPacket, FALSE);
+		tmpPacket.r_pos				= 0;
+		entity->Spawn_Read			(tmpPacket);
+
+		tmpPacket.write_start		();
+		source->UPDATE_Write		(tmpPacket);
+		tmpPacket.r_pos				= 0;
+		entity->UPDATE_Read			(tmpPacket);
+		synthetic.push_back			(entity);
+	}
+
+	server_update_writer			writer;
+	xr_vector<u8>					streams[2];
+	float							elapsed_us[2];
+	for (u32 mode = 0; mode < 2; ++mode)
+	{
+		CTimer						timer;
+		timer.Start					();
+		for (u32 tick = 0; tick < ticks; ++tick)
+		{
+			writer.begin			();
+			for (u32 i = 0, ie = synthetic.size(); i < ie; ++i)
+				writer.add			(synthetic[i]);
+			writer.write			(mode == 1);
+		}
+		elapsed_us[mode]			= timer.GetElapsed_sec() * 1000000.f / float(ticks);
+
+		for (u32 i = 0, ie = writer.count(); i < ie; ++i)
+		{
+			if (writer.read(i, tmpPacket))
+				streams[mode].insert(streams[mode].end(), tmpPacket.B.data, tmpPacket.B.data + tmpPacket.B.count);
+		}
+	}
+
+	Msg("* update write benchmark : %d entities of %d kinds, %d ticks, %d workers, %d bytes per tick",
+		synthetic.size(), templates.size(), ticks, ttapi_GetWorkersCount(), streams[0].size());
+	Msg("* serial   : %.1f us/tick", elapsed_us[0]);
+	Msg("* parallel : %.1f us/tick (x%.2f)", elapsed_us[1], elapsed_us[0] / _max(elapsed_us[1], EPS_S));
+	if (streams[0] != streams[1])
+		Msg("! update write benchmark : parallel update stream differs from the serial one");
+
+	for (xr_vector<CSE_Abstract*>::iterator i = synthetic.begin(), ie = synthetic.end(); i != ie; ++i)
+		F_entity_Destroy			(*i);
+}
+
+void xrServer::AssembleUpdatePackets(server_interest_manager::selection_t const & selection)
+{
+	NET_Packet						tmpPacket;
+
+	m_updator.begin_updates			();
+	for (server_interest_manager::selection_t::const_iterator i = selection.begin(), ie = selection.end(); i != ie; ++i)
+	{
+		m_interest.read_update		(*i, tmpPacket);
+		// the interest manager tracks the last sent updates per client
+		m_updator.write_update_for	(m_interest.update_entity(*i), tmpPacket, false);
+	}
 	m_updator.end_updates			(m_update_begin, m_update_end);
 }
 
+void xrServer::SendInterestUpdatesTo(IClient* client)
+{
+	xrClientData*	xr_client = static_cast<xrClientData*>(client);
+	VERIFY			(xr_client);
+	if (client->ID == GetServerClient()->ID)
+		return;
+	if (!client->flags.bConnected || !xr_client->net_Accepted)
+		return;
+
+	m_interest.select		(m_interest.get_client(client->ID), xr_client->owner,
+		(g_sv_traffic_optimization_level & eto_last_change) != 0, m_interest_selection);
+	AssembleUpdatePackets	(m_interest_selection);
+
+	for (update_iterator_t i = m_update_begin; i != m_update_end; ++i)
+	{
+		NET_Packet& to_send = **i;
+		if (to_send.B.count > 2)
+		{
+			m_last_updates_size += to_send.B.count;
+			SendTo			(client->ID, to_send, net_flags(FALSE,TRUE));
+		}
+	}
+	++m_interest_clients;
+}
+
+void xrServer::SendInterestUpdatesToAll()
+{
+	m_last_updates_size		= 0;
+	m_interest_clients		= 0;
+
+	fastdelegate::FastDelegate1<IClient*,void> sendtofd;
+	sendtofd.bind			(this, &xrServer::SendInterestUpdatesTo);
+	ForEachClientDoSender	(sendtofd);
+
+	m_interest.purge_clients();
+	// comparable with the broadcast size
+	if (m_interest_clients)
+		m_last_updates_size	/= m_interest_clients;
+}
+
+void xrServer::InterestBenchmark(u32 clients, u32 seconds)
+{
+	if (!m_interest.enabled())
+	{
+		Msg("! interest benchmark : sv_interest_radius is 0");
+		return;
+	}
+
+	MakeInterestUpdates				();
+	if (!m_interest.updates_count())
+	{
+		Msg("! interest benchmark : no entities to update");
+		return;
+	}
+
+	// simulated clients stand at the entities spread evenly over the level
+	xr_vector<CSE_Abstract*>		views;
+	for (xrS_entities::const_iterator I = entities.begin(), E = entities.end(); I != E; ++I)
+	{
+		if (I->second->ID_Parent == 0xffff)
+			views.push_back			(I->second);
+	}
+	if (views.empty() || !clients)
+		return;
+
+	typedef xr_vector<server_interest_manager::client_interest>	sim_clients_t;
+	sim_clients_t					sim_clients(clients);
+
+	u32 const rate					= u32(psNET_ServerUpdate);
+	u32 const ticks					= seconds * rate;
+	u32 time						= Device->dwTimeGlobal;
+
+	// a broadcast sends the same packets to everybody
+	u64 broadcast_bytes				= 0;
+	m_interest.select_all			(m_interest_selection);
+	AssembleUpdatePackets			(m_interest_selection);
+	for (update_iterator_t i = m_update_begin; i != m_update_end; ++i)
+	{
+		if ((*i)->B.count > 2)
+			broadcast_bytes			+= (*i)->B.count;
+	}
+
+	u64 interest_bytes				= 0;
+	u64 selected					= 0;
+	CTimer							timer;
+	timer.Start						();
+	for (u32 tick = 0; tick < ticks; ++tick)
+	{
+		time						+= 1000 / rate;
+		m_interest.benchmark_tick	(time);
+		for (u32 c = 0; c < clients; ++c)
+		{
+			// every entity is assumed to change every tick
+			m_interest.select		(sim_clients[c], views[(c * views.size()) / clients], false, m_interest_selection);
+			AssembleUpdatePackets	(m_interest_selection);
+			selected				+= m_interest_selection.size();
+			for (update_iterator_t i = m_update_begin; i != m_update_end; ++i)
+			{
+				if ((*i)->B.count > 2)
+					interest_bytes	+= (*i)->B.count;
+			}
+		}
+	}
+	float const elapsed_us			= timer.GetElapsed_sec() * 1000000.f;
+
+	u32 const client_ticks			= _max(clients * ticks, u32(1));
+	Msg("* interest benchmark : %d clients, %d entities, %d ticks at %d Hz, radius %d m",
+		clients, m_interest.updates_count(), ticks, rate, g_sv_interest_radius);
+	Msg("* broadcast : %u bytes/client/sec", u32(broadcast_bytes * rate));
+	Msg("* interest  : %u bytes/client/sec, %.1f entities/client/tick, %.1f us/tick",
+		u32(interest_bytes * rate / client_ticks), float(selected) / float(client_ticks), elapsed_us / float(_max(ticks, u32(1))));
+}
+
 void xrServer::SendUpdatePacketsToAll()
 {
 	m_last_updates_size = 0;
@@ -340,6 +581,7 @@ void xrServer::SendUpdatesToAll()
 {
 	if (IsGameTypeSingle())
 		return;
+	TRACE_ZONE("xrServer::SendUpdatesToAll");
 	
 	KickCheaters();
 
@@ -351,8 +593,16 @@ void xrServer::SendUpdatesToAll()
 
 	if ((Device->dwTimeGlobal - m_last_update_time) >= u32(1000/psNET_ServerUpdate))
 	{
-		MakeUpdatePackets				();
-		SendUpdatePacketsToAll			();
+		// demos record the broadcast
+		if (m_interest.enabled() && !Level().IsDemoSave())
+		{
+			MakeInterestUpdates			();
+			SendInterestUpdatesToAll	();
+		} else
+		{
+			MakeUpdatePackets			();
+			SendUpdatePacketsToAll		();
+		}
 
 #ifdef DEBUG
 		g_sv_SendUpdate = 0;
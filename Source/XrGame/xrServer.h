@@ -13,6 +13,8 @@
 #include "../xrEngine/mp_logging.h"
 #include "secure_messaging.h"
 #include "xrServer_updates_compressor.h"
+#include "xrServer_interest_manager.h"
+#include "xrServer_update_writer.h"
 #include "xrClientsPool.h"
 
 #ifdef DEBUG
@@ -102,6 +104,19 @@ private:
 	void						SendUpdatePacketsToAll		();
 	u32							m_last_updates_size;
 	u32							m_last_update_time;
+
+	server_update_writer		m_update_writer;
+	server_interest_manager		m_interest;
+	server_interest_manager::selection_t	m_interest_selection;
+	u32							m_interest_clients;
+
+	bool						IsUpdateRelevant			(CSE_Abstract & entity);
+	void						WriteEntityUpdates			();
+	bool						ReadEntityUpdate			(u32 index, NET_Packet & dest);
+	void						MakeInterestUpdates			();
+	void						AssembleUpdatePackets		(server_interest_manager::selection_t const & selection);
+	void						SendInterestUpdatesToAll	();
+	void						SendInterestUpdatesTo		(IClient* client);
 	
 	
 	void						SendServerInfoToClient		(ClientID const & new_client);
@@ -249,6 +264,8 @@ public:
 	u32						GetEntitiesNum		()			{ return entities.size(); };
 	CSE_Abstract*			GetEntity			(u32 Num);
 	u32 const				GetLastUpdatesSize	() const { return m_last_updates_size; };
+	void					InterestBenchmark	(u32 clients, u32 seconds);
+	void					UpdateWriteBenchmark(u32 count, u32 ticks);
 
 	xrClientData*			ID_to_client		(ClientID ID, bool ScanAll = false ) { return (xrClientData*)(IPureServer::ID_to_client( ID, ScanAll)); }
 	CSE_Abstract*			ID_to_entity		(u16 ID);
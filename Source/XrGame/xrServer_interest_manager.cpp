@@ -0,0 +1,258 @@
+#include "stdafx.h"
+#include "xrServer_interest_manager.h"
+#include "xrServer_Object_Base.h"
+
+int		g_sv_interest_radius		= 0;
+int		g_sv_interest_near			= 50;
+int		g_sv_interest_far_period	= 250;
+int		g_sv_interest_hysteresis	= 20;
+
+server_interest_manager::server_interest_manager()
+{
+	m_cell_size		= 1.f;
+	m_time			= 0;
+	m_tick			= 0;
+}
+
+int server_interest_manager::cell_coord(float const value) const
+{
+	return iFloor(value / m_cell_size);
+}
+
+u32 server_interest_manager::cell_key(Fvector const & position) const
+{
+	//the grid is flat, levels are much wider than they are high
+	u32 const x		= u32(cell_coord(position.x)) & 0xffff;
+	u32 const z		= u32(cell_coord(position.z)) & 0xffff;
+	return (x << 16) | z;
+}
+
+void server_interest_manager::begin_tick(u32 const time)
+{
+	m_time			= time;
+	++m_tick;
+	m_updates.clear	();
+	m_data.clear	();
+	m_always.clear	();
+}
+
+void server_interest_manager::add_update(u16 const entity_id,
+										 u16 const root_id,
+										 Fvector const & root_position,
+										 NET_Packet const & update,
+										 bool const critical)
+{
+	VERIFY(update.B.count < u32(u16(-1)));
+	entity_update	tmp_update;
+	tmp_update.m_position	= root_position;
+	tmp_update.m_offset		= m_data.size();
+	tmp_update.m_crc		= crc32(update.B.data, update.B.count);
+	tmp_update.m_size		= static_cast<u16>(update.B.count);
+	tmp_update.m_entity_id	= entity_id;
+	tmp_update.m_root_id	= root_id;
+	tmp_update.m_critical	= critical;
+	m_data.insert			(m_data.end(), update.B.data, update.B.data + update.B.count);
+
+	if (critical)
+		m_always.push_back	(m_updates.size());
+	m_updates.push_back		(tmp_update);
+}
+
+void server_interest_manager::end_tick()
+{
+	float const leave_radius	= float(g_sv_interest_radius) * float(100 + g_sv_interest_hysteresis) / 100.f;
+	//a client query touches about 5x5 cells
+	m_cell_size					= _max(leave_radius / 2.f, 8.f);
+
+	m_sort_buffer.clear			();
+	for (u32 i = 0, ie = m_updates.size(); i < ie; ++i)
+	{
+		if (m_updates[i].m_critical)
+			continue;
+		m_sort_buffer.push_back	((u64(cell_key(m_updates[i].m_position)) << 32) | i);
+	}
+	std::sort					(m_sort_buffer.begin(), m_sort_buffer.end());
+
+	m_cells.clear				();
+	m_cell_items.resize			(m_sort_buffer.size());
+	for (u32 i = 0, ie = m_sort_buffer.size(); i < ie; ++i)
+	{
+		u32 const key			= u32(m_sort_buffer[i] >> 32);
+		m_cell_items[i]			= u32(m_sort_buffer[i] & 0xffffffff);
+		if (!i || (key != u32(m_sort_buffer[i - 1] >> 32)))
+			m_cells.insert		(std::make_pair(key, cell_range_t(i, 0)));
+		++m_cells[key].second;
+	}
+}
+
+void server_interest_manager::benchmark_tick(u32 const time)
+{
+	m_time			= time;
+	++m_tick;
+}
+
+server_interest_manager::client_interest& server_interest_manager::get_client(ClientID const & client_id)
+{
+	return m_clients[client_id.value()];
+}
+
+void server_interest_manager::purge_clients()
+{
+	xr_vector<u32>	disconnected;
+	for (clients_t::const_iterator i = m_clients.begin(), ie = m_clients.end(); i != ie; ++i)
+	{
+		if (i->second.m_last_seen != m_tick)
+			disconnected.push_back(i->first);
+	}
+	for (xr_vector<u32>::const_iterator i = disconnected.begin(), ie = disconnected.end(); i != ie; ++i)
+	{
+		m_clients.erase(*i);
+	}
+}
+
+bool server_interest_manager::need_send(entity_update const & update,
+										relevance & rel,
+										float const distance_sqr,
+										bool const check_last_change) const
+{
+	if (!rel.m_fresh)
+	{
+		u16 const eq_count	= (update.m_crc == rel.m_sent_crc) ? rel.m_eq_count + 1 : 0;
+		//unreliable packets: the same update is repeated a few times before it is suppressed
+		if (check_last_change && (eq_count >= max_eq_packets))
+			return false;
+
+		float const distance	= _sqrt(distance_sqr);
+		float const near_radius	= float(g_sv_interest_near);
+		if (distance > near_radius)
+		{
+			float const range	= _max(float(g_sv_interest_radius) - near_radius, 1.f);
+			u32 const period	= iFloor(float(g_sv_interest_far_period) * _min(distance - near_radius, range) / range);
+			if (m_time - rel.m_last_sent < period)
+				return false;
+		}
+		rel.m_eq_count		= eq_count;
+	} else
+	{
+		rel.m_eq_count		= 0;
+		rel.m_fresh			= false;
+	}
+	rel.m_sent_crc			= update.m_crc;
+	rel.m_last_sent			= m_time;
+	return true;
+}
+
+void server_interest_manager::consider(client_interest & client,
+									   u32 const index,
+									   float const distance_sqr,
+									   bool const check_last_change,
+									   selection_t & result)
+{
+	entity_update const & update	= m_updates[index];
+	relevance_map_t::iterator it	= client.m_relevant.find(update.m_entity_id);
+	if (it == client.m_relevant.end())
+	{
+		relevance	tmp_rel;
+		tmp_rel.m_last_seen		= m_tick;
+		tmp_rel.m_last_sent		= m_time;
+		tmp_rel.m_sent_crc		= 0;
+		tmp_rel.m_eq_count		= 0;
+		tmp_rel.m_fresh			= true;
+		it = client.m_relevant.insert(std::make_pair(update.m_entity_id, tmp_rel)).first;
+	}
+	it->second.m_last_seen	= m_tick;
+	if (need_send(update, it->second, distance_sqr, check_last_change))
+		result.push_back	(index);
+}
+
+void server_interest_manager::drop_expired(client_interest & client)
+{
+	m_expired.clear();
+	for (relevance_map_t::const_iterator i = client.m_relevant.begin(), ie = client.m_relevant.end(); i != ie; ++i)
+	{
+		if (i->second.m_last_seen != m_tick)
+			m_expired.push_back(i->first);
+	}
+	for (xr_vector<u16>::const_iterator i = m_expired.begin(), ie = m_expired.end(); i != ie; ++i)
+	{
+		client.m_relevant.erase(*i);
+	}
+}
+
+void server_interest_manager::select(client_interest & client,
+									 CSE_Abstract const * view,
+									 bool const check_last_change,
+									 selection_t & result)
+{
+	result.clear			();
+	client.m_last_seen		= m_tick;
+
+	for (xr_vector<u32>::const_iterator i = m_always.begin(), ie = m_always.end(); i != ie; ++i)
+	{
+		consider(client, *i, 0.f, check_last_change, result);
+	}
+
+	if (!view)
+	{
+		//not spawned yet, nothing to measure from
+		for (u32 i = 0, ie = m_updates.size(); i < ie; ++i)
+		{
+			if (!m_updates[i].m_critical)
+				consider(client, i, 0.f, check_last_change, result);
+		}
+		drop_expired		(client);
+		return;
+	}
+
+	Fvector const & view_position	= view->o_Position;
+	float const enter_radius	= float(g_sv_interest_radius);
+	float const leave_radius	= enter_radius * float(100 + g_sv_interest_hysteresis) / 100.f;
+	float const enter_sqr		= _sqr(enter_radius);
+	float const leave_sqr		= _sqr(leave_radius);
+
+	int const min_x	= cell_coord(view_position.x - leave_radius);
+	int const max_x	= cell_coord(view_position.x + leave_radius);
+	int const min_z	= cell_coord(view_position.z - leave_radius);
+	int const max_z	= cell_coord(view_position.z + leave_radius);
+	for (int x = min_x; x <= max_x; ++x)
+	{
+		for (int z = min_z; z <= max_z; ++z)
+		{
+			u32 const key				= ((u32(x) & 0xffff) << 16) | (u32(z) & 0xffff);
+			cells_t::const_iterator cell	= m_cells.find(key);
+			if (cell == m_cells.end())
+				continue;
+
+			for (u32 i = cell->second.first, ie = cell->second.first + cell->second.second; i < ie; ++i)
+			{
+				u32 const index			= m_cell_items[i];
+				entity_update const & update	= m_updates[index];
+				//owned and attached objects share the owner's position, so they are always at zero distance
+				float const distance_sqr	= (update.m_root_id == view->ID) ? 0.f : view_position.distance_to_sqr(update.m_position);
+				if (distance_sqr > leave_sqr)
+					continue;
+				if ((distance_sqr > enter_sqr) && (client.m_relevant.find(update.m_entity_id) == client.m_relevant.end()))
+					continue;
+				consider(client, index, distance_sqr, check_last_change, result);
+			}
+		}
+	}
+	drop_expired			(client);
+}
+
+void server_interest_manager::select_all(selection_t & result) const
+{
+	result.resize(m_updates.size());
+	for (u32 i = 0, ie = m_updates.size(); i < ie; ++i)
+	{
+		result[i] = i;
+	}
+}
+
+void server_interest_manager::read_update(u32 const index, NET_Packet & dest) const
+{
+	entity_update const & update	= m_updates[index];
+	CopyMemory		(dest.B.data, &m_data[update.m_offset], update.m_size);
+	dest.B.count	= update.m_size;
+	dest.r_pos		= 0;
+}
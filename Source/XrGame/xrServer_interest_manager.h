@@ -0,0 +1,99 @@
+#ifndef XRSERVER_INTEREST_MANAGER_INCLUDED
+#define XRSERVER_INTEREST_MANAGER_INCLUDED
+
+class CSE_Abstract;
+
+extern int	g_sv_interest_radius;		// meters, 0 - every client gets every entity
+extern int	g_sv_interest_near;			// meters, entities closer than this are sent every update
+extern int	g_sv_interest_far_period;	// ms, update period of the entities at g_sv_interest_radius
+extern int	g_sv_interest_hysteresis;	// percents of g_sv_interest_radius an entity may go away before it is dropped
+
+// Area of interest filtering of the entity updates: every update is serialized
+// once per tick, then each client gets only the entities around its own one.
+// Owned/attached and game mode critical entities are always sent.
+class server_interest_manager : private boost::noncopyable
+{
+public:
+	static u16 const max_eq_packets		= 3;	// the same as server_updates_compressor
+
+	struct relevance
+	{
+		u32		m_last_seen;		// tick
+		u32		m_last_sent;		// time
+		u32		m_sent_crc;
+		u16		m_eq_count;
+		bool	m_fresh;			// just became relevant, nothing sent yet
+	};//struct relevance
+
+	typedef xr_hash_map<u16, relevance>	relevance_map_t;
+
+	struct client_interest
+	{
+		relevance_map_t	m_relevant;
+		u32				m_last_seen;		// tick
+
+		client_interest	() : m_last_seen(0) {};
+	};//struct client_interest
+
+	typedef xr_vector<u32>				selection_t;	// indices of the tick updates
+
+			server_interest_manager		();
+			~server_interest_manager	()	{};
+
+	void	begin_tick					(u32 const time);
+	void	add_update					(u16 const entity_id, u16 const root_id, Fvector const & root_position,
+										 NET_Packet const & update, bool const critical);
+	void	end_tick					();
+	void	purge_clients				();
+
+	client_interest&	get_client		(ClientID const & client_id);
+	void	select						(client_interest & client, CSE_Abstract const * view,
+										 bool const check_last_change, selection_t & result);
+	void	select_all					(selection_t & result) const;
+	void	read_update					(u32 const index, NET_Packet & dest) const;
+	u16		update_entity				(u32 const index) const { return m_updates[index].m_entity_id; };
+	u32		updates_count				() const { return m_updates.size(); };
+
+	bool	enabled						() const { return g_sv_interest_radius > 0; };
+	void	benchmark_tick				(u32 const time);
+	u32		tick						() const { return m_tick; };
+private:
+	struct entity_update
+	{
+		Fvector	m_position;			// of the root parent
+		u32		m_offset;
+		u32		m_crc;
+		u16		m_size;
+		u16		m_entity_id;
+		u16		m_root_id;
+		bool	m_critical;
+	};//struct entity_update
+
+	typedef xr_vector<entity_update>		updates_t;
+	typedef std::pair<u32, u32>				cell_range_t;		// first, count in m_cell_items
+	typedef xr_hash_map<u32, cell_range_t>	cells_t;
+	typedef xr_hash_map<u32, client_interest>	clients_t;
+
+	updates_t					m_updates;
+	xr_vector<u8>				m_data;
+	xr_vector<u32>				m_always;			// critical updates
+	xr_vector<u32>				m_cell_items;		// update indices sorted by cell
+	xr_vector<u64>				m_sort_buffer;		// cell key << 32 | update index
+	cells_t						m_cells;
+	clients_t					m_clients;
+	xr_vector<u16>				m_expired;
+
+	float						m_cell_size;
+	u32							m_time;
+	u32							m_tick;
+
+	u32		cell_key					(Fvector const & position) const;
+	int		cell_coord					(float const value) const;
+	bool	need_send					(entity_update const & update, relevance & rel,
+										 float const distance_sqr, bool const check_last_change) const;
+	void	consider					(client_interest & client, u32 const index, float const distance_sqr,
+										 bool const check_last_change, selection_t & result);
+	void	drop_expired				(client_interest & client);
+};//class server_interest_manager
+
+#endif//#ifndef XRSERVER_INTEREST_MANAGER_INCLUDED
@@ -0,0 +1,95 @@
+#include "stdafx.h"
+#include "xrServer_update_writer.h"
+#include "xrServer_Object_Base.h"
+#include "../xrCPU_Pipe/ttapi.h"
+
+BOOL		g_sv_parallel_update_write	= TRUE;
+
+server_update_writer::server_update_writer()
+{
+	m_slabs.resize	(1);
+}
+
+void server_update_writer::begin()
+{
+	m_entities.clear();
+}
+
+u32 server_update_writer::write_entity(CSE_Abstract & entity, NET_Packet & dest)
+{
+	u32				position;
+	dest.B.count	= 0;
+	dest.w_u16		(entity.ID);
+	dest.w_chunk_open8	(position);
+	entity.UPDATE_Write	(dest);
+	u32 const object_size	= u32(dest.w_tell() - position) - sizeof(u8);
+	dest.w_chunk_close8	(position);
+	return object_size;
+}
+
+void server_update_writer::write_range(u32 const first, u32 const last, u32 const slab)
+{
+	NET_Packet		tmp_packet;
+	slab_t &		dest = m_slabs[slab];
+	dest.clear		();
+	for (u32 i = first; i < last; ++i)
+	{
+		entity_slot & slot	= m_slots[i];
+		slot.m_slab			= static_cast<u16>(slab);
+		slot.m_offset		= dest.size();
+		slot.m_size			= 0;
+		if (!write_entity(*m_entities[i], tmp_packet))
+			continue;
+
+		slot.m_size			= static_cast<u16>(tmp_packet.B.count);
+		dest.insert			(dest.end(), tmp_packet.B.data, tmp_packet.B.data + tmp_packet.B.count);
+	}
+}
+
+void server_update_writer::range_worker(LPVOID params)
+{
+	range_params const & range = *static_cast<range_params const*>(params);
+	range.m_writer->write_range(range.m_first, range.m_last, range.m_slab);
+}
+
+void server_update_writer::write(bool const parallel)
+{
+	u32 const entities_count	= m_entities.size();
+	m_slots.resize				(entities_count);
+
+	u32 const workers_count		= (parallel && (entities_count >= min_parallel_entities)) ?
+		_max(u32(1), _min(entities_count / (min_parallel_entities / 2), u32(ttapi_GetWorkersCount()))) : 1;
+	if (workers_count == 1)
+	{
+		write_range				(0, entities_count, 0);
+		return;
+	}
+
+	if (m_slabs.size() < workers_count)
+		m_slabs.resize			(workers_count);
+
+	range_params* ranges		= static_cast<range_params*>(_alloca(workers_count * sizeof(range_params)));
+	ttapi_Lock					();
+	for (u32 i = 0; i < workers_count; ++i)
+	{
+		ranges[i].m_writer		= this;
+		ranges[i].m_first		= (entities_count * i) / workers_count;
+		ranges[i].m_last		= (entities_count * (i + 1)) / workers_count;
+		ranges[i].m_slab		= i;
+		ttapi_AddWorker			(&range_worker, &ranges[i]);
+	}
+	ttapi_RunAllWorkers			();
+	ttapi_Unlock				();
+}
+
+bool server_update_writer::read(u32 const index, NET_Packet & dest) const
+{
+	entity_slot const & slot	= m_slots[index];
+	if (!slot.m_size)
+		return false;
+
+	CopyMemory		(dest.B.data, &m_slabs[slot.m_slab][slot.m_offset], slot.m_size);
+	dest.B.count	= slot.m_size;
+	dest.r_pos		= 0;
+	return true;
+}
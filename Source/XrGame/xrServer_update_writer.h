@@ -0,0 +1,58 @@
+#ifndef XRSERVER_UPDATE_WRITER_INCLUDED
+#define XRSERVER_UPDATE_WRITER_INCLUDED
+
+class CSE_Abstract;
+
+extern BOOL	g_sv_parallel_update_write;
+
+// Runs UPDATE_Write of the entities of an update tick on the ttapi workers:
+// every worker serializes a contiguous range of the entities into its own
+// slab, the updates are read back in the order the entities were added, so
+// the update stream is the same as the serial one.
+class server_update_writer : private boost::noncopyable
+{
+public:
+			server_update_writer	();
+			~server_update_writer	()	{};
+
+	void	begin					();
+	void	add						(CSE_Abstract* entity)	{ m_entities.push_back(entity); };
+	void	write					(bool const parallel);
+
+	u32				count			() const					{ return m_entities.size(); };
+	CSE_Abstract*	entity			(u32 const index) const		{ return m_entities[index]; };
+	//returns false if the entity has nothing to update
+	bool	read					(u32 const index, NET_Packet & dest) const;
+
+	//entity id + UPDATE_Write chunk, returns the chunk size
+	static u32	write_entity		(CSE_Abstract & entity, NET_Packet & dest);
+private:
+	//fewer entities are not worth waking the workers up
+	static u32 const min_parallel_entities	= 32;
+
+	struct entity_slot
+	{
+		u32		m_offset;
+		u16		m_size;				// 0 - nothing to update
+		u16		m_slab;
+	};//struct entity_slot
+
+	struct range_params
+	{
+		server_update_writer*	m_writer;
+		u32						m_first;
+		u32						m_last;
+		u32						m_slab;
+	};//struct range_params
+
+	typedef xr_vector<u8>		slab_t;
+
+	xr_vector<CSE_Abstract*>	m_entities;
+	xr_vector<entity_slot>		m_slots;
+	xr_vector<slab_t>			m_slabs;
+
+	void			write_range		(u32 const first, u32 const last, u32 const slab);
+	static void		range_worker	(LPVOID params);
+};//class server_update_writer
+
+#endif//#ifndef XRSERVER_UPDATE_WRITER_INCLUDED
@@ -242,9 +242,9 @@ void server_updates_compressor::flush_accumulative_buffer()
 	m_acc_buff.w_begin(M_UPDATE_OBJECTS);
 }
 
-void server_updates_compressor::write_update_for(u16 const enity, NET_Packet & update)
+void server_updates_compressor::write_update_for(u16 const enity, NET_Packet & update, bool const check_last_change)
 {
-	if (g_sv_traffic_optimization_level & eto_last_change)
+	if (check_last_change && (g_sv_traffic_optimization_level & eto_last_change))
 	{
 		//if (m_updates_cache.get_last_equpdates(enity, update) >= max_eq_packets)
 		if (m_updates_cache.add_update(enity, update) >= max_eq_packets)
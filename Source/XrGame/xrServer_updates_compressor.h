@@ -38,7 +38,7 @@ public:
 	typedef xr_vector<NET_Packet*>	send_ready_updates_t;
 
 	void	begin_updates		();
-	void	write_update_for	(u16 const enity, NET_Packet & update);
+	void	write_update_for	(u16 const enity, NET_Packet & update, bool const check_last_change = true);
 	void	end_updates			(send_ready_updates_t::const_iterator & b,
 								 send_ready_updates_t::const_iterator & e);
 private:
@@ -260,6 +260,7 @@ XRNETSERVER_API int		psNET_ClientUpdate	= 30;		// FPS
 XRNETSERVER_API int		psNET_ClientPending	= 2;
 XRNETSERVER_API char	psNET_Name[32]		= "Player";
 XRNETSERVER_API BOOL	psNET_direct_connect = FALSE;
+XRNETSERVER_API BOOL	psNET_local_udp_host = FALSE;	// the listen server of this process hosts on udp, its client follows
 
 /****************************************************************************
  *
@@ -348,6 +349,8 @@ IPureClient::IPureClient	(CTimer* timer): net_Statistic(timer)
 	NET						= NULL;
 	net_Address_server		= NULL;
 	net_Address_device		= NULL;
+	m_transport				= NULL;
+	m_transport_peer		= 0;
 	device_timer			= timer;
 	net_TimeDelta_User		= 0;
 	net_Time_LastUpdate		= 0;
@@ -436,6 +439,15 @@ if(!psNET_direct_connect)
 	net_Syncronised	= FALSE;
 	net_Disconnected= FALSE;
 
+	if (psNET_Flags.test(NETFLAG_UDP_TRANSPORT) || psNET_local_udp_host || strstr(options, "/udp"))
+	{
+		if (!TransportConnect(server_name, password_str, user_name_str, user_pass, psSV_Port, psCL_Port, bPortWasSet))
+			return		FALSE;
+
+		net_TimeDelta	= 0;
+		return			TRUE;
+	}
+
 	//---------------------------
 	string1024 tmp="";
 //	HRESULT CoInitializeExRes = CoInitializeEx(NULL, 0);
@@ -738,9 +750,100 @@ if(!psNET_direct_connect)
 	return			TRUE;
 }
 
+BOOL IPureClient::TransportConnect(LPCSTR server_name, LPCSTR password, LPCSTR user_name, LPCSTR user_pass, int sv_port, int cl_port, BOOL bPortWasSet)
+{
+	m_transport			= NET_CreateUdpTransport(this);
+
+	u32 c_port			= u32(cl_port);
+	while (!m_transport->Bind(u16(c_port)))
+	{
+		Msg("! IPureClient : port %d is BUSY!", c_port);
+		c_port++;
+		if (bPortWasSet || c_port > END_PORT_LAN)
+		{
+			xr_delete	(m_transport);
+			return		FALSE;
+		}
+	}
+	Msg("- IPureClient : created on udp port %d!", c_port);
+
+	// SClientConnectData, then the session password
+	NET_Packet					request;
+	request.B.count				= 0;
+	SClientConnectData			cl_data;
+	cl_data.process_id			= GetCurrentProcessId();
+	xr_strcpy					(cl_data.name, user_name);
+	xr_strcpy					(cl_data.pass, user_pass);
+	request.w					(&cl_data, sizeof(cl_data));
+	request.w_stringZ			(password);
+
+	NET_Packet					reply;
+	INetTransport::EConnect res	= m_transport->Connect(server_name, u16(sv_port), request.B.data, request.B.count, reply, m_transport_peer, 5000);
+	if (res == INetTransport::ConnectInvalidHost || res == INetTransport::ConnectTimeout)
+	{
+		m_transport->Close		();
+		xr_delete				(m_transport);
+		OnInvalidHost			();
+		return					FALSE;
+	}
+
+	u8 code						= reply.r_eof() ? u8(net_connect_refused) : reply.r_u8();
+	if (res != INetTransport::ConnectAccepted)
+	{
+		m_transport->Close		();
+		xr_delete				(m_transport);
+		switch (code)
+		{
+		case net_connect_invalid_password:
+			{
+				OnInvalidPassword();
+			}break;
+		case net_connect_session_full:
+			{
+				OnSessionFull();
+			}break;
+		default:
+			{
+				shared_str		reason;
+				if (!reply.r_eof())
+					reply.r_stringZ	(reason);
+				Msg				("Connection result : %s", reason.size() ? *reason : "refused");
+			}break;
+		}
+		return					FALSE;
+	}
+
+	HOST_NODE	NODE;
+	ZeroMemory	(&NODE, sizeof(HOST_NODE));
+	reply.r		(&m_game_description, sizeof(m_game_description));
+	reply.r_stringZ				(NODE.dpSessionName);
+
+	net_csEnumeration.Enter		();
+	net_Hosts.push_back			(NODE);
+	net_csEnumeration.Leave		();
+	return						TRUE;
+}
+
+void IPureClient::OnTransportDisconnected(u32 peer, LPCSTR reason)
+{
+	net_Disconnected	= TRUE;
+	if (reason)
+		OnSessionTerminate	(reason);
+}
+
+void IPureClient::OnTransportReceive(u32 peer, void* data, u32 size)
+{
+	MultipacketReciever::RecievePacket( data, size );
+}
+
 void IPureClient::Disconnect()
 {
 	if( NET )	NET->Close(0);
+	if (m_transport)
+	{
+		m_transport->Close	();
+		xr_delete			(m_transport);
+	}
 
     // Clean up Host _list_
 	net_csEnumeration.Enter			();
@@ -958,7 +1061,14 @@ void	IPureClient::SendTo_LL(void* data, u32 size, u32 dwFlags, u32 dwTimeout)
 	desc.pBufferData    = (BYTE*)data;
 
     net_Statistic.dwBytesSended	+= size;
-	
+
+	if (m_transport)
+	{
+		m_transport->Send		(m_transport_peer, data, size, !!(dwFlags & DPNSEND_GUARANTEED));
+		if (dwFlags & DPNSEND_IMMEDIATELLY)
+			m_transport->Flush	(m_transport_peer);
+		return;
+	}
 
 	// verify
 	VERIFY(desc.dwBufferSize);
@@ -988,6 +1098,8 @@ void	IPureClient::Send( NET_Packet& packet, u32 dwFlags, u32 dwTimeout )
 void	IPureClient::Flush_Send_Buffer		()
 {
     MultipacketSender::FlushSendBuffer( 0 );
+	if (m_transport)
+		m_transport->FlushAll();
 }
 
 BOOL	IPureClient::net_HasBandwidth	()
@@ -1011,12 +1123,16 @@ BOOL	IPureClient::net_HasBandwidth	()
 	}else
 	if (0 != psNET_ClientUpdate && (dwTime-net_Time_LastUpdate)>dwInterval)	
 	{
-		HRESULT hr;
-		R_ASSERT			(NET);
 		// check queue for "empty" state
 		DWORD				dwPending=0;
-		hr					= NET->GetSendQueueInfo(&dwPending,0,0);
-		if (FAILED(hr)) return FALSE;
+		if (m_transport)
+			dwPending		= m_transport->GetPending(m_transport_peer);
+		else
+		{
+			R_ASSERT		(NET);
+			HRESULT hr		= NET->GetSendQueueInfo(&dwPending,0,0);
+			if (FAILED(hr)) return FALSE;
+		}
 
 		if (dwPending > u32(psNET_ClientPending))	
 		{
@@ -1039,8 +1155,17 @@ void	IPureClient::UpdateStatistic()
 	DPN_CONNECTION_INFO	CI;
 	ZeroMemory			(&CI,sizeof(CI));
 	CI.dwSize			= sizeof(CI);
-	HRESULT hr					= NET->GetConnectionInfo(&CI,0);
-	if (FAILED(hr)) return;
+	if (m_transport)
+	{
+		NET_TransportStats	S;
+		if (!m_transport->GetPeerStats(m_transport_peer, S)) return;
+		NET_TransportStatsToCI(S, CI);
+	}
+	else
+	{
+		HRESULT hr			= NET->GetConnectionInfo(&CI,0);
+		if (FAILED(hr)) return;
+	}
 
 	net_Statistic.Update(CI);
 }
@@ -1051,15 +1176,18 @@ void	IPureClient::Sync_Thread	()
 
 	//***** Ping server
 	net_DeltaArray.clear();
-	R_ASSERT			(NET);
-	for (; NET && !net_Disconnected; )
+	R_ASSERT			(NET || m_transport);
+	for (; (NET || m_transport) && !net_Disconnected; )
 	{
 		// Waiting for queue empty state
 		if (net_Syncronised)	break; // Sleep(2000);
 		else {
 			DWORD			dwPending=0;
 			do {
-				R_CHK			(NET->GetSendQueueInfo(&dwPending,0,0));
+				if (m_transport)
+					dwPending	= m_transport->GetPending(m_transport_peer);
+				else
+					R_CHK		(NET->GetSendQueueInfo(&dwPending,0,0));
 				Sleep			(1);
 			} while (dwPending);
 		}
@@ -1075,9 +1203,13 @@ void	IPureClient::Sync_Thread	()
 			DPNHANDLE						hAsync=0;
 			desc.dwBufferSize				= sizeof(clPing);
 			desc.pBufferData				= LPBYTE(&clPing);
-			if (0==NET || net_Disconnected)	break;
-
-			if (FAILED(NET->Send(&desc,1,0,0,&hAsync,net_flags(FALSE,FALSE,TRUE))))	{
+			if (m_transport && !net_Disconnected)
+			{
+				m_transport->Send			(m_transport_peer, &clPing, sizeof(clPing), false);
+				m_transport->Flush			(m_transport_peer);
+			}
+			else if (0==NET || net_Disconnected)	break;
+			else if (FAILED(NET->Send(&desc,1,0,0,&hAsync,net_flags(FALSE,FALSE,TRUE))))	{
 				Msg("* CLIENT: SyncThread: EXIT. (failed to send - disconnected?)");
 				break;
 			}
@@ -1149,6 +1281,14 @@ BOOL	IPureClient::net_IsSyncronised()
 bool	IPureClient::GetServerAddress		(ip_address& pAddress, DWORD* pPort)
 {
 	*pPort		= 0;
+	if (m_transport)
+	{
+		u16		port = 0;
+		if (!m_transport->GetPeerAddress(m_transport_peer, pAddress.m_data.data, port))
+			return false;
+		*pPort	= port;
+		return	true;
+	}
 	if (!net_Address_server) return false;
 
 	WCHAR wstrHostname[ 2048 ] = {0};	
@@ -2,6 +2,7 @@
 
 #include "net_shared.h"
 #include "NET_Common.h"
+#include "NET_Transport.h"
 
 struct ip_address;
 
@@ -28,7 +29,8 @@ public:
 class XRNETSERVER_API 
 IPureClient
   : private MultipacketReciever,
-    private MultipacketSender
+    private MultipacketSender,
+    private INetTransportHandler
 {
 	enum ConnectionState
 	{
@@ -50,6 +52,8 @@ protected:
 	IDirectPlay8Client*		NET;
 	IDirectPlay8Address*	net_Address_device;
 	IDirectPlay8Address*	net_Address_server;
+	INetTransport*			m_transport;		// instead of DirectPlay, see NETFLAG_UDP_TRANSPORT
+	u32						m_transport_peer;
 		
 	xrCriticalSection		net_csEnumeration;
 	xr_vector<HOST_NODE>	net_Hosts;
@@ -133,5 +137,12 @@ private:
 
     virtual void    _Recieve( const void* data, u32 data_size, u32 param );
     virtual void    _SendTo_LL( const void* data, u32 size, u32 flags, u32 timeout );
+
+	BOOL			TransportConnect		(LPCSTR server_name, LPCSTR password, LPCSTR user_name, LPCSTR user_pass, int sv_port, int cl_port, BOOL bPortWasSet);
+
+	virtual bool	OnTransportConnect		(u32 address, u16 port, const void* data, u32 size, NET_Packet& reply)	{ return false; }
+	virtual void	OnTransportConnected	(u32 peer, const void* data, u32 size)	{}
+	virtual void	OnTransportDisconnected	(u32 peer, LPCSTR reason);
+	virtual void	OnTransportReceive		(u32 peer, void* data, u32 size);
 };
 
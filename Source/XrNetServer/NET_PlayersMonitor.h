@@ -11,92 +11,158 @@ class PlayersMonitor
 {
 private:
 	typedef xr_vector<IClient*>	players_collection_t;
-	xrCriticalSection			csPlayers;
-	players_collection_t		net_Players;
+	typedef xr_vector<DWORD>	readers_collection_t;
+	// The players list is copied on write: iteration takes the current version
+	// and runs without csPlayers held, AddNewClient/FindAndEraseClient publish
+	// a new one. Replaced versions live until the last thread iterating on
+	// them is done.
+	struct players_version
+	{
+		players_collection_t	players;
+		readers_collection_t	readers;	// ids of the threads iterating on this version
+	};
+	typedef xr_vector<players_version*>	versions_collection_t;
+
+	mutable xrCriticalSection	csPlayers;
+	players_version*			net_Players;
+	versions_collection_t		net_Players_retired;
 	players_collection_t		net_Players_disconnected;
-	bool						now_iterating_in_net_players;
-	bool						now_iterating_in_net_players_disconn;
-#ifdef DEBUG
-	DWORD						iterator_thread_id;
-#endif
+
+	players_version*	AcquireVersion					()
+	{
+		csPlayers.Enter();
+		players_version* ret_version = net_Players;
+		ret_version->readers.push_back(GetCurrentThreadId());
+		csPlayers.Leave();
+		return ret_version;
+	}
+	void		ReleaseVersion					(players_version* version)
+	{
+		csPlayers.Enter();
+		readers_collection_t::iterator reader_iter = std::find(
+			version->readers.begin(),
+			version->readers.end(),
+			GetCurrentThreadId());
+		VERIFY(reader_iter != version->readers.end());
+		version->readers.erase(reader_iter);
+		if ((version != net_Players) && version->readers.empty())
+		{
+			net_Players_retired.erase(std::find(
+				net_Players_retired.begin(),
+				net_Players_retired.end(),
+				version));
+			xr_delete(version);
+		}
+		csPlayers.Leave();
+	}
+	//must be called under csPlayers
+	players_version*	CopyVersion						() const
+	{
+		players_version* ret_version = xr_new<players_version>();
+		ret_version->players = net_Players->players;
+		return ret_version;
+	}
+	//must be called under csPlayers
+	void		PublishVersion					(players_version* version)
+	{
+		if (net_Players->readers.empty())
+			xr_delete(net_Players);
+		else
+			net_Players_retired.push_back(net_Players);
+		net_Players = version;
+	}
+	bool		IsIteratedByOthers				(players_version const* version, DWORD thread_id) const
+	{
+		for (readers_collection_t::const_iterator i = version->readers.begin(),
+			ie = version->readers.end(); i != ie; ++i)
+		{
+			if (*i != thread_id)
+				return true;
+		}
+		return false;
+	}
+	//an erased client may be destroyed only when nobody iterates on a version that still has it,
+	//the readers run whole send loops so after a few yields it sleeps and leaves them the cpu
+	void		WaitForRetiredReaders			()
+	{
+		DWORD const thread_id = GetCurrentThreadId();
+		for (u32 spin = 0; ; ++spin)
+		{
+			bool busy = false;
+			csPlayers.Enter();
+			for (versions_collection_t::const_iterator i = net_Players_retired.begin(),
+				ie = net_Players_retired.end(); (i != ie) && !busy; ++i)
+			{
+				busy = IsIteratedByOthers(*i, thread_id);
+			}
+			csPlayers.Leave();
+			if (!busy)
+				return;
+			if ((spin >= 16) || !SwitchToThread())
+				Sleep(1);
+		}
+	}
 public:
 	PlayersMonitor()
 	{
-	  now_iterating_in_net_players			= false;
-	  now_iterating_in_net_players_disconn	= false;
-#ifdef DEBUG
-	  iterator_thread_id					= 0;
-#endif
+		net_Players = xr_new<players_version>();
+	}
+	~PlayersMonitor()
+	{
+		VERIFY(net_Players->readers.empty() && net_Players_retired.empty());
+		xr_delete(net_Players);
+		for (versions_collection_t::iterator i = net_Players_retired.begin(),
+			ie = net_Players_retired.end(); i != ie; ++i)
+		{
+			xr_delete(*i);
+		}
 	}
 #ifdef DEBUG
 	bool IsCurrentThreadIteratingOnClients() const
 	{
-		if (now_iterating_in_net_players || now_iterating_in_net_players_disconn)
+		DWORD const thread_id = GetCurrentThreadId();
+		csPlayers.Enter();
+		bool result = std::find(net_Players->readers.begin(), net_Players->readers.end(), thread_id) != net_Players->readers.end();
+		for (versions_collection_t::const_iterator i = net_Players_retired.begin(),
+			ie = net_Players_retired.end(); (i != ie) && !result; ++i)
 		{
-			if (iterator_thread_id == GetCurrentThreadId())
-			{
-				return true;
-			}
+			result = std::find((*i)->readers.begin(), (*i)->readers.end(), thread_id) != (*i)->readers.end();
 		}
-		return false;
+		csPlayers.Leave();
+		return result;
 	}
 #endif
 	template<typename ActionFunctor>
 	void ForEachClientDo					(ActionFunctor & functor)
 	{
-		//Msg("-S- Entering to csPlayers [%d]", GetCurrentThreadId());
-		csPlayers.Enter();
-		//LogStackTrace(
-		//	make_string("-S- Entered to csPlayers [%d]", GetCurrentThreadId()).c_str());
-		now_iterating_in_net_players	=	true;
-#ifdef DEBUG
-		iterator_thread_id = GetCurrentThreadId();
-#endif
-		for (players_collection_t::iterator i = net_Players.begin(),
-			ie = net_Players.end(); i != ie; ++i)
+		players_version* version = AcquireVersion();
+		for (players_collection_t::iterator i = version->players.begin(),
+			ie = version->players.end(); i != ie; ++i)
 		{
 			VERIFY2(*i != NULL, "IClient ptr is NULL");
 			functor(*i);
 		}
-		now_iterating_in_net_players	=	false;
-		//Msg("-S- Leaving from csPlayers [%d]", GetCurrentThreadId());
-		csPlayers.Leave();
+		ReleaseVersion(version);
 	}
 	void ForEachClientDo				(fastdelegate::FastDelegate1<IClient*, void> & fast_delegate)
 	{
-		//Msg("-S- Entering to csPlayers [%d]", GetCurrentThreadId());
-		csPlayers.Enter();
-		//LogStackTrace(
-		//	make_string("-S- Entered to csPlayers [%d]", GetCurrentThreadId()).c_str());
-		now_iterating_in_net_players	=	true;
-#ifdef DEBUG
-		iterator_thread_id = GetCurrentThreadId();
-#endif
-		for (players_collection_t::iterator i = net_Players.begin(),
-			ie = net_Players.end(); i != ie; ++i)
+		players_version* version = AcquireVersion();
+		for (players_collection_t::iterator i = version->players.begin(),
+			ie = version->players.end(); i != ie; ++i)
 		{
 			VERIFY2(*i != NULL, "IClient ptr is NULL");
 			fast_delegate(*i);
 		}
-		now_iterating_in_net_players	=	false;
-		//Msg("-S- Leaving from csPlayers [%d]", GetCurrentThreadId());
-		csPlayers.Leave();
+		ReleaseVersion(version);
 	}
 	template<typename SearchPredicate, typename ActionFunctor>
 	u32	ForFoundClientsDo				(SearchPredicate const & predicate,	ActionFunctor & functor)
 	{
 		u32 ret_count = 0;
-		//Msg("-S- Entering to csPlayers [%d]", GetCurrentThreadId());
-		csPlayers.Enter();
-		//LogStackTrace(
-		//	make_string("-S- Entered to csPlayers [%d]", GetCurrentThreadId()).c_str());
-		now_iterating_in_net_players	=	true;
-#ifdef DEBUG
-		iterator_thread_id = GetCurrentThreadId();
-#endif
-		players_collection_t::iterator players_endi = net_Players.end();
+		players_version* version = AcquireVersion();
+		players_collection_t::iterator players_endi = version->players.end();
 		players_collection_t::iterator temp_iter = std::find_if(
-			net_Players.begin(),
+			version->players.begin(),
 			players_endi,
 			predicate);
 		
@@ -106,68 +172,56 @@ public:
 			functor(*temp_iter);
 			temp_iter = std::find_if(++temp_iter, players_endi, predicate);
 		}
-		now_iterating_in_net_players	=	false;
-		//Msg("-S- Leaving from csPlayers [%d]", GetCurrentThreadId());
-		csPlayers.Leave();
+		ReleaseVersion(version);
 		return ret_count;
 	}
 	
 	template<typename SearchPredicate>
 	IClient*	FindAndEraseClient				(SearchPredicate const & predicate)
 	{
-		//Msg("-S- Entering to csPlayers [%d]", GetCurrentThreadId());
+		VERIFY2(!IsCurrentThreadIteratingOnClients(), "erasing a client while iterating on clients");
 		csPlayers.Enter();
-		//LogStackTrace(
-		//	make_string("-S- Entered to csPlayers [%d]", GetCurrentThreadId()).c_str());
-		VERIFY(!now_iterating_in_net_players);
-		now_iterating_in_net_players	=	true;
-#ifdef DEBUG
-		iterator_thread_id = GetCurrentThreadId();
-#endif
 		players_collection_t::iterator client_iter = std::find_if(
-			net_Players.begin(),
-			net_Players.end(),
+			net_Players->players.begin(),
+			net_Players->players.end(),
 			predicate);
 		IClient* ret_client = NULL;
-		if (client_iter != net_Players.end())
+		if (client_iter != net_Players->players.end())
 		{
 			ret_client = *client_iter;
-			net_Players.erase(client_iter);
+			players_version* new_version = CopyVersion();
+			new_version->players.erase(
+				new_version->players.begin() + (client_iter - net_Players->players.begin()));
+			PublishVersion(new_version);
 		}
-		now_iterating_in_net_players	=	false;
-		//Msg("-S- Leaving from csPlayers [%d]", GetCurrentThreadId());
 		csPlayers.Leave();
+
+		if (ret_client)
+			WaitForRetiredReaders();
 		return ret_client;
 	}
 	template<typename SearchPredicate>
 	IClient*	GetFoundClient					(SearchPredicate const & predicate)
 	{
-		//Msg("-S- Entering to csPlayers [%d]", GetCurrentThreadId());
 		csPlayers.Enter();
-		//LogStackTrace(
-		//	make_string("-S- Entered to csPlayers [%d]", GetCurrentThreadId()).c_str());
 		players_collection_t::iterator client_iter = std::find_if(
-			net_Players.begin(),
-			net_Players.end(),
+			net_Players->players.begin(),
+			net_Players->players.end(),
 			predicate);
 		IClient* ret_client = NULL;
-		if (client_iter != net_Players.end())
+		if (client_iter != net_Players->players.end())
 		{
 			ret_client = *client_iter;
 		}
-		//Msg("-S- Leaving from csPlayers [%d]", GetCurrentThreadId());
 		csPlayers.Leave();
 		return ret_client;
 	}
 	void		AddNewClient					(IClient* new_client)
 	{
-		//Msg("-S- Entering to csPlayers [%d]", GetCurrentThreadId());
 		csPlayers.Enter();
-		//LogStackTrace(
-		//	make_string("-S- Entered to csPlayers [%d]", GetCurrentThreadId()).c_str());
-		VERIFY(!now_iterating_in_net_players);
-		net_Players.push_back(new_client);
-		//Msg("-S- Leaving from csPlayers [%d]", GetCurrentThreadId());
+		players_version* new_version = CopyVersion();
+		new_version->players.push_back(new_client);
+		PublishVersion(new_version);
 		csPlayers.Leave();
 	}
 
@@ -251,12 +305,8 @@ public:
 
 	u32			ClientsCount					()
 	{
-		//Msg("-S- Entering to csPlayers [%d]", GetCurrentThreadId());
 		csPlayers.Enter();
-		//LogStackTrace(
-		//	make_string("-S- Entered to csPlayers [%d]", GetCurrentThreadId()).c_str());
-		u32 ret_count = net_Players.size();
-		//Msg("-S- Leaving from csPlayers [%d]", GetCurrentThreadId());
+		u32 ret_count = net_Players->players.size();
 		csPlayers.Leave();
 		return ret_count;
 	}
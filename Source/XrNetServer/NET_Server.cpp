@@ -220,6 +220,8 @@ IPureServer::IPureServer	(CTimer* timer, BOOL	Dedicated)
 	SV_Client				= NULL;
 	NET						= NULL;
 	net_Address_device		= NULL;
+	m_transport				= NULL;
+	m_max_players			= 0;
 	pSvNetLog				= NULL;//xr_new<INetLog>("logs\\net_sv_log.log", TimeGlobal(device_timer));
 #ifdef DEBUG
 	sender_functor_invoked = false;
@@ -299,7 +301,17 @@ IPureServer::EConnect IPureServer::Connect(LPCSTR options, GameDescriptionData &
 	}
 	//-------------------------------------------------------------------
 
-if(!psNET_direct_connect)
+	if (!psNET_direct_connect && (psNET_Flags.test(NETFLAG_UDP_TRANSPORT) || strstr(options, "/udp")))
+	{
+		m_session_name		= session_name;
+		m_session_password	= password_str;
+		// the same limit as dwMaxPlayers of DirectPlay without the server player
+		m_max_players		= (m_bDedicated) ? (dwMaxPlayers+1) : dwMaxPlayers;
+		if (TransportHost(game_descr, dwServerPort, bPortWasSet) != ErrNoError)
+			return			ErrConnect;
+	}
+
+if(!psNET_direct_connect && !m_transport)
 {
 	//---------------------------
 #ifdef DEBUG
@@ -435,6 +447,28 @@ if(!psNET_direct_connect)
 	return	ErrNoError;
 }
 
+IPureServer::EConnect IPureServer::TransportHost(GameDescriptionData & game_descr, u32 port, BOOL bPortWasSet)
+{
+	m_game_description	= game_descr;
+	m_transport			= NET_CreateUdpTransport(this);
+
+	psNET_Port = port;
+	while (!m_transport->Bind(u16(psNET_Port)))
+	{
+		Msg("! IPureServer : port %d is BUSY!", psNET_Port);
+		psNET_Port++;
+		if (bPortWasSet || psNET_Port > END_PORT_LAN)
+		{
+			xr_delete	(m_transport);
+			return		ErrConnect;
+		}
+	}
+	m_transport->Listen	();
+	psNET_local_udp_host	= TRUE;
+	Msg("- IPureServer : created on udp port %d!", psNET_Port);
+	return	ErrNoError;
+}
+
 void IPureServer::Disconnect	()
 {
 //.	config_Save		();
@@ -446,6 +480,12 @@ void IPureServer::Disconnect	()
 	}
 
     if( NET )	NET->Close(0);
+	if (m_transport)
+	{
+		m_transport->Close	();
+		xr_delete			(m_transport);
+		psNET_local_udp_host	= FALSE;
+	}
 	
 	// Release interfaces
     _RELEASE	(net_Address_device);
@@ -506,45 +546,15 @@ HRESULT	IPureServer::net_Handler(u32 dwMessageType, PVOID pMessage)
 	case DPN_MSGID_DESTROY_PLAYER:
 		{
 			PDPNMSG_DESTROY_PLAYER	msg = PDPNMSG_DESTROY_PLAYER(pMessage);
-			IClient* tmp_client = net_players.GetFoundClient(
-				ClientIdSearchPredicate(static_cast<ClientID>(msg->dpnidPlayer))
-			);
-			if (tmp_client)
-			{
-				tmp_client->flags.bConnected	= FALSE;
-				tmp_client->flags.bReconnect	= FALSE;
-				OnCL_Disconnected	(tmp_client);
-				// real destroy
-				client_Destroy		(tmp_client);
-			}
+			client_link_aborted		(static_cast<ClientID>(msg->dpnidPlayer));
 		}
 		break;
 	case DPN_MSGID_RECEIVE:
         {
 
             PDPNMSG_RECEIVE	pMsg = PDPNMSG_RECEIVE(pMessage);
-			void*	m_data		= pMsg->pReceiveData;
-			u32		m_size		= pMsg->dwReceiveDataSize;
-			DPNID   m_sender	= pMsg->dpnidSender;
-
-			MSYS_PING*	m_ping	= (MSYS_PING*)m_data;
-			
-			if ((m_size>2*sizeof(u32)) && (m_ping->sign1==0x12071980) && (m_ping->sign2==0x26111975))
-			{
-				// this is system message
-				if (m_size==sizeof(MSYS_PING))
-				{
-					// ping - save server time and reply
-					m_ping->dwTime_Server	= TimerAsync(device_timer);
-					ClientID ID; ID.set(m_sender);
-					//						IPureServer::SendTo_LL	(ID,m_data,m_size,net_flags(FALSE,FALSE,TRUE));
-					IPureServer::SendTo_Buf	(ID,m_data,m_size,net_flags(FALSE,FALSE,TRUE, TRUE));
-				}
-			} 
-			else 
-			{
-                MultipacketReciever::RecievePacket( pMsg->pReceiveData, pMsg->dwReceiveDataSize, m_sender );
-			}
+			ClientID ID; ID.set(pMsg->dpnidSender);
+			ReceiveData		(ID, pMsg->pReceiveData, pMsg->dwReceiveDataSize);
         } break;
         
 	case DPN_MSGID_INDICATE_CONNECT :
@@ -554,17 +564,11 @@ HRESULT	IPureServer::net_Handler(u32 dwMessageType, PVOID pMessage)
 			ip_address			HAddr;
 			GetClientAddress	(msg->pAddressPlayer, HAddr);
 
-			if (GetBannedClient(HAddr)) 
+			LPCSTR reject		= CheckConnectAddress(HAddr);
+			if (reject)
 			{
-				msg->dwReplyDataSize	= sizeof(NET_BANNED_STR);
-				msg->pvReplyData		= NET_BANNED_STR;
-				return					S_FALSE;
-			};
-			//first connected client is SV_Client so if it is NULL then this server client tries to connect ;)
-			if (SV_Client && !m_ip_filter.is_ip_present(HAddr.m_data.data))
-			{
-				msg->dwReplyDataSize	= sizeof(NET_NOTFOR_SUBNET_STR);
-				msg->pvReplyData		= NET_NOTFOR_SUBNET_STR;
+				msg->dwReplyDataSize	= xr_strlen(reject) + 1;
+				msg->pvReplyData		= (PVOID)reject;
 				return					S_FALSE;
 			}
 		}break;
@@ -572,6 +576,111 @@ HRESULT	IPureServer::net_Handler(u32 dwMessageType, PVOID pMessage)
     return S_OK;
 }
 
+LPCSTR IPureServer::CheckConnectAddress(const ip_address& Address)
+{
+	if (GetBannedClient(Address))
+		return		NET_BANNED_STR;
+
+	//first connected client is SV_Client so if it is NULL then this server client tries to connect ;)
+	if (SV_Client && !m_ip_filter.is_ip_present(Address.m_data.data))
+		return		NET_NOTFOR_SUBNET_STR;
+
+	return			NULL;
+}
+
+void IPureServer::ReceiveData(ClientID sender, void* data, u32 size)
+{
+	MSYS_PING*	m_ping	= (MSYS_PING*)data;
+	
+	if ((size>2*sizeof(u32)) && (m_ping->sign1==0x12071980) && (m_ping->sign2==0x26111975))
+	{
+		// this is system message
+		if (size==sizeof(MSYS_PING))
+		{
+			// ping - save server time and reply
+			m_ping->dwTime_Server	= TimerAsync(device_timer);
+			IPureServer::SendTo_Buf	(sender,data,size,net_flags(FALSE,FALSE,TRUE, TRUE));
+		}
+	} 
+	else 
+	{
+		MultipacketReciever::RecievePacket( data, size, sender.value() );
+	}
+}
+
+void IPureServer::client_link_aborted(ClientID ID)
+{
+	IClient* tmp_client = net_players.GetFoundClient(
+		ClientIdSearchPredicate(ID)
+	);
+	if (tmp_client)
+	{
+		tmp_client->flags.bConnected	= FALSE;
+		tmp_client->flags.bReconnect	= FALSE;
+		OnCL_Disconnected	(tmp_client);
+		// real destroy
+		client_Destroy		(tmp_client);
+	}
+}
+
+//------------------------------------------------------------------------------
+
+bool IPureServer::OnTransportConnect(u32 address, u16 port, const void* data, u32 size, NET_Packet& reply)
+{
+	// SClientConnectData, then the password
+	const char*			password = (const char*)data + sizeof(SClientConnectData);
+	if (size <= sizeof(SClientConnectData) || password[size - sizeof(SClientConnectData) - 1])
+	{
+		reply.w_u8		(net_connect_refused);
+		reply.w_stringZ	("");
+		return			false;
+	}
+
+	ip_address			HAddr;
+	HAddr.m_data.data	= address;
+	LPCSTR reject		= CheckConnectAddress(HAddr);
+	if (reject)
+	{
+		reply.w_u8		(net_connect_refused);
+		reply.w_stringZ	(reject);
+		return			false;
+	}
+	if (m_session_password.size() && xr_strcmp(m_session_password, password))
+	{
+		reply.w_u8		(net_connect_invalid_password);
+		return			false;
+	}
+	if (net_players.ClientsCount() >= m_max_players)
+	{
+		reply.w_u8		(net_connect_session_full);
+		return			false;
+	}
+
+	reply.w_u8			(net_connect_accepted);
+	reply.w				(&m_game_description, sizeof(m_game_description));
+	reply.w_stringZ		(m_session_name);
+	return				true;
+}
+
+void IPureServer::OnTransportConnected(u32 peer, const void* data, u32 size)
+{
+	SClientConnectData	cl_data;
+	CopyMemory			(&cl_data, data, sizeof(cl_data));
+	cl_data.clientID.set(peer);
+
+	new_client			(&cl_data);
+}
+
+void IPureServer::OnTransportDisconnected(u32 peer, LPCSTR reason)
+{
+	client_link_aborted	(static_cast<ClientID>(peer));
+}
+
+void IPureServer::OnTransportReceive(u32 peer, void* data, u32 size)
+{
+	ReceiveData			(static_cast<ClientID>(peer), data, size);
+}
+
 void	IPureServer::Flush_Clients_Buffers	()
 {
     #if NET_LOG_PACKETS
@@ -589,6 +698,10 @@ void	IPureServer::Flush_Clients_Buffers	()
 	net_players.ForEachClientDo(
 		LocalSenderFunctor::FlushBuffer
 	);
+
+	// the merged packets leave as coalesced datagrams once per update
+	if (m_transport)
+		m_transport->FlushAll();
 }
 
 void	IPureServer::SendTo_Buf(ClientID id, void* data, u32 size, u32 dwFlags, u32 dwTimeout)
@@ -626,6 +739,14 @@ void	IPureServer::SendTo_LL(ClientID ID/*DPNID ID*/, void* data, u32 size, u32 d
 		stats.dwBytesSended += size;
 #endif
 
+	if (m_transport)
+	{
+		m_transport->Send	(ID.value(), data, size, !!(dwFlags & DPNSEND_GUARANTEED));
+		if (dwFlags & DPNSEND_IMMEDIATELLY)
+			m_transport->Flush	(ID.value());
+		return;
+	}
+
 	// verify
 	VERIFY		(desc.dwBufferSize);
 	VERIFY		(desc.pBufferData);
@@ -744,8 +865,13 @@ BOOL IPureServer::HasBandwidth			(IClient* C)
 	{
 		// check queue for "empty" state
 		DWORD				dwPending;
-		hr					= NET->GetSendQueueInfo(C->ID.value(),&dwPending,0,0);
-		if (FAILED(hr))		return FALSE;
+		if (m_transport)
+			dwPending		= m_transport->GetPending(C->ID.value());
+		else
+		{
+			hr				= NET->GetSendQueueInfo(C->ID.value(),&dwPending,0,0);
+			if (FAILED(hr))	return FALSE;
+		}
 
 		if (dwPending > u32(psNET_ServerPending))	
 		{
@@ -767,7 +893,14 @@ void	IPureServer::UpdateClientStatistic		(IClient* C)
 	DPN_CONNECTION_INFO			CI;
 	ZeroMemory					(&CI,sizeof(CI));
 	CI.dwSize					= sizeof(CI);
-	if(!psNET_direct_connect)
+	if (m_transport)
+	{
+		NET_TransportStats		S;
+		if (!m_transport->GetPeerStats(C->ID.value(), S))
+			return;
+		NET_TransportStatsToCI	(S, CI);
+	}
+	else if(!psNET_direct_connect)
 	{
 		HRESULT hr					= NET->GetConnectionInfo(C->ID.value(),&CI,0);
 		if (FAILED(hr))				return;
@@ -802,6 +935,12 @@ bool			IPureServer::DisconnectClient	(IClient* C, LPCSTR Reason)
 {
 	if (!C) return false;
 
+	if (m_transport)
+	{
+		m_transport->Disconnect(C->ID.value(), Reason);
+		return true;
+	}
+
 	HRESULT res = NET->DestroyClient(C->ID.value(), Reason, xr_strlen(Reason)+1, 0);
 	CHK_DX(res);
 	return true;
@@ -871,6 +1010,16 @@ bool IPureServer::GetClientAddress	(IDirectPlay8Address* pClientAddress, ip_addr
 
 bool IPureServer::GetClientAddress	(ClientID ID, ip_address& Address, DWORD* pPort)
 {
+	if (m_transport)
+	{
+		u16		port = 0;
+		if (!m_transport->GetPeerAddress(ID.value(), Address.m_data.data, port))
+			return false;
+		if (pPort != NULL)
+			*pPort	= port;
+		return	true;
+	}
+
 	IDirectPlay8Address* pClAddr	= NULL;
 	CHK_DX(NET->GetClientAddress	(ID.value(), &pClAddr, 0));
 
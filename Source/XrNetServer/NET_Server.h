@@ -4,6 +4,7 @@
 #include "ip_filter.h"
 #include "NET_Common.h"
 #include "NET_PlayersMonitor.h"
+#include "NET_Transport.h"
 
 struct SClientConnectData
 {
@@ -146,7 +147,8 @@ class CServerInfo;
 
 class XRNETSERVER_API 
 IPureServer
-  : private MultipacketReciever
+  : private MultipacketReciever,
+	private INetTransportHandler
 {
 public:
 	enum EConnect
@@ -159,6 +161,7 @@ protected:
 	shared_str				connect_options;
 	IDirectPlay8Server*		NET;
 	IDirectPlay8Address*	net_Address_device;
+	INetTransport*			m_transport;		// instead of DirectPlay, see NETFLAG_UDP_TRANSPORT
 	
 	NET_Compressor			net_Compressor;
 
@@ -291,5 +294,19 @@ private:
 #endif
 
     virtual void    _Recieve( const void* data, u32 data_size, u32 param );
+
+			EConnect		TransportHost		(GameDescriptionData & game_descr, u32 port, BOOL bPortWasSet);
+			LPCSTR			CheckConnectAddress	(const ip_address& Address);
+			void			ReceiveData			(ClientID sender, void* data, u32 size);
+
+	virtual bool			OnTransportConnect		(u32 address, u16 port, const void* data, u32 size, NET_Packet& reply);
+	virtual void			OnTransportConnected	(u32 peer, const void* data, u32 size);
+	virtual void			OnTransportDisconnected	(u32 peer, LPCSTR reason);
+	virtual void			OnTransportReceive		(u32 peer, void* data, u32 size);
+
+	GameDescriptionData		m_game_description;
+	shared_str				m_session_name;
+	shared_str				m_session_password;
+	u32						m_max_players;
 };
 
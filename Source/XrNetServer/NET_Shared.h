@@ -29,12 +29,14 @@ XRNETSERVER_API extern int		get_psNET_ServerUpdate();
 XRNETSERVER_API extern int		psNET_ServerPending;
 
 XRNETSERVER_API extern BOOL		psNET_direct_connect;
+XRNETSERVER_API extern BOOL		psNET_local_udp_host;
 
 enum	{
 	NETFLAG_MINIMIZEUPDATES		= (1<<0),
 	NETFLAG_DBG_DUMPSIZE		= (1<<1),
 	NETFLAG_LOG_SV_PACKETS		= (1<<2),
 	NETFLAG_LOG_CL_PACKETS		= (1<<3),
+	NETFLAG_UDP_TRANSPORT		= (1<<4),
 };
 
 IC u32 TimeGlobal	(CTimer* timer)	{ return timer->GetElapsed_ms();	}
@@ -0,0 +1,95 @@
+#pragma once
+
+//==============================================================================
+// Transport used by IPureServer/IPureClient instead of DirectPlay.
+// Peers are identified by the ids the transport assigns, the server uses them
+// as ClientID values. Handler callbacks come from the transport I/O thread, the
+// same way DirectPlay calls net_Handler from its own threads.
+//==============================================================================
+
+struct NET_TransportStats
+{
+	u32		rtt;					// ms, smoothed
+	u32		throughput;				// bytes sent during the last second
+	u32		peak_throughput;
+	u32		bytes_sent;
+	u32		bytes_received;
+	u32		datagrams_sent;
+	u32		datagrams_received;
+	u32		messages_sent;
+	u32		messages_received;
+	u32		reliable_sent;
+	u32		retransmits;
+	u32		dropped;				// incomplete unreliable messages
+};
+
+// first byte of the connect reply, the rest is up to the handler
+enum ENetConnectReply
+{
+	net_connect_accepted		= 0,
+	net_connect_refused,
+	net_connect_invalid_password,
+	net_connect_session_full,
+};
+
+class XRNETSERVER_API
+INetTransportHandler
+{
+public:
+	virtual			~INetTransportHandler	() {}
+
+	// server side: decide on a new peer, reply is sent back with accept or reject
+	virtual bool	OnTransportConnect		( u32 address, u16 port, const void* data, u32 size, NET_Packet& reply ) =0;
+	virtual void	OnTransportConnected	( u32 peer, const void* data, u32 size ) =0;
+	// reason is NULL for timeouts and local close
+	virtual void	OnTransportDisconnected	( u32 peer, LPCSTR reason ) =0;
+	virtual void	OnTransportReceive		( u32 peer, void* data, u32 size ) =0;
+};
+
+class XRNETSERVER_API
+INetTransport
+{
+public:
+	enum EConnect
+	{
+		ConnectAccepted,
+		ConnectRejected,
+		ConnectInvalidHost,
+		ConnectTimeout,
+	};
+
+	virtual			~INetTransport	() {}
+
+	virtual bool	Bind			( u16 port ) =0;			// 0 - any free port
+	virtual u16		GetPort			() =0;
+	virtual void	Listen			() =0;
+	virtual EConnect Connect		( LPCSTR host, u16 port, const void* data, u32 size, NET_Packet& reply, u32& peer, u32 timeout ) =0;
+	virtual void	Close			() =0;
+
+	// messages are queued per peer and leave as coalesced datagrams on Flush
+	virtual void	Send			( u32 peer, const void* data, u32 size, bool reliable ) =0;
+	virtual void	Flush			( u32 peer ) =0;
+	virtual void	FlushAll		() =0;
+	virtual void	Disconnect		( u32 peer, LPCSTR reason ) =0;
+
+	virtual u32		GetPending		( u32 peer ) =0;			// messages waiting for (re)transmission
+	virtual bool	GetPeerAddress	( u32 peer, u32& address, u16& port ) =0;
+	virtual bool	GetPeerStats	( u32 peer, NET_TransportStats& stats ) =0;
+};
+
+XRNETSERVER_API INetTransport*	NET_CreateUdpTransport		( INetTransportHandler* handler );
+// loopback server and headless clients, reports messages/sec, bytes per datagram and latency
+XRNETSERVER_API void			NET_UdpTransportBenchmark	( u32 clients, u32 seconds );
+
+IC void NET_TransportStatsToCI( const NET_TransportStats& S, DPN_CONNECTION_INFO& CI )
+{
+	CI.dwRoundTripLatencyMS					= S.rtt;
+	CI.dwThroughputBPS						= S.throughput;
+	CI.dwPeakThroughputBPS					= S.peak_throughput;
+	CI.dwPacketsSentGuaranteed				= S.reliable_sent;
+	CI.dwPacketsSentNonGuaranteed			= S.messages_sent - S.reliable_sent;
+	CI.dwPacketsRetried						= S.retransmits;
+	CI.dwPacketsDropped						= S.dropped;
+	CI.dwMessagesTransmittedNormalPriority	= S.messages_sent;
+	CI.dwMessagesReceived					= S.messages_received;
+}
@@ -0,0 +1,1364 @@
+#include "stdafx.h"
+#include "NET_Transport.h"
+
+#include <WINSOCK2.H>
+#include <Ws2tcpip.h>
+
+#ifndef SIO_UDP_CONNRESET
+#	define SIO_UDP_CONNRESET	_WSAIOW(IOC_VENDOR,12)
+#endif
+
+//==============================================================================
+// Every datagram starts with UdpHeader, DATA datagrams carry messages framed as
+// UdpMessage [u16 seq] [UdpFragment] payload. Reliable messages are delivered
+// in order and acked cumulatively plus a bitmask of the ones which came out of
+// order, unreliable ones are delivered as they come. Messages larger than a
+// datagram are split into fragments.
+//==============================================================================
+
+static const u16	UdpMagic			= 0x5258;
+static const u8		UdpVersion			= 1;
+static const u32	UdpDatagramSize		= 1200;		// fits ethernet MTU with room for tunnels
+static const u32	UdpFragmentSize		= 1152;
+static const u32	UdpMaxFragments		= 64;
+static const u32	UdpWindow			= 512;		// reliable messages in flight, divides 65536
+static const u32	UdpRecvBatch		= 64;		// datagrams drained per wakeup
+static const u32	UdpIoPeriod			= 5;		// ms, acks and retransmits
+static const u32	UdpFlushDelay		= 50;		// ms, messages nobody flushed leave after this
+static const u32	UdpConnectRetry		= 250;
+static const u32	UdpKeepAlive		= 1000;
+static const u32	UdpTimeout			= 15000;
+static const u32	UdpFirstPeer		= 0x100;
+static const u16	UdpNoEcho			= 0xffff;
+
+enum
+{
+	UdpConnect			= 1,
+	UdpAccept,
+	UdpReject,
+	UdpData,
+	UdpDisconnect,
+};
+
+enum
+{
+	UdpMsgReliable		= (1<<0),
+	UdpMsgFragment		= (1<<1),
+};
+
+#pragma pack(push,1)
+struct UdpHeader
+{
+	u16		magic;
+	u8		version;
+	u8		type;
+	u16		ack;			// last reliable sequence delivered in order
+	u32		ack_bits;		// bit i - sequence ack+2+i arrived out of order
+	u32		stamp;			// sender time, ms
+	u32		echo;			// last stamp seen from the other side
+	u16		echo_delay;		// ms it was held before being sent back, UdpNoEcho - nothing seen yet
+};
+
+struct UdpMessage
+{
+	u8		flags;
+	u16		size;
+};
+
+struct UdpFragment
+{
+	u16		id;				// unreliable messages only, reliable ones are ordered anyway
+	u8		index;
+	u8		count;
+};
+#pragma pack(pop)
+
+//==============================================================================
+
+class NET_UdpTransport : public INetTransport
+{
+	friend void				udp_io_thread		( void* );
+public:
+							NET_UdpTransport	( INetTransportHandler* handler );
+	virtual					~NET_UdpTransport	();
+
+	virtual bool			Bind				( u16 port );
+	virtual u16				GetPort				();
+	virtual void			Listen				();
+	virtual EConnect		Connect				( LPCSTR host, u16 port, const void* data, u32 size, NET_Packet& reply, u32& peer, u32 timeout );
+	virtual void			Close				();
+
+	virtual void			Send				( u32 peer, const void* data, u32 size, bool reliable );
+	virtual void			Flush				( u32 peer );
+	virtual void			FlushAll			();
+	virtual void			Disconnect			( u32 peer, LPCSTR reason );
+
+	virtual u32				GetPending			( u32 peer );
+	virtual bool			GetPeerAddress		( u32 peer, u32& address, u16& port );
+	virtual bool			GetPeerStats		( u32 peer, NET_TransportStats& stats );
+
+private:
+	struct OutMessage
+	{
+		u16					seq;
+		u8					index;
+		u8					count;
+		u32					sent_time;
+		u32					sends;
+		bool				acked;
+		xr_vector<u8>		data;
+	};
+
+	struct InMessage
+	{
+		bool				present;
+		u8					index;
+		u8					count;
+		xr_vector<u8>		data;
+
+							InMessage			() : present(false), index(0), count(0) {}
+	};
+
+	struct Peer
+	{
+		u32					id;
+		sockaddr_in			address;
+		u32					last_receive;
+		u32					last_send;
+		bool				closing;
+		shared_str			close_reason;
+
+		// outgoing
+		xr_deque<OutMessage>	reliable;			// by sequence, acked ones leave from the front
+		u16					next_seq;
+		xr_vector<u8>		unreliable;			// framed, waiting for the next flush
+		u16					next_fragment;
+		bool				has_new;
+		u32					new_since;
+		bool				need_ack;
+
+		// incoming
+		u16					expected_seq;
+		InMessage			window				[UdpWindow];
+		xr_vector<u8>		reliable_parts;
+		xr_vector<u8>		unreliable_parts;
+		u16					unreliable_id;
+		u8					unreliable_count;	// 0 - nothing is being assembled
+		u64					unreliable_mask;
+		u32					unreliable_size;
+
+		// round trip
+		u32					peer_stamp;
+		u32					peer_stamp_time;
+		bool				has_peer_stamp;
+		u32					srtt;
+		u32					rate_time;
+		u32					rate_base;
+
+		NET_TransportStats	stats;
+		xr_vector<u8>		accept;				// resent if the client repeats its request
+	};
+
+	struct Datagram
+	{
+		sockaddr_in			address;
+		u32					offset;
+		u32					size;
+	};
+
+	enum
+	{
+		EventConnect,
+		EventReceive,
+		EventDisconnect,
+	};
+
+	struct Event
+	{
+		u32					type;
+		u32					peer;
+		sockaddr_in			address;
+		u32					offset;
+		u32					size;
+	};
+
+	enum
+	{
+		ConnectIdle,
+		ConnectWaiting,
+		ConnectDone,
+		ConnectRefused,
+	};
+
+	typedef xr_map<u32, Peer*>	PeerMap;
+	typedef xr_map<u64, u32>	AddressMap;
+
+	INetTransportHandler*	m_handler;
+	SOCKET					m_socket;
+	CTimer					m_timer;
+	xrCriticalSection		m_lock;
+	volatile BOOL			m_stop;
+	HANDLE					m_io_done;
+	bool					m_listening;
+
+	PeerMap					m_peers;
+	AddressMap				m_addresses;
+	u32						m_next_id;
+	u32						m_last_service;
+
+	// client side connect, guarded by m_lock
+	sockaddr_in				m_server;
+	u32						m_connect_state;
+	u32						m_connect_peer;
+	xr_vector<u8>			m_connect_reply;
+
+	// datagrams built under m_lock
+	xr_vector<Datagram>		m_batch;
+	xr_vector<u8>			m_batch_data;
+	bool					m_open;				// the last datagram of the batch takes more messages
+
+	// I/O thread only
+	xr_vector<Event>		m_events;
+	xr_vector<u8>			m_event_data;
+	u8						m_recv_buffer		[2048];
+
+	IC u32					Time				()	{ return m_timer.GetElapsed_ms(); }
+	IC static u64			AddressKey			( const sockaddr_in& A ) { return (u64(A.sin_addr.s_addr) << 16) | A.sin_port; }
+
+	void					IoThread			();
+	void					ReceiveBatch		( u32 now );
+	void					Service				( u32 now );
+	void					DispatchEvents		();
+	void					AcceptPeer			( const sockaddr_in& address, void* data, u32 size );
+
+	Peer*					FindPeer			( u32 id );
+	Peer*					FindPeer			( const sockaddr_in& address );
+	Peer*					CreatePeer			( const sockaddr_in& address, u32 now );
+	void					DestroyPeer			( Peer* P );
+	u32						RetransmitTimeout	( const Peer& P ) const;
+
+	void					PushEvent			( u32 type, u32 peer, const sockaddr_in& address, const void* data, u32 size );
+	void					ProcessDatagram		( const sockaddr_in& from, const u8* data, u32 size, u32 now );
+	void					ProcessHeader		( Peer& P, const UdpHeader& H, u32 now );
+	void					ProcessMessages		( Peer& P, const u8* data, u32 size );
+	void					ReceiveReliable		( Peer& P, u16 seq, const UdpFragment& F, const u8* data, u32 size );
+	void					ReceiveUnreliable	( Peer& P, const UdpFragment& F, bool fragment, const u8* data, u32 size );
+	void					Deliver				( Peer& P, const void* data, u32 size );
+
+	void					BeginDatagram		( const sockaddr_in& address, Peer* P, u8 type, u32 now );
+	u8*						Reserve				( Peer& P, u32 size, u32 now );
+	void					SendControl			( const sockaddr_in& address, Peer* P, u8 type, const void* data, u32 size, u32 now );
+	void					FlushPeer			( Peer& P, u32 now, bool send_new );
+	void					SendBatch			();
+};
+
+void udp_io_thread( void* P )
+{
+	((NET_UdpTransport*)P)->IoThread();
+}
+
+//------------------------------------------------------------------------------
+
+NET_UdpTransport::NET_UdpTransport( INetTransportHandler* handler )
+#ifdef PROFILE_CRITICAL_SECTIONS
+	: m_lock(MUTEX_PROFILE_ID(NET_UdpTransport::m_lock))
+#endif // PROFILE_CRITICAL_SECTIONS
+{
+	STATIC_CHECK	( sizeof(UdpHeader) + sizeof(UdpMessage) + sizeof(u16) + sizeof(UdpFragment) + UdpFragmentSize <= UdpDatagramSize, Udp_fragment_does_not_fit_datagram );
+
+	WSADATA			wsa_data;
+	WSAStartup		( MAKEWORD(2,2), &wsa_data );
+
+	m_handler		= handler;
+	m_socket		= INVALID_SOCKET;
+	m_stop			= FALSE;
+	m_io_done		= NULL;
+	m_listening		= false;
+	m_next_id		= UdpFirstPeer;
+	m_last_service	= 0;
+	m_connect_state	= ConnectIdle;
+	m_connect_peer	= 0;
+	m_open			= false;
+	ZeroMemory		( &m_server, sizeof(m_server) );
+	m_timer.Start	();
+}
+
+NET_UdpTransport::~NET_UdpTransport()
+{
+	Close			();
+	WSACleanup		();
+}
+
+bool NET_UdpTransport::Bind( u16 port )
+{
+	VERIFY			( m_socket == INVALID_SOCKET );
+
+	SOCKET	S		= socket( AF_INET, SOCK_DGRAM, IPPROTO_UDP );
+	if( S == INVALID_SOCKET )
+		return		false;
+
+	sockaddr_in		address;
+	ZeroMemory		( &address, sizeof(address) );
+	address.sin_family		= AF_INET;
+	address.sin_addr.s_addr	= htonl( INADDR_ANY );
+	address.sin_port		= htons( port );
+	if( bind(S, (sockaddr*)&address, sizeof(address)) == SOCKET_ERROR )
+	{
+		closesocket	( S );
+		return		false;
+	}
+
+	u_long			non_blocking = 1;
+	ioctlsocket		( S, FIONBIO, &non_blocking );
+
+	int				buffer_size = 1 << 20;
+	setsockopt		( S, SOL_SOCKET, SO_RCVBUF, (const char*)&buffer_size, sizeof(buffer_size) );
+	setsockopt		( S, SOL_SOCKET, SO_SNDBUF, (const char*)&buffer_size, sizeof(buffer_size) );
+
+	// ICMP "port unreachable" from a gone peer must not fail the following recvfrom
+	BOOL			report_reset = FALSE;
+	DWORD			bytes = 0;
+	WSAIoctl		( S, SIO_UDP_CONNRESET, &report_reset, sizeof(report_reset), NULL, 0, &bytes, NULL, NULL );
+
+	m_socket		= S;
+	m_stop			= FALSE;
+	m_io_done		= CreateEvent( NULL, TRUE, FALSE, NULL );
+	thread_spawn	( udp_io_thread, "network-udp-io", 0, this );
+	return			true;
+}
+
+u16 NET_UdpTransport::GetPort()
+{
+	sockaddr_in		address;
+	int				address_size = sizeof(address);
+	if( (m_socket == INVALID_SOCKET) || (getsockname(m_socket, (sockaddr*)&address, &address_size) == SOCKET_ERROR) )
+		return		0;
+
+	return			ntohs( address.sin_port );
+}
+
+void NET_UdpTransport::Listen()
+{
+	xrCriticalSection::raii	guard( &m_lock );
+	m_listening		= true;
+}
+
+INetTransport::EConnect NET_UdpTransport::Connect( LPCSTR host, u16 port, const void* data, u32 size, NET_Packet& reply, u32& peer, u32 timeout )
+{
+	VERIFY			( m_socket != INVALID_SOCKET );
+	VERIFY			( sizeof(UdpHeader) + size <= UdpDatagramSize );
+
+	sockaddr_in		address;
+	ZeroMemory		( &address, sizeof(address) );
+	address.sin_family		= AF_INET;
+	address.sin_port		= htons( port );
+	address.sin_addr.s_addr	= inet_addr( host );
+	if( address.sin_addr.s_addr == INADDR_NONE )
+	{
+		hostent*	H = gethostbyname( host );
+		if( !H || !H->h_addr_list[0] )
+			return	ConnectInvalidHost;
+
+		address.sin_addr	= *(in_addr*)H->h_addr_list[0];
+	}
+
+	m_lock.Enter	();
+	m_server		= address;
+	m_connect_state	= ConnectWaiting;
+	m_connect_reply.clear();
+	m_lock.Leave	();
+
+	EConnect		result = ConnectTimeout;
+	u32 const		start = Time();
+	u32				last_request = start - UdpConnectRetry;
+	reply.B.count	= 0;
+	for( ;; )
+	{
+		u32 const	now = Time();
+		m_lock.Enter();
+		if( m_connect_state != ConnectWaiting )
+		{
+			result	= (m_connect_state == ConnectDone) ? ConnectAccepted : ConnectRejected;
+			peer	= m_connect_peer;
+			if( !m_connect_reply.empty() )
+				reply.w	( &m_connect_reply.front(), m_connect_reply.size() );
+			break;
+		}
+		if( now - start >= timeout )
+			break;
+
+		if( now - last_request >= UdpConnectRetry )
+		{
+			SendControl	( address, NULL, UdpConnect, data, size, now );
+			SendBatch	();
+			last_request= now;
+		}
+		m_lock.Leave();
+		Sleep		( 1 );
+	}
+	m_connect_state	= ConnectIdle;
+	m_lock.Leave	();
+
+	reply.r_pos		= 0;
+	return			result;
+}
+
+void NET_UdpTransport::Close()
+{
+	if( m_socket == INVALID_SOCKET )
+		return;
+
+	m_stop			= TRUE;
+	WaitForSingleObject( m_io_done, INFINITE );
+	CloseHandle		( m_io_done );
+	m_io_done		= NULL;
+
+	xr_vector<u32>	closed;
+	m_lock.Enter	();
+	u32 const		now = Time();
+	for( PeerMap::iterator it = m_peers.begin(); it != m_peers.end(); ++it )
+	{
+		SendControl	( it->second->address, it->second, UdpDisconnect, NULL, 0, now );
+		closed.push_back( it->first );
+		xr_delete	( it->second );
+	}
+	SendBatch		();
+	m_peers.clear	();
+	m_addresses.clear();
+	m_listening		= false;
+	m_lock.Leave	();
+
+	closesocket		( m_socket );
+	m_socket		= INVALID_SOCKET;
+
+	// the same as DirectPlay does on Close
+	for( u32 i = 0; i < closed.size(); ++i )
+		m_handler->OnTransportDisconnected( closed[i], NULL );
+}
+
+//------------------------------------------------------------------------------
+
+void NET_UdpTransport::Send( u32 peer, const void* data, u32 size, bool reliable )
+{
+	VERIFY			( size );
+	R_ASSERT2		( size <= UdpFragmentSize*UdpMaxFragments, "too large net message" );
+
+	xrCriticalSection::raii	guard( &m_lock );
+	Peer*			P = FindPeer( peer );
+	if( !P || P->closing )
+		return;
+
+	u32 const		count = (size + UdpFragmentSize - 1) / UdpFragmentSize;
+	u16 const		fragment_id = (count > 1 && !reliable) ? P->next_fragment++ : 0;
+	const u8*		src = (const u8*)data;
+	for( u32 i = 0; i < count; ++i )
+	{
+		u32 const	part = _min( UdpFragmentSize, size - i*UdpFragmentSize );
+		const u8*	part_data = src + i*UdpFragmentSize;
+		if( reliable )
+		{
+			P->reliable.push_back	( OutMessage() );
+			OutMessage&	M	= P->reliable.back();
+			M.seq			= P->next_seq++;
+			M.index			= u8(i);
+			M.count			= u8(count);
+			M.sent_time		= 0;
+			M.sends			= 0;
+			M.acked			= false;
+			M.data.assign	( part_data, part_data + part );
+			continue;
+		}
+
+		UdpMessage	M;
+		M.flags		= (count > 1) ? UdpMsgFragment : 0;
+		M.size		= u16(part);
+		P->unreliable.insert( P->unreliable.end(), (const u8*)&M, (const u8*)&M + sizeof(M) );
+		if( count > 1 )
+		{
+			UdpFragment	F;
+			F.id	= fragment_id;
+			F.index	= u8(i);
+			F.count	= u8(count);
+			P->unreliable.insert( P->unreliable.end(), (const u8*)&F, (const u8*)&F + sizeof(F) );
+		}
+		P->unreliable.insert( P->unreliable.end(), part_data, part_data + part );
+	}
+
+	++P->stats.messages_sent;
+	if( reliable )
+		++P->stats.reliable_sent;
+	if( !P->has_new )
+	{
+		P->has_new		= true;
+		P->new_since	= Time();
+	}
+}
+
+void NET_UdpTransport::Flush( u32 peer )
+{
+	xrCriticalSection::raii	guard( &m_lock );
+	Peer*			P = FindPeer( peer );
+	if( !P || P->closing )
+		return;
+
+	FlushPeer		( *P, Time(), true );
+	SendBatch		();
+}
+
+void NET_UdpTransport::FlushAll()
+{
+	xrCriticalSection::raii	guard( &m_lock );
+	u32 const		now = Time();
+	for( PeerMap::iterator it = m_peers.begin(); it != m_peers.end(); ++it )
+	{
+		if( !it->second->closing )
+			FlushPeer( *it->second, now, true );
+	}
+	SendBatch		();
+}
+
+void NET_UdpTransport::Disconnect( u32 peer, LPCSTR reason )
+{
+	// the peer is dropped and reported on the I/O thread, like DirectPlay DestroyClient
+	xrCriticalSection::raii	guard( &m_lock );
+	Peer*			P = FindPeer( peer );
+	if( !P || P->closing )
+		return;
+
+	P->closing		= true;
+	P->close_reason	= reason;
+}
+
+u32 NET_UdpTransport::GetPending( u32 peer )
+{
+	xrCriticalSection::raii	guard( &m_lock );
+	Peer*			P = FindPeer( peer );
+	if( !P )
+		return		0;
+
+	u32 const		now = Time();
+	u32 const		rto = RetransmitTimeout( *P );
+	u32				pending = 0;
+	for( xr_deque<OutMessage>::const_iterator it = P->reliable.begin(); it != P->reliable.end(); ++it )
+	{
+		if( !it->acked && (!it->sends || (now - it->sent_time >= rto)) )
+			++pending;
+	}
+	return			pending;
+}
+
+bool NET_UdpTransport::GetPeerAddress( u32 peer, u32& address, u16& port )
+{
+	xrCriticalSection::raii	guard( &m_lock );
+	Peer*			P = FindPeer( peer );
+	if( !P )
+		return		false;
+
+	address			= P->address.sin_addr.s_addr;
+	port			= ntohs( P->address.sin_port );
+	return			true;
+}
+
+bool NET_UdpTransport::GetPeerStats( u32 peer, NET_TransportStats& stats )
+{
+	xrCriticalSection::raii	guard( &m_lock );
+	Peer*			P = FindPeer( peer );
+	if( !P )
+		return		false;
+
+	stats			= P->stats;
+	stats.rtt		= P->srtt;
+	return			true;
+}
+
+//------------------------------------------------------------------------------
+
+void NET_UdpTransport::IoThread()
+{
+	while( !m_stop )
+	{
+		fd_set			read_set;
+		FD_ZERO			( &read_set );
+		FD_SET			( m_socket, &read_set );
+		timeval			wait = { 0, UdpIoPeriod*1000 };
+		int const		ready = select( 0, &read_set, NULL, NULL, &wait );
+
+		m_lock.Enter	();
+		u32 const		now = Time();
+		if( ready > 0 )
+			ReceiveBatch( now );
+		if( now - m_last_service >= UdpIoPeriod )
+		{
+			Service		( now );
+			m_last_service	= now;
+		}
+		m_lock.Leave	();
+
+		// handlers are free to Send from here
+		DispatchEvents	();
+	}
+	SetEvent			( m_io_done );
+}
+
+void NET_UdpTransport::ReceiveBatch( u32 now )
+{
+	// Winsock has no recvmmsg, so drain what is queued in one wakeup and one lock instead
+	for( u32 i = 0; i < UdpRecvBatch; ++i )
+	{
+		sockaddr_in		from;
+		int				from_size = sizeof(from);
+		int const		size = recvfrom( m_socket, (char*)m_recv_buffer, sizeof(m_recv_buffer), 0, (sockaddr*)&from, &from_size );
+		if( size == SOCKET_ERROR )
+		{
+			if( WSAGetLastError() == WSAEWOULDBLOCK )
+				break;
+			continue;	// oversized or reset, the datagram is lost
+		}
+		ProcessDatagram	( from, m_recv_buffer, u32(size), now );
+	}
+}
+
+void NET_UdpTransport::Service( u32 now )
+{
+	xr_vector<Peer*>	dead;
+	for( PeerMap::iterator it = m_peers.begin(); it != m_peers.end(); ++it )
+	{
+		Peer&			P = *it->second;
+		if( P.closing )
+		{
+			// the reason is not retransmitted, a lost one ends in the client timeout
+			LPCSTR		reason = P.close_reason.size() ? P.close_reason.c_str() : "";
+			SendControl	( P.address, &P, UdpDisconnect, reason, xr_strlen(reason) + 1, now );
+			PushEvent	( EventDisconnect, P.id, P.address, reason, xr_strlen(reason) + 1 );
+			dead.push_back( &P );
+			continue;
+		}
+		if( now - P.last_receive > UdpTimeout )
+		{
+			PushEvent	( EventDisconnect, P.id, P.address, NULL, 0 );
+			dead.push_back( &P );
+			continue;
+		}
+
+		FlushPeer		( P, now, P.has_new && (now - P.new_since >= UdpFlushDelay) );
+
+		if( now - P.rate_time >= 1000 )
+		{
+			P.stats.throughput		= P.stats.bytes_sent - P.rate_base;
+			P.stats.peak_throughput	= _max( P.stats.peak_throughput, P.stats.throughput );
+			P.rate_base				= P.stats.bytes_sent;
+			P.rate_time				= now;
+		}
+	}
+	SendBatch			();
+
+	for( u32 i = 0; i < dead.size(); ++i )
+		DestroyPeer		( dead[i] );
+}
+
+void NET_UdpTransport::DispatchEvents()
+{
+	for( u32 i = 0; i < m_events.size(); ++i )
+	{
+		Event const&	E = m_events[i];
+		void*			data = E.size ? &m_event_data[E.offset] : NULL;
+		switch( E.type )
+		{
+		case EventConnect:
+			AcceptPeer	( E.address, data, E.size );
+			break;
+		case EventReceive:
+			m_handler->OnTransportReceive( E.peer, data, E.size );
+			break;
+		case EventDisconnect:
+			m_handler->OnTransportDisconnected( E.peer, (E.size > 1) ? (LPCSTR)data : NULL );
+			break;
+		}
+	}
+	m_events.clear		();
+	m_event_data.clear	();
+}
+
+void NET_UdpTransport::AcceptPeer( const sockaddr_in& address, void* data, u32 size )
+{
+	NET_Packet			reply;
+	reply.B.count		= 0;
+	bool const			accept = m_handler->OnTransportConnect( address.sin_addr.s_addr, ntohs(address.sin_port), data, size, reply );
+	R_ASSERT			( sizeof(UdpHeader) + reply.B.count <= UdpDatagramSize );
+
+	u32					id = 0;
+	{
+		xrCriticalSection::raii	guard( &m_lock );
+		// an earlier copy of the request has been accepted already
+		if( FindPeer(address) )
+			return;
+
+		u32 const		now = Time();
+		Peer*			P = NULL;
+		if( accept )
+		{
+			P			= CreatePeer( address, now );
+			P->accept.assign( reply.B.data, reply.B.data + reply.B.count );
+			id			= P->id;
+		}
+		SendControl		( address, P, accept ? UdpAccept : UdpReject, reply.B.data, reply.B.count, now );
+		SendBatch		();
+	}
+
+	if( accept )
+		m_handler->OnTransportConnected( id, data, size );
+}
+
+//------------------------------------------------------------------------------
+
+NET_UdpTransport::Peer* NET_UdpTransport::FindPeer( u32 id )
+{
+	PeerMap::iterator	it = m_peers.find( id );
+	return				(it == m_peers.end()) ? NULL : it->second;
+}
+
+NET_UdpTransport::Peer* NET_UdpTransport::FindPeer( const sockaddr_in& address )
+{
+	AddressMap::iterator	it = m_addresses.find( AddressKey(address) );
+	return				(it == m_addresses.end()) ? NULL : FindPeer( it->second );
+}
+
+NET_UdpTransport::Peer* NET_UdpTransport::CreatePeer( const sockaddr_in& address, u32 now )
+{
+	Peer*				P = xr_new<Peer>();
+	do {
+		P->id			= m_next_id++;
+	} while( !P->id || (P->id == 0xffffffff) || FindPeer(P->id) );
+
+	P->address			= address;
+	P->last_receive		= now;
+	P->last_send		= now;
+	P->closing			= false;
+	P->next_seq			= 0;
+	P->next_fragment	= 0;
+	P->has_new			= false;
+	P->new_since		= now;
+	P->need_ack			= false;
+	P->expected_seq		= 0;
+	P->unreliable_id	= 0;
+	P->unreliable_count	= 0;
+	P->unreliable_mask	= 0;
+	P->unreliable_size	= 0;
+	P->peer_stamp		= 0;
+	P->peer_stamp_time	= now;
+	P->has_peer_stamp	= false;
+	P->srtt				= 0;
+	P->rate_time		= now;
+	P->rate_base		= 0;
+	ZeroMemory			( &P->stats, sizeof(P->stats) );
+
+	m_peers.insert		( mk_pair(P->id, P) );
+	m_addresses.insert	( mk_pair(AddressKey(address), P->id) );
+	return				P;
+}
+
+void NET_UdpTransport::DestroyPeer( Peer* P )
+{
+	m_addresses.erase	( AddressKey(P->address) );
+	m_peers.erase		( P->id );
+	xr_delete			( P );
+}
+
+u32 NET_UdpTransport::RetransmitTimeout( const Peer& P ) const
+{
+	if( !P.srtt )
+		return			200;
+
+	u32					rto = P.srtt*2 + UdpIoPeriod*2;
+	clamp				( rto, u32(50), u32(1000) );
+	return				rto;
+}
+
+//------------------------------------------------------------------------------
+
+void NET_UdpTransport::PushEvent( u32 type, u32 peer, const sockaddr_in& address, const void* data, u32 size )
+{
+	Event				E;
+	E.type				= type;
+	E.peer				= peer;
+	E.address			= address;
+	E.offset			= m_event_data.size();
+	E.size				= size;
+	m_events.push_back	( E );
+	if( size )
+		m_event_data.insert( m_event_data.end(), (const u8*)data, (const u8*)data + size );
+	// reasons and connect data may come from anybody
+	if( type == EventDisconnect && size )
+		m_event_data.back()	= 0;
+}
+
+void NET_UdpTransport::ProcessDatagram( const sockaddr_in& from, const u8* data, u32 size, u32 now )
+{
+	if( size < sizeof(UdpHeader) )
+		return;
+
+	UdpHeader			H;
+	CopyMemory			( &H, data, sizeof(H) );
+	if( (H.magic != UdpMagic) || (H.version != UdpVersion) )
+		return;
+
+	const u8*			body = data + sizeof(H);
+	u32 const			body_size = size - sizeof(H);
+	Peer*				P = FindPeer( from );
+	switch( H.type )
+	{
+	case UdpConnect:
+		{
+			if( !m_listening )
+				return;
+			if( P )
+			{
+				// our accept is lost
+				if( !P->closing )
+					SendControl( from, P, UdpAccept, P->accept.empty() ? NULL : &P->accept.front(), P->accept.size(), now );
+				return;
+			}
+			PushEvent	( EventConnect, 0, from, body, body_size );
+		}break;
+	case UdpAccept:
+	case UdpReject:
+		{
+			if( (m_connect_state != ConnectWaiting) || (AddressKey(from) != AddressKey(m_server)) )
+				return;
+
+			m_connect_reply.assign( body, body + body_size );
+			if( H.type == UdpAccept )
+			{
+				P				= P ? P : CreatePeer( from, now );
+				m_connect_peer	= P->id;
+				m_connect_state	= ConnectDone;
+			}
+			else
+				m_connect_state	= ConnectRefused;
+		}break;
+	case UdpDisconnect:
+		{
+			if( !P )
+				return;
+			PushEvent	( EventDisconnect, P->id, from, body, body_size );
+			DestroyPeer	( P );
+		}break;
+	case UdpData:
+		{
+			if( !P || P->closing )
+				return;
+
+			P->last_receive	= now;
+			++P->stats.datagrams_received;
+			P->stats.bytes_received	+= size;
+			ProcessHeader	( *P, H, now );
+			ProcessMessages	( *P, body, body_size );
+		}break;
+	}
+}
+
+void NET_UdpTransport::ProcessHeader( Peer& P, const UdpHeader& H, u32 now )
+{
+	if( !P.has_peer_stamp || (s32(H.stamp - P.peer_stamp) > 0) )
+	{
+		P.peer_stamp		= H.stamp;
+		P.peer_stamp_time	= now;
+		P.has_peer_stamp	= true;
+	}
+
+	if( H.echo_delay != UdpNoEcho )
+	{
+		u32 const		sample = now - H.echo - H.echo_delay;
+		if( sample < UdpTimeout )
+			P.srtt		= P.srtt ? (P.srtt*7 + sample + 4)/8 : _max( sample, u32(1) );
+	}
+
+	// selective acks first, then everything in order up to H.ack
+	if( !P.reliable.empty() )
+	{
+		u16 const		base = P.reliable.front().seq;
+		for( u32 i = 0; i < 32; ++i )
+		{
+			if( !(H.ack_bits & (1<<i)) )
+				continue;
+			u16 const	offset = u16(H.ack + 2 + i - base);
+			if( (offset < P.reliable.size()) && P.reliable[offset].sends )
+				P.reliable[offset].acked	= true;
+		}
+	}
+	while( !P.reliable.empty() )
+	{
+		OutMessage const&	M = P.reliable.front();
+		if( !M.sends || (!M.acked && (s16(M.seq - H.ack) > 0)) )
+			break;
+		P.reliable.pop_front();
+	}
+}
+
+void NET_UdpTransport::ProcessMessages( Peer& P, const u8* data, u32 size )
+{
+	u32					pos = 0;
+	while( pos + sizeof(UdpMessage) <= size )
+	{
+		UdpMessage		M;
+		CopyMemory		( &M, data + pos, sizeof(M) );
+		pos				+= sizeof(M);
+
+		u16				seq = 0;
+		if( M.flags & UdpMsgReliable )
+		{
+			if( pos + sizeof(seq) > size )
+				return;
+			CopyMemory	( &seq, data + pos, sizeof(seq) );
+			pos			+= sizeof(seq);
+		}
+
+		UdpFragment		F;
+		F.id			= 0;
+		F.index			= 0;
+		F.count			= 1;
+		if( M.flags & UdpMsgFragment )
+		{
+			if( pos + sizeof(F) > size )
+				return;
+			CopyMemory	( &F, data + pos, sizeof(F) );
+			pos			+= sizeof(F);
+			if( !F.count || (F.index >= F.count) || (F.count > UdpMaxFragments) || (M.size > UdpFragmentSize) )
+				return;
+		}
+
+		if( !M.size || (pos + M.size > size) )
+			return;
+
+		if( M.flags & UdpMsgReliable )
+			ReceiveReliable		( P, seq, F, data + pos, M.size );
+		else
+			ReceiveUnreliable	( P, F, !!(M.flags & UdpMsgFragment), data + pos, M.size );
+		pos				+= M.size;
+	}
+}
+
+void NET_UdpTransport::ReceiveReliable( Peer& P, u16 seq, const UdpFragment& F, const u8* data, u32 size )
+{
+	// duplicates are acked again as well, the previous ack may be lost
+	P.need_ack			= true;
+
+	s16 const			distance = s16( seq - P.expected_seq );
+	if( (distance < 0) || (distance >= s16(UdpWindow)) )
+		return;
+
+	InMessage&			S = P.window[seq % UdpWindow];
+	if( !S.present )
+	{
+		S.present		= true;
+		S.index			= F.index;
+		S.count			= F.count;
+		S.data.assign	( data, data + size );
+	}
+
+	for( ;; )
+	{
+		InMessage&		N = P.window[P.expected_seq % UdpWindow];
+		if( !N.present )
+			break;
+
+		if( N.count == 1 )
+			Deliver		( P, &N.data.front(), N.data.size() );
+		else
+		{
+			if( !N.index )
+				P.reliable_parts.clear();
+			P.reliable_parts.insert( P.reliable_parts.end(), N.data.begin(), N.data.end() );
+			if( N.index + 1 == N.count )
+			{
+				Deliver	( P, &P.reliable_parts.front(), P.reliable_parts.size() );
+				P.reliable_parts.clear();
+			}
+		}
+		N.present		= false;
+		N.data.clear	();
+		++P.expected_seq;
+	}
+}
+
+void NET_UdpTransport::ReceiveUnreliable( Peer& P, const UdpFragment& F, bool fragment, const u8* data, u32 size )
+{
+	if( !fragment )
+	{
+		Deliver			( P, data, size );
+		return;
+	}
+
+	if( !P.unreliable_count || (F.id != P.unreliable_id) )
+	{
+		// a late part of a message which is dropped already
+		if( P.unreliable_count && (s16(F.id - P.unreliable_id) < 0) )
+			return;
+		if( P.unreliable_count )
+			++P.stats.dropped;
+
+		P.unreliable_id		= F.id;
+		P.unreliable_count	= F.count;
+		P.unreliable_mask	= 0;
+		P.unreliable_size	= 0;
+		P.unreliable_parts.resize( F.count*UdpFragmentSize );
+	}
+
+	u64 const			bit = u64(1) << F.index;
+	if( (F.count != P.unreliable_count) || (P.unreliable_mask & bit) )
+		return;
+	// every part but the last one is full
+	if( (F.index + 1 < F.count) && (size != UdpFragmentSize) )
+		return;
+
+	CopyMemory			( &P.unreliable_parts[F.index*UdpFragmentSize], data, size );
+	P.unreliable_mask	|= bit;
+	if( F.index + 1 == F.count )
+		P.unreliable_size	= F.index*UdpFragmentSize + size;
+
+	u64 const			full = (F.count == 64) ? u64(-1) : ((u64(1) << F.count) - 1);
+	if( P.unreliable_mask == full )
+	{
+		Deliver			( P, &P.unreliable_parts.front(), P.unreliable_size );
+		P.unreliable_count	= 0;
+	}
+}
+
+void NET_UdpTransport::Deliver( Peer& P, const void* data, u32 size )
+{
+	++P.stats.messages_received;
+	PushEvent			( EventReceive, P.id, P.address, data, size );
+}
+
+//------------------------------------------------------------------------------
+
+void NET_UdpTransport::BeginDatagram( const sockaddr_in& address, Peer* P, u8 type, u32 now )
+{
+	Datagram			D;
+	D.address			= address;
+	D.offset			= m_batch_data.size();
+	D.size				= sizeof(UdpHeader);
+	m_batch.push_back	( D );
+
+	UdpHeader			H;
+	H.magic				= UdpMagic;
+	H.version			= UdpVersion;
+	H.type				= type;
+	H.ack				= 0xffff;
+	H.ack_bits			= 0;
+	H.stamp				= now;
+	H.echo				= 0;
+	H.echo_delay		= UdpNoEcho;
+	if( P )
+	{
+		H.ack			= u16( P->expected_seq - 1 );
+		for( u32 i = 0; i < 32; ++i )
+		{
+			if( P->window[u16(P->expected_seq + 1 + i) % UdpWindow].present )
+				H.ack_bits	|= (1<<i);
+		}
+		if( P->has_peer_stamp )
+		{
+			H.echo		= P->peer_stamp;
+			H.echo_delay= u16( _min(now - P->peer_stamp_time, u32(UdpNoEcho - 1)) );
+		}
+		P->need_ack		= false;
+		P->last_send	= now;
+		++P->stats.datagrams_sent;
+		P->stats.bytes_sent	+= sizeof(H);
+	}
+	m_batch_data.insert	( m_batch_data.end(), (const u8*)&H, (const u8*)&H + sizeof(H) );
+}
+
+u8* NET_UdpTransport::Reserve( Peer& P, u32 size, u32 now )
+{
+	if( !m_open || (m_batch.back().size + size > UdpDatagramSize) )
+	{
+		BeginDatagram	( P.address, &P, UdpData, now );
+		m_open			= true;
+	}
+
+	Datagram&			D = m_batch.back();
+	m_batch_data.resize	( D.offset + D.size + size );
+	u8*					result = &m_batch_data[D.offset + D.size];
+	D.size				+= size;
+	P.stats.bytes_sent	+= size;
+	return				result;
+}
+
+void NET_UdpTransport::SendControl( const sockaddr_in& address, Peer* P, u8 type, const void* data, u32 size, u32 now )
+{
+	BeginDatagram		( address, P, type, now );
+	if( size )
+	{
+		m_batch_data.insert	( m_batch_data.end(), (const u8*)data, (const u8*)data + size );
+		m_batch.back().size	+= size;
+	}
+	m_open				= false;
+}
+
+void NET_UdpTransport::FlushPeer( Peer& P, u32 now, bool send_new )
+{
+	m_open				= false;
+
+	if( !P.reliable.empty() )
+	{
+		u16 const		base = P.reliable.front().seq;
+		u32 const		rto = RetransmitTimeout( P );
+		for( xr_deque<OutMessage>::iterator it = P.reliable.begin(); it != P.reliable.end(); ++it )
+		{
+			OutMessage&	M = *it;
+			if( u16(M.seq - base) >= UdpWindow )
+				break;
+			if( M.acked || (M.sends ? (now - M.sent_time < rto) : !send_new) )
+				continue;
+
+			if( M.sends )
+				++P.stats.retransmits;
+			++M.sends;
+			M.sent_time	= now;
+
+			bool const	fragment = (M.count > 1);
+			u32 const	frame = sizeof(UdpMessage) + sizeof(u16) + (fragment ? sizeof(UdpFragment) : 0) + M.data.size();
+			u8*			dest = Reserve( P, frame, now );
+
+			UdpMessage	H;
+			H.flags		= UdpMsgReliable | (fragment ? UdpMsgFragment : 0);
+			H.size		= u16(M.data.size());
+			CopyMemory	( dest, &H, sizeof(H) );				dest += sizeof(H);
+			CopyMemory	( dest, &M.seq, sizeof(M.seq) );		dest += sizeof(M.seq);
+			if( fragment )
+			{
+				UdpFragment	F;
+				F.id	= 0;
+				F.index	= M.index;
+				F.count	= M.count;
+				CopyMemory	( dest, &F, sizeof(F) );			dest += sizeof(F);
+			}
+			CopyMemory	( dest, &M.data.front(), M.data.size() );
+		}
+	}
+
+	if( send_new )
+	{
+		u32				pos = 0;
+		while( pos < P.unreliable.size() )
+		{
+			UdpMessage	H;
+			CopyMemory	( &H, &P.unreliable[pos], sizeof(H) );
+			u32 const	frame = sizeof(UdpMessage) + ((H.flags & UdpMsgFragment) ? sizeof(UdpFragment) : 0) + H.size;
+			CopyMemory	( Reserve(P, frame, now), &P.unreliable[pos], frame );
+			pos			+= frame;
+		}
+		P.unreliable.clear();
+
+		// the ones beyond the window go with the following flushes
+		P.has_new		= !P.reliable.empty() && !P.reliable.back().sends;
+		P.new_since		= now;
+	}
+
+	// nothing to say, but the acks and the keep alive
+	if( !m_open && (P.need_ack || (now - P.last_send >= UdpKeepAlive)) )
+		BeginDatagram	( P.address, &P, UdpData, now );
+	m_open				= false;
+}
+
+void NET_UdpTransport::SendBatch()
+{
+	// one sendto per datagram, Winsock has no sendmmsg; the batch is still built
+	// first, so a platform with batched sends can hand it over in one call
+	for( u32 i = 0; i < m_batch.size(); ++i )
+	{
+		Datagram const&	D = m_batch[i];
+		sendto			( m_socket, (const char*)&m_batch_data[D.offset], D.size, 0, (const sockaddr*)&D.address, sizeof(D.address) );
+	}
+	m_batch.clear		();
+	m_batch_data.clear	();
+	m_open				= false;
+}
+
+//==============================================================================
+
+INetTransport* NET_CreateUdpTransport( INetTransportHandler* handler )
+{
+	return xr_new<NET_UdpTransport>( handler );
+}
+
+//==============================================================================
+// Loopback benchmark: headless clients send update sized unreliable messages
+// and one reliable message every tick, the server echoes everything back and
+// flushes on its own tick, so the latency includes the server tick as in game.
+//==============================================================================
+
+#pragma pack(push,1)
+struct UdpBenchMessage
+{
+	u8		reliable;
+	u64		stamp;			// CPU::QPC of the client
+};
+#pragma pack(pop)
+
+static const u32	UdpBenchTickRate		= 60;
+static const u32	UdpBenchUnreliable		= 8;		// per client per tick
+static const u32	UdpBenchMessageSize		= 96;
+
+class UdpBenchServer : public INetTransportHandler
+{
+public:
+	INetTransport*	transport;
+	u32				received;
+
+					UdpBenchServer			() : transport(NULL), received(0) {}
+
+	virtual bool	OnTransportConnect		( u32, u16, const void*, u32, NET_Packet& reply )	{ reply.w_u8(net_connect_accepted); return true; }
+	virtual void	OnTransportConnected	( u32, const void*, u32 )	{}
+	virtual void	OnTransportDisconnected	( u32, LPCSTR )				{}
+	virtual void	OnTransportReceive		( u32 peer, void* data, u32 size )
+	{
+		++received;
+		transport->Send	( peer, data, size, ((UdpBenchMessage*)data)->reliable != 0 );
+	}
+};
+
+class UdpBenchClient : public INetTransportHandler
+{
+public:
+	INetTransport*	transport;
+	u32				peer;
+	u32				sent;
+	u32				reliable_sent;
+	u32				received;
+	u32				reliable_received;
+	u64				latency_sum;
+	u64				latency_max;
+
+					UdpBenchClient			() : transport(NULL), peer(0), sent(0), reliable_sent(0), received(0), reliable_received(0), latency_sum(0), latency_max(0) {}
+
+	virtual bool	OnTransportConnect		( u32, u16, const void*, u32, NET_Packet& )	{ return false; }
+	virtual void	OnTransportConnected	( u32, const void*, u32 )	{}
+	virtual void	OnTransportDisconnected	( u32, LPCSTR )				{}
+	virtual void	OnTransportReceive		( u32, void* data, u32 size )
+	{
+		UdpBenchMessage const*	M = (UdpBenchMessage const*)data;
+		u64 const	latency = CPU::QPC() - M->stamp;
+		++received;
+		if( M->reliable )
+			++reliable_received;
+		latency_sum	+= latency;
+		latency_max	= _max( latency_max, latency );
+	}
+};
+
+void NET_UdpTransportBenchmark( u32 clients, u32 seconds )
+{
+	clamp				( clients, u32(1), u32(256) );
+	clamp				( seconds, u32(1), u32(600) );
+
+	UdpBenchServer		server;
+	server.transport	= NET_CreateUdpTransport( &server );
+	if( !server.transport->Bind(0) )
+	{
+		Msg				( "! udp benchmark: can't bind the server socket" );
+		xr_delete		( server.transport );
+		return;
+	}
+	server.transport->Listen();
+	u16 const			port = server.transport->GetPort();
+
+	xr_vector<UdpBenchClient*>	bench;
+	for( u32 i = 0; i < clients; ++i )
+	{
+		UdpBenchClient*	C = xr_new<UdpBenchClient>();
+		C->transport	= NET_CreateUdpTransport( C );
+		NET_Packet		reply;
+		if( !C->transport->Bind(0) || (C->transport->Connect("127.0.0.1", port, "bench", 6, reply, C->peer, 5000) != INetTransport::ConnectAccepted) )
+		{
+			Msg			( "! udp benchmark: client %d failed to connect", i );
+			xr_delete	( C->transport );
+			xr_delete	( C );
+			break;
+		}
+		bench.push_back	( C );
+	}
+
+	u8					message[UdpBenchMessageSize];
+	ZeroMemory			( message, sizeof(message) );
+	UdpBenchMessage*	M = (UdpBenchMessage*)message;
+
+	CTimer				timer;
+	timer.Start			();
+	u32 const			tick = 1000 / UdpBenchTickRate;
+	u32					ticks = 0;
+	while( timer.GetElapsed_ms() < seconds*1000 )
+	{
+		for( u32 i = 0; i < bench.size(); ++i )
+		{
+			UdpBenchClient&	C = *bench[i];
+			for( u32 j = 0; j <= UdpBenchUnreliable; ++j )
+			{
+				M->reliable	= (j == UdpBenchUnreliable);
+				M->stamp	= CPU::QPC();
+				C.transport->Send( C.peer, message, sizeof(message), M->reliable != 0 );
+				++C.sent;
+				if( M->reliable )
+					++C.reliable_sent;
+			}
+			C.transport->FlushAll();
+		}
+		server.transport->FlushAll();
+
+		++ticks;
+		u32 const		elapsed = timer.GetElapsed_ms();
+		if( ticks*tick > elapsed )
+			Sleep		( ticks*tick - elapsed );
+	}
+	float const			time = timer.GetElapsed_sec();
+
+	// the last echoes and retransmits
+	for( u32 i = 0; i < 10; ++i )
+	{
+		server.transport->FlushAll();
+		Sleep			( 50 );
+	}
+
+	u32					sent = 0, reliable_sent = 0, received = 0, reliable_received = 0, retransmits = 0;
+	u64					latency_sum = 0, latency_max = 0;
+	u64					up_bytes = 0, up_datagrams = 0, down_bytes = 0, down_datagrams = 0;
+	for( u32 i = 0; i < bench.size(); ++i )
+	{
+		UdpBenchClient&	C = *bench[i];
+		NET_TransportStats	S;
+		if( C.transport->GetPeerStats(C.peer, S) )
+		{
+			up_bytes		+= S.bytes_sent;
+			up_datagrams	+= S.datagrams_sent;
+			down_bytes		+= S.bytes_received;
+			down_datagrams	+= S.datagrams_received;
+			retransmits		+= S.retransmits;
+		}
+		C.transport->Close();
+
+		sent				+= C.sent;
+		reliable_sent		+= C.reliable_sent;
+		received			+= C.received;
+		reliable_received	+= C.reliable_received;
+		latency_sum			+= C.latency_sum;
+		latency_max			= _max( latency_max, C.latency_max );
+		xr_delete			( C.transport );
+		xr_delete			( bench[i] );
+	}
+	server.transport->Close();
+	u32 const			server_received = server.received;
+	xr_delete			( server.transport );
+
+	double const		to_ms = 1000.0 / double(CPU::qpc_freq);
+	Msg					( "* udp benchmark: %d clients, %d ticks in %.2f s", bench.size(), ticks, time );
+	Msg					( "* messages: %d sent, %d received by the server (%.0f/s), %d echoed back (%.0f/s)",
+						  sent, server_received, float(server_received)/time, received, float(received)/time );
+	Msg					( "* reliable: %d sent, %d echoed back, %d retransmits", reliable_sent, reliable_received, retransmits );
+	Msg					( "* datagrams: up %.1f bytes avg (%d), down %.1f bytes avg (%d)",
+						  up_datagrams ? double(up_bytes)/double(up_datagrams) : 0.0, u32(up_datagrams),
+						  down_datagrams ? double(down_bytes)/double(down_datagrams) : 0.0, u32(down_datagrams) );
+	Msg					( "* round trip: avg %.3f ms, max %.3f ms",
+						  received ? double(latency_sum)*to_ms/double(received) : 0.0, double(latency_max)*to_ms );
+}
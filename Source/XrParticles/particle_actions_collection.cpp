@@ -1771,6 +1771,7 @@ void PATurbulence::Execute(ParticleEffect *effect, const float dt, float& tm_max
 
 	u32 nStep = ( ( p_cnt - nSlice ) / nWorkers );
 
+	ttapi_Lock();
 	for ( u32 i = 0 ; i < nWorkers ; ++i ) {
 		tesParams[i].p_from = i * nStep;
 		tesParams[i].p_to = ( i == ( nWorkers - 1 ) ) ? p_cnt : ( tesParams[i].p_from + nStep );
@@ -1787,6 +1788,7 @@ void PATurbulence::Execute(ParticleEffect *effect, const float dt, float& tm_max
 	}
 
 	ttapi_RunAllWorkers();
+	ttapi_Unlock();
 
 }
 
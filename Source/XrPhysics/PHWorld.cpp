@@ -498,6 +498,7 @@ u32 CPHWorld::CalcNumSteps (u32 dTime)
 void CPHWorld::FrameStep(dReal step)
 {
 	if(IsFreezed())		return;
+	TRACE_ZONE	("PHWorld::FrameStep");
 	
 	VERIFY		(_valid(step))	;
 	step	*=	phTimefactor	;
@@ -1,4 +1,48 @@
 #pragma once
+#include	<emmintrin.h>
+//------------------------------------------------------------------------------
+// SSE: a quaternion is a single register, a key is unpacked in one go
+//------------------------------------------------------------------------------
+ICF __m128 QR2Quat_SSE(const CKeyQR &K)
+{
+	__m128i	q	= _mm_loadl_epi64	((const __m128i*)&K);
+	q			= _mm_srai_epi32	(_mm_unpacklo_epi16(q,q),16);
+	return		_mm_mul_ps			(_mm_cvtepi32_ps(q),_mm_set1_ps(KEY_QuantI));
+}
+
+// the same factors as Fquaternion::slerp, acos approximation included
+IC void quat_slerp_factors(float cosom, float tm, float &scale0, float &scale1)
+{
+	float			sign	= 1.f;
+	if (cosom<0)	{
+		cosom		= -cosom;
+		sign		= -1.f;
+	}
+	if ( (1.0f - cosom) > EPS ) {
+		float	x2		= cosom*cosom;
+		float	omega	= PI_DIV_2 - cosom*(0.892399f + x2*(1.693204f + x2*(-3.853735f + x2*2.838933f)));
+		float	i_sinom	= 1.f / _sin( omega );
+		float	t_omega	= tm*omega;
+		scale0			= _sin( omega - t_omega ) * i_sinom;
+		scale1			= _sin( t_omega ) * i_sinom;
+	} else {
+		scale0			= 1.0f - tm;
+		scale1			= tm;
+	}
+	scale1			*= sign;
+}
+
+ICF __m128 quat_slerp_SSE(__m128 Q0, __m128 Q1, float tm)
+{
+	VERIFY			(tm>=0.f && tm<=1.f);
+	__m128	d		= _mm_mul_ps	(Q0,Q1);
+	d				= _mm_add_ps	(d,_mm_movehl_ps(d,d));
+	d				= _mm_add_ss	(d,_mm_shuffle_ps(d,d,_MM_SHUFFLE(1,1,1,1)));
+	float			scale0,scale1;
+	quat_slerp_factors(_mm_cvtss_f32(d),tm,scale0,scale1);
+	return			_mm_add_ps		(_mm_mul_ps(Q0,_mm_set1_ps(scale0)),_mm_mul_ps(Q1,_mm_set1_ps(scale1)));
+}
+
 //------------------------------------------------------------------------------
 // calculate
 //------------------------------------------------------------------------------
@@ -6,7 +50,7 @@ IC void	KEY_Interp	(CKey& D,const CKey& K1,const CKey& K2, float delta)
 {
 	VERIFY			(_valid(delta));
 	VERIFY			(delta>=0.f && delta<=1.f);
-	D.Q.slerp		(K1.Q,K2.Q,delta);
+	_mm_storeu_ps	(&D.Q.x,quat_slerp_SSE(_mm_loadu_ps(&K1.Q.x),_mm_loadu_ps(&K2.Q.x),delta));
 	D.T.lerp		(K1.T,K2.T,delta);
 }
 struct ConsistantKey
@@ -88,10 +132,7 @@ IC void Dequantize(CKey& K,const CBlend& BD,const CMotion& M)
 	}else{
 		const CKeyQR*		K1r		=	&M._keysR[(frame+0)%count];
 		const CKeyQR*		K2r		=	&M._keysR[(frame+1)%count];
-		Fquaternion	Q1,Q2;
-		QR2Quat(*K1r,Q1);
-		QR2Quat(*K2r,Q2);
-		D->Q.slerp	(Q1,Q2,clampr(delta,0.f,1.f));
+		_mm_storeu_ps	(&D->Q.x,quat_slerp_SSE(QR2Quat_SSE(*K1r),QR2Quat_SSE(*K2r),clampr(delta,0.f,1.f)));
 	}
 
 	// translate
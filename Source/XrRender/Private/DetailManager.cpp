@@ -87,6 +87,15 @@ CDetailManager::CDetailManager	()
 	m_time_rot_2 = 0;
 	m_time_pos	= 0;
 	m_global_time_old = 0;
+#ifndef REDITOR
+	stream_wakeup	= NULL;
+	stream_exited	= NULL;
+	stream_shutdown	= FALSE;
+	stream_running	= FALSE;
+	stream_eye.set		(0,0,0);
+	stream_ahead.set	(0,0,0);
+	stream_velocity.set	(0,0,0);
+#endif
 }
 
 CDetailManager::~CDetailManager	()
@@ -144,6 +153,9 @@ void CDetailManager::Load		()
 	// Initialize 'vis' and 'cache'
 	for (u32 i=0; i<3; ++i)	m_visibles[i].resize(objects.size());
 	cache_Initialize	();
+#ifndef REDITOR
+	stream_Start		();
+#endif
 
 	// Make dither matrix
 	bwdithermap		(2,dither);
@@ -169,6 +181,9 @@ void CDetailManager::Load		()
 #endif
 void CDetailManager::Unload		()
 {
+#ifndef REDITOR
+	stream_Stop		();
+#endif
 	if (UseVS())	hw_Unload	();
 	else			soft_Unload	();
 
@@ -356,6 +371,9 @@ void 	CDetailManager::MT_CALC		()
 			int s_z	= iFloor			(EYE.z/dm_slot_size+.5f);
 
 			Device->Statistic->RenderDUMP_DT_Cache.Begin	();
+#ifndef REDITOR
+			stream_Predict				(EYE,Device->fTimeDelta);
+#endif
 			cache_Update				(s_x,s_z,EYE,dm_max_decompress);
 			Device->Statistic->RenderDUMP_DT_Cache.End	();
 
@@ -33,6 +33,8 @@ const int		dm_cache_line		= dm_size+1+dm_size;
 const int		dm_cache_size		= dm_cache_line*dm_cache_line;
 const float		dm_fade				= float(2*dm_size)-.5f;
 const float		dm_slot_size		= DETAIL_SLOT_SIZE;
+const float		dm_stream_ahead		= 0.5f;								// seconds of the camera movement the streaming looks ahead
+const float		dm_stream_sync		= 4*dm_slot_size;					// nearer pending slots are decompressed right away
 
 class  CDetailManager
 {
@@ -67,11 +69,29 @@ public:
 			u32						frame	:30;
 		};
 		int							sx,sz;				// ���������� ����� X x Y
+		u32							ticket;				// changes every time the slot is given to other X x Y
+		u32							queued;				// ticket+1 of the stream job, 0 - none
 		vis_data					vis;				// 
 		SlotPart					G[dm_obj_in_slot];	// 
 
-									Slot()				{ frame=0;empty=1; type=stReady; sx=sz=0; vis.clear(); }
+									Slot()				{ frame=0;empty=1; type=stReady; sx=sz=0; ticket=0; queued=0; vis.clear(); }
 	};
+	struct	SlotStage	{								// decompressed item, it goes to the pool when the slot is published
+		SlotItem					item;
+		u32							part;
+	};
+	DEFINE_VECTOR(SlotStage,SlotStageVec,SlotStageIt);
+	struct	SlotJob		{								// everything the decompression reads and writes, so it may run off the slot
+		Slot*						slot;
+		u32							ticket;
+		int							sx,sz;
+		Fbox						box;
+		DetailSlot					DS;
+		BOOL						tris;				// FALSE - nothing to put the items on, the slot keeps its box
+		Fbox						bounds;
+		SlotStageVec				items;
+	};
+	DEFINE_VECTOR(SlotJob*,SlotJobVec,SlotJobIt);
     struct 	CacheSlot1	{
 		u32							empty;
     	vis_data 					vis;
@@ -170,6 +190,9 @@ public:
 	void							cache_Task		(int gx, int gz, Slot* D);
 	Slot*							cache_Query		(int sx, int sz);
 	void							cache_Decompress(Slot* D);
+	void							cache_Prepare	(SlotJob& J, Slot* D);
+	void							cache_Decompress(SlotJob& J, BOOL async);
+	void							cache_Publish	(SlotJob& J);
 	BOOL							cache_Validate	();
     // cache grid to world
 	int								cg2w_X			(int x)			{ return cache_cx-dm_size+x;					}
@@ -182,6 +205,33 @@ public:
 	void							Unload			();
 	void							Render			();
 
+#ifndef REDITOR
+	// Slot streaming: the pending slots nearest to the predicted camera path are decompressed
+	// by the stream thread, cache_Update publishes the finished jobs whole
+	xrXRC							stream_xrc;
+	xrCriticalSection				stream_lock;
+	SlotJobVec						stream_requests;							// the nearest one is the last
+	SlotJobVec						stream_done;
+	SlotJobVec						stream_free;
+	HANDLE							stream_wakeup;
+	HANDLE							stream_exited;
+	volatile BOOL					stream_shutdown;
+	BOOL							stream_running;
+	Fvector							stream_eye;
+	Fvector							stream_velocity;
+	Fvector							stream_ahead;								// predicted eye
+
+	void							stream_Start	();
+	void							stream_Stop		();
+	void							stream_Predict	(const Fvector& view, float dt);
+	BOOL							stream_Update	(Fvector& view, int limit);
+	void							stream_Reset	(Fvector& view);
+	static void						stream_Thread	(void* params);
+	void							stream_Process	();
+	SlotJob*						stream_Job		();
+	void							stream_Benchmark(u32 frames, float speed);
+#endif
+
 	/// MT stuff
 	xrCriticalSection				MT;
 	volatile u32					m_frame_calc;
@@ -49,6 +49,8 @@ void 	CDetailManager::cache_Task		(int gx, int gz, Slot* D)
 	D->type					= stPending;
 	D->sx					= sx;
 	D->sz					= sz;
+	D->ticket				++;				// a stream job of the old place is dropped
+	D->frame				= 0;
 
 	D->vis.box.min.set		(sx*dm_slot_size,				DS.r_ybase(),					sz*dm_slot_size);
 	D->vis.box.max.set		(D->vis.box.min.x+dm_slot_size,	DS.r_ybase()+DS.r_yheight(),	D->vis.box.min.z+dm_slot_size);
@@ -59,6 +61,9 @@ void 	CDetailManager::cache_Task		(int gx, int gz, Slot* D)
 		for (u32 clr=0; clr<D->G[i].items.size(); clr++)
 			poolSI.destroy(D->G[i].items[clr]);
 		D->G[i].items.clear	();
+		D->G[i].r_items[0].clear_not_free();
+		D->G[i].r_items[1].clear_not_free();
+		D->G[i].r_items[2].clear_not_free();
 	}
 
 	if (old_type != stPending)
@@ -144,38 +149,48 @@ void	CDetailManager::cache_Update	(int v_x, int v_z, Fvector& view, int limit)
 	}
 
 	// Task performer
-	BOOL	bFullUnpack		= FALSE;
-	if (cache_task.size() == dm_cache_size)	{ limit = dm_cache_size; bFullUnpack=TRUE; }
-
-	for (int iteration=0; cache_task.size() && (iteration<limit); iteration++){
-		u32		best_id		= 0;
-		float	best_dist	= flt_max;
-
-		if (bFullUnpack){
-			best_id			= cache_task.size()-1;
-		} else {
-			for (u32 entry=0; entry<cache_task.size(); entry++){
-				// Gain access to data
-				Slot*		S	= cache_task[entry];
-				VERIFY		(stPending == S->type);
-
-				// Estimate
-				Fvector		C;
-				S->vis.box.getcenter	(C);
-				float		D	= view.distance_to_sqr	(C);
-
-				// Select
-				if (D<best_dist)
-				{
-					best_dist	= D;
-					best_id		= entry;
+#ifndef REDITOR
+	if (stream_running && ps_r__detail_stream)
+	{
+		// the published slots got their real bounds
+		if (stream_Update(view,limit))	bNeedMegaUpdate	= true;
+	}
+	else
+#endif
+	{
+		BOOL	bFullUnpack		= FALSE;
+		if (cache_task.size() == dm_cache_size)	{ limit = dm_cache_size; bFullUnpack=TRUE; }
+
+		for (int iteration=0; cache_task.size() && (iteration<limit); iteration++){
+			u32		best_id		= 0;
+			float	best_dist	= flt_max;
+
+			if (bFullUnpack){
+				best_id			= cache_task.size()-1;
+			} else {
+				for (u32 entry=0; entry<cache_task.size(); entry++){
+					// Gain access to data
+					Slot*		S	= cache_task[entry];
+					VERIFY		(stPending == S->type);
+
+					// Estimate
+					Fvector		C;
+					S->vis.box.getcenter	(C);
+					float		D	= view.distance_to_sqr	(C);
+
+					// Select
+					if (D<best_dist)
+					{
+						best_dist	= D;
+						best_id		= entry;
+					}
 				}
 			}
-		}
 
-		// Decompress and remove task
-		cache_Decompress	(cache_task[best_id]);
-		cache_task.erase	(best_id);
+			// Decompress and remove task
+			cache_Decompress	(cache_task[best_id]);
+			cache_task.erase	(best_id);
+		}
 	}
 
     if (bNeedMegaUpdate){
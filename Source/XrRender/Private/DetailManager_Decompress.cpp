@@ -71,31 +71,79 @@ bool det_render_debug = false;
 void		CDetailManager::cache_Decompress(Slot* S)
 {
 	VERIFY				(S);
-	Slot&	D			= *S;
+	SlotJob				J;
+	cache_Prepare		(J,S);
+	cache_Decompress	(J,FALSE);
+	cache_Publish		(J);
+}
+
+void		CDetailManager::cache_Prepare	(SlotJob& J, Slot* S)
+{
+	J.slot				= S;
+	J.ticket			= S->ticket;
+	J.sx				= S->sx;
+	J.sz				= S->sz;
+	J.box				= S->vis.box;
+	J.DS				= QueryDB(S->sx,S->sz);
+	J.tris				= FALSE;
+	J.items.clear		();
+}
+
+void		CDetailManager::cache_Publish	(SlotJob& J)
+{
+	Slot&	D			= *J.slot;
 	D.type				= stReady;
-	if (D.empty)		return;
+	D.queued			= 0;
+	D.frame				= 0;			// the render lists are rebuilt at once
 
-	DetailSlot&	DS		= QueryDB(D.sx,D.sz);
+	for (SlotStageIt it=J.items.begin(); it!=J.items.end(); it++)
+	{
+		SlotItem*	ItemP	= poolSI.create();
+		*ItemP				= it->item;
+		if (ItemP->vis_ID)
+		{
+			if (::Random.randI(0,3)==0)	ItemP->vis_ID	= 2;	// Second wave
+			else						ItemP->vis_ID	= 1;	// First wave
+		}
+		D.G[it->part].items.push_back(ItemP);
+	}
+	if (!J.tris)		return;
+
+	// Update bounds to more tight and real ones
+	D.vis.clear			();
+	D.vis.box.set		(J.bounds);
+	D.vis.box.getsphere	(D.vis.sphere.P,D.vis.sphere.R);
+}
+
+// reads only the job, the objects and the static geometry: the stream thread runs it with its own collider
+void		CDetailManager::cache_Decompress(SlotJob& J, BOOL async)
+{
+	DetailSlot&	DS		= J.DS;
+	if ((DS.id0==DetailSlot::ID_Empty)&&(DS.id1==DetailSlot::ID_Empty)&&(DS.id2==DetailSlot::ID_Empty)&&(DS.id3==DetailSlot::ID_Empty))
+		return;
 
 	// Select polygons
 	Fvector		bC,bD;
-	D.vis.box.get_CD	(bC,bD);
+	J.box.get_CD		(bC,bD);
 
 #ifdef REDITOR
+	VERIFY				(!async);
 	ETOOLS::box_options	(CDB::OPT_FULL_TEST);
 	// Select polygons
 	SBoxPickInfoVec		pinf;
-    Scene->BoxPickObjects(D.vis.box,pinf,GetSnapList());
+    Scene->BoxPickObjects(J.box,pinf,GetSnapList());
 	u32	triCount		= pinf.size();
 #else
-	xrc.box_options		(CDB::OPT_FULL_TEST); 
-	xrc.box_query		(g_pGameLevel->ObjectSpace.GetStaticModel(),bC,bD);
-	u32	triCount		= xrc.r_count	();
+	xrXRC&		X		= async ? stream_xrc : xrc;
+	X.box_options		(CDB::OPT_FULL_TEST); 
+	X.box_query			(g_pGameLevel->ObjectSpace.GetStaticModel(),bC,bD);
+	u32	triCount		= X.r_count	();
 	CDB::TRI*	tris	= g_pGameLevel->ObjectSpace.GetStaticTris();
 	Fvector*	verts	= g_pGameLevel->ObjectSpace.GetStaticVerts();
 #endif
 
 	if (0==triCount)	return;
+	J.tris				= TRUE;
 
 	// Build shading table
 	float		alpha255	[dm_obj_in_slot][4];
@@ -113,7 +161,7 @@ void		CDetailManager::cache_Decompress(Slot* S)
 	u32			d_size		= iCeil	(dm_slot_size/density);
 	svector<int,dm_obj_in_slot>		selected;
 
-    u32 p_rnd	= D.sx*D.sz; //      ()
+    u32 p_rnd	= J.sx*J.sz; //      ()
 	CRandom				r_selection	(0x12071980^p_rnd);
 	CRandom				r_jitter	(0x12071980^p_rnd);
 	CRandom				r_yaw		(0x12071980^p_rnd);
@@ -162,22 +210,21 @@ void		CDetailManager::cache_Decompress(Slot* S)
 #endif
 
 			CDetail*	Dobj	= objects[DS.r_id(index)];
-			SlotItem*	ItemP	= poolSI.create();
-			SlotItem&	Item	= *ItemP;
+			SlotItem	Item;
 
 			// Position (XZ)
-			float		rx = (float(x)/float(d_size))*dm_slot_size + D.vis.box.min.x;
-			float		rz = (float(z)/float(d_size))*dm_slot_size + D.vis.box.min.z;
+			float		rx = (float(x)/float(d_size))*dm_slot_size + J.box.min.x;
+			float		rz = (float(z)/float(d_size))*dm_slot_size + J.box.min.z;
 			Fvector		Item_P;
 
 #ifndef		DBG_SWITCHOFF_RANDOMIZE
-			Item_P.set	(rx + r_jitter.randFs(jitter), D.vis.box.max.y, rz + r_jitter.randFs(jitter));
+			Item_P.set	(rx + r_jitter.randFs(jitter), J.box.max.y, rz + r_jitter.randFs(jitter));
 #else
-			Item_P.set	(rx , D.vis.box.max.y, rz );
+			Item_P.set	(rx , J.box.max.y, rz );
 #endif
 
 			// Position (Y)
-			float y		= D.vis.box.min.y-5;
+			float y		= J.box.min.y-5;
 			Fvector	dir; dir.set(0,-1,0);
 
 			float		r_u,r_v,r_range;
@@ -200,7 +247,7 @@ Device->Statistic->TEST0.End		();
 					}
 				}
 #else
-				CDB::TRI&	T		= tris[xrc.r_begin()[tid].id];
+				CDB::TRI&	T		= tris[X.r_begin()[tid].id];
 				SGameMtl* mtl		= GameMaterialLibrary->GetMaterialByIdx(T.material);
 				if(mtl->Flags.test(SGameMtl::flPassable))	
 					continue;
@@ -215,7 +262,7 @@ Device->Statistic->TEST0.End		();
 				}
 #endif
 			}
-			if (y<D.vis.box.min.y)			continue;
+			if (y<J.box.min.y)				continue;
 			Item_P.y	= y;
 
 			// Angles and scale
@@ -243,7 +290,7 @@ Device->Statistic->TEST0.End		();
 
 #ifndef REDITOR
 #ifdef		DEBUG
-			if(det_render_debug)
+			if(det_render_debug && !async)
 				draw_obb(  mXform, color_rgba		(255,0,0,255) );//Fmatrix().mul_43( mXform, Fmatrix().scale(5,5,5) )
 #endif
 #endif
@@ -272,7 +319,7 @@ Device->Statistic->TEST0.End		();
 			//? hack: RGB = hemi
 			//? Item.c_rgb.add					(ps_r__Detail_rainbow_hemi*Item.c_hemi);
 
-			// Vis-sorting
+			// Vis-sorting, the wave is chosen when the slot is published
 #ifndef		DBG_SWITCHOFF_RANDOMIZE
 			if (!UseVS())
 			{
@@ -280,22 +327,17 @@ Device->Statistic->TEST0.End		();
 				Item.vis_ID	= 0;
 			} else {
 				if (Dobj->m_Flags.is(DO_NO_WAVING))	Item.vis_ID	= 0;
-				else
-				{
-					if (::Random.randI(0,3)==0)	Item.vis_ID	= 2;	// Second wave
-					else						Item.vis_ID = 1;	// First wave
-				}
+				else								Item.vis_ID	= 1;
 			}
 #else
 			Item.vis_ID = 0;
 #endif
 			// Save it
-			D.G[index].items.push_back(ItemP);
+			SlotStage	stage;
+			stage.item	= Item;
+			stage.part	= index;
+			J.items.push_back	(stage);
 		}
 	}
-
-	// Update bounds to more tight and real ones
-	D.vis.clear			();
-	D.vis.box.set		(Bounds);
-	D.vis.box.getsphere	(D.vis.sphere.P,D.vis.sphere.R);
+	J.bounds			= Bounds;
 }
@@ -0,0 +1,277 @@
+#include "stdafx.h"
+#pragma hdrstop
+
+#include "DetailManager.h"
+
+#ifndef REDITOR
+
+//--------------------------------------------------- Slot streaming
+struct	stream_order
+{
+	CDetailManager::Slot*	slot;
+	float					eye;			// squared distance to the eye
+	float					path;			// squared distance to the predicted movement
+	bool	operator <		(const stream_order& O) const	{ return path<O.path; }
+};
+static xr_vector<stream_order>	stream_list;
+
+void	CDetailManager::stream_Start	()
+{
+	if (stream_running)	return;
+
+	stream_shutdown		= FALSE;
+	stream_wakeup		= CreateEvent	(NULL,FALSE,FALSE,NULL);
+	stream_exited		= CreateEvent	(NULL,TRUE,FALSE,NULL);
+	thread_spawn		(stream_Thread,"X-RAY Detail streaming",0,this);
+	stream_running		= TRUE;
+
+	stream_eye.set		(Device->vCameraPosition);
+	stream_ahead.set	(stream_eye);
+	stream_velocity.set	(0,0,0);
+}
+
+void	CDetailManager::stream_Stop		()
+{
+	if (!stream_running)	return;
+
+	stream_shutdown		= TRUE;
+	SetEvent			(stream_wakeup);
+	WaitForSingleObject	(stream_exited,INFINITE);
+	CloseHandle			(stream_wakeup);
+	CloseHandle			(stream_exited);
+	stream_wakeup		= NULL;
+	stream_exited		= NULL;
+	stream_running		= FALSE;
+
+	// nothing is in the thread now, the pending slots go back to cache_Update
+	for (SlotJobIt it=stream_requests.begin(); it!=stream_requests.end(); it++)	stream_free.push_back(*it);
+	for (SlotJobIt it=stream_done.begin(); it!=stream_done.end(); it++)			stream_free.push_back(*it);
+	stream_requests.clear	();
+	stream_done.clear		();
+	for (SlotJobIt it=stream_free.begin(); it!=stream_free.end(); it++)
+	{
+		Slot*	S		= (*it)->slot;
+		if (S && S->queued==(*it)->ticket+1)	S->queued	= 0;
+		xr_delete		(*it);
+	}
+	stream_free.clear	();
+}
+
+void	CDetailManager::stream_Thread	(void* params)
+{
+	((CDetailManager*)params)->stream_Process	();
+}
+
+void	CDetailManager::stream_Process	()
+{
+	while (!stream_shutdown)
+	{
+		WaitForSingleObject	(stream_wakeup,INFINITE);
+		for (;;)
+		{
+			stream_lock.Enter	();
+			if (stream_shutdown || stream_requests.empty())	{
+				stream_lock.Leave	();
+				break;
+			}
+			SlotJob*	J		= stream_requests.back();
+			stream_requests.pop_back	();
+			stream_lock.Leave	();
+
+			cache_Decompress	(*J,TRUE);
+
+			stream_lock.Enter	();
+			stream_done.push_back	(J);
+			stream_lock.Leave	();
+		}
+	}
+	SetEvent			(stream_exited);
+}
+
+CDetailManager::SlotJob*	CDetailManager::stream_Job	()
+{
+	if (stream_free.empty())	return xr_new<SlotJob>	();
+	SlotJob*	J		= stream_free.back();
+	stream_free.pop_back();
+	return		J;
+}
+
+void	CDetailManager::stream_Predict	(const Fvector& view, float dt)
+{
+	if (dt>EPS_S)
+	{
+		Fvector		v;
+		v.sub		(view,stream_eye).div(dt);
+		stream_velocity.lerp	(stream_velocity,v,.5f);
+	}
+	stream_eye.set	(view);
+
+	// never further than the cache reaches, a jump is not a movement to follow
+	Fvector		ahead;
+	ahead.mul		(stream_velocity,dm_stream_ahead);
+	float		range	= float(dm_size)*dm_slot_size;
+	float		len		= ahead.magnitude();
+	if (len>range)	ahead.mul	(range/len);
+	stream_ahead.add(view,ahead);
+}
+
+BOOL	CDetailManager::stream_Update	(Fvector& view, int limit)
+{
+	BOOL	published	= FALSE;
+
+	// publish the finished jobs and take back the ones not started yet, they are ordered again below
+	stream_lock.Enter		();
+	for (SlotJobIt it=stream_done.begin(); it!=stream_done.end(); it++)
+	{
+		SlotJob*	J	= *it;
+		Slot*		S	= J->slot;
+		if (S->ticket==J->ticket && stPending==S->type)
+		{
+			cache_Publish		(*J);
+			cache_task.erase	(std::find(cache_task.begin(),cache_task.end(),S));
+			published			= TRUE;
+		}
+		stream_free.push_back	(J);
+	}
+	stream_done.clear		();
+	for (SlotJobIt it=stream_requests.begin(); it!=stream_requests.end(); it++)
+	{
+		SlotJob*	J	= *it;
+		if (J->slot->queued==J->ticket+1)	J->slot->queued	= 0;
+		stream_free.push_back	(J);
+	}
+	stream_requests.clear	();
+	stream_lock.Leave		();
+
+	// the pending slots without a job, nearest to the predicted path first
+	BOOL	bFullUnpack	= (cache_task.size() == dm_cache_size);
+	Fvector	path;		path.sub	(stream_ahead,view);
+	float	path_sq		= path.square_magnitude();
+	stream_list.clear	();
+	for (u32 entry=0; entry<cache_task.size(); entry++)
+	{
+		Slot*		S	= cache_task[entry];
+		VERIFY			(stPending == S->type);
+		if (S->queued==S->ticket+1)	continue;		// the thread has it
+
+		Fvector		C,P;
+		S->vis.box.getcenter	(C);
+		float		t	= (path_sq>EPS_S) ? clampr(P.sub(C,view).dotproduct(path)/path_sq,0.f,1.f) : 0.f;
+		stream_order	O;
+		O.slot			= S;
+		O.eye			= view.distance_to_sqr	(C);
+		O.path			= P.mad(view,path,t).distance_to_sqr(C);
+		stream_list.push_back	(O);
+	}
+	std::sort			(stream_list.begin(),stream_list.end());
+
+	// the nearest ones can't wait: all of them after a jump, a few per frame when the thread lags behind
+	float	sync_sq		= dm_stream_sync*dm_stream_sync;
+	int		sync		= 0;
+	for (xr_vector<stream_order>::iterator it=stream_list.begin(); it!=stream_list.end(); it++)
+	{
+		if (it->eye>sync_sq)				continue;
+		if (!bFullUnpack && sync>=limit)	break;
+		cache_Decompress	(it->slot);
+		cache_task.erase	(std::find(cache_task.begin(),cache_task.end(),it->slot));
+		it->slot			= 0;
+		published			= TRUE;
+		sync				++;
+	}
+
+	// the rest goes to the thread, the nearest is the last
+	stream_lock.Enter		();
+	for (xr_vector<stream_order>::reverse_iterator it=stream_list.rbegin(); it!=stream_list.rend(); it++)
+	{
+		if (0==it->slot)	continue;
+		SlotJob*	J		= stream_Job();
+		cache_Prepare		(*J,it->slot);
+		it->slot->queued	= J->ticket+1;
+		stream_requests.push_back	(J);
+	}
+	BOOL	wakeup		= !stream_requests.empty();
+	stream_lock.Leave		();
+	if (wakeup)			SetEvent	(stream_wakeup);
+
+	return	published;
+}
+
+// cache around the eye fully unpacked, as after the level load
+void	CDetailManager::stream_Reset	(Fvector& view)
+{
+	int		stream		= ps_r__detail_stream;
+	ps_r__detail_stream	= 0;
+	cache_Initialize	();
+	cache_Update		(iFloor(view.x/dm_slot_size+.5f),iFloor(view.z/dm_slot_size+.5f),view,dm_max_decompress);
+	ps_r__detail_stream	= stream;
+
+	stream_eye.set		(view);
+	stream_ahead.set	(view);
+	stream_velocity.set	(0,0,0);
+}
+
+//--------------------------------------------------- Benchmark
+// Replays the camera going straight ahead with a jump sideways in the middle, the time spent in
+// cache_Update is what the render thread pays; 'holes' counts the pending slots inside the fade distance
+void	CDetailManager::stream_Benchmark	(u32 frames, float speed)
+{
+	if (0==dtFS)
+	{
+		Msg						("! detail stream bench: no details on the level");
+		return;
+	}
+
+	MT.Enter					();
+	Fvector		start			= Device->vCameraPosition;
+	Fvector		dir				= Device->vCameraDirection;
+	dir.y						= 0;
+	if (dir.square_magnitude()<EPS_S)	dir.set(0,0,1);
+	dir.normalize				();
+	Fvector		side;			side.set(dir.z,0,-dir.x);
+
+	float		dt				= 1.f/60.f;
+	float		fade_sq			= dm_fade*dm_fade;
+	int			stream			= ps_r__detail_stream;
+	for (u32 mode=0; mode<2; mode++)
+	{
+		if (mode && !stream_running)	break;
+		ps_r__detail_stream		= 0;
+		stream_Reset			(start);
+		ps_r__detail_stream		= mode;
+
+		float	total			= 0;
+		float	worst			= 0;
+		u32		holes			= 0;
+		CTimer	T;
+		for (u32 f=0; f<frames; f++)
+		{
+			Fvector	eye;		eye.mad(start,dir,speed*dt*float(f));
+			if (f>=frames/2)	eye.mad(side,float(2*dm_size)*dm_slot_size);
+
+			T.Start				();
+			if (mode)			stream_Predict	(eye,dt);
+			cache_Update		(iFloor(eye.x/dm_slot_size+.5f),iFloor(eye.z/dm_slot_size+.5f),eye,dm_max_decompress);
+			float	ms			= T.GetElapsed_sec()*1000.f;
+			total				+= ms;
+			worst				= _max(worst,ms);
+
+			for (u32 entry=0; entry<cache_task.size(); entry++)
+			{
+				Fvector	C;		cache_task[entry]->vis.box.getcenter(C);
+				if (eye.distance_to_sqr(C)<fade_sq)	holes	++;
+			}
+
+			// the thread gets the real frame time
+			Sleep				(iFloor(dt*1000.f));
+		}
+		Msg		("* detail stream bench: %s, %.3f ms per frame, %.3f ms max, %.1f holes per frame",
+			mode?"stream":"sync",total/float(frames),worst,float(holes)/float(frames));
+	}
+	ps_r__detail_stream			= stream;
+
+	Fvector		eye				= Device->vCameraPosition;
+	stream_Reset				(eye);
+	MT.Leave					();
+}
+
+#endif // REDITOR
@@ -5,7 +5,9 @@
 #include "stdafx.h"
 #include "HOM.h"
 #include "occRasterizer.h"
+#include "occRasterizer_tiled.h"
 #include "../../xrEngine/GameFont.h"
+#include "xrRender_console.h"
 
 #include "dxRenderDeviceRender.h"
  
@@ -34,6 +36,9 @@ CHOM::CHOM()
 	bEnabled		= FALSE;
 	m_pModel		= 0;
 	m_pTris			= 0;
+	m_tiled			= FALSE;
+	m_record_state	= record_none;
+	m_record_name[0]= 0;
 #ifdef DEBUG
 	Device->seqRender.Add(this,REG_PRIORITY_LOW-1000);
 #endif
@@ -217,6 +222,24 @@ void CHOM::Render_DB			(CFrustum& base)
 		u32		pixels			= 0;
 		int		limit			= int(P->size())-1;
 		for (int v=1; v<limit; v++)	{
+			if (m_tiled || m_record_state==record_frame)
+			{
+				Fvector			r0,r1,r2;
+				m_xform_01.transform(r0,(*P)[0]);
+				m_xform_01.transform(r1,(*P)[v+0]);
+				m_xform_01.transform(r2,(*P)[v+1]);
+				if (m_record_state==record_frame)
+				{
+					m_record_tris.push_back	(r0);
+					m_record_tris.push_back	(r1);
+					m_record_tris.push_back	(r2);
+				}
+				if (m_tiled)
+				{
+					pixels	+=			RasterTiled.rasterize(r0,r1,r2);
+					continue;
+				}
+			}
 			m_xform.transform	(T.raster[0],(*P)[0]);
 			m_xform.transform	(T.raster[1],(*P)[v+0]);
 			m_xform.transform	(T.raster[2],(*P)[v+1]);
@@ -231,9 +254,24 @@ void CHOM::Render		(CFrustum& base)
 	if (!bEnabled)		return;
 	
 	Device->Statistic->RenderCALC_HOM.Begin	();
-	Raster.clear		();
+	if (m_record_state==record_frame)	Record_Flush();
+	if (m_record_state==record_armed)
+	{
+		m_record_state		= record_frame;
+		m_record_tris.clear	();
+		m_record_tests.clear();
+	}
+
+	m_tiled				= ps_r__occ_tiled;
+	if (m_tiled)
+	{
+		RasterTiled.resize	(ps_r__occ_width,ps_r__occ_height);
+		RasterTiled.clear	();
+	}
+	else				Raster.clear		();
 	Render_DB			(base);
-	Raster.propagade	();
+	if (m_tiled)		RasterTiled.propagade	();
+	else				Raster.propagade		();
 	MT_frame_rendered	= Device->dwFrame;
 	Device->Statistic->RenderCALC_HOM.End	();
 }
@@ -257,7 +295,7 @@ ICF	BOOL	xform_b1	(Fvector2& min, Fvector2& max, float& minz, Fmatrix& X, float
 	t			= 0.f+z*iw;										if (t<minz)	 minz =t;
 	return FALSE;
 }
-IC	BOOL	_visible	(Fbox& B, Fmatrix& m_xform_01)
+IC	BOOL	_visible	(CHOM& H, Fbox& B, Fmatrix& m_xform_01)
 {
 	// Find min/max points of xformed-box
 	Fvector2	min,max;
@@ -270,20 +308,34 @@ IC	BOOL	_visible	(Fbox& B, Fmatrix& m_xform_01)
 	if (xform_b1(min,max,z,m_xform_01,B.min.x, B.max.y, B.max.z)) return TRUE;
 	if (xform_b1(min,max,z,m_xform_01,B.max.x, B.max.y, B.max.z)) return TRUE;
 	if (xform_b1(min,max,z,m_xform_01,B.max.x, B.max.y, B.min.z)) return TRUE;
-	return Raster.test	(min.x,min.y,max.x,max.y,z);
+	return H.test		(min.x,min.y,max.x,max.y,z);
+}
+
+BOOL CHOM::test			(float x0, float y0, float x1, float y1, float z)
+{
+	// MT-Sync (delayed as possible), it also decides which rasterizer is filled
+	MT_SYNC				();
+	if (m_record_state==record_frame)
+	{
+		m_record_tests.push_back(x0);	m_record_tests.push_back(y0);
+		m_record_tests.push_back(x1);	m_record_tests.push_back(y1);
+		m_record_tests.push_back(z);
+	}
+	if (m_tiled)		return RasterTiled.test	(x0,y0,x1,y1,z);
+	return				Raster.test				(x0,y0,x1,y1,z);
 }
 
 BOOL CHOM::visible		(Fbox3& B)
 {
 	if (!bEnabled)							return TRUE;
 	if (B.contains(Device->vCameraPosition))	return TRUE;
-	return _visible		(B,m_xform_01)		;
+	return _visible		(*this,B,m_xform_01)	;
 }
 
 BOOL CHOM::visible		(Fbox2& B, float depth)
 {
 	if (!bEnabled)		return TRUE;
-	return Raster.test	(B.min.x,B.min.y,B.max.x,B.max.y,depth);
+	return test			(B.min.x,B.min.y,B.max.x,B.max.y,depth);
 }
 
 BOOL CHOM::visible		(vis_data& vis)
@@ -301,7 +353,7 @@ BOOL CHOM::visible		(vis_data& vis)
 #ifdef DEBUG
 	Device->Statistic->RenderCALC_HOM.Begin	();
 #endif
-	BOOL result			= _visible			(vis.box,m_xform_01);
+	BOOL result			= _visible			(*this,vis.box,m_xform_01);
 	u32  delay			= 1;
 	if (result)
 	{
@@ -330,7 +382,7 @@ BOOL CHOM::visible		(sPoly& P)
 	if (xform_b0(min,max,z,m_xform_01,P.front().x,P.front().y,P.front().z)) return TRUE;
 	for (u32 it=1; it<P.size(); it++)
 		if (xform_b1(min,max,z,m_xform_01,P[it].x,P[it].y,P[it].z)) return TRUE;
-	return Raster.test	(min.x,min.y,max.x,max.y,z);
+	return test			(min.x,min.y,max.x,max.y,z);
 }
 
 void CHOM::Disable		()
@@ -343,6 +395,110 @@ void CHOM::Enable		()
 	bEnabled			= m_pModel?TRUE:FALSE;
 }
 
+void CHOM::Record		(LPCSTR name)
+{
+	MT.Enter			();
+	xr_strcpy			(m_record_name,name);
+	m_record_state		= record_armed;
+	MT.Leave			();
+}
+
+void CHOM::Record_Flush	()
+{
+	string_path			fn;
+	strconcat			(sizeof(fn),fn,m_record_name,".hom_rec");
+	IWriter*			W	= FS.w_open("$logs$",fn);
+	if (W)
+	{
+		W->w_u32		(m_record_tris.size()/3);
+		if (!m_record_tris.empty())		W->w	(&*m_record_tris.begin(),m_record_tris.size()*sizeof(Fvector));
+		W->w_u32		(m_record_tests.size()/5);
+		if (!m_record_tests.empty())	W->w	(&*m_record_tests.begin(),m_record_tests.size()*sizeof(float));
+		FS.w_close		(W);
+		Msg				("* HOM: recorded %d occluder triangles and %d tests to [%s]",m_record_tris.size()/3,m_record_tests.size()/5,fn);
+	}
+	m_record_state		= record_none;
+	m_record_tris.clear	();
+	m_record_tests.clear();
+}
+
+void CHOM::Benchmark	(LPCSTR name, u32 iterations)
+{
+	string_path			fn;
+	strconcat			(sizeof(fn),fn,name,".hom_rec");
+	IReader*			F	= FS.r_open("$logs$",fn);
+	if (!F)
+	{
+		Msg				("! HOM bench: can't open [%s], record it with r__occ_record first",fn);
+		return;
+	}
+	xr_vector<Fvector>	tris	(F->r_u32()*3);
+	if (!tris.empty())	F->r	(&*tris.begin(),tris.size()*sizeof(Fvector));
+	xr_vector<float>	tests	(F->r_u32()*5);
+	if (!tests.empty())	F->r	(&*tests.begin(),tests.size()*sizeof(float));
+	FS.r_close			(F);
+
+	u32					count	= tris.size()/3;
+	xr_vector<occTri>	occ		(count);
+	for (u32 it=0; it<count; it++)
+	{
+		occTri&			T	= occ[it];
+		T.adjacent[0]	= T.adjacent[1] = T.adjacent[2] = (occTri*)(-1);
+		for (u32 v=0; v<3; v++)
+			T.raster[v].set	(tris[it*3+v].x*occ_dim_0,tris[it*3+v].y*occ_dim_0,tris[it*3+v].z);
+	}
+
+	// the frame HOM is rebuilt on the next test
+	MT.Enter			();
+	MT_frame_rendered	= Device->dwFrame;
+	BOOL				tiled		= m_tiled;
+	CTimer				T;
+
+	m_tiled				= FALSE;
+	T.Start				();
+	for (u32 i=0; i<iterations; i++)
+	{
+		Raster.clear	();
+		for (u32 it=0; it<count; it++)	Raster.rasterize(&occ[it]);
+		Raster.propagade();
+	}
+	float				old_time	= T.GetElapsed_sec()*1000.f;
+	xr_vector<BOOL>		old_visible	(tests.size()/5);
+	for (u32 t=0; t<old_visible.size(); t++)
+		old_visible[t]	= Raster.test(tests[t*5+0],tests[t*5+1],tests[t*5+2],tests[t*5+3],tests[t*5+4]);
+
+	RasterTiled.resize	(ps_r__occ_width,ps_r__occ_height);
+	T.Start				();
+	for (u32 i=0; i<iterations; i++)
+	{
+		RasterTiled.clear	();
+		for (u32 it=0; it<count; it++)	RasterTiled.rasterize(tris[it*3+0],tris[it*3+1],tris[it*3+2]);
+		RasterTiled.propagade();
+	}
+	float				tiled_time	= T.GetElapsed_sec()*1000.f;
+
+	u32					old_culled	= 0, tiled_culled = 0, extra = 0, lost = 0;
+	T.Start				();
+	for (u32 t=0; t<old_visible.size(); t++)
+	{
+		BOOL	visible	= RasterTiled.test(tests[t*5+0],tests[t*5+1],tests[t*5+2],tests[t*5+3],tests[t*5+4]);
+		if (!old_visible[t])			old_culled	++;
+		if (!visible)					tiled_culled++;
+		if (!visible && old_visible[t])	extra		++;
+		if (visible && !old_visible[t])	lost		++;
+	}
+	float				test_time	= T.GetElapsed_sec()*1000.f;
+
+	m_tiled				= tiled;
+	MT_frame_rendered	= 0;
+	MT.Leave			();
+
+	Msg					("* HOM bench [%s]: %d triangles, %d tests, %d iterations",fn,count,old_visible.size(),iterations);
+	Msg					("* %dx%d scanline : %.1f tris/ms, %d culled",occ_dim_0,occ_dim_0,old_time>0.f ? float(count*iterations)/old_time : 0.f,old_culled);
+	Msg					("* %dx%d tiled    : %.1f tris/ms, %d culled, %d more, %d less, %.3f ms per test pass",RasterTiled.get_width(),RasterTiled.get_height(),
+						 tiled_time>0.f ? float(count*iterations)/tiled_time : 0.f,tiled_culled,extra,lost,test_time);
+}
+
 #ifdef DEBUG
 void CHOM::OnRender	()
 {
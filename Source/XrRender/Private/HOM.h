@@ -27,6 +27,16 @@ private:
 	xrCriticalSection		MT;
 	volatile u32			MT_frame_rendered;
 
+	BOOL					m_tiled;				// the frame went to RasterTiled
+
+	// one frame of occluders and box tests, for the benchmark
+	enum					{ record_none, record_armed, record_frame };
+	u32						m_record_state;
+	string_path				m_record_name;
+	xr_vector<Fvector>		m_record_tris;			// viewport space, 3 per triangle
+	xr_vector<float>		m_record_tests;			// x0,y0,x1,y1,z
+	void					Record_Flush();
+
 	void					Render_DB	(CFrustum&	base);
 public:
 	void					Load		();
@@ -51,6 +61,10 @@ public:
 	BOOL					visible		(Fbox3&		B);
 	BOOL					visible		(sPoly&		P);
 	BOOL					visible		(Fbox2&		B, float depth);	// viewport-space (0..1)
+	BOOL					test		(float x0, float y0, float x1, float y1, float z);
+
+	void					Record		(LPCSTR name);
+	void					Benchmark	(LPCSTR name, u32 iterations);	// old vs. tiled rasterizer on a recorded frame
 
 	CHOM	();
 	~CHOM	();
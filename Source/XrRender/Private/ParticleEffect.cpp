@@ -531,6 +531,7 @@ void CParticleEffect::Render(float )
 
 			u32 nStep = ( ( p_cnt - nSlice ) / nWorkers );
 
+			ttapi_Lock();
 			for ( u32 i = 0 ; i < nWorkers ; ++i ) {
 				prsParams[i].pv = pv + i*nStep*4;
 				prsParams[i].p_from = i * nStep;
@@ -541,6 +542,7 @@ void CParticleEffect::Render(float )
 			}
 
 			ttapi_RunAllWorkers();
+			ttapi_Unlock();
 
 			dwCount = p_cnt<<2;
 
@@ -10,8 +10,39 @@
 #ifdef DEBUG
 #include	"../../xrcore/dump_string.h"
 #endif
+#ifndef REDITOR
+#include	"../../xrCPU_Pipe/ttapi.h"
+#endif
 extern int	psSkeletonUpdate;
+int			psSkeletonBatch		= 1;
 using	namespace animation;
+
+// the bone locals are evaluated in parallel starting from this amount of bones
+static const u32							batch_min_parallel_bones	= 512;
+static xr_vector<CKinematicsAnimated*>		batch_current;		// calculated during batch_frame
+static xr_vector<CKinematicsAnimated*>		batch_previous;		// calculated during the frame before
+static xr_vector<CKinematicsAnimated*>		batch_models;
+static u32									batch_frame					= u32(-1);
+
+static void batch_rotate()
+{
+	if (batch_frame==Device->dwFrame)			return;
+	if (batch_frame+1==Device->dwFrame)			batch_previous.swap	(batch_current);
+	else										batch_previous.clear();
+	batch_current.clear	();
+	batch_frame			= Device->dwFrame;
+}
+
+static void batch_remove(xr_vector<CKinematicsAnimated*> &models, CKinematicsAnimated* K)
+{
+	models.erase		(std::remove(models.begin(),models.end(),K),models.end());
+}
+
+struct batch_range
+{
+	CKinematicsAnimated**	first;
+	CKinematicsAnimated**	last;
+};
 //////////////////////////////////////////////////////////////////////////
 // BoneInstance methods
 void		CBlendInstance::construct()
@@ -40,22 +71,26 @@ void		CBlendInstance::blend_remove	(CBlend* H)
 // Motion control
 void	CKinematicsAnimated::Bone_Motion_Start		(CBoneData* bd, CBlend* handle) 
 {
+	LL_BoneLocalsInvalidate	();
 	LL_GetBlendInstance	(bd->GetSelfID()).blend_add	(handle);
 	for (vecBonesIt I=bd->children.begin(); I!=bd->children.end(); I++)                        
 		Bone_Motion_Start	(*I,handle);
 }
 void	CKinematicsAnimated::Bone_Motion_Stop		(CBoneData* bd, CBlend* handle) 
 {
+	LL_BoneLocalsInvalidate	();
 	LL_GetBlendInstance	(bd->GetSelfID()).blend_remove	(handle);
 	for (vecBonesIt I=bd->children.begin(); I!=bd->children.end(); I++)
 		Bone_Motion_Stop	(*I,handle);
 }
 void	CKinematicsAnimated::Bone_Motion_Start_IM	(CBoneData* bd,  CBlend* handle) 
 {
+	LL_BoneLocalsInvalidate	();
 	LL_GetBlendInstance	(bd->GetSelfID()).blend_add		(handle);
 }
 void	CKinematicsAnimated::Bone_Motion_Stop_IM	(CBoneData* bd, CBlend* handle) 
 {
+	LL_BoneLocalsInvalidate	();
 	LL_GetBlendInstance	(bd->GetSelfID()).blend_remove	(handle);
 }
 
@@ -570,6 +605,12 @@ void CKinematicsAnimated::Release()
 
 CKinematicsAnimated::~CKinematicsAnimated	()
 {
+	{
+		UCalc_mtlock			lock;
+		batch_remove			(batch_current,this);
+		batch_remove			(batch_previous,this);
+		batch_remove			(batch_models,this);
+	}
 	IBoneInstances_Destroy	();
 }
 CKinematicsAnimated::CKinematicsAnimated(): 
@@ -579,7 +620,10 @@ CKinematicsAnimated::CKinematicsAnimated():
     m_Partition	( NULL ),
 	m_blend_destroy_callback( 0 ),
 	m_update_tracks_callback( 0 ),
-	Update_LastTime ( 0 )
+	Update_LastTime ( 0 ),
+	m_bone_locals_valid( FALSE ),
+	m_bone_locals_use( FALSE ),
+	m_batch_frame( u32(-1) )
 {
 	
 }
@@ -591,6 +635,7 @@ void	CKinematicsAnimated::IBoneInstances_Create()
 	blend_instances			= xr_alloc<CBlendInstance>(size);
 	for (u32 i=0; i<size; i++)
 		blend_instances[i].construct();
+	LL_BoneLocalsInvalidate	();
 }
 
 void	CKinematicsAnimated::IBoneInstances_Destroy()
@@ -600,6 +645,7 @@ void	CKinematicsAnimated::IBoneInstances_Destroy()
 		xr_free(blend_instances);
 		blend_instances = NULL;
 	}
+	LL_BoneLocalsInvalidate	();
 }
 
 #define PCOPY(a)	a = pFrom->a
@@ -659,6 +705,7 @@ void CKinematicsAnimated::IBlend_Startup	()
 		blend_cycles[i].clear();
 	blend_fx.clear		();
 	ChannelFactorsStartup();
+	LL_BoneLocalsInvalidate();
 }
 
 CBlend*	CKinematicsAnimated::IBlend_Create	()
@@ -830,26 +877,8 @@ const	CBlendInstance::BlendSVec	&Blend				= BLEND_INST.blend_vector();
 // calculate single bone with key blending 
 void	CKinematicsAnimated::LL_BoneMatrixBuild	( CBoneInstance &bi, const Fmatrix *parent, const SKeyTable	&keys )
 {
-	// Blend them together
-	CKey					channel_keys[MAX_CHANNELS];
-	animation::channel_def	BC			[MAX_CHANNELS];
-	u16						ch_count = 0;
-
-	for(u16 j= 0;MAX_CHANNELS>j;++j)
-	{
-		if(j!=0&&keys.chanel_blend_conts[j]==0)
-			continue;
-		//data for channel mix cycle based on ch_count
-		channels.get_def ( j, BC[ch_count]	);
-		process_single_channel( channel_keys[ch_count], BC[ch_count], keys.keys[j], keys.blends[j], keys.chanel_blend_conts[j] );
-		++ch_count;
-	}
-	CKey	Result;
-	//Mix channels
-	MixChannels( Result, channel_keys,  BC, ch_count );
-
 	Fmatrix					RES;
-	RES.mk_xform			(Result.Q,Result.T);
+	LL_BoneLocalBuild		(RES,keys);
 	bi.mTransform.mul_43	(*parent,RES);
 #ifdef DEBUG
 #ifndef REDITOR
@@ -873,8 +902,38 @@ void	CKinematicsAnimated::LL_BoneMatrixBuild	( CBoneInstance &bi, const Fmatrix
 #endif
 }
 
+// parent relative transform of a bone, touches nothing but the keys
+void	CKinematicsAnimated::LL_BoneLocalBuild	( Fmatrix &RES, const SKeyTable	&keys )
+{
+	// Blend them together
+	CKey					channel_keys[MAX_CHANNELS];
+	animation::channel_def	BC			[MAX_CHANNELS];
+	u16						ch_count = 0;
+
+	for(u16 j= 0;MAX_CHANNELS>j;++j)
+	{
+		if(j!=0&&keys.chanel_blend_conts[j]==0)
+			continue;
+		//data for channel mix cycle based on ch_count
+		channels.get_def ( j, BC[ch_count]	);
+		process_single_channel( channel_keys[ch_count], BC[ch_count], keys.keys[j], keys.blends[j], keys.chanel_blend_conts[j] );
+		++ch_count;
+	}
+	CKey	Result;
+	//Mix channels
+	MixChannels( Result, channel_keys,  BC, ch_count );
+
+	RES.mk_xform			(Result.Q,Result.T);
+}
+
 void	CKinematicsAnimated::BuildBoneMatrix			( const CBoneData* bd, CBoneInstance &bi, const Fmatrix *parent, u8 channel_mask /*= (1<<0)*/ )
 {
+			if ( m_bone_locals_use && channel_mask==u8(-1) )
+			{
+				bi.mTransform.mul_43	( *parent, m_bone_locals[bd->GetSelfID()] );
+				VERIFY					( _valid( bi.mTransform ) );
+				return;
+			}
 			
 			//CKey				R						[MAX_CHANNELS][MAX_BLENDED];	//all keys 
 			//float				BA						[MAX_CHANNELS][MAX_BLENDED];	//all factors
@@ -949,6 +1008,344 @@ void CKinematicsAnimated::OnCalculateBones		()
 {
 	UpdateTracks	()	;
 }
+
+void CKinematicsAnimated::Bones_Calculate		()
+{
+	m_bone_locals_use			= LL_BoneLocalsActual();
+	inherited::Bones_Calculate	();
+	m_bone_locals_use			= FALSE;
+	// the next frame's locals are only worth it at the full rate
+	if (!UCalc_Partial && !UCalc_LOD)
+		Batch_Enqueue			();
+}
+
+// remembers what the bone locals are going to be made of
+bool CKinematicsAnimated::LL_BoneLocalsStamp	()
+{
+	m_bone_locals_valid			= FALSE;
+	m_bone_locals_stamp.clear	();
+	for (u16 part=0; part<MAX_PARTS; part++)
+		for (BlendSVecCIt I=blend_cycles[part].begin(); I!=blend_cycles[part].end(); I++)
+		{
+			const CBlend& B		= **I;
+			SBlendStamp S		= { &B, B.motionID, B.timeCurrent, B.blendAmount, B.channel };
+			m_bone_locals_stamp.push_back(S);
+		}
+	for (BlendSVecCIt I=blend_fx.begin(); I!=blend_fx.end(); I++)
+	{
+		const CBlend& B			= **I;
+		SBlendStamp S			= { &B, B.motionID, B.timeCurrent, B.blendAmount, B.channel };
+		m_bone_locals_stamp.push_back(S);
+	}
+	for (u16 j=0; j<MAX_CHANNELS; j++)
+	{
+		channel_def				def;
+		channels.get_def		(j,def);
+		m_bone_locals_factors[j]= def.factor;
+	}
+	m_bone_locals.resize		(LL_BoneCount());
+	return						!m_bone_locals_stamp.empty();
+}
+
+bool CKinematicsAnimated::LL_BoneLocalsActual	()
+{
+	if (!m_bone_locals_valid)	return false;
+
+	xr_vector<SBlendStamp>::const_iterator S	= m_bone_locals_stamp.begin();
+	xr_vector<SBlendStamp>::const_iterator SE	= m_bone_locals_stamp.end();
+	for (u16 part=0; part<MAX_PARTS; part++)
+		for (BlendSVecCIt I=blend_cycles[part].begin(); I!=blend_cycles[part].end(); I++, S++)
+			if ((S==SE) || !S->equal(**I))	return false;
+	for (BlendSVecCIt I=blend_fx.begin(); I!=blend_fx.end(); I++, S++)
+		if ((S==SE) || !S->equal(**I))		return false;
+	if (S!=SE)					return false;
+
+	for (u16 j=0; j<MAX_CHANNELS; j++)
+	{
+		channel_def				def;
+		channels.get_def		(j,def);
+		if (def.factor!=m_bone_locals_factors[j])	return false;
+	}
+	return						true;
+}
+
+void CKinematicsAnimated::LL_BoneLocalsCalculate	()
+{
+	for (u16 i=0; i<LL_BoneCount(); i++)
+	{
+		SKeyTable				keys;
+		LL_BuldBoneMatrixDequatize	(&LL_GetData(i),u8(-1),keys);
+		LL_BoneLocalBuild		(m_bone_locals[i],keys);
+	}
+	m_bone_locals_valid			= TRUE;
+}
+
+void CKinematicsAnimated::Batch_Enqueue			()
+{
+	if (!psSkeletonBatch)		return;
+	batch_rotate				();
+	if (m_batch_frame==Device->dwFrame)	return;
+	m_batch_frame				= Device->dwFrame;
+	batch_current.push_back		(this);
+}
+
+void CKinematicsAnimated::Batch_Worker			(LPVOID params)
+{
+	batch_range const & range	= *static_cast<batch_range const*>(params);
+	for (CKinematicsAnimated** K=range.first; K!=range.last; K++)
+		(*K)->LL_BoneLocalsCalculate	();
+}
+
+void CKinematicsAnimated::Batch_Evaluate		(xr_vector<CKinematicsAnimated*> &models, bool parallel)
+{
+	u32 bones_count				= 0;
+	for (xr_vector<CKinematicsAnimated*>::const_iterator I=models.begin(); I!=models.end(); I++)
+		bones_count				+= (*I)->LL_BoneCount();
+
+#ifdef REDITOR
+	u32 const workers_count		= 1;
+	bool const serial			= true;
+#else
+	u32 const workers_count		= (parallel && (bones_count >= batch_min_parallel_bones)) ?
+		_max(u32(1), _min(bones_count / (batch_min_parallel_bones / 2), u32(ttapi_GetWorkersCount()))) : 1;
+	// the workers may be busy with the particles of the mt thread, the render thread doesn't wait for them
+	bool const serial			= (workers_count==1) || !ttapi_TryLock();
+#endif
+	if (serial)
+	{
+		for (xr_vector<CKinematicsAnimated*>::iterator I=models.begin(); I!=models.end(); I++)
+			(*I)->LL_BoneLocalsCalculate	();
+		return;
+	}
+
+#ifndef REDITOR
+	// ranges of about the same amount of bones
+	batch_range* ranges			= static_cast<batch_range*>(_alloca(workers_count * sizeof(batch_range)));
+	CKinematicsAnimated** I		= &*models.begin();
+	CKinematicsAnimated** E		= I + models.size();
+	u32 accumulated				= 0;
+	for (u32 i=0; i<workers_count; i++)
+	{
+		u32 const target		= (bones_count * (i + 1)) / workers_count;
+		ranges[i].first			= I;
+		while ((I!=E) && ((accumulated < target) || (i==workers_count-1)))
+		{
+			accumulated			+= (*I)->LL_BoneCount();
+			I++;
+		}
+		ranges[i].last			= I;
+		ttapi_AddWorker			(&Batch_Worker, &ranges[i]);
+	}
+	ttapi_RunAllWorkers			();
+	ttapi_Unlock				();
+#endif
+}
+
+void CKinematicsAnimated::BatchCalculate		()
+{
+	if (!psSkeletonBatch)		return;
+
+	UCalc_mtlock				lock;
+	batch_rotate				();
+	if (batch_previous.empty())	return;
+
+#ifdef DEBUG
+	Device->Statistic->Animation.Begin();
+#endif
+	batch_models.clear			();
+	for (u32 i=0; i<batch_previous.size(); i++)
+	{
+		CKinematicsAnimated* K	= batch_previous[i];
+		if (K->UCalc_Time==Device->dwTimeGlobal)	continue;	// already done this frame
+		K->UpdateTracks			();
+		if ((i>=batch_previous.size()) || (batch_previous[i]!=K))	continue;	// destroyed from a play callback
+		if (K->LL_BoneLocalsActual())				continue;	// nothing has moved since
+		if (!K->LL_BoneLocalsStamp())				continue;
+		batch_models.push_back	(K);
+	}
+	batch_previous.clear		();
+	Batch_Evaluate				(batch_models,true);
+#ifdef DEBUG
+	Device->Statistic->Animation.End	();
+#endif
+}
+
+void CKinematicsAnimated::Bench_Create			(LPCSTR model, u32 count, u32 blends, xr_vector<IRenderVisual*> &visuals, xr_vector<CKinematicsAnimated*> &models)
+{
+	blends						= _min(_max(blends,u32(1)),MAX_BLENDED);
+	for (u32 i=0; i<count; i++)
+	{
+		IRenderVisual* V		= ::Render->model_Create(model);
+		CKinematicsAnimated* K	= V ? PKinematicsAnimated(V) : 0;
+		if (!K)
+		{
+			Msg					("! skeleton bench: [%s] is not an animated model",model);
+			if (V)	::Render->model_Delete(V);
+			break;
+		}
+		visuals.push_back		(V);
+		models.push_back		(K);
+
+		// every bone gets the same amount of mixed cycles
+		accel_map* cycles		= K->m_Motions[0].motions.cycle();
+		accel_map::const_iterator C	= cycles->begin();
+		for (u32 j=0; (j<blends) && !cycles->empty(); j++, C++)
+		{
+			if (C==cycles->end())	C = cycles->begin();
+			K->LL_PlayCycle		(BI_NONE,MotionID(0,C->second),TRUE,1.f,0.1f,1.f,FALSE,0,0);
+		}
+	}
+}
+
+void CKinematicsAnimated::BatchBenchmark		(LPCSTR model, u32 count, u32 blends, u32 frames)
+{
+	xr_vector<IRenderVisual*>		visuals;
+	xr_vector<CKinematicsAnimated*>	models;
+	Bench_Create				(model,count,blends,visuals,models);
+	blends						= _min(_max(blends,u32(1)),MAX_BLENDED);
+
+	if (!models.empty())
+	{
+		UCalc_mtlock			lock;
+		u32 bones_count			= 0;
+		for (u32 i=0; i<models.size(); i++)
+			bones_count			+= models[i]->LL_BoneCount();
+
+		xr_vector<Fmatrix>		reference(models[0]->LL_BoneCount());
+		float					serial_time = 0.f, batch_time = 0.f, error = 0.f;
+		CTimer					T;
+		for (u32 frame=0; frame<frames; frame++)
+		{
+			for (u32 i=0; i<models.size(); i++)
+				models[i]->LL_UpdateTracks	(1.f/30.f,true,true);
+
+			T.Start				();
+			for (u32 i=0; i<models.size(); i++)
+			{
+				CKinematicsAnimated* K	= models[i];
+				K->Bone_Calculate		(K->bones->at(K->iRoot),&Fidentity);
+			}
+			serial_time			+= T.GetElapsed_sec();
+			for (u16 b=0; b<reference.size(); b++)
+				reference[b]	= models[0]->LL_GetTransform(b);
+
+			T.Start				();
+			batch_models.clear	();
+			for (u32 i=0; i<models.size(); i++)
+				if (models[i]->LL_BoneLocalsStamp())
+					batch_models.push_back	(models[i]);
+			Batch_Evaluate		(batch_models,true);
+			for (u32 i=0; i<models.size(); i++)
+			{
+				CKinematicsAnimated* K	= models[i];
+				K->m_bone_locals_use	= K->LL_BoneLocalsActual();
+				K->Bone_Calculate		(K->bones->at(K->iRoot),&Fidentity);
+				K->m_bone_locals_use	= FALSE;
+			}
+			batch_time			+= T.GetElapsed_sec();
+			for (u16 b=0; b<reference.size(); b++)
+				for (u32 e=0; e<16; e++)
+					error		= _max(error,_abs(reference[b].m[e/4][e%4] - models[0]->LL_GetTransform(b).m[e/4][e%4]));
+		}
+		batch_models.clear		();
+
+		float const total		= float(bones_count) * float(frames);
+		Msg						("* skeleton bench [%s]: %d models x %d blends, %d bones, %d frames",model,models.size(),blends,bones_count,frames);
+		Msg						("* serial  : %.1f ms, %.0f bones/sec",serial_time*1000.f,serial_time>0.f ? total/serial_time : 0.f);
+#ifdef REDITOR
+		Msg						("* batched : %.1f ms, %.0f bones/sec, max error %f",batch_time*1000.f,batch_time>0.f ? total/batch_time : 0.f,error);
+#else
+		Msg						("* batched : %.1f ms, %.0f bones/sec on %d workers, max error %f",batch_time*1000.f,batch_time>0.f ? total/batch_time : 0.f,ttapi_GetWorkersCount(),error);
+#endif
+	}
+
+	for (u32 i=0; i<visuals.size(); i++)
+		::Render->model_Delete	(visuals[i],TRUE);
+}
+
+void CKinematicsAnimated::LODBenchmark		(LPCSTR model, u32 count, u32 budget, u32 frames)
+{
+	xr_vector<IRenderVisual*>		visuals;
+	xr_vector<CKinematicsAnimated*>	models;
+	Bench_Create				(model,count,2,visuals,models);
+
+	if (!models.empty())
+	{
+		UCalc_mtlock			lock;
+		u32 const frame_time	= 33;
+		u32 bones_count			= 0;
+		for (u32 i=0; i<models.size(); i++)
+			bones_count			+= models[i]->LL_BoneCount();
+
+		// full rate: every model, every bone, every frame
+		CTimer					T;
+		float					full_time	= 0.f;
+		for (u32 frame=0; frame<frames; frame++)
+		{
+			for (u32 i=0; i<models.size(); i++)
+				models[i]->LL_UpdateTracks	(float(frame_time)/1000.f,true,true);
+			T.Start				();
+			for (u32 i=0; i<models.size(); i++)
+			{
+				CKinematicsAnimated* K	= models[i];
+				K->Bone_Calculate		(K->bones->at(K->iRoot),&Fidentity);
+			}
+			full_time			+= T.GetElapsed_sec();
+		}
+
+		// LOD: the models stand 2..150m away, a third of them is behind the camera
+		float					lod_time	= 0.f;
+		u32						evaluated	= 0, interpolated = 0;
+		xr_vector<u32>			last_calc	(models.size(),0);
+		for (u32 frame=0; frame<frames; frame++)
+		{
+			u32 const time		= (frame+1)*frame_time;
+			for (u32 i=0; i<models.size(); i++)
+				models[i]->LL_UpdateTracks	(float(frame_time)/1000.f,true,true);
+			T.Start				();
+			for (u32 i=0; i<models.size(); i++)
+			{
+				CKinematicsAnimated* K	= models[i];
+				CBoneData* root			= K->bones->at(K->iRoot);
+				if ((i%3)==0)
+				{
+					if (budget && (time<last_calc[i]+budget))	continue;
+					last_calc[i]		= time;
+					BonesVisible		required;
+					required.zero		();
+					K->Bone_Required	(root,required);
+					K->Bone_CalculateRequired	(root,&Fidentity,required);
+					for (u16 b=0; b<K->LL_BoneCount(); b++)
+						if (required.is(b))	evaluated++;
+					continue;
+				}
+				float distance			= 2.f + 148.f*float(i)/float(models.size());
+				float pixels			= 1080.f*K->vis.sphere.R/distance;
+				u32 interval			= K->LOD_Interval(pixels);
+				if (!interval || !K->UCalc_LOD_Samples || (time>=K->UCalc_LOD_Time[1]+interval))
+				{
+					K->Bone_Calculate	(root,&Fidentity);
+					evaluated			+= K->LL_BoneCount();
+					if (!interval)		continue;
+					K->LOD_Sample		(time);
+				}
+				if (K->UCalc_LOD_Samples<2)	continue;
+				K->LOD_Interpolate		(time);
+				interpolated			+= K->LL_BoneCount();
+			}
+			lod_time			+= T.GetElapsed_sec();
+		}
+
+		float const total		= float(bones_count) * float(frames);
+		Msg						("* skeleton LOD bench [%s]: %d models, %d bones, %d frames, budget %d ms",model,models.size(),bones_count,frames,budget);
+		Msg						("* full rate : %.1f ms, %.0f bones evaluated per frame",full_time*1000.f,total/float(frames));
+		Msg						("* LOD       : %.1f ms, %.0f bones evaluated and %.0f interpolated per frame",lod_time*1000.f,float(evaluated)/float(frames),float(interpolated)/float(frames));
+	}
+
+	for (u32 i=0; i<visuals.size(); i++)
+		::Render->model_Delete	(visuals[i],TRUE);
+}
+
 IBlendDestroyCallback* CKinematicsAnimated::GetBlendDestroyCallback	( )
 {
 	return m_blend_destroy_callback;
@@ -61,10 +61,30 @@ private:
 	
 	void						LL_BuldBoneMatrixDequatize	( const CBoneData* bd, u8 channel_mask,  SKeyTable& keys );
 	void						LL_BoneMatrixBuild			( CBoneInstance &bi, const Fmatrix *parent, const SKeyTable& keys );
+	void						LL_BoneLocalBuild			( Fmatrix &RES, const SKeyTable& keys );
 virtual	void					BuildBoneMatrix				( const CBoneData* bd, CBoneInstance &bi, const Fmatrix *parent, u8 mask_channel = (1<<0) );
+virtual	void					Bones_Calculate				();
+
+	// Bone locals evaluated ahead of the hierarchy walk, on the ttapi workers.
+	// They stay in use while the blends they were made of are left untouched.
+	bool						LL_BoneLocalsStamp			();
+	bool						LL_BoneLocalsActual			();
+	void						LL_BoneLocalsInvalidate		()	{ m_bone_locals_valid = FALSE; }
+	void						LL_BoneLocalsCalculate		();
+	void						Batch_Enqueue				();
+	static void					Batch_Worker				( LPVOID params );
+	static void					Batch_Evaluate				( xr_vector<CKinematicsAnimated*> &models, bool parallel );
+	static void					Bench_Create				( LPCSTR model, u32 count, u32 blends, xr_vector<IRenderVisual*> &visuals, xr_vector<CKinematicsAnimated*> &models );
 public:
 
 	virtual void				OnCalculateBones		();
+	// models calculated during the previous frame get their bone locals ahead, called before the render traversal
+	static void					BatchCalculate			();
+	// N copies of the model with M mixed cycles each, serial vs. batched bones/sec
+	static void					BatchBenchmark			( LPCSTR model, u32 count, u32 blends, u32 frames );
+	// N copies of the model spread in front of the camera, some of them unseen and budgeted,
+	// full rate vs. animation LOD bones evaluated per frame
+	static void					LODBenchmark			( LPCSTR model, u32 count, u32 budget, u32 frames );
 public: 
 #ifdef REDITOR
 public:
@@ -91,6 +111,22 @@ private:
 	BlendSVec									blend_cycles[MAX_PARTS];
 	BlendSVec									blend_fx;
 	animation::channels							channels;
+
+	struct SBlendStamp{
+		const CBlend*							blend;
+		MotionID								motionID;
+		float									timeCurrent;
+		float									blendAmount;
+		u8										channel;
+
+		IC bool				equal				(const CBlend& B) const	{ return blend==&B && motionID==B.motionID && timeCurrent==B.timeCurrent && blendAmount==B.blendAmount && channel==B.channel; }
+	};
+	xr_vector<Fmatrix>							m_bone_locals;
+	xr_vector<SBlendStamp>						m_bone_locals_stamp;
+	float										m_bone_locals_factors[MAX_CHANNELS];
+	BOOL										m_bone_locals_valid;
+	BOOL										m_bone_locals_use;
+	u32											m_batch_frame;
 protected:
 	// internal functions
 	virtual void				IBoneInstances_Create	();
@@ -96,6 +96,17 @@ CKinematics::CKinematics()
 #endif
 
 	m_is_original_lod = false;
+
+	UCalc_Time			= 0;
+	UCalc_Budget		= 0;
+	UCalc_Partial		= FALSE;
+	UCalc_RenderFrame	= 0;
+	UCalc_LOD			= 0;
+	UCalc_LOD_Frame		= 0;
+	UCalc_LOD_Posed		= FALSE;
+	UCalc_LOD_Samples	= 0;
+	UCalc_LOD_Time[0]	= UCalc_LOD_Time[1] = 0;
+	bonesrequired.zero	();
 }
 
 CKinematics::~CKinematics	()
@@ -386,6 +397,8 @@ void CKinematics::CalculateBones_Invalidate	()
 {	
 	UCalc_Time		= 0x0; 
 	UCalc_Visibox	= psSkeletonUpdate;		
+	UCalc_LOD_Samples	= 0;	// the pose may jump, don't interpolate across it
+	UCalc_LOD_Posed		= FALSE;
 }
 
 void CKinematics::Spawn			()
@@ -396,6 +409,9 @@ void CKinematics::Spawn			()
 		bone_instances[i].construct();
 	Update_Callback				= NULL;
 	CalculateBones_Invalidate	();
+	UCalc_Budget				= 0;
+	UCalc_Partial				= FALSE;
+	bonesrequired.zero			();
 	// wallmarks
 	ClearWallmarks				();
 	Visibility_Invalidate		();
@@ -94,6 +94,8 @@ public:
 	BOOL						dbg_single_use_marker;
 #endif
 			void				Bone_Calculate		(CBoneData* bd, Fmatrix* parent);
+			void				Bone_CalculateRequired	(CBoneData* bd, Fmatrix* parent, BonesVisible& required);
+			bool				Bone_Required		(CBoneData* bd, BonesVisible& required);
 			void				CLBone				(const CBoneData* bd, CBoneInstance &bi, const Fmatrix *parent, u8 mask_channel = (1<<0));
 
 			void				BoneChain_Calculate	(const CBoneData* bd, CBoneInstance &bi,u8 channel_mask, bool ignore_callbacks);
@@ -102,6 +104,7 @@ public:
 
 	virtual	void				BuildBoneMatrix		( const CBoneData* bd, CBoneInstance &bi, const Fmatrix *parent, u8 mask_channel = (1<<0) );
 	virtual void				OnCalculateBones	(){}
+	virtual void				Bones_Calculate		();
 	
 public:
 	dxRender_Visual*				m_lod;
@@ -125,6 +128,24 @@ protected:
 	u32							UCalc_Time				;
 	s32							UCalc_Visibox			;
 
+	// animation LOD
+	struct SPoseKey
+	{
+		Fquaternion				Q;
+		Fvector					T;
+	};
+	u32							UCalc_Budget			;	// ms, budget while nobody renders the model
+	BOOL						UCalc_Partial			;	// only the required bones are actual
+	u32							UCalc_RenderFrame		;
+	u32							UCalc_LOD				;	// ms between the pose samples, 0 - full rate
+	u32							UCalc_LOD_Frame			;
+	BOOL						UCalc_LOD_Posed			;	// the bones hold the interpolated pose, not the one of UCalc_Time
+	u32							UCalc_LOD_Samples		;
+	u32							UCalc_LOD_Time[2]		;	// previous and last sample
+	xr_vector<SPoseKey>			UCalc_LOD_Pose			;	// model space, previous and last sample
+
+	BonesVisible				bonesrequired;
+
 	BonesVisible					bonesvisible;
     
 	CSkeletonX*					LL_GetChild				(u32 idx);
@@ -135,6 +156,9 @@ protected:
 	virtual void				IBoneInstances_Destroy	();
 	void						Visibility_Invalidate	()	{ Update_Visibility=TRUE; };
 	void						Visibility_Update		()	;
+	u32							LOD_Interval			(float pixels);
+	void						LOD_Sample				(u32 time);
+	void						LOD_Interpolate			(u32 time);
 
     void						LL_Validate				();
 public:
@@ -225,6 +249,10 @@ public:
 	// Main functionality
 	virtual void					CalculateBones				(BOOL bForceExact	=	FALSE);		// Recalculate skeleton
 	void							CalculateBones_Invalidate	();
+	void							CalculateBones_Render		(float ssa);		// from the render, picks the animation LOD
+	void							LL_SetUpdateBudget			(u32 interval)		{	UCalc_Budget	= interval;	}
+	u32								LL_GetUpdateBudget			()					{	return UCalc_Budget;	}
+	void							LL_SetBoneRequired			(u16 bone_id, BOOL val)	{	VERIFY(bone_id<LL_BoneCount()); bonesrequired.set(bone_id,!!val);	}
 	void							Callback					(UpdateCallback C, void* Param)		{	Update_Callback	= C; Update_Callback_Param	= Param;	}
 
 	//	Callback: data manipulation
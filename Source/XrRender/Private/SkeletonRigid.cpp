@@ -5,6 +5,11 @@
 #include 	"SkeletonCustom.h"
 
 extern int	psSkeletonUpdate;
+int			psSkeletonLOD_Interval	= 100;		// ms between the pose samples of the smallest models, 0 - off
+float		psSkeletonLOD_Near		= 200.f;	// pixels, full rate from this size on
+float		psSkeletonLOD_Far		= 50.f;		// pixels, psSkeletonLOD_Interval from this size down
+
+extern float	g_fSCREEN;
 
 #ifdef DEBUG
 void check_kinematics(CKinematics* _k, LPCSTR s);
@@ -15,10 +20,17 @@ void CKinematics::CalculateBones			(BOOL bForceExact)
 	// early out.
 	// check if the info is still relevant
 	// skip all the computations - assume nothing changes in a small period of time :)
-	if		(Device->dwTimeGlobal == UCalc_Time)										return;	// early out for "fast" update
+	BOOL	rendered		= Device->dwFrame <= UCalc_RenderFrame+1;
+	BOOL	partial			= UCalc_Budget && !rendered && !bForceExact;
+	if		(!bForceExact && UCalc_LOD_Posed && (UCalc_LOD_Frame==Device->dwFrame))	return;	// the render has posed it for this frame
+	if		(Device->dwTimeGlobal == UCalc_Time && !UCalc_LOD_Posed && (partial || !UCalc_Partial))	return;	// early out for "fast" update
 	UCalc_mtlock	lock	;
 	OnCalculateBones		();
-	if		(!bForceExact && (Device->dwTimeGlobal < (UCalc_Time + UCalc_Interval)))	return;	// early out for "slow" update
+	if		(partial)
+	{
+		if	(Device->dwTimeGlobal < (UCalc_Time + UCalc_Budget))						return;	// early out for budgeted update
+	}
+	else if	(!bForceExact && !UCalc_Partial && (Device->dwTimeGlobal < (UCalc_Time + UCalc_Interval)))	return;	// early out for "slow" update
 	if		(Update_Visibility)									Visibility_Update	();
 
 	_DBG_SINGLE_USE_MARKER;
@@ -26,6 +38,9 @@ void CKinematics::CalculateBones			(BOOL bForceExact)
 	//	1:	timeout elapsed
 	//	2:	exact computation required
 	UCalc_Time			= Device->dwTimeGlobal;
+	UCalc_Partial		= partial;
+	UCalc_LOD_Posed		= FALSE;
+	if (!rendered)		UCalc_LOD	= 0;
 
 	// exact computation
 	// Calculate bones
@@ -33,11 +48,20 @@ void CKinematics::CalculateBones			(BOOL bForceExact)
 	Device->Statistic->Animation.Begin();
 #endif
 
-	Bone_Calculate					(bones->at(iRoot),&Fidentity);
+	Bones_Calculate					();
 #ifdef DEBUG
 	check_kinematics				(this, dbg_name.c_str() );
 	Device->Statistic->Animation.End	();
 #endif
+	if (partial)
+	{
+		// nobody looks at it, the box stays as it was
+		if (Update_Callback)	Update_Callback(this);
+		return;
+	}
+	if (UCalc_LOD && rendered)		LOD_Sample	(UCalc_Time);
+	else							UCalc_LOD_Samples	= 0;
+
 	//VERIFY( LL_GetBonesVisible()!=0 );
 	// Calculate BOXes/Spheres if needed
 	UCalc_Visibox++; 
@@ -159,6 +183,116 @@ void	CKinematics::Bone_GetAnimPos(Fmatrix& pos,u16 id,u8 mask_channel, bool igno
 	pos.set( bi.mTransform );
 }
 
+void CKinematics::Bones_Calculate()
+{
+	CBoneData*					root				= bones->at(iRoot);
+	if (!UCalc_Partial)
+	{
+		Bone_Calculate			(root,&Fidentity);
+		return;
+	}
+	BonesVisible				required;
+	required.zero				();
+	Bone_Required				(root,required);
+	Bone_CalculateRequired		(root,&Fidentity,required);
+}
+
+// marks the bones the collision, the bone callbacks or the owner need, together with their parents
+bool CKinematics::Bone_Required(CBoneData* bd, BonesVisible& required)
+{
+	u16							SelfID				= bd->GetSelfID();
+	bool						result				= (bd->shape.type!=SBoneShape::stNone) || bonesrequired.is(SelfID) || (LL_GetBoneInstance(SelfID).callback()!=0);
+	for (xr_vector<CBoneData*>::iterator C=bd->children.begin(); C!=bd->children.end(); C++)
+		if (Bone_Required(*C,required))		result	= true;
+	if (result)					required.set		(SelfID,true);
+	return						result;
+}
+
+void CKinematics::Bone_CalculateRequired(CBoneData* bd, Fmatrix* parent, BonesVisible& required)
+{
+	u16							SelfID				= bd->GetSelfID();
+	CBoneInstance				&BONE_INST			= LL_GetBoneInstance(SelfID);
+	CLBone( bd, BONE_INST, parent, u8(-1) );
+	for (xr_vector<CBoneData*>::iterator C=bd->children.begin(); C!=bd->children.end(); C++)
+		if (required.is((*C)->GetSelfID()))
+			Bone_CalculateRequired( *C, &BONE_INST.mTransform, required );
+}
+
+void CKinematics::CalculateBones_Render(float ssa)
+{
+	UCalc_RenderFrame			= Device->dwFrame;
+	UCalc_LOD					= LOD_Interval(3.f*_sqrt(ssa*g_fSCREEN));
+	if (!UCalc_LOD)
+	{
+		CalculateBones			(TRUE);
+		return;
+	}
+	if (UCalc_LOD_Frame==Device->dwFrame)		return;		// already posed for this frame
+	UCalc_mtlock				lock;
+	UCalc_LOD_Frame				= Device->dwFrame;
+
+	// the exact computation leaves the next sample
+	if (!UCalc_LOD_Samples || UCalc_Partial || (Device->dwTimeGlobal >= UCalc_LOD_Time[1]+UCalc_LOD))
+		CalculateBones			(TRUE);
+	if (UCalc_LOD_Samples<2)					return;		// nothing to interpolate from yet
+
+	// the model is shown one sample late, in between the samples; UCalc_Time stays the time of the exact pose
+	LOD_Interpolate				(Device->dwTimeGlobal);
+	UCalc_LOD_Posed				= TRUE;
+}
+
+u32 CKinematics::LOD_Interval(float pixels)
+{
+	if (!psSkeletonLOD_Interval || !dcast_PKinematicsAnimated())	return 0;	// rigid ones move with callbacks only
+	if (pixels>=psSkeletonLOD_Near)				return 0;
+	float	range				= _max(psSkeletonLOD_Near-psSkeletonLOD_Far,1.f);
+	float	factor				= _min((psSkeletonLOD_Near-pixels)/range,1.f);
+	u32		interval			= iFloor(factor*float(psSkeletonLOD_Interval));
+	return	(interval>Device->dwTimeDelta) ? interval : 0;
+}
+
+void CKinematics::LOD_Sample(u32 time)
+{
+	u32		count				= LL_BoneCount();
+	UCalc_LOD_Pose.resize		(2*count);
+	if (UCalc_LOD_Samples && (UCalc_LOD_Time[1]!=time))
+	{
+		std::copy				(UCalc_LOD_Pose.begin()+count,UCalc_LOD_Pose.end(),UCalc_LOD_Pose.begin());
+		UCalc_LOD_Time[0]		= UCalc_LOD_Time[1];
+		UCalc_LOD_Samples		= 2;
+	}
+	else if (!UCalc_LOD_Samples)
+		UCalc_LOD_Samples		= 1;
+	UCalc_LOD_Time[1]			= time;
+
+	for (u32 b=0; b<count; b++)
+	{
+		const Fmatrix&	M		= bone_instances[b].mTransform;
+		SPoseKey&		K		= UCalc_LOD_Pose[count+b];
+		K.Q.set					(M);
+		K.T.set					(M.c);
+	}
+}
+
+void CKinematics::LOD_Interpolate(u32 time)
+{
+	u32		count				= LL_BoneCount();
+	u32		period				= _max(UCalc_LOD_Time[1]-UCalc_LOD_Time[0],u32(1));
+	float	t					= _min(float(time-UCalc_LOD_Time[1])/float(period),1.f);
+
+	for (u16 b=0; b<count; b++)
+	{
+		if (!LL_GetBoneVisible(b))				continue;
+		const SPoseKey&	K0		= UCalc_LOD_Pose[b];
+		const SPoseKey&	K1		= UCalc_LOD_Pose[count+b];
+		Fquaternion		Q;		Q.slerp	(K0.Q,K1.Q,t);
+		Fvector			T;		T.lerp	(K0.T,K1.T,t);
+		CBoneInstance&	bi		= bone_instances[b];
+		bi.mTransform.mk_xform	(Q,T);
+		bi.mRenderTransform.mul_43	(bi.mTransform,(*bones)[b]->m2b_transform);
+	}
+}
+
 void CKinematics::Bone_Calculate(CBoneData* bd, Fmatrix *parent)
 {
 
@@ -0,0 +1,242 @@
+// occRasterizer_tiled.cpp: implementation of the occTiledRasterizer class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "occRasterizer_tiled.h"
+#include <emmintrin.h>
+
+occTiledRasterizer	RasterTiled;
+
+static const u32	bits_4	[16]	= { 0,1,1,2, 1,2,2,3, 1,2,2,3, 2,3,3,4 };
+
+// edge function E(x,y) = A*x + B*y + C, the inside is where it is not negative
+struct occ_edge
+{
+	float		A, B, C;
+
+	IC void		build		(const Fvector& a, const Fvector& b)
+	{
+		A		= a.y - b.y;
+		B		= b.x - a.x;
+		C		= -(A*a.x + B*a.y);
+	}
+	// min/max of the function over the rectangle of the pixel centers
+	IC float	lo			(float x0, float y0, float x1, float y1) const	{ return A*(A>=0?x0:x1) + B*(B>=0?y0:y1) + C; }
+	IC float	hi			(float x0, float y0, float x1, float y1) const	{ return A*(A>=0?x1:x0) + B*(B>=0?y1:y0) + C; }
+};
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+occTiledRasterizer::occTiledRasterizer	()
+{
+	width		= height	= 0;
+	tiles_x		= tiles_y	= 0;
+	blocks_x	= blocks_y	= 0;
+}
+
+occTiledRasterizer::~occTiledRasterizer	()
+{
+}
+
+void occTiledRasterizer::resize	(int w, int h)
+{
+	int	tx				= (_max(w,occ_tile) + occ_tile - 1)/occ_tile;
+	int	ty				= (_max(h,occ_tile) + occ_tile - 1)/occ_tile;
+	if (tx==tiles_x && ty==tiles_y)	return;
+
+	tiles_x				= tx;
+	tiles_y				= ty;
+	width				= tx*occ_tile;
+	height				= ty*occ_tile;
+	blocks_x			= (tx + occ_block - 1)/occ_block;
+	blocks_y			= (ty + occ_block - 1)/occ_block;
+	bufDepth.resize		(tx*ty*occ_tile_size);
+	bufTiles.resize		(tx*ty);
+	bufBlocks.resize	(blocks_x*blocks_y);
+	clear				();
+	propagade			();
+}
+
+void occTiledRasterizer::clear	()
+{
+	float f				= 1.f;
+	Memory.mem_fill32	(&*bufDepth.begin(),*LPDWORD(&f),bufDepth.size());
+}
+
+void occTiledRasterizer::propagade	()
+{
+	// tiles
+	for (int ty=0; ty<tiles_y; ty++)
+	{
+		for (int tx=0; tx<tiles_x; tx++)
+		{
+			float*	src		= tile_depth(tx,ty);
+			__m128	vmin	= _mm_loadu_ps(src);
+			__m128	vmax	= vmin;
+			for (int i=4; i<occ_tile_size; i+=4)
+			{
+				__m128 d	= _mm_loadu_ps(src+i);
+				vmin		= _mm_min_ps(vmin,d);
+				vmax		= _mm_max_ps(vmax,d);
+			}
+			vmin			= _mm_min_ps(vmin,_mm_shuffle_ps(vmin,vmin,_MM_SHUFFLE(1,0,3,2)));
+			vmin			= _mm_min_ps(vmin,_mm_shuffle_ps(vmin,vmin,_MM_SHUFFLE(2,3,0,1)));
+			vmax			= _mm_max_ps(vmax,_mm_shuffle_ps(vmax,vmax,_MM_SHUFFLE(1,0,3,2)));
+			vmax			= _mm_max_ps(vmax,_mm_shuffle_ps(vmax,vmax,_MM_SHUFFLE(2,3,0,1)));
+			depth_range& T	= tile(tx,ty);
+			_mm_store_ss	(&T.min,vmin);
+			_mm_store_ss	(&T.max,vmax);
+		}
+	}
+
+	// blocks
+	for (int by=0; by<blocks_y; by++)
+	{
+		for (int bx=0; bx<blocks_x; bx++)
+		{
+			depth_range& B	= block(bx,by);
+			B.min			= flt_max;
+			B.max			= -flt_max;
+			int	ty1			= _min((by+1)*occ_block,tiles_y);
+			int	tx1			= _min((bx+1)*occ_block,tiles_x);
+			for (int ty=by*occ_block; ty<ty1; ty++)
+			{
+				for (int tx=bx*occ_block; tx<tx1; tx++)
+				{
+					depth_range& T	= tile(tx,ty);
+					if (T.min<B.min)	B.min	= T.min;
+					if (T.max>B.max)	B.max	= T.max;
+				}
+			}
+		}
+	}
+}
+
+u32 occTiledRasterizer::rasterize	(const Fvector& _v0, const Fvector& _v1, const Fvector& _v2)
+{
+	// to pixels
+	Fvector		v0,v1,v2;
+	v0.set		(_v0.x*width,_v0.y*height,_v0.z);
+	v1.set		(_v1.x*width,_v1.y*height,_v1.z);
+	v2.set		(_v2.x*width,_v2.y*height,_v2.z);
+
+	// both windings are occluders, make the inside positive
+	float area	= (v1.x-v0.x)*(v2.y-v0.y) - (v1.y-v0.y)*(v2.x-v0.x);
+	if (_abs(area)<EPS_S)		return 0;
+	if (area<0)	{ std::swap(v1,v2); area = -area; }
+
+	// bounds, in pixels
+	int x0		= iFloor(_min(_min(v0.x,v1.x),v2.x));	x0 = _max(x0,0);
+	int y0		= iFloor(_min(_min(v0.y,v1.y),v2.y));	y0 = _max(y0,0);
+	int x1		= iCeil	(_max(_max(v0.x,v1.x),v2.x));	x1 = _min(x1,width);
+	int y1		= iCeil	(_max(_max(v0.y,v1.y),v2.y));	y1 = _min(y1,height);
+	if (x0>=x1 || y0>=y1)		return 0;
+
+	occ_edge	E0,E1,E2;
+	E0.build	(v1,v2);
+	E1.build	(v2,v0);
+	E2.build	(v0,v1);
+
+	// depth plane, shifted to the far corner of a pixel so the occluder never gets nearer than it is
+	float zA	= ((v1.z-v0.z)*(v2.y-v0.y) - (v2.z-v0.z)*(v1.y-v0.y))/area;
+	float zB	= ((v2.z-v0.z)*(v1.x-v0.x) - (v1.z-v0.z)*(v2.x-v0.x))/area;
+	float zC	= v0.z - zA*v0.x - zB*v0.y + 0.5f*(_abs(zA)+_abs(zB));
+	float zmax	= _max(_max(v0.z,v1.z),v2.z);
+
+	__m128	const	step		= _mm_set_ps(3.f,2.f,1.f,0.f);
+	__m128	const	zero		= _mm_setzero_ps();
+	__m128	const	vA0			= _mm_set1_ps(E0.A), vA1 = _mm_set1_ps(E1.A), vA2 = _mm_set1_ps(E2.A);
+	__m128	const	vzA			= _mm_set1_ps(zA);
+	__m128	const	vzmax		= _mm_set1_ps(zmax);
+
+	u32		pixels				= 0;
+	int		tx0 = x0/occ_tile, tx1 = (x1-1)/occ_tile;
+	int		ty0 = y0/occ_tile, ty1 = (y1-1)/occ_tile;
+	for (int ty=ty0; ty<=ty1; ty++)
+	{
+		float	cy0			= float(ty*occ_tile)+.5f;
+		float	cy1			= cy0 + float(occ_tile-1);
+		for (int tx=tx0; tx<=tx1; tx++)
+		{
+			float	cx0		= float(tx*occ_tile)+.5f;
+			float	cx1		= cx0 + float(occ_tile-1);
+
+			// trivial reject and accept of the whole tile
+			if (E0.hi(cx0,cy0,cx1,cy1)<0 || E1.hi(cx0,cy0,cx1,cy1)<0 || E2.hi(cx0,cy0,cx1,cy1)<0)	continue;
+			BOOL	full	= E0.lo(cx0,cy0,cx1,cy1)>=0 && E1.lo(cx0,cy0,cx1,cy1)>=0 && E2.lo(cx0,cy0,cx1,cy1)>=0;
+
+			float*	dst		= tile_depth(tx,ty);
+			for (int r=0; r<occ_tile; r++, dst+=occ_tile)
+			{
+				float	cy		= cy0 + float(r);
+				for (int h=0; h<occ_tile; h+=4)
+				{
+					__m128	X		= _mm_add_ps(_mm_set1_ps(cx0+float(h)),step);
+					__m128	mask;
+					if (full)		mask	= _mm_cmpeq_ps(zero,zero);
+					else
+					{
+						__m128	e0	= _mm_add_ps(_mm_mul_ps(vA0,X),_mm_set1_ps(E0.B*cy+E0.C));
+						__m128	e1	= _mm_add_ps(_mm_mul_ps(vA1,X),_mm_set1_ps(E1.B*cy+E1.C));
+						__m128	e2	= _mm_add_ps(_mm_mul_ps(vA2,X),_mm_set1_ps(E2.B*cy+E2.C));
+						mask		= _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0,zero),_mm_cmpge_ps(e1,zero)),_mm_cmpge_ps(e2,zero));
+					}
+					__m128	z		= _mm_min_ps(_mm_add_ps(_mm_mul_ps(vzA,X),_mm_set1_ps(zB*cy+zC)),vzmax);
+					__m128	d		= _mm_loadu_ps(dst+h);
+					__m128	closer	= _mm_and_ps(mask,_mm_cmplt_ps(z,d));
+					int		bits	= _mm_movemask_ps(closer);
+					if (!bits)		continue;
+					_mm_storeu_ps	(dst+h,_mm_or_ps(_mm_and_ps(closer,z),_mm_andnot_ps(closer,d)));
+					pixels			+= bits_4[bits];
+				}
+			}
+		}
+	}
+	return	pixels;
+}
+
+BOOL occTiledRasterizer::test	(float _x0, float _y0, float _x1, float _y1, float z)
+{
+	// every pixel the rectangle touches
+	int x0		= iFloor(_x0*width);	clamp(x0,0,		width-1);
+	int x1		= iFloor(_x1*width);	clamp(x1,x0,	width-1);
+	int y0		= iFloor(_y0*height);	clamp(y0,0,		height-1);
+	int y1		= iFloor(_y1*height);	clamp(y1,y0,	height-1);
+
+	int tx0 = x0/occ_tile, tx1 = x1/occ_tile;
+	int ty0 = y0/occ_tile, ty1 = y1/occ_tile;
+	int bx0 = tx0/occ_block, bx1 = tx1/occ_block;
+	int by0 = ty0/occ_block, by1 = ty1/occ_block;
+	for (int by=by0; by<=by1; by++)
+	{
+		for (int bx=bx0; bx<=bx1; bx++)
+		{
+			depth_range& B	= block(bx,by);
+			if (z<B.min)	return TRUE;		// nearer than any occluder here
+			if (z>=B.max)	continue;			// behind all of them
+
+			int	_ty0	= _max(ty0,by*occ_block),	_ty1	= _min(ty1,by*occ_block+occ_block-1);
+			int	_tx0	= _max(tx0,bx*occ_block),	_tx1	= _min(tx1,bx*occ_block+occ_block-1);
+			for (int ty=_ty0; ty<=_ty1; ty++)
+			{
+				for (int tx=_tx0; tx<=_tx1; tx++)
+				{
+					depth_range& T	= tile(tx,ty);
+					if (z<T.min)	return TRUE;
+					if (z>=T.max)	continue;
+
+					int		px0		= _max(x0,tx*occ_tile)-tx*occ_tile,	px1	= _min(x1,tx*occ_tile+occ_tile-1)-tx*occ_tile;
+					int		py0		= _max(y0,ty*occ_tile)-ty*occ_tile,	py1	= _min(y1,ty*occ_tile+occ_tile-1)-ty*occ_tile;
+					float*	depth	= tile_depth(tx,ty);
+					for (int py=py0; py<=py1; py++)
+						for (int px=px0; px<=px1; px++)
+							if (z<depth[py*occ_tile+px])	return TRUE;
+				}
+			}
+		}
+	}
+	return FALSE;
+}
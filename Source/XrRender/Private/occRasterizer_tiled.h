@@ -0,0 +1,51 @@
+// occRasterizer_tiled.h: interface for the occTiledRasterizer class.
+//////////////////////////////////////////////////////////////////////
+#pragma once
+
+// Half-space SSE rasterizer of the HOM occluders at a configurable resolution.
+// Coordinates are the viewport ones (0..1, y goes down), depth is the projected z, 1 is far.
+// The depth is stored tile by tile, every tile and every block of tiles keeps its
+// min/max depth, so a box test stops at the coarsest level that decides.
+const int	occ_tile		= 8;				// pixels per tile side
+const int	occ_tile_size	= occ_tile*occ_tile;
+const int	occ_block		= 8;				// tiles per block side
+
+class occTiledRasterizer
+{
+public:
+	struct	depth_range
+	{
+		float		min;
+		float		max;
+	};
+private:
+	int							width;
+	int							height;
+	int							tiles_x;
+	int							tiles_y;
+	int							blocks_x;
+	int							blocks_y;
+
+	xr_vector<float>			bufDepth;			// occ_tile_size per tile
+	xr_vector<depth_range>		bufTiles;
+	xr_vector<depth_range>		bufBlocks;
+
+	IC depth_range&	tile		(int x, int y)		{ return bufTiles	[y*tiles_x+x];	}
+	IC depth_range&	block		(int x, int y)		{ return bufBlocks	[y*blocks_x+x];	}
+	IC float*		tile_depth	(int x, int y)		{ return &bufDepth	[(y*tiles_x+x)*occ_tile_size];	}
+public:
+	void			resize		(int w, int h);		// rounded up to the whole tiles
+	int				get_width	() const			{ return width;		}
+	int				get_height	() const			{ return height;	}
+
+	void			clear		();
+	void			propagade	();
+	u32				rasterize	(const Fvector& v0, const Fvector& v1, const Fvector& v2);	// returns pixels written
+	BOOL			test		(float x0, float y0, float x1, float y1, float z);
+	float			get_depth	(int x, int y)		{ return tile_depth(x/occ_tile,y/occ_tile)[(y%occ_tile)*occ_tile+(x%occ_tile)]; }
+
+	occTiledRasterizer	();
+	~occTiledRasterizer	();
+};
+
+extern occTiledRasterizer	RasterTiled;
@@ -8,6 +8,7 @@
 #include "flod.h"
 #include "particlegroup.h"
 #include "FTreeVisual.h"
+#include "../../xrCPU_Pipe/ttapi.h"
 
 using	namespace R_dsgraph;
 
@@ -226,6 +227,81 @@ void R_dsgraph_structure::r_dsgraph_insert_dynamic	(dxRender_Visual *pVisual, Fv
 #endif
 }
 
+void R_dsgraph_structure::r_dsgraph_insert_normal	(mapNormal_T& map, SPass& pass, float SSA, dxRender_Visual *pVisual)
+{
+//#ifdef USE_RESOURCE_DEBUGGER
+//	mapNormalVS::TNode*			Nvs		= map.insert		(pass.vs);
+//	mapNormalPS::TNode*			Nps		= Nvs->val.insert	(pass.ps);
+//#else
+//#if defined(USE_DX10) || defined(USE_DX11)
+//	mapNormalVS::TNode*			Nvs		= map.insert		(&*pass.vs);
+//#else	//	USE_DX10
+//	mapNormalVS::TNode*			Nvs		= map.insert		(pass.vs->vs);
+//#endif	//	USE_DX10
+//	mapNormalPS::TNode*			Nps		= Nvs->val.insert	(pass.ps->ps);
+//#endif
+
+#ifdef USE_RESOURCE_DEBUGGER
+#	if defined(USE_DX10) || defined(USE_DX11)
+	mapNormalVS::TNode*			Nvs		= map.insert		(pass.vs);
+	mapNormalGS::TNode*			Ngs		= Nvs->val.insert	(pass.gs);
+	mapNormalPS::TNode*			Nps		= Ngs->val.insert	(pass.ps);
+#	else	//	USE_DX10
+	mapNormalVS::TNode*			Nvs		= map.insert		(pass.vs);
+	mapNormalPS::TNode*			Nps		= Nvs->val.insert	(pass.ps);
+#	endif	//	USE_DX10
+#else // USE_RESOURCE_DEBUGGER
+#	if defined(USE_DX10) || defined(USE_DX11)
+	mapNormalVS::TNode*			Nvs		= map.insert		(&*pass.vs);
+	mapNormalGS::TNode*			Ngs		= Nvs->val.insert	(pass.gs->gs);
+	mapNormalPS::TNode*			Nps		= Ngs->val.insert	(pass.ps->ps);
+#	else	//	USE_DX10
+	mapNormalVS::TNode*			Nvs		= map.insert		(pass.vs->vs);
+	mapNormalPS::TNode*			Nps		= Nvs->val.insert	(pass.ps->ps);
+#	endif	//	USE_DX10
+#endif // USE_RESOURCE_DEBUGGER
+
+#ifdef USE_DX11
+#	ifdef USE_RESOURCE_DEBUGGER
+	Nps->val.hs = pass.hs;
+	Nps->val.ds = pass.ds;
+	mapNormalCS::TNode*			Ncs		= Nps->val.mapCS.insert	(pass.constants._get());
+#	else
+	Nps->val.hs = pass.hs->sh;
+	Nps->val.ds = pass.ds->sh;
+	mapNormalCS::TNode*			Ncs		= Nps->val.mapCS.insert	(pass.constants._get());
+#	endif
+#else
+	mapNormalCS::TNode*			Ncs		= Nps->val.insert	(pass.constants._get());
+#endif
+	mapNormalStates::TNode*		Nstate	= Ncs->val.insert	(pass.state->state);
+	mapNormalTextures::TNode*	Ntex	= Nstate->val.insert(pass.T._get());
+	mapNormalItems&				items	= Ntex->val;
+	_NormalItem					item	= {SSA,pVisual};
+	items.push_back						(item);
+
+	// Need to sort for HZB efficient use
+	if (SSA>Ntex->val.ssa)		{ Ntex->val.ssa = SSA;
+	if (SSA>Nstate->val.ssa)	{ Nstate->val.ssa = SSA;
+	if (SSA>Ncs->val.ssa)		{ Ncs->val.ssa = SSA;
+#ifdef USE_DX11
+	if (SSA>Nps->val.mapCS.ssa)		{ Nps->val.mapCS.ssa = SSA;
+#else
+	if (SSA>Nps->val.ssa)		{ Nps->val.ssa = SSA;
+#endif
+//	if (SSA>Nvs->val.ssa)		{ Nvs->val.ssa = SSA;
+//	} } } } }
+#if defined(USE_DX10) || defined(USE_DX11)
+	if (SSA>Ngs->val.ssa)		{ Ngs->val.ssa = SSA;
+#endif	//	USE_DX10
+	if (SSA>Nvs->val.ssa)		{ Nvs->val.ssa = SSA;
+#if defined(USE_DX10) || defined(USE_DX11)
+	} } } } } }
+#else	//	USE_DX10
+	} } } } }
+#endif	//	USE_DX10
+}
+
 void R_dsgraph_structure::r_dsgraph_insert_static	(dxRender_Visual *pVisual)
 {
 	CRender&	RI				=	RImplementation;
@@ -300,84 +376,16 @@ void R_dsgraph_structure::r_dsgraph_insert_static	(dxRender_Visual *pVisual)
 
 	counter_S					++;
 
-	for ( u32 iPass = 0; iPass<sh->passes.size(); ++iPass)
+	if (ps_r__dsgraph_queue)
 	{
-		//SPass&						pass	= *sh->passes.front	();
-		//mapNormal_T&				map		= mapNormal			[sh->flags.iPriority/2];
-		SPass&						pass	= *sh->passes[iPass];
-		mapNormal_T&				map		= mapNormalPasses[sh->flags.iPriority/2][iPass];
-
-//#ifdef USE_RESOURCE_DEBUGGER
-//	mapNormalVS::TNode*			Nvs		= map.insert		(pass.vs);
-//	mapNormalPS::TNode*			Nps		= Nvs->val.insert	(pass.ps);
-//#else
-//#if defined(USE_DX10) || defined(USE_DX11)
-//	mapNormalVS::TNode*			Nvs		= map.insert		(&*pass.vs);
-//#else	//	USE_DX10
-//	mapNormalVS::TNode*			Nvs		= map.insert		(pass.vs->vs);
-//#endif	//	USE_DX10
-//	mapNormalPS::TNode*			Nps		= Nvs->val.insert	(pass.ps->ps);
-//#endif
-
-#ifdef USE_RESOURCE_DEBUGGER
-#	if defined(USE_DX10) || defined(USE_DX11)
-		mapNormalVS::TNode*			Nvs		= map.insert		(pass.vs);
-		mapNormalGS::TNode*			Ngs		= Nvs->val.insert	(pass.gs);
-		mapNormalPS::TNode*			Nps		= Ngs->val.insert	(pass.ps);
-#	else	//	USE_DX10
-		mapNormalVS::TNode*			Nvs		= map.insert		(pass.vs);
-		mapNormalPS::TNode*			Nps		= Nvs->val.insert	(pass.ps);
-#	endif	//	USE_DX10
-#else // USE_RESOURCE_DEBUGGER
-#	if defined(USE_DX10) || defined(USE_DX11)
-		mapNormalVS::TNode*			Nvs		= map.insert		(&*pass.vs);
-		mapNormalGS::TNode*			Ngs		= Nvs->val.insert	(pass.gs->gs);
-		mapNormalPS::TNode*			Nps		= Ngs->val.insert	(pass.ps->ps);
-#	else	//	USE_DX10
-		mapNormalVS::TNode*			Nvs		= map.insert		(pass.vs->vs);
-		mapNormalPS::TNode*			Nps		= Nvs->val.insert	(pass.ps->ps);
-#	endif	//	USE_DX10
-#endif // USE_RESOURCE_DEBUGGER
-
-#ifdef USE_DX11
-#	ifdef USE_RESOURCE_DEBUGGER
-		Nps->val.hs = pass.hs;
-		Nps->val.ds = pass.ds;
-		mapNormalCS::TNode*			Ncs		= Nps->val.mapCS.insert	(pass.constants._get());
-#	else
-		Nps->val.hs = pass.hs->sh;
-		Nps->val.ds = pass.ds->sh;
-		mapNormalCS::TNode*			Ncs		= Nps->val.mapCS.insert	(pass.constants._get());
-#	endif
-#else
-		mapNormalCS::TNode*			Ncs		= Nps->val.insert	(pass.constants._get());
-#endif
-		mapNormalStates::TNode*		Nstate	= Ncs->val.insert	(pass.state->state);
-		mapNormalTextures::TNode*	Ntex	= Nstate->val.insert(pass.T._get());
-		mapNormalItems&				items	= Ntex->val;
-		_NormalItem					item	= {SSA,pVisual};
-		items.push_back						(item);
-
-		// Need to sort for HZB efficient use
-		if (SSA>Ntex->val.ssa)		{ Ntex->val.ssa = SSA;
-		if (SSA>Nstate->val.ssa)	{ Nstate->val.ssa = SSA;
-		if (SSA>Ncs->val.ssa)		{ Ncs->val.ssa = SSA;
-#ifdef USE_DX11
-		if (SSA>Nps->val.mapCS.ssa)		{ Nps->val.mapCS.ssa = SSA;
-#else
-		if (SSA>Nps->val.ssa)		{ Nps->val.ssa = SSA;
-#endif
-//	if (SSA>Nvs->val.ssa)		{ Nvs->val.ssa = SSA;
-//	} } } } }
-#if defined(USE_DX10) || defined(USE_DX11)
-		if (SSA>Ngs->val.ssa)		{ Ngs->val.ssa = SSA;
-#endif	//	USE_DX10
-		if (SSA>Nvs->val.ssa)		{ Nvs->val.ssa = SSA;
-#if defined(USE_DX10) || defined(USE_DX11)
-		} } } } } }
-#else	//	USE_DX10
-		} } } } }
-#endif	//	USE_DX10
+		R_dsgraph_queue&	queue	= mapNormalQueue[sh->flags.iPriority/2];
+		for ( u32 iPass = 0; iPass<sh->passes.size(); ++iPass)
+			queue.insert				(iPass, &*sh->passes[iPass], SSA, pVisual);
+	}
+	else
+	{
+		for ( u32 iPass = 0; iPass<sh->passes.size(); ++iPass)
+			r_dsgraph_insert_normal		(mapNormalPasses[sh->flags.iPriority/2][iPass], *sh->passes[iPass], SSA, pVisual);
 	}
 
 #if RENDER!=R_R1
@@ -426,18 +434,18 @@ void CRender::add_leafs_Dynamic	(dxRender_Visual *pVisual)
 			// Add all children, doesn't perform any tests
 			CKinematics * pV			= (CKinematics*)pVisual;
 			BOOL	_use_lod			= FALSE	;
+			Fvector							Tpos;	float		D;
+			val_pTransform->transform_tiny	(Tpos, pV->vis.sphere.P);
+			float		ssa		=	CalcSSA	(D,Tpos,pV->vis.sphere.R/2.f);	// assume dynamics never consume full sphere
 			if (pV->m_lod)				
 			{
-				Fvector							Tpos;	float		D;
-				val_pTransform->transform_tiny	(Tpos, pV->vis.sphere.P);
-				float		ssa		=	CalcSSA	(D,Tpos,pV->vis.sphere.R/2.f);	// assume dynamics never consume full sphere
 				if (ssa<r_ssaLOD_A)	_use_lod	= TRUE;
 			}
 			if (_use_lod)				
 			{
 				add_leafs_Dynamic			(pV->m_lod)		;
 			} else {
-				pV->CalculateBones			(TRUE);
+				pV->CalculateBones_Render	(ssa);
 				pV->CalculateWallmarks		();		//. bug?
 				I = pV->children.begin		();
 				E = pV->children.end		();
@@ -597,11 +605,11 @@ BOOL CRender::add_Dynamic(dxRender_Visual *pVisual, u32 planes)
 			// Add all children, doesn't perform any tests
 			CKinematics * pV			= (CKinematics*)pVisual;
 			BOOL	_use_lod			= FALSE	;
+			Fvector							Tpos;	float		D;
+			val_pTransform->transform_tiny	(Tpos, pV->vis.sphere.P);
+			float		ssa		=	CalcSSA	(D,Tpos,pV->vis.sphere.R/2.f);	// assume dynamics never consume full sphere
 			if (pV->m_lod)				
 			{
-				Fvector							Tpos;	float		D;
-				val_pTransform->transform_tiny	(Tpos, pV->vis.sphere.P);
-				float		ssa		=	CalcSSA	(D,Tpos,pV->vis.sphere.R/2.f);	// assume dynamics never consume full sphere
 				if (ssa<r_ssaLOD_A)	_use_lod	= TRUE		;
 			}
 			if (_use_lod)
@@ -609,7 +617,7 @@ BOOL CRender::add_Dynamic(dxRender_Visual *pVisual, u32 planes)
 				add_leafs_Dynamic			(pV->m_lod)		;
 			} else 
 			{
-				pV->CalculateBones			(TRUE);
+				pV->CalculateBones_Render	(ssa);
 				pV->CalculateWallmarks		();		//. bug?
 				I = pV->children.begin		();
 				E = pV->children.end		();
@@ -739,3 +747,212 @@ void CRender::add_Static(dxRender_Visual *pVisual, u32 planes)
 		break;
 	}
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Static geometry culling of independent views ////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+struct	cull_job
+{
+	R_dsgraph_cull_view*	view;
+	u32						frustum;
+};
+struct	cull_queue
+{
+	cull_job*				jobs;
+	u32						count;
+	volatile LONG			next;
+};
+
+// Read-only walk of the hierarchy: only the frustum is tested, the leafs and the nodes which
+// need the main thread (particles, skeletons, lods) are collected in the traversal order
+static	void	cull_static		(const CFrustum& F, dxRender_Visual* pVisual, u32 planes, xr_vector<dxRender_Visual*>& dest)
+{
+	vis_data&	vis			= pVisual->vis;
+	if (fcvNone==F.testSAABB(vis.sphere.P,vis.sphere.R,vis.box.data(),planes))	return;
+
+	if (MT_HIERRARHY==pVisual->Type)
+	{
+		FHierrarhyVisual* pV = (FHierrarhyVisual*)pVisual;
+		xr_vector<dxRender_Visual*>::iterator I = pV->children.begin	();
+		xr_vector<dxRender_Visual*>::iterator E = pV->children.end		();
+		for (; I!=E; I++)	cull_static	(F,*I,planes,dest);
+		return;
+	}
+	dest.push_back			(pVisual);
+}
+
+static	void	cull_job_execute	(cull_job& J)
+{
+	R_dsgraph_cull_view&			V		= *J.view;
+	xr_vector<dxRender_Visual*>&	dest	= V.buckets[J.frustum];
+	CFrustum&						F		= V.frustums[J.frustum];
+	dest.clear				();
+	cull_static				(F,V.roots[J.frustum],F.getMask(),dest);
+}
+
+static	void	cull_worker		(LPVOID params)
+{
+	cull_queue&	Q			= *static_cast<cull_queue*>(params);
+	for (;;)
+	{
+		u32	id				= u32(InterlockedIncrement(&Q.next)-1);
+		if (id>=Q.count)	break;
+		cull_job_execute	(Q.jobs[id]);
+	}
+}
+
+u32		R_dsgraph_structure::r_dsgraph_cull_add	(IRender_Sector* _sector, Fmatrix& mCombined, Fvector& _cop)
+{
+	CFrustum	temp;
+	temp.CreateFromMatrix			(mCombined,	FRUSTUM_P_ALL &(~FRUSTUM_P_NEAR));
+	return		r_dsgraph_cull_add	(_sector,&temp,mCombined,_cop);
+}
+
+u32		R_dsgraph_structure::r_dsgraph_cull_add	(IRender_Sector* _sector, CFrustum* _frustum, Fmatrix& mCombined, Fvector& _cop)
+{
+	VERIFY							(_sector);
+	if (cullViews_count==cullViews.size())	cullViews.push_back(R_dsgraph_cull_view());
+	R_dsgraph_cull_view&	V		= cullViews[cullViews_count];
+	V.sector						= _sector;
+	V.frustum						= *_frustum;
+	V.xform							= mCombined;
+	V.cop							= _cop;
+
+	// Traverse sector/portal structure, the sector frustums are kept for the workers
+	PortalTraverser.traverse		(_sector, V.frustum, _cop, mCombined, 0);
+	V.roots.clear					();
+	V.frustums.clear				();
+	for (u32 s_it=0; s_it<PortalTraverser.r_sectors.size(); s_it++)
+	{
+		CSector*	sector		= (CSector*)PortalTraverser.r_sectors[s_it];
+		for (u32 v_it=0; v_it<sector->r_frustums.size(); v_it++)	{
+			V.roots.push_back		(sector->root());
+			V.frustums.push_back	(sector->r_frustums[v_it]);
+		}
+	}
+	if (V.buckets.size()<V.frustums.size())	V.buckets.resize(V.frustums.size());
+	return	cullViews_count++;
+}
+
+void	R_dsgraph_structure::r_dsgraph_cull_views	(BOOL _parallel)
+{
+	static xr_vector<cull_job>	jobs;
+	jobs.clear				();
+	for (u32 v_it=0; v_it<cullViews_count; v_it++)
+	{
+		for (u32 f_it=0; f_it<cullViews[v_it].frustums.size(); f_it++)
+		{
+			cull_job	J	= { &cullViews[v_it], f_it };
+			jobs.push_back	(J);
+		}
+	}
+	if (jobs.empty())		return;
+
+	// the render thread doesn't wait for the workers when the mt thread has them
+	u32	const workers_count	= _parallel ? _min(u32(ttapi_GetWorkersCount()),jobs.size()) : 1;
+	if (workers_count<=1 || !ttapi_TryLock())
+	{
+		for (u32 j_it=0; j_it<jobs.size(); j_it++)
+			cull_job_execute	(jobs[j_it]);
+		return;
+	}
+
+	// every sector frustum of every view goes to its own bucket, so the workers share only the job counter
+	cull_queue		Q;
+	Q.jobs			= &*jobs.begin();
+	Q.count			= jobs.size();
+	Q.next			= 0;
+	for (u32 i=0; i<workers_count; i++)
+		ttapi_AddWorker		(&cull_worker, &Q);
+	ttapi_RunAllWorkers		();
+	ttapi_Unlock			();
+}
+
+struct	cull_camera
+{
+	Fvector		position;
+	Fmatrix		xform;
+};
+
+static	void	cull_cameras_load	(LPCSTR _name, xr_vector<cull_camera>& cameras)
+{
+	string_path			fn;
+	strconcat			(sizeof(fn),fn,_name,".dsg_cam");
+	cameras.clear		();
+	IReader*			F	= FS.r_open("$logs$",fn);
+	if (!F)				return;
+	cameras.resize		(F->r_u32());
+	if (!cameras.empty())	F->r	(&*cameras.begin(),cameras.size()*sizeof(cull_camera));
+	FS.r_close			(F);
+}
+
+void	R_dsgraph_structure::r_dsgraph_cull_capture	(LPCSTR _name)
+{
+	xr_vector<cull_camera>	cameras;
+	cull_cameras_load		(_name,cameras);
+
+	cull_camera				C;
+	C.position.set			(Device->vCameraPosition);
+	C.xform.set				(Device->mFullTransform);
+	cameras.push_back		(C);
+
+	string_path				fn;
+	strconcat				(sizeof(fn),fn,_name,".dsg_cam");
+	IWriter*				W	= FS.w_open("$logs$",fn);
+	if (!W)
+	{
+		Msg					("! dsgraph capture: can't write [%s]",fn);
+		return;
+	}
+	W->w_u32				(cameras.size());
+	W->w					(&*cameras.begin(),cameras.size()*sizeof(cull_camera));
+	FS.w_close				(W);
+	Msg						("* dsgraph capture: %d cameras in [%s]",cameras.size(),fn);
+}
+
+void	R_dsgraph_structure::r_dsgraph_cull_benchmark	(LPCSTR _name, u32 _iterations)
+{
+	xr_vector<cull_camera>	cameras;
+	cull_cameras_load		(_name,cameras);
+	if (cameras.empty())
+	{
+		Msg					("! dsgraph bench: no cameras in [%s.dsg_cam], capture them with r__dsgraph_capture first",_name);
+		return;
+	}
+
+	// every camera is an independent view, nothing is drawn
+	CTimer					T;
+	r_dsgraph_cull_reset	();
+	T.Start					();
+	for (u32 c_it=0; c_it<cameras.size(); c_it++)
+	{
+		cull_camera&		C		= cameras[c_it];
+		IRender_Sector*		sector	= detectSector(C.position);
+		if (sector)			r_dsgraph_cull_add	(sector,C.xform,C.position);
+	}
+	float	traverse_time	= T.GetElapsed_sec()*1000.f;
+
+	u32		frustums		= 0;
+	for (u32 v_it=0; v_it<cullViews_count; v_it++)
+		frustums			+= cullViews[v_it].frustums.size();
+
+	float	time	[2];
+	u32		visuals	[2];
+	for (u32 parallel=0; parallel<2; parallel++)
+	{
+		T.Start				();
+		for (u32 i=0; i<_iterations; i++)
+			r_dsgraph_cull_views	(BOOL(parallel));
+		time[parallel]		= T.GetElapsed_sec()*1000.f/float(_iterations);
+
+		visuals[parallel]	= 0;
+		for (u32 v_it=0; v_it<cullViews_count; v_it++)
+			for (u32 f_it=0; f_it<cullViews[v_it].frustums.size(); f_it++)
+				visuals[parallel]	+= cullViews[v_it].buckets[f_it].size();
+	}
+
+	Msg		("* dsgraph bench: %d views, %d sector frustums, %d visuals, traverse %.2f ms",cullViews_count,frustums,visuals[0],traverse_time);
+	Msg		("* dsgraph bench: serial %.3f ms, parallel %.3f ms on %d workers%s",time[0],time[1],ttapi_GetWorkersCount(),
+		(visuals[0]==visuals[1])?"":" (visuals mismatch!)");
+	r_dsgraph_cull_reset	();
+}
@@ -0,0 +1,236 @@
+// r__dsgraph_queue.cpp: implementation of the R_dsgraph_queue class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "r__dsgraph_queue.h"
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+R_dsgraph_queue::R_dsgraph_queue	()
+{
+	sorted				= TRUE;
+}
+
+IC u32	hash_pass		(SPass* pass, u32 index)
+{
+	return	(u32(size_t(pass))>>4)*2654435761u + index;
+}
+
+void R_dsgraph_queue::groups_rehash	()
+{
+	u32	size			= _max(u32(256),u32(btwPow2_Ceil(u32(groups.size()*2+1))));
+	groups_table.assign	(size,0);
+	for (u32 g=0; g<groups.size(); g++)
+	{
+		u32	slot		= hash_pass(groups[g].pass,groups[g].index)&(size-1);
+		while (groups_table[slot])	slot = (slot+1)&(size-1);
+		groups_table[slot]	= g+1;
+	}
+}
+
+u32 R_dsgraph_queue::group_find	(SPass* pass, u32 index)
+{
+	if ((groups.size()+1)*2>groups_table.size())	groups_rehash();
+
+	u32	mask			= groups_table.size()-1;
+	u32	slot			= hash_pass(pass,index)&mask;
+	for (;;)
+	{
+		u32	g			= groups_table[slot];
+		if (0==g)		break;
+		group&	G		= groups[g-1];
+		if (G.pass==pass && G.index==index)		return g-1;
+		slot			= (slot+1)&mask;
+	}
+
+	group	G;
+	G.pass				= pass;
+	G.index				= index;
+	G.rank				= 0;
+	G.ssa				= 0.f;
+	groups.push_back	(G);
+	groups_table[slot]	= groups.size();
+	return	groups.size()-1;
+}
+
+void R_dsgraph_queue::insert	(u32 index, SPass* pass, float ssa, dxRender_Visual* visual)
+{
+	u32		g			= group_find(pass,index);
+	item	I			= { g, ssa, visual, pass };
+	items.push_back		(I);
+	if (ssa>groups[g].ssa)	groups[g].ssa	= ssa;
+	sorted				= FALSE;
+}
+
+void R_dsgraph_queue::clear	()
+{
+	items.clear			();
+	groups.clear		();
+	if (!groups_table.empty())	groups_table.assign(groups_table.size(),0);
+	sorted				= TRUE;
+}
+
+// the state switched by a level of the mapping trees
+static int	level_compare	(const SPass& P1, const SPass& P2, u32 level)
+{
+#define	CMP(a,b)	if ((a)!=(b))	return ((a)<(b)) ? -1 : 1
+	switch (level)
+	{
+	case R_dsgraph_queue::level_vs:			CMP(P1.vs._get(),P2.vs._get());					break;
+#if defined(USE_DX10) || defined(USE_DX11)
+	case R_dsgraph_queue::level_gs:			CMP(P1.gs._get(),P2.gs._get());					break;
+#endif	//	USE_DX10
+	case R_dsgraph_queue::level_ps:
+		CMP(P1.ps._get(),P2.ps._get());
+#ifdef USE_DX11
+		CMP(P1.hs._get(),P2.hs._get());
+		CMP(P1.ds._get(),P2.ds._get());
+#endif
+		break;
+	case R_dsgraph_queue::level_constants:	CMP(P1.constants._get(),P2.constants._get());	break;
+	case R_dsgraph_queue::level_states:		CMP(P1.state._get(),P2.state._get());			break;
+	case R_dsgraph_queue::level_textures:
+		{
+			STextureList*	t1	= P1.T._get();
+			STextureList*	t2	= P2.T._get();
+			if (t1==t2)		break;
+			if (!t1 || !t2)	return (t1<t2) ? -1 : 1;
+			if (std::lexicographical_compare(t1->begin(),t1->end(),t2->begin(),t2->end()))	return -1;
+			if (std::lexicographical_compare(t2->begin(),t2->end(),t1->begin(),t1->end()))	return 1;
+			CMP(t1,t2);
+		}
+		break;
+	}
+#undef	CMP
+	return	0;
+}
+
+// the state only, the groups of one subtree come together
+struct	pred_groups_state
+{
+	const R_dsgraph_queue::group*	groups;
+
+	bool	operator()	(u32 _1, u32 _2) const
+	{
+		const R_dsgraph_queue::group&	G1	= groups[_1];
+		const R_dsgraph_queue::group&	G2	= groups[_2];
+		if (G1.index!=G2.index)			return G1.index<G2.index;
+		for (u32 L=0; L<R_dsgraph_queue::level_count; L++)
+			if (int c = level_compare(*G1.pass,*G2.pass,L))	return c<0;
+		return	G1.pass<G2.pass;
+	}
+};
+
+// as the mapping trees were walked: on every level the subtree with the largest ssa first
+struct	pred_groups
+{
+	const R_dsgraph_queue::group*	groups;
+
+	bool	operator()	(u32 _1, u32 _2) const
+	{
+		const R_dsgraph_queue::group&	G1	= groups[_1];
+		const R_dsgraph_queue::group&	G2	= groups[_2];
+		if (G1.index!=G2.index)			return G1.index<G2.index;
+		for (u32 L=0; L<R_dsgraph_queue::level_count; L++)
+		{
+			if (G1.level_ssa[L]!=G2.level_ssa[L])			return G1.level_ssa[L]>G2.level_ssa[L];
+			if (int c = level_compare(*G1.pass,*G2.pass,L))	return c<0;
+		}
+		return	G1.pass<G2.pass;
+	}
+};
+
+void R_dsgraph_queue::sort	()
+{
+	if (sorted)			return;
+	sorted				= TRUE;
+
+	// rank the groups, there are a few hundred of them against thousands of items
+	u32	count			= groups.size();
+	groups_order.resize	(count);
+	for (u32 g=0; g<count; g++)	groups_order[g] = g;
+	if (count)
+	{
+		group*	G		= &*groups.begin();
+		pred_groups_state	pred_state	= { G };
+		std::sort		(groups_order.begin(),groups_order.end(),pred_state);
+
+		// the subtrees are runs of the state order now, every group gets the largest ssa of its subtrees
+		groups_shared.resize	(count);
+		groups_shared[0]	= 0;
+		for (u32 r=1; r<count; r++)
+		{
+			group&	P	= G[groups_order[r-1]];
+			group&	N	= G[groups_order[r]];
+			u32		L	= 0;
+			if (P.index==N.index)
+				while (L<level_count && 0==level_compare(*P.pass,*N.pass,L))	L++;
+			groups_shared[r]	= L;
+		}
+		for (u32 L=0; L<level_count; L++)
+		{
+			for (u32 b=0, e; b<count; b=e)
+			{
+				float	ssa		= G[groups_order[b]].ssa;
+				for (e=b+1; e<count && groups_shared[e]>L; e++)
+					ssa			= _max(ssa,G[groups_order[e]].ssa);
+				for (u32 r=b; r<e; r++)
+					G[groups_order[r]].level_ssa[L]	= ssa;
+			}
+		}
+
+		pred_groups		pred	= { G };
+		std::sort		(groups_order.begin(),groups_order.end(),pred);
+	}
+	for (u32 r=0; r<count; r++)
+		groups[groups_order[r]].rank	= r;
+
+	// [pass index:16][rank:32][ssa:16], the larger ssa goes first inside a group
+	for (item* I=begin(); I!=end(); I++)
+	{
+		group&	G		= groups[u32(I->key)];
+		u32		ssa		= *(u32*)(&I->ssa);
+		I->key			= (u64(G.index)<<48) | (u64(G.rank)<<16) | u64(u16(~(ssa>>16)));
+	}
+	radix_sort			();
+}
+
+void R_dsgraph_queue::radix_sort	()
+{
+	u32	count			= items.size();
+	if (count<2)		return;
+
+	// histograms of all the digits in one pass
+	u32	histogram		[8][256];
+	ZeroMemory			(histogram,sizeof(histogram));
+	for (item* I=begin(); I!=end(); I++)
+	{
+		u64	key			= I->key;
+		for (u32 d=0; d<8; d++)
+			histogram[d][u32(key>>(d*8))&0xff]	++;
+	}
+
+	items_temp.resize	(count);
+	item*	src			= &*items.begin();
+	item*	dst			= &*items_temp.begin();
+	for (u32 d=0; d<8; d++)
+	{
+		u32*	H		= histogram[d];
+		if (H[u32(src->key>>(d*8))&0xff]==count)	continue;	// the same digit everywhere
+
+		u32	offset		= 0;
+		for (u32 b=0; b<256; b++)
+		{
+			u32	c		= H[b];
+			H[b]		= offset;
+			offset		+= c;
+		}
+		for (u32 i=0; i<count; i++)
+			dst[H[u32(src[i].key>>(d*8))&0xff]++]	= src[i];
+		std::swap		(src,dst);
+	}
+	if (src!=&*items.begin())	items.swap(items_temp);
+}
@@ -0,0 +1,67 @@
+// r__dsgraph_queue.h: interface for the R_dsgraph_queue class.
+//////////////////////////////////////////////////////////////////////
+#pragma once
+
+struct	SPass;
+class	dxRender_Visual;
+
+// Flat render queue of the normal (static) geometry.
+// An item is a visual drawn with a shader pass, the pass is the group of the item: SPass objects are
+// shared by the resource manager, so one pass is one combination of shaders, constants, states and textures.
+// Before the rendering the groups are ranked level by level as the mapping trees were walked: the vs by
+// the largest ssa under it, descending, then the gs, ps (with hs/ds), constants, states and textures
+// inside it the same way, so the state changes stay as few as with the trees and the near geometry
+// still goes first for early-z and HZB. Every item gets the 64-bit key [pass index][group rank]
+// [ssa, descending] and the items are radix-sorted once.
+class	R_dsgraph_queue
+{
+public:
+	struct	item
+	{
+		u64						key;
+		float					ssa;
+		dxRender_Visual*		visual;
+		SPass*					pass;
+	};
+	enum
+	{
+		level_vs				= 0,			// the levels of the mapping trees
+		level_gs,
+		level_ps,
+		level_constants,
+		level_states,
+		level_textures,
+		level_count
+	};
+	struct	group
+	{
+		SPass*					pass;
+		u32						index;			// shader pass index
+		u32						rank;
+		float					ssa;			// the largest of the items
+		float					level_ssa		[level_count];	// the largest in the subtree of every level
+	};
+private:
+	xr_vector<item>				items;
+	xr_vector<item>				items_temp;
+	xr_vector<group>			groups;
+	xr_vector<u32>				groups_table;	// open addressing, group+1, 0 - free
+	xr_vector<u32>				groups_order;
+	xr_vector<u32>				groups_shared;	// levels shared with the previous group in the state order
+	BOOL						sorted;
+
+	u32							group_find		(SPass* pass, u32 index);
+	void						groups_rehash	();
+	void						radix_sort		();
+public:
+	void						insert			(u32 index, SPass* pass, float ssa, dxRender_Visual* visual);
+	void						sort			();
+	void						clear			();
+
+	u32							size			() const		{ return items.size();		}
+	u32							groups_count	() const		{ return groups.size();		}
+	item*						begin			()				{ return items.empty()?0:&*items.begin();	}
+	item*						end				()				{ return begin()+items.size();	}
+
+	R_dsgraph_queue		();
+};
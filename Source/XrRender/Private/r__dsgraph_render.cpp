@@ -7,6 +7,8 @@
 #include "../../xrEngine/CustomHUD.h"
 
 #include "FBasicVisual.h"
+#include "fhierrarhyvisual.h"
+#include "../../xrEngine/fmesh.h"
 
 using namespace		R_dsgraph;
 
@@ -269,6 +271,7 @@ void R_dsgraph_structure::r_dsgraph_render_graph	(u32	_priority, bool _clear)
 	// Sorting by SSA and changes minimizations
 	{
 		RCache.set_xform_world			(Fidentity);
+		r_dsgraph_render_queue			(_priority,_clear);
 
 		// Render several passes
 		for ( u32 iPass = 0; iPass<SHADER_PASSES_MAX; ++iPass)
@@ -456,6 +459,199 @@ void R_dsgraph_structure::r_dsgraph_render_graph	(u32	_priority, bool _clear)
 	Device->Statistic->RenderDUMP.End	();
 }
 
+// the flat queue is sorted in the order of the mapping trees, so only the changed parts of the pass are set
+void R_dsgraph_structure::r_dsgraph_render_queue	(u32	_priority, bool _clear)
+{
+	R_dsgraph_queue&	queue		= mapNormalQueue[_priority];
+	if (0==queue.size())			return;
+	queue.sort						();
+
+	SPass*				prev		= 0;
+	R_dsgraph_queue::item*	I		= queue.begin	();
+	R_dsgraph_queue::item*	E		= queue.end		();
+	for (; I!=E; I++)
+	{
+		SPass&			pass		= *I->pass;
+		if (&pass!=prev)
+		{
+			if (!prev || prev->vs._get()!=pass.vs._get())					RCache.set_VS			(pass.vs);
+#if defined(USE_DX10) || defined(USE_DX11)
+			if (!prev || prev->gs._get()!=pass.gs._get())					RCache.set_GS			(pass.gs);
+#endif	//	USE_DX10
+			if (!prev || prev->ps._get()!=pass.ps._get())					RCache.set_PS			(pass.ps);
+#ifdef USE_DX11
+			if (!prev || prev->hs._get()!=pass.hs._get())					RCache.set_HS			(pass.hs);
+			if (!prev || prev->ds._get()!=pass.ds._get())					RCache.set_DS			(pass.ds);
+#endif
+			if (!prev || prev->constants._get()!=pass.constants._get())	RCache.set_Constants	(pass.constants);
+			if (!prev || prev->state._get()!=pass.state._get())			RCache.set_States		(pass.state);
+			if (!prev || prev->T._get()!=pass.T._get())					RCache.set_Textures		(pass.T);
+			RImplementation.apply_lmaterial	();
+			prev						= &pass;
+		}
+
+		float LOD = calcLOD(I->ssa,I->visual->vis.sphere.R);
+#ifdef USE_DX11
+		RCache.LOD.set_LOD(LOD);
+#endif
+		I->visual->Render			(LOD);
+	}
+	if (_clear)						queue.clear	();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Queue benchmark: the mapping trees against the flat queue, the state changes are counted instead of drawing
+static u32	bench_tree_changes		(mapNormalVS& vs)
+{
+	u32		changes		= 0;
+	xr_vector<mapNormalVS::TNode*,render_alloc<mapNormalVS::TNode*> >				lstVS;
+#if defined(USE_DX10) || defined(USE_DX11)
+	xr_vector<mapNormalGS::TNode*,render_alloc<mapNormalGS::TNode*> >				lstGS;
+#endif	//	USE_DX10
+	xr_vector<mapNormalPS::TNode*,render_alloc<mapNormalPS::TNode*> >				lstPS;
+	xr_vector<mapNormalCS::TNode*,render_alloc<mapNormalCS::TNode*> >				lstCS;
+	xr_vector<mapNormalStates::TNode*,render_alloc<mapNormalStates::TNode*> >		lstStates;
+	xr_vector<mapNormalTextures::TNode*,render_alloc<mapNormalTextures::TNode*> >	lstTextures, lstTexturesTemp;
+
+	vs.getANY_P						(lstVS);
+	std::sort						(lstVS.begin(), lstVS.end(), cmp_vs_nrm);
+	for (u32 vs_id=0; vs_id<lstVS.size(); vs_id++)
+	{
+#if defined(USE_DX10) || defined(USE_DX11)
+		mapNormalGS&		gs			= lstVS[vs_id]->val;
+		gs.getANY_P						(lstGS);
+		std::sort						(lstGS.begin(), lstGS.end(), cmp_gs_nrm);
+		for (u32 gs_id=0; gs_id<lstGS.size(); gs_id++)
+		{
+			mapNormalPS&		ps			= lstGS[gs_id]->val;
+#else	//	USE_DX10
+			mapNormalPS&		ps			= lstVS[vs_id]->val;
+#endif	//	USE_DX10
+			ps.getANY_P						(lstPS);
+			std::sort						(lstPS.begin(), lstPS.end(), cmp_ps_nrm);
+			for (u32 ps_id=0; ps_id<lstPS.size(); ps_id++)
+			{
+#ifdef USE_DX11
+				mapNormalCS&		cs			= lstPS[ps_id]->val.mapCS;
+#else
+				mapNormalCS&		cs			= lstPS[ps_id]->val;
+#endif
+				cs.getANY_P						(lstCS);
+				std::sort						(lstCS.begin(), lstCS.end(), cmp_cs_nrm);
+				for (u32 cs_id=0; cs_id<lstCS.size(); cs_id++)
+				{
+					mapNormalStates&	states		= lstCS[cs_id]->val;
+					states.getANY_P					(lstStates);
+					std::sort						(lstStates.begin(), lstStates.end(), cmp_states_nrm);
+					for (u32 state_id=0; state_id<lstStates.size(); state_id++)
+					{
+						mapNormalTextures&	tex			= lstStates[state_id]->val;
+						sort_tlist_nrm					(lstTextures,lstTexturesTemp,tex,true);
+						for (u32 tex_id=0; tex_id<lstTextures.size(); tex_id++)
+						{
+							mapNormalItems&		items	= lstTextures[tex_id]->val;
+							std::sort					(items.begin(),items.end(),cmp_normal_items);
+							items.clear					();
+							changes						++;
+						}
+						lstTextures.clear		();
+						lstTexturesTemp.clear	();
+						tex.clear				();
+					}
+					lstStates.clear			();
+					states.clear			();
+				}
+				lstCS.clear				();
+				cs.clear				();
+			}
+			lstPS.clear				();
+			ps.clear				();
+#if defined(USE_DX10) || defined(USE_DX11)
+		}
+		lstGS.clear				();
+		gs.clear				();
+#endif	//	USE_DX10
+	}
+	vs.clear					();
+	return	changes;
+}
+
+static u32	bench_queue_changes		(R_dsgraph_queue& queue)
+{
+	u32		changes		= 0;
+	SPass*	prev		= 0;
+	queue.sort			();
+	for (R_dsgraph_queue::item* I=queue.begin(); I!=queue.end(); I++)
+	{
+		if (I->pass!=prev)	{ prev = I->pass; changes++; }
+	}
+	queue.clear			();
+	return	changes;
+}
+
+void R_dsgraph_structure::r_dsgraph_queue_benchmark	(u32 _items, u32 _iterations)
+{
+	// the static level geometry with its real shaders
+	xr_vector<dxRender_Visual*>	visuals;
+	for (u32 s_it=0; s_it<RImplementation.Sectors.size(); s_it++)
+	{
+		lstVisuals.clear		();
+		lstVisuals.push_back	(((CSector*)RImplementation.Sectors[s_it])->root());
+		for (u32 v_it=0; v_it<lstVisuals.size(); v_it++)
+		{
+			dxRender_Visual*	V	= lstVisuals[v_it];
+			if (MT_HIERRARHY==V->Type)
+			{
+				FHierrarhyVisual*	pV	= (FHierrarhyVisual*)V;
+				lstVisuals.insert		(lstVisuals.end(),pV->children.begin(),pV->children.end());
+			}
+			else if (V->shader._get() && V->shader->E[0]._get())
+				visuals.push_back		(V);
+		}
+	}
+	lstVisuals.clear			();
+	if (visuals.empty())
+	{
+		Msg						("! dsgraph queue bench: no static geometry, load a level first");
+		return;
+	}
+
+	// the same items in the same order for both, ssa as a visual at some distance would have
+	CRandom						R		(0x31337);
+	xr_vector<float>			ssa		(_items);
+	for (u32 i=0; i<_items; i++)	ssa[i]	= R.randF(r_ssaDISCARD,1.f);
+
+	mapNormal_T					tree;
+	R_dsgraph_queue				queue;
+	u32							changes	[2]	= {0,0};
+	float						ms		[2];
+	CTimer						T;
+	for (u32 mode=0; mode<2; mode++)
+	{
+		T.Start					();
+		for (u32 it=0; it<_iterations; it++)
+		{
+			for (u32 i=0; i<_items; i++)
+			{
+				dxRender_Visual*	V		= visuals[i%visuals.size()];
+				ShaderElement*		sh		= &*V->shader->E[0];
+				for (u32 iPass=0; iPass<sh->passes.size(); iPass++)
+				{
+					if (mode)		queue.insert			(iPass,&*sh->passes[iPass],ssa[i],V);
+					else			r_dsgraph_insert_normal	(tree,*sh->passes[iPass],ssa[i],V);
+				}
+			}
+			changes[mode]		= mode ? bench_queue_changes(queue) : bench_tree_changes(tree);
+		}
+		ms[mode]				= T.GetElapsed_sec()*1000.f/float(_iterations);
+	}
+	tree.destroy				();
+
+	Msg		("* dsgraph queue bench: %d items of %d static visuals",_items,visuals.size());
+	Msg		("* dsgraph queue bench: trees %.3f ms, %d state groups",ms[0],changes[0]);
+	Msg		("* dsgraph queue bench: queue %.3f ms, %d state groups",ms[1],changes[1]);
+}
+
 //////////////////////////////////////////////////////////////////////////
 // HUD render
 void R_dsgraph_structure::r_dsgraph_render_hud	()
@@ -684,44 +880,92 @@ void	R_dsgraph_structure::r_dsgraph_render_subspace	(IRender_Sector* _sector, CF
 	}
 
 	if (_dynamic)
-	{
-		set_Object						(0);
-
-		// Traverse object database
-		g_SpatialSpace->q_frustum
-			(
-			lstRenderables,
-			ISpatial_DB::O_ORDERED,
-			STYPE_RENDERABLE,
-			ViewBase
-			);
-
-		// Determine visibility for dynamic part of scene
-		for (u32 o_it=0; o_it<lstRenderables.size(); o_it++)
-		{
-			ISpatial*	spatial		= lstRenderables[o_it];
-			CSector*	sector		= (CSector*)spatial->spatial.sector;
-			if	(0==sector)										continue;	// disassociated from S/P structure
-			if	(PortalTraverser.i_marker != sector->r_marker)	continue;	// inactive (untouched) sector
-			for (u32 v_it=0; v_it<sector->r_frustums.size(); v_it++)
-			{
-				set_Frustum			(&(sector->r_frustums[v_it]));
-				if (!View->testSphere_dirty(spatial->spatial.sphere.P,spatial->spatial.sphere.R))	continue;
+		r_dsgraph_render_subspace_dynamic	();
 
-				// renderable
-				IRenderable*	renderable		= spatial->dcast_Renderable	();
-				if (0==renderable)				continue;					// unknown, but renderable object (r1_glow???)
+	// Restore
+	ViewBase						= ViewSave;
+	View							= 0;
+}
+
+// sub-space rendering of a view culled by r_dsgraph_cull_views
+void	R_dsgraph_structure::r_dsgraph_render_subspace	(u32 _view, BOOL _dynamic)
+{
+	VERIFY							(_view<cullViews_count);
+	R_dsgraph_cull_view&	V		= cullViews[_view];
+	RImplementation.marker			++;			// !!! critical here
+
+	CFrustum	ViewSave			= ViewBase;
+	ViewBase						= V.frustum;
+	View							= &ViewBase;
 
-				renderable->renderable_Render	();
+	// Insert the static geometry found by the workers, the nodes which need the main thread are processed as usual
+	for (u32 f_it=0; f_it<V.frustums.size(); f_it++)
+	{
+		set_Frustum					(&V.frustums[f_it]);
+		xr_vector<dxRender_Visual*>&	bucket	= V.buckets[f_it];
+		for (u32 v_it=0; v_it<bucket.size(); v_it++)
+		{
+			dxRender_Visual*	pVisual	= bucket[v_it];
+			switch (pVisual->Type)	{
+			case MT_PARTICLE_GROUP:
+			case MT_SKELETON_ANIM:
+			case MT_SKELETON_RIGID:
+			case MT_LOD:
+				add_Geometry		(pVisual);
+				break;
+			default:
+				r_dsgraph_insert_static	(pVisual);
+				break;
 			}
 		}
 	}
 
+	if (_dynamic)
+	{
+		// the sector frustums of the portal traversal are needed for the objects
+		PortalTraverser.traverse	(V.sector, ViewBase, V.cop, V.xform, 0);
+		r_dsgraph_render_subspace_dynamic	();
+	}
+
 	// Restore
 	ViewBase						= ViewSave;
 	View							= 0;
 }
 
+void	R_dsgraph_structure::r_dsgraph_render_subspace_dynamic	()
+{
+	set_Object						(0);
+
+	// Traverse object database
+	g_SpatialSpace->q_frustum
+		(
+		lstRenderables,
+		ISpatial_DB::O_ORDERED,
+		STYPE_RENDERABLE,
+		ViewBase
+		);
+
+	// Determine visibility for dynamic part of scene
+	for (u32 o_it=0; o_it<lstRenderables.size(); o_it++)
+	{
+		ISpatial*	spatial		= lstRenderables[o_it];
+		CSector*	sector		= (CSector*)spatial->spatial.sector;
+		if	(0==sector)										continue;	// disassociated from S/P structure
+		if	(PortalTraverser.i_marker != sector->r_marker)	continue;	// inactive (untouched) sector
+		for (u32 v_it=0; v_it<sector->r_frustums.size(); v_it++)
+		{
+			set_Frustum			(&(sector->r_frustums[v_it]));
+			if (!View->testSphere_dirty(spatial->spatial.sphere.P,spatial->spatial.sphere.R))	continue;
+
+			// renderable
+			IRenderable*	renderable		= spatial->dcast_Renderable	();
+			if (0==renderable)				continue;					// unknown, but renderable object (r1_glow???)
+
+			renderable->renderable_Render	();
+		}
+	}
+}
+
 #include "fhierrarhyvisual.h"
 #include "SkeletonCustom.h"
 #include "../../xrEngine/fmesh.h"
@@ -3,6 +3,7 @@
 #include "../../xrEngine/render.h"
 #include "../../xrcdb/ispatial.h"
 #include "r__dsgraph_types.h"
+#include "r__dsgraph_queue.h"
 #include "r__sector.h"
 
 //////////////////////////////////////////////////////////////////////////
@@ -14,6 +15,20 @@ public:
 	virtual		void	rfeedback_static	(dxRender_Visual*	V)		= 0;
 };
 
+//////////////////////////////////////////////////////////////////////////
+// static geometry of a view culled ahead of the insertion				//
+//////////////////////////////////////////////////////////////////////////
+struct	R_dsgraph_cull_view
+{
+	IRender_Sector*												sector		;
+	CFrustum													frustum		;
+	Fmatrix														xform		;
+	Fvector														cop			;
+	xr_vector<dxRender_Visual*>									roots		;	// sector root per sector frustum
+	xr_vector<CFrustum>											frustums	;	// sector frustums after the portal traversal
+	xr_vector<xr_vector<dxRender_Visual*> >						buckets		;	// per sector frustum, filled by the workers
+};
+
 //////////////////////////////////////////////////////////////////////////
 // common part of interface implementation for all D3D renderers		//
 //////////////////////////////////////////////////////////////////////////
@@ -38,6 +53,7 @@ public:
 	R_dsgraph::mapNormalPasses_T								mapNormalPasses	[2]	;	// 2==(priority/2)
 	//R_dsgraph::mapMatrix_T										mapMatrix	[2]		;
 	R_dsgraph::mapMatrixPasses_T								mapMatrixPasses	[2]	;
+	R_dsgraph_queue												mapNormalQueue	[2]	;	// replaces mapNormalPasses with r__dsgraph_queue
 	R_dsgraph::mapSorted_T										mapSorted;
 	R_dsgraph::mapHUD_T											mapHUD;
 	R_dsgraph::mapLOD_T											mapLOD;
@@ -78,6 +94,9 @@ public:
 
 	xr_vector<dxRender_Visual*,render_alloc<dxRender_Visual*> >			lstRecorded	;
 
+	xr_vector<R_dsgraph_cull_view>										cullViews	;
+	u32																	cullViews_count;
+
 	u32															counter_S	;
 	u32															counter_D	;
 	BOOL														b_loaded	;
@@ -102,6 +121,7 @@ public:
 		val_feedback_breakp	= 0;
 		val_recorder		= 0;
 		marker				= 0;
+		cullViews_count		= 0;
 		r_pmask				(true,true);
 		b_loaded			= FALSE	;
 	};
@@ -130,6 +150,9 @@ public:
 
 		lstRecorded.clear		();
 
+		cullViews.clear			();
+		cullViews_count			= 0;
+
 		//mapNormal[0].destroy	();
 		//mapNormal[1].destroy	();
 		//mapMatrix[0].destroy	();
@@ -141,6 +164,8 @@ public:
 			mapMatrixPasses[0][i].destroy	();
 			mapMatrixPasses[1][i].destroy	();
 		}
+		mapNormalQueue[0].clear	();
+		mapNormalQueue[1].clear	();
 		mapSorted.destroy		();
 		mapHUD.destroy			();
 		mapLOD.destroy			();
@@ -156,8 +181,11 @@ public:
 
 	void		r_dsgraph_insert_dynamic						(dxRender_Visual	*pVisual, Fvector& Center);
 	void		r_dsgraph_insert_static							(dxRender_Visual	*pVisual);
+	void		r_dsgraph_insert_normal							(R_dsgraph::mapNormal_T& map, SPass& pass, float SSA, dxRender_Visual *pVisual);
 
 	void		r_dsgraph_render_graph							(u32	_priority,	bool _clear=true);
+	void		r_dsgraph_render_queue							(u32	_priority,	bool _clear=true);
+	void		r_dsgraph_queue_benchmark						(u32 _items, u32 _iterations);
 	void		r_dsgraph_render_hud							();
 	void		r_dsgraph_render_hud_ui							();
 	void		r_dsgraph_render_lods							(bool	_setup_zb,	bool _clear);
@@ -167,8 +195,21 @@ public:
 	void		r_dsgraph_render_distort						();
 	void		r_dsgraph_render_subspace						(IRender_Sector* _sector, CFrustum* _frustum, Fmatrix& mCombined, Fvector& _cop, BOOL _dynamic, BOOL _precise_portals=FALSE	);
 	void		r_dsgraph_render_subspace						(IRender_Sector* _sector, Fmatrix& mCombined, Fvector& _cop, BOOL _dynamic, BOOL _precise_portals=FALSE	);
+	void		r_dsgraph_render_subspace						(u32 _view, BOOL _dynamic);
 	void		r_dsgraph_render_R1_box							(IRender_Sector* _sector, Fbox& _bb, int _element);
 
+	// Independent views: the portals are traversed when a view is added, the static geometry of
+	// all of them is culled at once on the worker threads and inserted by r_dsgraph_render_subspace(view)
+	u32			r_dsgraph_cull_add								(IRender_Sector* _sector, CFrustum* _frustum, Fmatrix& mCombined, Fvector& _cop);
+	u32			r_dsgraph_cull_add								(IRender_Sector* _sector, Fmatrix& mCombined, Fvector& _cop);
+	void		r_dsgraph_cull_views							(BOOL _parallel);
+	void		r_dsgraph_cull_reset							()												{ cullViews_count = 0; }
+	void		r_dsgraph_cull_benchmark						(LPCSTR _name, u32 _iterations);
+	void		r_dsgraph_cull_capture							(LPCSTR _name);
+private:
+	void		r_dsgraph_render_subspace_dynamic				();
+public:
+
 
 public:
 	virtual		u32						memory_usage			()
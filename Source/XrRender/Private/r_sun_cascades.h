@@ -14,13 +14,19 @@ struct ray
 
 struct cascade 
 {
-	cascade () : reset_chain( false )	{}
+	cascade () : reset_chain( false ), cull_sector( 0 ), cull_view( u32(-1) )	{}
 
 	Fmatrix			xform;
 	xr_vector<ray>	rays;
 	float			size;
 	float			bias;
 	bool			reset_chain;
+
+	// filled by calc_sun_cascade
+	CFrustum		cull_frustum;
+	Fvector3		cull_COP;
+	IRender_Sector*	cull_sector;
+	u32				cull_view;		// r_dsgraph_cull_add id, u32(-1) if not culled ahead
 };
 
 } //namespace sun
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "..\..\XrAPI\xrGameManager.h"
 #include	"xrRender_console.h"
 #include	"dxRenderDeviceRender.h"
+#include	"SkeletonAnimated.h"
 
 u32			ps_Preset				=	2	;
 xr_token							qpreset_token							[ ]={
@@ -88,6 +89,10 @@ xr_token							qminmax_sm_token					[ ]={
 
 // Common
 extern int			psSkeletonUpdate;
+extern int			psSkeletonBatch;
+extern int			psSkeletonLOD_Interval;
+extern float		psSkeletonLOD_Near;
+extern float		psSkeletonLOD_Far;
 extern float		r__dtex_range;
 
 //int		ps_r__Supersample			= 1		;
@@ -118,6 +123,13 @@ float		ps_r__ssaHZBvsTEX			=  96.f	;					//RO
 
 int			ps_r__tf_Anisotropic		= 8		;
 
+int			ps_r__occ_tiled				= 1		;
+int			ps_r__occ_width				= 256	;
+int			ps_r__occ_height			= 128	;
+int			ps_r__dsgraph_mt			= 1		;
+int			ps_r__dsgraph_queue			= 1		;
+int			ps_r__detail_stream			= 1		;
+
 // R1
 float		ps_r1_ssaLOD_A				= 64.f	;
 float		ps_r1_ssaLOD_B				= 48.f	;
@@ -336,6 +348,76 @@ public:
 	}
 };
 
+class CCC_OccRecord : public IConsole_Command
+{
+public:
+	CCC_OccRecord(LPCSTR N) : IConsole_Command(N)  { };
+	virtual void Execute(LPCSTR args) {
+		string_path	name;	name[0]=0;
+		sscanf		(args,"%s",name);
+		RImplementation.HOM.Record(xr_strlen(name)?name:"hom");
+	}
+};
+
+class CCC_OccBench : public IConsole_Command
+{
+public:
+	CCC_OccBench(LPCSTR N) : IConsole_Command(N)  { };
+	virtual void Execute(LPCSTR args) {
+		string_path	name;	name[0]=0;
+		u32			iterations	= 100;
+		sscanf		(args,"%s %d",name,&iterations);
+		RImplementation.HOM.Benchmark(xr_strlen(name)?name:"hom",_max(iterations,u32(1)));
+	}
+};
+
+class CCC_DsgraphCapture : public IConsole_Command
+{
+public:
+	CCC_DsgraphCapture(LPCSTR N) : IConsole_Command(N)  { bEmptyArgsHandled = TRUE; };
+	virtual void Execute(LPCSTR args) {
+		string_path	name;	name[0]=0;
+		sscanf		(args,"%s",name);
+		RImplementation.r_dsgraph_cull_capture(xr_strlen(name)?name:"dsgraph");
+	}
+};
+
+class CCC_DsgraphBench : public IConsole_Command
+{
+public:
+	CCC_DsgraphBench(LPCSTR N) : IConsole_Command(N)  { bEmptyArgsHandled = TRUE; };
+	virtual void Execute(LPCSTR args) {
+		string_path	name;	name[0]=0;
+		u32			iterations	= 100;
+		sscanf		(args,"%s %d",name,&iterations);
+		RImplementation.r_dsgraph_cull_benchmark(xr_strlen(name)?name:"dsgraph",_max(iterations,u32(1)));
+	}
+};
+
+class CCC_DsgraphQueueBench : public IConsole_Command
+{
+public:
+	CCC_DsgraphQueueBench(LPCSTR N) : IConsole_Command(N)  { bEmptyArgsHandled = TRUE; };
+	virtual void Execute(LPCSTR args) {
+		u32			items		= 20000, iterations = 100;
+		sscanf		(args,"%d %d",&items,&iterations);
+		RImplementation.r_dsgraph_queue_benchmark(_max(items,u32(1)),_max(iterations,u32(1)));
+	}
+};
+
+class CCC_DetailStreamBench : public IConsole_Command
+{
+public:
+	CCC_DetailStreamBench(LPCSTR N) : IConsole_Command(N)  { bEmptyArgsHandled = TRUE; };
+	virtual void Execute(LPCSTR args) {
+		u32			frames		= 600;
+		float		speed		= 30.f;
+		sscanf		(args,"%d %f",&frames,&speed);
+		if (0==RImplementation.Details)	{ Msg("! detail stream bench: no level loaded"); return; }
+		RImplementation.Details->stream_Benchmark(_max(frames,u32(2)),speed);
+	}
+};
+
 class CCC_ModelPoolStat : public IConsole_Command
 {
 public:
@@ -345,6 +427,40 @@ public:
 	}
 };
 
+class CCC_SkeletonBench : public IConsole_Command
+{
+public:
+	CCC_SkeletonBench(LPCSTR N) : IConsole_Command(N)  { };
+	virtual void Execute(LPCSTR args) {
+		string_path	name;	name[0]=0;
+		u32			count	= 64, blends = 4, frames = 100;
+		sscanf		(args,"%s %d %d %d",name,&count,&blends,&frames);
+		if (!xr_strlen(name))
+		{
+			Msg		("! usage: rs_skeleton_bench <model> [count] [blends] [frames]");
+			return;
+		}
+		CKinematicsAnimated::BatchBenchmark(name,_max(count,u32(1)),blends,_max(frames,u32(1)));
+	}
+};
+
+class CCC_SkeletonLODBench : public IConsole_Command
+{
+public:
+	CCC_SkeletonLODBench(LPCSTR N) : IConsole_Command(N)  { };
+	virtual void Execute(LPCSTR args) {
+		string_path	name;	name[0]=0;
+		u32			count	= 128, budget = 200, frames = 300;
+		sscanf		(args,"%s %d %d %d",name,&count,&budget,&frames);
+		if (!xr_strlen(name))
+		{
+			Msg		("! usage: rs_skeleton_lod_bench <model> [count] [budget_ms] [frames]");
+			return;
+		}
+		CKinematicsAnimated::LODBenchmark(name,_max(count,u32(1)),budget,_max(frames,u32(1)));
+	}
+};
+
 class	CCC_SSAO_Mode		: public CCC_Token
 {
 public:
@@ -653,6 +769,12 @@ void		xrRender_initconsole	()
 	CMD3(CCC_Preset,	"_preset",				&ps_Preset,	qpreset_token	);
 
 	CMD4(CCC_Integer,	"rs_skeleton_update",	&psSkeletonUpdate,	2,		128	);
+	CMD4(CCC_Integer,	"rs_skeleton_batch",	&psSkeletonBatch,	0,		1	);
+	CMD1(CCC_SkeletonBench,	"rs_skeleton_bench"	);
+	CMD4(CCC_Integer,	"rs_skeleton_lod_interval",	&psSkeletonLOD_Interval,	0,	500	);
+	CMD4(CCC_Float,		"rs_skeleton_lod_near",		&psSkeletonLOD_Near,		16.f,	2048.f	);
+	CMD4(CCC_Float,		"rs_skeleton_lod_far",		&psSkeletonLOD_Far,			1.f,	1024.f	);
+	CMD1(CCC_SkeletonLODBench,	"rs_skeleton_lod_bench"	);
 #ifdef	DEBUG
 	CMD1(CCC_DumpResources,		"dump_resources");
 #endif	//	 DEBUG
@@ -682,10 +804,23 @@ void		xrRender_initconsole	()
 	Fvector	tw_min,tw_max;
 	
 	CMD4(CCC_Float,		"r__geometry_lod",		&ps_r__LOD,					0.1f,	1.2f		);
+
+	CMD4(CCC_Integer,	"r__occ_tiled",			&ps_r__occ_tiled,			0,		1		);
+	CMD4(CCC_Integer,	"r__occ_width",			&ps_r__occ_width,			64,		1024	);
+	CMD4(CCC_Integer,	"r__occ_height",		&ps_r__occ_height,			64,		512		);
+	CMD1(CCC_OccRecord,	"r__occ_record"			);
+	CMD1(CCC_OccBench,	"r__occ_bench"			);
+	CMD4(CCC_Integer,	"r__dsgraph_mt",		&ps_r__dsgraph_mt,			0,		1		);
+	CMD1(CCC_DsgraphCapture,"r__dsgraph_capture"	);
+	CMD1(CCC_DsgraphBench,	"r__dsgraph_bench"		);
+	CMD4(CCC_Integer,	"r__dsgraph_queue",		&ps_r__dsgraph_queue,		0,		1		);
+	CMD1(CCC_DsgraphQueueBench,"r__dsgraph_queue_bench");
 //.	CMD4(CCC_Float,		"r__geometry_lod_pow",	&ps_r__LOD_Power,			0,		2		);
 
 //.	CMD4(CCC_Float,		"r__detail_density",	&ps_r__Detail_density,		.05f,	0.99f	);
 	CMD4(CCC_Float,		"r__detail_density",	&ps_r__Detail_density,		.2f,	0.6f	);
+	CMD4(CCC_Integer,	"r__detail_stream",		&ps_r__detail_stream,		0,		1		);
+	CMD1(CCC_DetailStreamBench,"r__detail_stream_bench");
 
 #ifdef DEBUG
 	CMD4(CCC_Float,		"r__detail_l_ambient",	&ps_r__Detail_l_ambient,	.5f,	.95f	);
@@ -50,6 +50,13 @@ extern ECORE_API	float		ps_r__ssaDONTSORT	;
 extern ECORE_API	float		ps_r__ssaHZBvsTEX	;
 extern ECORE_API	int			ps_r__tf_Anisotropic;
 
+extern ECORE_API	int			ps_r__occ_tiled		;
+extern ECORE_API	int			ps_r__occ_width		;
+extern ECORE_API	int			ps_r__occ_height	;
+extern ECORE_API	int			ps_r__dsgraph_mt	;
+extern ECORE_API	int			ps_r__dsgraph_queue	;
+extern ECORE_API	int			ps_r__detail_stream	;
+
 // R1
 extern ECORE_API	float		ps_r1_ssaLOD_A;
 extern ECORE_API	float		ps_r1_ssaLOD_B;
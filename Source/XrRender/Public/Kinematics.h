@@ -70,6 +70,11 @@ virtual	const IBoneData&		_BCL	GetBoneData(u16 bone_id) const = 0;
 	// Main functionality
 	virtual void						CalculateBones(BOOL bForceExact	= FALSE) = 0; // Recalculate skeleton
 	virtual void						CalculateBones_Invalidate() = 0;
+	// Update budget of a model nobody renders: its bones are evaluated at most once per 'interval' ms
+	// and only the ones needed by the collision shapes, the bone callbacks and the required bones
+	virtual void						LL_SetUpdateBudget(u32 interval) = 0;	// 0 - full rate
+	virtual u32							LL_GetUpdateBudget() = 0;
+	virtual void						LL_SetBoneRequired(u16 bone_id, BOOL val) = 0;
 	virtual void						Callback(UpdateCallback C, void* Param) = 0;
 
 	//	Callback: data manipulation
@@ -9,7 +9,7 @@
 #include "../../xrEngine/CustomHUD.h"
 #include "../../xrEngine/xr_object.h"
 #include "../../xrEngine/fmesh.h"
-#include "../Private/SkeletonCustom.h"
+#include "../Private/SkeletonAnimated.h"
 #include "../Private/lighttrack.h"
 #include "../Private/dxRenderDeviceRender.h"
 #include "../Private/dxWallMarkArray.h"
@@ -350,6 +350,9 @@ void CRender::Calculate				()
 {
 	Device->Statistic->RenderCALC.Begin();
 
+	// Bones of the skeletons seen the last frame, ahead of the traversal
+	CKinematicsAnimated::BatchCalculate	();
+
 	// Transfer to global space to avoid deep pointer access
 	IRender_Target* T				=	getTarget	();
 	float	fov_factor				=	_sqr		(90.f / Device->fFOV);
@@ -564,6 +567,7 @@ void	CRender::rmNormal	()
 extern u32 g_r;
 void	CRender::Render		()
 {
+	TRACE_ZONE				("Render::Render");
 	if( m_bFirstFrameAfterReset )
 	{
 		m_bFirstFrameAfterReset = false;
@@ -609,6 +613,7 @@ void	CRender::Render		()
 #ifdef DEBUG
 	for (int _priority=0; _priority<2; ++_priority)
 	{
+		R_ASSERT( mapNormalQueue[_priority].size() == 0);
 		for ( u32 iPass = 0; iPass<SHADER_PASSES_MAX; ++iPass)
 		{
 			R_ASSERT( mapNormalPasses[_priority][iPass].size() == 0);
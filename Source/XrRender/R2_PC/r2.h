@@ -160,6 +160,7 @@ public:
 	void							render_sun_near				();
 	void							render_sun_filtered			();
 	void							render_menu					();
+	void							calc_sun_cascade			(u32 cascade_ind);
 	void							render_sun_cascade			(u32 cascade_ind);
 	void							init_cacades				();
 	void							render_sun_cascades			();
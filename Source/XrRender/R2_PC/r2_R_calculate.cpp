@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include "../../xrEngine/customhud.h"
+#include "../Private/SkeletonAnimated.h"
 
 float				g_fSCREEN		;
 
@@ -13,6 +14,9 @@ extern float		r_ssaGLOD_start,	r_ssaGLOD_end;
 
 void CRender::Calculate		()
 {
+	// Bones of the skeletons seen the last frame, ahead of the traversal
+	CKinematicsAnimated::BatchCalculate	();
+
 	// Transfer to global space to avoid deep pointer access
 	IRender_Target* T				=	getTarget	();
 	float	fov_factor				=	_sqr		(90.f / Device->fFOV);
@@ -187,6 +187,7 @@ void CRender::render_menu	()
 extern u32 g_r;
 void CRender::Render		()
 {
+	TRACE_ZONE				("Render::Render");
 	g_r						= 1;
 	VERIFY					(0==mapDistort.size());
 
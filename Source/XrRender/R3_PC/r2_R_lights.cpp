@@ -76,6 +76,19 @@ void	CRender::render_lights	(light_Package& LP)
 	//	if (left_some_lights_that_doesn't cast shadows)
 	//		accumulate them
 	HOM.Disable	();
+
+	// static geometry of all the shadowed spots is culled at once on the worker threads,
+	// the lights are popped from the back so the view of a light is its index in v_shadowed
+	r_dsgraph_cull_reset	();
+	BOOL	culled_ahead	= ps_r__dsgraph_mt;
+	if (culled_ahead)		{
+		for (u32 it=0; it<LP.v_shadowed.size(); it++)	{
+			light*	L		= LP.v_shadowed[it];
+			r_dsgraph_cull_add	(L->spatial.sector, L->X.S.combine, L->position);
+		}
+		r_dsgraph_cull_views	(TRUE);
+	}
+
 	while		(LP.v_shadowed.size() )
 	{
 		// if (has_spot_shadowed)
@@ -101,9 +114,10 @@ void	CRender::render_lights	(light_Package& LP)
 			else							r_pmask	(true,false	);
 			L->svis.begin							();
          PIX_EVENT(SHADOWED_LIGHTS_RENDER_SUBSPACE);
-			r_dsgraph_render_subspace				(L->spatial.sector, L->X.S.combine, L->position, TRUE);
-			bool	bNormal							= mapNormalPasses[0][0].size() || mapMatrixPasses[0][0].size();
-			bool	bSpecial						= mapNormalPasses[1][0].size() || mapMatrixPasses[1][0].size() || mapSorted.size();
+			if (culled_ahead)						r_dsgraph_render_subspace	(source.size(), TRUE);
+			else									r_dsgraph_render_subspace	(L->spatial.sector, L->X.S.combine, L->position, TRUE);
+			bool	bNormal							= mapNormalPasses[0][0].size() || mapNormalQueue[0].size() || mapMatrixPasses[0][0].size();
+			bool	bSpecial						= mapNormalPasses[1][0].size() || mapNormalQueue[1].size() || mapMatrixPasses[1][0].size() || mapSorted.size();
 			if ( bNormal || bSpecial)	{
 				stats.s_merged						++;
 				L_spot_s.push_back					(L);
@@ -213,7 +213,7 @@ void CRender::render_rain()
 
 	// Begin SMAP-render
 	{
-		bool	bSpecialFull					= mapNormalPasses[1][0].size() || mapMatrixPasses[1][0].size() || mapSorted.size();
+		bool	bSpecialFull					= mapNormalPasses[1][0].size() || mapNormalQueue[1].size() || mapMatrixPasses[1][0].size() || mapSorted.size();
 		VERIFY									(!bSpecialFull);
 		HOM.Disable								();
 		phase									= PHASE_SMAP;
@@ -230,8 +230,8 @@ void CRender::render_rain()
 	// Render shadow-map
 	//. !!! We should clip based on shrinked frustum (again)
 	{
-		bool	bNormal							= mapNormalPasses[0][0].size() || mapMatrixPasses[0][0].size();
-		bool	bSpecial						= mapNormalPasses[1][0].size() || mapMatrixPasses[1][0].size() || mapSorted.size();
+		bool	bNormal							= mapNormalPasses[0][0].size() || mapNormalQueue[0].size() || mapMatrixPasses[0][0].size();
+		bool	bSpecial						= mapNormalPasses[1][0].size() || mapNormalQueue[1].size() || mapMatrixPasses[1][0].size() || mapSorted.size();
 		if ( bNormal || bSpecial)	{
 			Target->phase_smap_direct			(&RainLight	, SE_SUN_RAIN_SMAP	);
 			RCache.set_xform_world				(Fidentity					);
@@ -727,8 +727,8 @@ void CRender::render_sun				()
 	// Render shadow-map
 	//. !!! We should clip based on shrinked frustum (again)
 	{
-		bool	bNormal							= mapNormalPasses[0][0].size() || mapMatrixPasses[0][0].size();
-		bool	bSpecial						= mapNormalPasses[1][0].size() || mapMatrixPasses[1][0].size() || mapSorted.size();
+		bool	bNormal							= mapNormalPasses[0][0].size() || mapNormalQueue[0].size() || mapMatrixPasses[0][0].size();
+		bool	bSpecial						= mapNormalPasses[1][0].size() || mapNormalQueue[1].size() || mapMatrixPasses[1][0].size() || mapSorted.size();
 		if ( bNormal || bSpecial)	{
 			Target->phase_smap_direct			(fuckingsun, SE_SUN_FAR		);
 			RCache.set_xform_world				(Fidentity					);
@@ -937,7 +937,7 @@ void CRender::render_sun_near	()
 
 	// Begin SMAP-render
 	{
-		bool	bSpecialFull					= mapNormalPasses[1][0].size() || mapMatrixPasses[1][0].size() || mapSorted.size();
+		bool	bSpecialFull					= mapNormalPasses[1][0].size() || mapNormalQueue[1].size() || mapMatrixPasses[1][0].size() || mapSorted.size();
 		VERIFY									(!bSpecialFull);
 		HOM.Disable								();
 		phase									= PHASE_SMAP;
@@ -955,8 +955,8 @@ void CRender::render_sun_near	()
 	// Render shadow-map
 	//. !!! We should clip based on shrinked frustum (again)
 	{
-		bool	bNormal							= mapNormalPasses[0][0].size() || mapMatrixPasses[0][0].size();
-		bool	bSpecial						= mapNormalPasses[1][0].size() || mapMatrixPasses[1][0].size() || mapSorted.size();
+		bool	bNormal							= mapNormalPasses[0][0].size() || mapNormalQueue[0].size() || mapMatrixPasses[0][0].size();
+		bool	bSpecial						= mapNormalPasses[1][0].size() || mapNormalQueue[1].size() || mapMatrixPasses[1][0].size() || mapSorted.size();
 		if ( bNormal || bSpecial)	{
 			Target->phase_smap_direct			(fuckingsun	, SE_SUN_NEAR	);
 			RCache.set_xform_world				(Fidentity					);
@@ -1039,6 +1039,21 @@ void CRender::render_sun_cascades ( )
 	if ( b_need_to_render_sunshafts )
 		m_sun_cascades[m_sun_cascades.size()-1].reset_chain = true;
 
+	for( u32 i = 0; i < m_sun_cascades.size(); ++i )
+		calc_sun_cascade ( i );
+
+	// static geometry of all the cascades is culled at once on the worker threads
+	r_dsgraph_cull_reset	();
+	if ( ps_r__dsgraph_mt )
+	{
+		for( u32 i = 0; i < m_sun_cascades.size(); ++i )
+		{
+			sun::cascade& cascade	= m_sun_cascades[i];
+			cascade.cull_view		= r_dsgraph_cull_add( cascade.cull_sector, &cascade.cull_frustum, cascade.xform, cascade.cull_COP );
+		}
+		r_dsgraph_cull_views	( TRUE );
+	}
+
 	for( u32 i = 0; i < m_sun_cascades.size(); ++i )
 		render_sun_cascade ( i );
 
@@ -1046,7 +1061,7 @@ void CRender::render_sun_cascades ( )
 		m_sun_cascades[m_sun_cascades.size()-1].reset_chain = last_cascade_chain_mode;
 }
 
-void CRender::render_sun_cascade ( u32 cascade_ind )
+void CRender::calc_sun_cascade ( u32 cascade_ind )
 {
 	light*			fuckingsun			= (light*)Lights.sun_adapted._get()	;
 
@@ -1269,9 +1284,22 @@ void CRender::render_sun_cascade ( u32 cascade_ind )
 		FPU::m24r			();
 	}
 
+	sun::cascade&	cascade			= m_sun_cascades[cascade_ind];
+	cascade.cull_frustum			= cull_frustum;
+	cascade.cull_COP				= cull_COP;
+	cascade.cull_sector				= cull_sector;
+	cascade.cull_view				= u32(-1);
+}
+
+void CRender::render_sun_cascade ( u32 cascade_ind )
+{
+	light*			fuckingsun			= (light*)Lights.sun_adapted._get()	;
+	sun::cascade&	cascade				= m_sun_cascades[cascade_ind];
+	Fmatrix&		cull_xform			= cascade.xform;
+
 	// Begin SMAP-render
 	{
-		bool	bSpecialFull					= mapNormalPasses[1][0].size() || mapMatrixPasses[1][0].size() || mapSorted.size();
+		bool	bSpecialFull					= mapNormalPasses[1][0].size() || mapNormalQueue[1].size() || mapMatrixPasses[1][0].size() || mapSorted.size();
 		VERIFY									(!bSpecialFull);
 		HOM.Disable								();
 		phase									= PHASE_SMAP;
@@ -1281,7 +1309,8 @@ void CRender::render_sun_cascade ( u32 cascade_ind )
 	}
 
 	// Fill the database
-	r_dsgraph_render_subspace				(cull_sector, &cull_frustum, cull_xform, cull_COP, TRUE);
+	if (cascade.cull_view!=u32(-1))		r_dsgraph_render_subspace	(cascade.cull_view, TRUE);
+	else								r_dsgraph_render_subspace	(cascade.cull_sector, &cascade.cull_frustum, cull_xform, cascade.cull_COP, TRUE);
 
 	// Finalize & Cleanup
 	fuckingsun->X.D.combine					= cull_xform;	//*((Fmatrix*)&m_LightViewProj);
@@ -1289,8 +1318,8 @@ void CRender::render_sun_cascade ( u32 cascade_ind )
 	// Render shadow-map
 	//. !!! We should clip based on shrinked frustum (again)
 	{
-		bool	bNormal							= mapNormalPasses[0][0].size() || mapMatrixPasses[0][0].size();
-		bool	bSpecial						= mapNormalPasses[1][0].size() || mapMatrixPasses[1][0].size() || mapSorted.size();
+		bool	bNormal							= mapNormalPasses[0][0].size() || mapNormalQueue[0].size() || mapMatrixPasses[0][0].size();
+		bool	bSpecial						= mapNormalPasses[1][0].size() || mapNormalQueue[1].size() || mapMatrixPasses[1][0].size() || mapSorted.size();
 		if ( bNormal || bSpecial)	{
 			Target->phase_smap_direct			(fuckingsun	, SE_SUN_FAR	);
 			RCache.set_xform_world				(Fidentity					);
@@ -194,6 +194,7 @@ public:
 	void							render_menu					();
 	void							render_rain					();
 
+	void							calc_sun_cascade			(u32 cascade_ind);
 	void							render_sun_cascade			(u32 cascade_ind);
 	void							init_cacades				();
 	void							render_sun_cascades			();
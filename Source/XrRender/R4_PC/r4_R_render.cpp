@@ -194,6 +194,7 @@ extern u32 g_r;
 void CRender::Render		()
 {
 	PIX_EVENT(CRender_Render);
+	TRACE_ZONE				("Render::Render");
 
 	g_r						= 1;
 	VERIFY					(0==mapDistort.size());
@@ -137,6 +137,10 @@ public:
 	// Main functionality
 	virtual void CalculateBones(BOOL bForceExact = FALSE); // Recalculate skeleton
 	virtual void CalculateBones_Invalidate();
+	// no animation LOD here, the bones are always evaluated in full
+	virtual void LL_SetUpdateBudget(u32 interval) {}
+	virtual u32 LL_GetUpdateBudget() { return 0; }
+	virtual void LL_SetBoneRequired(u16 bone_id, BOOL val) {}
 	virtual void Callback(UpdateCallback C, void* Param)
 	{
 		Update_Callback = C;
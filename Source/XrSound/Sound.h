@@ -36,6 +36,7 @@ XRSOUND_API extern float			psSoundOcclusionScale	;
 XRSOUND_API extern Flags32			psSoundFlags			;
 XRSOUND_API extern int				psSoundTargets			;
 XRSOUND_API extern int				psSoundCacheSizeMB		;
+XRSOUND_API extern int				psSoundPrefetchLines	;	//!< cache lines decoded ahead of the playback cursor, 0 - decode on demand only
 XRSOUND_API extern xr_token*		snd_devices_token		;
 XRSOUND_API extern u32				snd_device_id			;
 
@@ -206,6 +207,12 @@ public:
 	u32						_simulated;
 	u32						_cache_hits;
 	u32						_cache_misses;
+	u32						_cache_prefetched;
+	u32						_decode_stolen;
+	u32						_decode_waits;
+	u32						_decode_wait_us;
+	u32						_decode_latency_avg;	// us, queue -> ready
+	u32						_decode_latency_max;	// us
 	u32						_events;
 };
 
@@ -12,6 +12,7 @@ CSoundRender_Cache::CSoundRender_Cache	()
 	_total		= 0;
 	_line		= 0;
 	_count		= 0;
+	stats_clear	();
 }
 
 CSoundRender_Cache::~CSoundRender_Cache	()
@@ -62,7 +63,7 @@ BOOL	CSoundRender_Cache::request		(cache_cat& cat, u32 id)
 
 	// 2. purge oldest item + move it to top
 	_stat_miss		++;
-	move2top	(c_end);
+	move2top	(evict(FALSE));
 	if (c_begin->loopback)	{
 		*c_begin->loopback		= CAT_FREE;
 		c_begin->loopback		= NULL;
@@ -76,6 +77,60 @@ BOOL	CSoundRender_Cache::request		(cache_cat& cat, u32 id)
 	return			TRUE;
 }
 
+cache_line*	CSoundRender_Cache::prefetch	(cache_cat& cat, u32 id)
+{
+	id				%= cat.size;
+	u16&	cptr	= cat.table[id];
+	if (CAT_FREE != cptr)	{
+		// already cached (or queued), keep it away from the LRU tail until played
+		move2top		(c_storage + cptr);
+		return			NULL;
+	}
+
+	// every line is pending decode - skip, the line is decoded on demand
+	cache_line*		L	= evict(TRUE);
+	if (!L)			return	NULL;
+
+	_stat_prefetch	++;
+	move2top	(L);
+	if (c_begin->loopback)	{
+		*c_begin->loopback		= CAT_FREE;
+		c_begin->loopback		= NULL;
+	}
+
+	cptr				= c_begin->id;
+	c_begin->loopback	= &cptr;
+	c_begin->ticket		++;
+	c_begin->state		= line_queued;
+	return			c_begin;
+}
+
+void	CSoundRender_Cache::discard		(cache_line* L)
+{
+	if (L->loopback)	{
+		*L->loopback		= CAT_FREE;
+		L->loopback			= NULL;
+	}
+	L->state			= line_ready;
+}
+
+cache_line*	CSoundRender_Cache::evict		(BOOL bPrefetch)
+{
+	// lines waiting for the decoder can't be reused, their memory is being written
+	cache_line*		L	= c_end;
+	while (L && (line_ready!=L->state))
+		L				= L->prev;
+	if (bPrefetch)	{
+		// the last ready line is left to the demand requests, so they always find one
+		cache_line*	spare	= L ? L->prev : NULL;
+		while (spare && (line_ready!=spare->state))
+			spare		= spare->prev;
+		return			spare ? L : NULL;
+	}
+	R_ASSERT2			(L,"sound cache is too small for the prefetch depth");
+	return				L;
+}
+
 void	CSoundRender_Cache::initialize	(u32 _total_kb_approx, u32 bytes_per_line)
 {
 	// use twice the requisted memory (to avoid bad configs)
@@ -120,6 +175,8 @@ void	CSoundRender_Cache::format		()
 		L->data				= data + it*_line;
 		L->loopback			= NULL;
 		L->id				= u16	(it);
+		L->state			= line_ready;
+		L->ticket			= 0;
 	}
 
 	// start-end
@@ -23,6 +23,14 @@ struct	cache_line						// internal, LRU queue
 	void*					data;		// pre-formatted
 	u16*					loopback;	// dual-connectivity
 	u16						id;			// need this for dual-connectivity
+	volatile LONG			state;		// line_ready / line_queued / line_decoding, see decoder
+	u32						ticket;		// bumped by every prefetch, tells a stale decoder job from the current one
+};
+enum
+{
+	line_ready				= 0,		// data is valid (or line is unused)
+	line_queued,						// waits in the decoder queue
+	line_decoding,						// is being decoded right now
 };
 //////////////////////////////////////////////////////////////////////////
 struct	cache_cat						// cache allocation table
@@ -44,15 +52,20 @@ class	CSoundRender_Cache
 public:
 	u32						_stat_hit;
 	u32						_stat_miss;
+	u32						_stat_prefetch;
 private:
 	void					move2top	(cache_line* line);					// move one line to TOP-priority
+	cache_line*				evict		(BOOL bPrefetch);					// oldest line which isn't pending decode, prefetch leaves the last one
 	void					disconnect	();									// disconnect from CATs
 	void					format		();									// format structure (like filesystem)
 public:
 	BOOL					request		(cache_cat& cat, u32 id);			// TRUE=need to fill, FALSE=cached info avail
+	cache_line*				prefetch	(cache_cat& cat, u32 id);			// line to be filled in background, NULL=already cached or no free line
+	void					discard		(cache_line* line);					// forget line contents (cancelled fill)
 	void					purge		();									// discard all contents of cache
 
 	void*					get_dataptr	(cache_cat& cat, u32 id)			{ id%=cat.size; return c_storage[cat.table[id]].data;			} //.
+	cache_line*				get_line	(cache_cat& cat, u32 id)			{ id%=cat.size; return c_storage + cat.table[id];				}
 	u32						get_linesize()									{ return _line;													}
 
 	void					cat_create	(cache_cat& cat, u32 bytes);
@@ -65,6 +78,7 @@ public:
 	{
 		_stat_hit			= 0;
 		_stat_miss			= 0;
+		_stat_prefetch		= 0;
 	}
 
 	CSoundRender_Cache		();
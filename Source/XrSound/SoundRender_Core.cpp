@@ -21,6 +21,7 @@ float	psSoundVFactor			= 1.0f;
 
 float	psSoundVMusic			= 1.f;
 int		psSoundCacheSizeMB		= 32;
+int		psSoundPrefetchLines	= 4;
 
 CSoundRender_Core*				SoundRender = 0;
 CSound_manager_interface*		Sound		= 0;
@@ -73,6 +74,7 @@ void CSoundRender_Core::_initialize(int stage)
 	// Cache
 	cache_bytes_per_line		= (sdef_target_block/8)*276400/1000;
     cache.initialize			(psSoundCacheSizeMB*1024,cache_bytes_per_line);
+	decoder.initialize			();
 
     bReady						= TRUE;
 }
@@ -81,6 +83,7 @@ extern xr_vector<u8> g_target_temp_data;
 void CSoundRender_Core::_clear	()
 {
     bReady						= FALSE;
+	decoder.destroy				();
 	cache.destroy				();
 	env_unload					();
 
@@ -141,6 +144,7 @@ void CSoundRender_Core::env_unload	()
 
 void CSoundRender_Core::_restart		()
 {
+	decoder.flush				();
 	cache.destroy				();
 	cache.initialize			(psSoundCacheSizeMB*1024,cache_bytes_per_line);
 	env_apply					();
@@ -558,6 +562,7 @@ void						CSoundRender_Core::refresh_sources()
 {
 	for (u32 eit=0; eit<s_emitters.size(); eit++)
     	s_emitters[eit]->stop(FALSE);
+	decoder.flush		();
 	for (u32 sit=0; sit<s_sources.size(); sit++){
     	CSoundRender_Source* s = s_sources[sit];
     	s->unload		();
@@ -5,6 +5,7 @@
 #include "SoundRender.h"
 #include "SoundRender_Environment.h"
 #include "SoundRender_Cache.h"
+#include "SoundRender_Decoder.h"
 #include "soundrender_environment.h"
 
 class CSoundRender_Core					: public CSound_manager_interface
@@ -56,6 +57,7 @@ public:
 	// Cache
 	CSoundRender_Cache					cache;
 	u32									cache_bytes_per_line;
+	CSoundRender_Decoder				decoder;
 protected:
 	virtual void						i_eax_set				(const GUID* guid, u32 prop, void* val, u32 sz)=0;
 	virtual void						i_eax_get				(const GUID* guid, u32 prop, void* val, u32 sz)=0;
@@ -152,8 +152,15 @@ void	CSoundRender_Core::statistic			(CSound_stats*  dest, CSound_stats_ext*  ext
 		dest->_simulated	= s_emitters.size();
 		dest->_cache_hits	= cache._stat_hit;
 		dest->_cache_misses	= cache._stat_miss;
+		dest->_cache_prefetched		= cache._stat_prefetch;
+		dest->_decode_stolen		= decoder._stat_stolen;
+		dest->_decode_waits			= decoder._stat_waits;
+		dest->_decode_wait_us		= decoder._stat_wait_us;
+		dest->_decode_latency_avg	= decoder._stat_decoded ? decoder._stat_latency_sum/decoder._stat_decoded : 0;
+		dest->_decode_latency_max	= decoder._stat_latency_max;
 		dest->_events		= g_saved_event_count;
 		cache.stats_clear	();
+		decoder.stats_clear	();
 	}
 	if (ext){
 		for (u32 it=0; it<s_emitters.size(); it++)
@@ -0,0 +1,247 @@
+#include "stdafx.h"
+#pragma hdrstop
+
+#include "soundrender_core.h"
+#include "soundrender_source.h"
+#include "soundrender_decoder.h"
+
+extern int		ov_seek_func	(void *datasource, s64 offset, int whence);
+extern size_t	ov_read_func	(void *ptr, size_t size, size_t nmemb, void *datasource);
+extern int		ov_close_func	(void *datasource);
+extern long		ov_tell_func	(void *datasource);
+
+IC u32	ticks2us	(u64 ticks)	{ return u32(ticks*u64(1000000)/CPU::qpc_freq); }
+
+CSoundRender_Decoder::CSoundRender_Decoder	()
+#ifdef PROFILE_CRITICAL_SECTIONS
+	:lock			(MUTEX_PROFILE_ID(CSoundRender_Decoder::lock))
+#endif // PROFILE_CRITICAL_SECTIONS
+{
+	ZeroMemory		(slots,sizeof(slots));
+	stamp			= 0;
+	ev_wakeup		= NULL;
+	ev_exited		= NULL;
+	shutdown		= FALSE;
+	running			= FALSE;
+	stats_clear		();
+}
+
+CSoundRender_Decoder::~CSoundRender_Decoder	()
+{
+	VERIFY			(!running);
+}
+
+void	CSoundRender_Decoder::initialize	()
+{
+	if (running)	return;
+
+	shutdown		= FALSE;
+	ev_wakeup		= CreateEvent	(NULL,FALSE,FALSE,NULL);
+	ev_exited		= CreateEvent	(NULL,TRUE,FALSE,NULL);
+	thread_spawn	(worker,"X-RAY Sound decoder",0,this);
+	running			= TRUE;
+}
+
+void	CSoundRender_Decoder::destroy		()
+{
+	if (!running)	return;
+
+	flush			();
+	shutdown		= TRUE;
+	SetEvent		(ev_wakeup);
+	WaitForSingleObject	(ev_exited,INFINITE);
+	CloseHandle		(ev_wakeup);
+	CloseHandle		(ev_exited);
+	ev_wakeup		= NULL;
+	ev_exited		= NULL;
+	running			= FALSE;
+}
+
+void	CSoundRender_Decoder::worker		(void* params)
+{
+	((CSoundRender_Decoder*)params)->process	();
+}
+
+void	CSoundRender_Decoder::process		()
+{
+	while (!shutdown)
+	{
+		WaitForSingleObject	(ev_wakeup,INFINITE);
+		for (;;)
+		{
+			lock.Enter		();
+			if (jobs.empty())	{
+				lock.Leave	();
+				break;
+			}
+			decode_job	J	= jobs.front();
+			jobs.pop_front	();
+			lock.Leave		();
+
+			// the sound thread may have taken the line over while it was queued, or even
+			// evicted and queued it again for another sound - then the job of the new
+			// owner is behind this one. The ticket is stable once the line is decoding
+			BOOL	decoded	= line_queued==InterlockedCompareExchange(&J.line->state,line_decoding,line_queued);
+			if (decoded && (J.line->ticket!=J.ticket))	{
+				InterlockedExchange				(&J.line->state,line_queued);
+				decoded		= FALSE;
+			}
+			if (decoded)	{
+				J.source->decompress			(J.id,&J.slot->ovf,J.line->data);
+				InterlockedExchange				(&J.line->state,line_ready);
+			}
+
+			u32	latency		= ticks2us(CPU::QPC()-J.queued);
+			lock.Enter		();
+			J.slot->jobs	--;
+			if (decoded)	{
+				_stat_decoded		++;
+				_stat_latency_sum	+= latency;
+				_stat_latency_max	= _max(_stat_latency_max,latency);
+			}
+			lock.Leave		();
+		}
+	}
+	SetEvent		(ev_exited);
+}
+
+void	CSoundRender_Decoder::slot_close	(decode_slot& slot)
+{
+	VERIFY			(0==slot.jobs);
+	if (slot.wave)	{
+		ov_clear	(&slot.ovf);
+		FS.r_close	(slot.wave);
+	}
+	slot.source		= NULL;
+	slot.used		= 0;
+}
+
+CSoundRender_Decoder::decode_slot*	CSoundRender_Decoder::acquire	(CSoundRender_Source* S)
+{
+	stamp			++;
+
+	// already opened
+	for (u32 it=0; it<slot_count; it++)
+		if (slots[it].source==S)	{
+			slots[it].used	= stamp;
+			return			slots+it;
+		}
+
+	// reuse the least recently used idle one
+	decode_slot*	best	= NULL;
+	{
+		xrCriticalSection::raii	guard(&lock);
+		for (u32 it=0; it<slot_count; it++)	{
+			decode_slot&	slot	= slots[it];
+			if (slot.jobs)			continue;
+			if (!best || slot.used<best->used)	best = &slot;
+		}
+	}
+	if (!best)		return NULL;
+
+	slot_close		(*best);
+	ov_callbacks ovc= {ov_read_func,ov_seek_func,ov_close_func,ov_tell_func};
+	best->wave		= FS.r_open		(S->pname.c_str());
+	R_ASSERT3		(best->wave&&best->wave->length(),"Can't open wave file:",S->pname.c_str());
+	ov_open_callbacks(best->wave,&best->ovf,NULL,0,ovc);
+	best->source	= S;
+	best->used		= stamp;
+	return			best;
+}
+
+void	CSoundRender_Decoder::prefetch		(CSoundRender_Source* S, u32 id)
+{
+	if (!running)	return;
+
+	// don't hold a decoder open for lines already in cache
+	cache_cat&		cat	= S->CAT;
+	if (CAT_FREE!=cat.table[id%cat.size])	{
+		SoundRender->cache.prefetch	(cat,id);
+		return;
+	}
+
+	decode_slot*	slot	= acquire(S);
+	if (!slot)		return;
+
+	cache_line*		L		= SoundRender->cache.prefetch(cat,id);
+	if (!L)			return;
+
+	decode_job		J;
+	J.source		= S;
+	J.slot			= slot;
+	J.line			= L;
+	J.ticket		= L->ticket;
+	J.id			= id%cat.size;
+	J.queued		= CPU::QPC();
+
+	lock.Enter		();
+	slot->jobs		++;
+	jobs.push_back	(J);
+	lock.Leave		();
+	SetEvent		(ev_wakeup);
+}
+
+void	CSoundRender_Decoder::fetch			(CSoundRender_Source* S, u32 id, OggVorbis_File* ovf)
+{
+	CSoundRender_Cache&	cache	= SoundRender->cache;
+	if (cache.request(S->CAT,id))	{
+		// demand miss, nobody has queued it
+		S->decompress		(id,ovf);
+		return;
+	}
+
+	cache_line*		L		= cache.get_line(S->CAT,id);
+	if (line_ready==L->state)		return;
+
+	if (line_queued==InterlockedCompareExchange(&L->state,line_decoding,line_queued))	{
+		// the worker hasn't reached it yet - decoding here is faster than waiting for the queue
+		S->decompress		(id,ovf,L->data);
+		InterlockedExchange	(&L->state,line_ready);
+		_stat_stolen		++;
+		return;
+	}
+
+	// the worker is decoding it right now
+	u64				start	= CPU::QPC();
+	while (line_ready!=L->state)
+		SwitchToThread		();
+	_stat_waits		++;
+	_stat_wait_us	+= ticks2us(CPU::QPC()-start);
+}
+
+void	CSoundRender_Decoder::flush			()
+{
+	if (!running)	return;
+
+	// cancel everything queued, the worker finishes the line it holds
+	lock.Enter		();
+	for (xr_deque<decode_job>::iterator it=jobs.begin(); it!=jobs.end(); it++)	{
+		if (line_queued==InterlockedCompareExchange(&it->line->state,line_ready,line_queued))
+			SoundRender->cache.discard	(it->line);
+		it->slot->jobs	--;
+	}
+	jobs.clear		();
+	lock.Leave		();
+
+	for (u32 it=0; it<slot_count; it++)	{
+		for (;;)	{
+			lock.Enter	();
+			u32	pending	= slots[it].jobs;
+			lock.Leave	();
+			if (!pending)	break;
+			SwitchToThread	();
+		}
+		slot_close	(slots[it]);
+	}
+}
+
+void	CSoundRender_Decoder::stats_clear	()
+{
+	xrCriticalSection::raii	guard(&lock);
+	_stat_decoded		= 0;
+	_stat_stolen		= 0;
+	_stat_waits			= 0;
+	_stat_wait_us		= 0;
+	_stat_latency_sum	= 0;
+	_stat_latency_max	= 0;
+}
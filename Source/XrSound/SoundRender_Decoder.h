@@ -0,0 +1,69 @@
+#ifndef SoundRender_DecoderH
+#define SoundRender_DecoderH
+#pragma once
+
+#include "soundrender_cache.h"
+
+class CSoundRender_Source;
+
+//////////////////////////////////////////////////////////////////////////
+// background decoder: emitters queue the cache lines they are about to play,
+// the worker thread decodes them into the cache ahead of the playback cursor.
+// Cache and queue are owned by the sound thread, worker only writes line data
+// and flips line state (line_queued -> line_decoding -> line_ready, or back to
+// line_queued if the line was prefetched again for another sound)
+class	CSoundRender_Decoder
+{
+	enum	{ slot_count = 16 };
+	struct	decode_slot						// per-source decoder, opened on the sound thread, read by the worker
+	{
+		CSoundRender_Source*	source;
+		IReader*				wave;
+		OggVorbis_File			ovf;
+		u32						jobs;		// queued + in progress, slot can't be reused while non-zero
+		u32						used;		// LRU stamp
+	};
+	struct	decode_job
+	{
+		CSoundRender_Source*	source;
+		decode_slot*			slot;
+		cache_line*				line;
+		u32						ticket;		// line ticket at queue time, the line may be reused before the job runs
+		u32						id;
+		u64						queued;		// CPU::QPC
+	};
+
+	xrCriticalSection			lock;		// jobs, slot::jobs, worker stats
+	xr_deque<decode_job>		jobs;
+	decode_slot					slots		[slot_count];
+	u32							stamp;
+	HANDLE						ev_wakeup;
+	HANDLE						ev_exited;
+	volatile BOOL				shutdown;
+	BOOL						running;
+public:
+	u32							_stat_decoded;		// lines decoded by the worker
+	u32							_stat_stolen;		// queued lines the sound thread decoded itself
+	u32							_stat_waits;		// sound thread waited for the worker
+	u32							_stat_wait_us;
+	u32							_stat_latency_sum;	// queue -> ready, us
+	u32							_stat_latency_max;
+private:
+	static void					worker		(void* params);
+	void						process		();
+	decode_slot*				acquire		(CSoundRender_Source* S);
+	void						slot_close	(decode_slot& slot);
+public:
+	void						prefetch	(CSoundRender_Source* S, u32 id);					// queue line for background decode
+	void						fetch		(CSoundRender_Source* S, u32 id, OggVorbis_File* ovf);	// make line available right now
+	void						flush		();													// cancel queue, close decoders
+
+	void						initialize	();
+	void						destroy		();
+
+	void						stats_clear	();
+
+	CSoundRender_Decoder		();
+	~CSoundRender_Decoder		();
+};
+#endif
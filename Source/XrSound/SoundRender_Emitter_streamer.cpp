@@ -52,11 +52,8 @@ void	CSoundRender_Emitter::fill_data(u8* _dest, u32 offset, u32 size)
 	while	(size)
 	{
 		// cache access
-		if (SoundRender->cache.request(source()->CAT,line))		
-		{
-			source()->decompress	(line,target->get_data());
-		}
-                                                
+		SoundRender->decoder.fetch	(source(),line,target->get_data());
+
 		// fill block
 		u32		blk_size	= _min(size,line_amount);
 		u8*		ptr			= (u8*)SoundRender->cache.get_dataptr(source()->CAT,line);
@@ -70,6 +67,14 @@ void	CSoundRender_Emitter::fill_data(u8* _dest, u32 offset, u32 size)
 		line_offs	=	0;
 		line_amount	=	line_size;
 	}
+
+	// decode ahead of the cursor, looped sounds wrap to the beginning
+	u32		lines_total						= source()->CAT.size;
+	for (int it=0; it<psSoundPrefetchLines; it++,line++)
+	{
+		if ((line>=lines_total) && (m_current_state!=stPlayingLooped))	break;
+		SoundRender->decoder.prefetch	(source(),line%lines_total);
+	}
 }
 
 void	CSoundRender_Emitter::fill_block	(void* ptr, u32 size)
@@ -35,6 +35,7 @@ public:
 	void					load					(LPCSTR name);
     void					unload					();
 	void					decompress				(u32 line, OggVorbis_File* ovf);
+	void					decompress				(u32 line, OggVorbis_File* ovf, void* dest);	// thread-safe, doesn't touch the cache
 	
 	virtual	float			length_sec				() const	{return fTimeTotal;}
 	virtual u32				game_type				() const	{return m_uGameType;}
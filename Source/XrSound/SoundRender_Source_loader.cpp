@@ -36,11 +36,16 @@ long ov_tell_func(void *datasource)
 }
 
 void CSoundRender_Source::decompress(u32 line, OggVorbis_File* ovf)
+{
+	decompress				(line,ovf,SoundRender->cache.get_dataptr(CAT,line));
+}
+
+void CSoundRender_Source::decompress(u32 line, OggVorbis_File* ovf, void* _dest)
 {
 	VERIFY	(ovf);
 	// decompression of one cache-line
 	u32		line_size		= SoundRender->cache.get_linesize();
-	char*	dest			= (char*)SoundRender->cache.get_dataptr	(CAT,line);
+	char*	dest			= (char*)_dest;
 	u32		buf_offs		= (line*line_size) / 2 / m_wformat.nChannels;
 	u32		left_file		= dwBytesTotal - buf_offs;
 	u32		left			= (u32)_min	(left_file,line_size);
@@ -275,6 +275,9 @@ extern void export_classes(lua_State *L);
 
 void CScriptEngine::init				()
 {
+	CTimer								timer;
+	timer.Start							();
+
 #ifdef USE_LUA_STUDIO
 	bool lua_studio_connected = !!m_lua_studio_world;
 	if (lua_studio_connected)
@@ -330,6 +333,8 @@ void CScriptEngine::init				()
 	load_common_scripts					();
 #endif
 	m_stack_level						= lua_gettop(lua());
+
+	Msg									("* script engine initialized in %.2f ms (bytecode cache : %d hits, %d misses)",timer.GetElapsed_sec()*1000.f,bytecode_cache_hits(),bytecode_cache_misses());
 }
 
 void CScriptEngine::remove_script_process	(const EScriptProcessors &process_id)
@@ -83,15 +83,6 @@ void CScriptProcess::update()
 		ai().script_engine().script_log	(ScriptStorage::eLuaMessageTypeInfo,"%s",g_ca_stdout);
 		fflush							(stderr);
 	}
-
-#if defined(DEBUG)
-	try {
-#pragma todo ("Dima cant find this function 'lua_setgcthreshold' ")
-		lua_gc				(ai().script_engine().lua(), LUA_GCSTEP, 0);
-	}
-	catch(...) {
-	}
-#endif
 }
 
 void CScriptProcess::add_script	(LPCSTR	script_name,bool do_string, bool reload)
@@ -10,8 +10,12 @@
 #include "script_storage.h"
 #include "script_thread.h"
 #include <stdarg.h>
+#include <wincrypt.h>
 #include "../xrCore/doug_lea_allocator.h"
 
+#pragma comment(lib, "advapi32.lib")
+#pragma comment(lib, "crypt32.lib")
+
 #ifndef DEBUG
 #	include "opt.lua.h"
 #	include "opt_inline.lua.h"
@@ -39,6 +43,114 @@ setfenv(1, this) \
 
 LPCSTR	file_header = 0;
 
+// compiled chunks are cached in the user data folder as LuaJIT bytecode,
+// one file per chunk name, validated against crc32 and size of the source
+// (the namespace header is a part of the source, so -_g switch invalidates it).
+// LuaJIT doesn't verify bytecode and the folder is writable by anybody running
+// as the user, so every file carries an HMAC-SHA256 of the chunk name, the source
+// crc/size and the bytecode, keyed with a random per-install key which is kept
+// DPAPI-protected: a file which wasn't written by this install is never loaded
+static LPCSTR const	bytecode_cache_path		= "$app_data_root$";
+static LPCSTR const	bytecode_cache_folder	= "scripts_cache\\";
+static LPCSTR const	bytecode_cache_key_file	= "scripts_cache\\cache.key";
+static u32 const	bytecode_cache_magic	= 0x434a4c58;	// "XLJC"
+static u32 const	bytecode_cache_version	= 2;
+static u32 const	bytecode_cache_key_size	= 32;
+static u32 const	bytecode_cache_mac_size	= 32;
+static u8			bytecode_cache_key		[bytecode_cache_key_size];
+
+static bool bytecode_cache_load_key		()
+{
+	IReader			*reader = FS.r_open(bytecode_cache_path, bytecode_cache_key_file);
+	if (reader) {
+		DATA_BLOB	in = { DWORD(reader->length()), (BYTE*)reader->pointer() };
+		DATA_BLOB	out = { 0, 0 };
+		bool const	result = CryptUnprotectData(&in, NULL, NULL, NULL, NULL, CRYPTPROTECT_UI_FORBIDDEN, &out) && (out.cbData == bytecode_cache_key_size);
+		if (result)
+			CopyMemory	(bytecode_cache_key, out.pbData, bytecode_cache_key_size);
+		if (out.pbData)
+			LocalFree	(out.pbData);
+		FS.r_close	(reader);
+		if (result)
+			return	(true);
+	}
+
+	// no key (or another user's one) - a new key, the files signed with the old one are recompiled
+	HCRYPTPROV		provider;
+	if (!CryptAcquireContext(&provider, NULL, NULL, PROV_RSA_AES, CRYPT_VERIFYCONTEXT))
+		return		(false);
+	bool const		generated = !!CryptGenRandom(provider, bytecode_cache_key_size, bytecode_cache_key);
+	CryptReleaseContext	(provider, 0);
+	if (!generated)
+		return		(false);
+
+	DATA_BLOB		in = { bytecode_cache_key_size, bytecode_cache_key };
+	DATA_BLOB		out = { 0, 0 };
+	if (!CryptProtectData(&in, NULL, NULL, NULL, NULL, CRYPTPROTECT_UI_FORBIDDEN, &out))
+		return		(false);
+
+	IWriter			*writer = FS.w_open(bytecode_cache_path, bytecode_cache_key_file);
+	if (writer) {
+		writer->w	(out.pbData, out.cbData);
+		FS.w_close	(writer);
+	}
+	LocalFree		(out.pbData);
+	return			(!!writer);
+}
+
+// HMAC-SHA256 of the parts: H(key^opad, H(key^ipad, parts))
+static bool bytecode_cache_mac			(void const* const* parts, u32 const* sizes, u32 const count, u8* mac)
+{
+	HCRYPTPROV		provider;
+	if (!CryptAcquireContext(&provider, NULL, NULL, PROV_RSA_AES, CRYPT_VERIFYCONTEXT))
+		return		(false);
+
+	u8				pad[64];
+	bool			result = true;
+	for (u32 pass = 0; result && (pass < 2); ++pass) {
+		for (u32 i = 0; i < sizeof(pad); ++i)
+			pad[i]	= u8((i < bytecode_cache_key_size ? bytecode_cache_key[i] : 0) ^ (pass ? 0x5c : 0x36));
+
+		HCRYPTHASH	hash;
+		if (!CryptCreateHash(provider, CALG_SHA_256, 0, 0, &hash)) {
+			result	= false;
+			break;
+		}
+		result		= !!CryptHashData(hash, pad, sizeof(pad), 0);
+		if (pass)
+			result	= result && CryptHashData(hash, mac, bytecode_cache_mac_size, 0);
+		else
+			for (u32 i = 0; result && (i < count); ++i)
+				result	= !!CryptHashData(hash, (BYTE const*)parts[i], sizes[i], 0);
+
+		DWORD		mac_size = bytecode_cache_mac_size;
+		result		= result && CryptGetHashParam(hash, HP_HASHVAL, mac, &mac_size, 0) && (mac_size == bytecode_cache_mac_size);
+		CryptDestroyHash	(hash);
+	}
+	CryptReleaseContext	(provider, 0);
+	return			(result);
+}
+
+static bool bytecode_cache_mac			(LPCSTR chunk_name, u32 const source_crc, u32 const source_size, void const* bytecode, u32 const bytecode_size, u8* mac)
+{
+	void const*		parts[] = { chunk_name, &source_crc, &source_size, bytecode };
+	u32 const		sizes[] = { xr_strlen(chunk_name), sizeof(source_crc), sizeof(source_size), bytecode_size };
+	return			(bytecode_cache_mac(parts, sizes, sizeof(sizes)/sizeof(sizes[0]), mac));
+}
+
+static void bytecode_cache_file_name	(LPSTR result, u32 const result_size, LPCSTR chunk_name)
+{
+	string32		crc;
+	xr_sprintf		(crc, "%08x", path_crc32(chunk_name, xr_strlen(chunk_name)));
+	strconcat		(result_size, result, bytecode_cache_folder, crc, ".luac");
+}
+
+static int bytecode_cache_writer		(lua_State *L, void const* buffer, size_t size, void* writer)
+{
+	static_cast<CMemoryWriter*>(writer)->w(buffer, u32(size));
+	return			(0);
+}
+
 #ifndef ENGINE_BUILD
 #	include "script_engine.h"
 #	include "ai_space.h"
@@ -245,6 +357,9 @@ CScriptStorage::CScriptStorage		()
 #endif // DEBUG
 	
 	m_virtual_machine		= 0;
+	m_use_bytecode_cache	= false;
+	m_bytecode_cache_hits	= 0;
+	m_bytecode_cache_misses	= 0;
 
 #ifdef USE_LUA_STUDIO
 #	ifndef USE_DEBUGGER
@@ -322,6 +437,26 @@ void CScriptStorage::reinit	()
 		file_header			= file_header_new;
 	else
 		file_header			= file_header_old;
+
+	m_bytecode_cache_hits	= 0;
+	m_bytecode_cache_misses	= 0;
+
+	bool use_bytecode_cache	= !strstr(Core.Params,"-no_script_cache") && FS.path_exist(bytecode_cache_path);
+#ifndef NO_XRGAME_SCRIPT_ENGINE
+	// a server always compiles the sources it runs
+	use_bytecode_cache		= use_bytecode_cache && !g_dedicated_server;
+#endif // #ifndef NO_XRGAME_SCRIPT_ENGINE
+	if (use_bytecode_cache && !m_use_bytecode_cache) {
+		// the user data root is not scanned recursively, so register the files cached by the previous runs
+		string_path			folder;
+		FS.update_path		(folder, bytecode_cache_path, bytecode_cache_folder);
+		VerifyPath			(folder);
+		FS.rescan_path		(folder, FALSE);
+
+		// nothing can be verified without the key
+		use_bytecode_cache	= bytecode_cache_load_key();
+	}
+	m_use_bytecode_cache	= use_bytecode_cache;
 }
 
 int CScriptStorage::vscript_log		(ScriptStorage::ELuaMessageType tLuaMessageType, LPCSTR caFormat, va_list marker)
@@ -486,6 +621,73 @@ bool CScriptStorage::parse_namespace(LPCSTR caNamespaceName, LPSTR b, u32 const
 	return			(true);
 }
 
+int CScriptStorage::load_chunk		(lua_State *L, LPCSTR caBuffer, size_t tSize, LPCSTR caScriptName)
+{
+	if (!m_use_bytecode_cache || (*caScriptName != '@'))
+		return			(luaL_loadbuffer(L,caBuffer,tSize,caScriptName));
+
+	string_path			file_name;
+	bytecode_cache_file_name(file_name, sizeof(file_name), caScriptName);
+
+	u32 const			source_crc = crc32(caBuffer, u32(tSize));
+	u32 const			source_size = u32(tSize);
+
+	IReader				*reader = FS.r_open(bytecode_cache_path, file_name);
+	if (reader) {
+		bool			valid = (reader->length() > int(4*sizeof(u32) + bytecode_cache_mac_size));
+		valid			= valid && (reader->r_u32() == bytecode_cache_magic);
+		valid			= valid && (reader->r_u32() == bytecode_cache_version);
+		valid			= valid && (reader->r_u32() == source_crc);
+		valid			= valid && (reader->r_u32() == source_size);
+		if (valid) {
+			u8			stored[bytecode_cache_mac_size], expected[bytecode_cache_mac_size];
+			reader->r	(stored, bytecode_cache_mac_size);
+			valid		= bytecode_cache_mac(caScriptName, source_crc, source_size, reader->pointer(), u32(reader->elapsed()), expected);
+			valid		= valid && !memcmp(stored, expected, bytecode_cache_mac_size);
+		}
+		if (valid) {
+			int			error_code = luaL_loadbuffer(L,(LPCSTR)reader->pointer(),reader->elapsed(),caScriptName);
+			FS.r_close	(reader);
+			if (!error_code) {
+				++m_bytecode_cache_hits;
+				return	(0);
+			}
+
+			// stale or broken bytecode, fall back to the source
+			lua_pop		(L,1);
+		}
+		else
+			FS.r_close	(reader);
+	}
+
+	++m_bytecode_cache_misses;
+
+	int					error_code = luaL_loadbuffer(L,caBuffer,tSize,caScriptName);
+	if (error_code)
+		return			(error_code);
+
+	CMemoryWriter		bytecode;
+	if (lua_dump(L, bytecode_cache_writer, &bytecode) || !bytecode.size())
+		return			(0);
+
+	u8					mac[bytecode_cache_mac_size];
+	if (!bytecode_cache_mac(caScriptName, source_crc, source_size, bytecode.pointer(), bytecode.size(), mac))
+		return			(0);
+
+	IWriter				*writer = FS.w_open(bytecode_cache_path, file_name);
+	if (!writer)
+		return			(0);
+
+	writer->w_u32		(bytecode_cache_magic);
+	writer->w_u32		(bytecode_cache_version);
+	writer->w_u32		(source_crc);
+	writer->w_u32		(source_size);
+	writer->w			(mac, bytecode_cache_mac_size);
+	writer->w			(bytecode.pointer(), bytecode.size());
+	FS.w_close			(writer);
+	return				(0);
+}
+
 bool CScriptStorage::load_buffer	(lua_State *L, LPCSTR caBuffer, size_t tSize, LPCSTR caScriptName, LPCSTR caNameSpaceName)
 {
 	int					l_iErrorCode;
@@ -530,7 +732,7 @@ bool CScriptStorage::load_buffer	(lua_State *L, LPCSTR caBuffer, size_t tSize, L
 		xr_strcpy		(script, total_size, insert);
 		CopyMemory		(script + str_len,caBuffer,u32(tSize));
 
-		l_iErrorCode	= luaL_loadbuffer(L,script,tSize + str_len,caScriptName);
+		l_iErrorCode	= load_chunk(L,script,tSize + str_len,caScriptName);
 
 		if ( dynamic_allocation )
 			xr_free		(script);
@@ -538,7 +740,7 @@ bool CScriptStorage::load_buffer	(lua_State *L, LPCSTR caBuffer, size_t tSize, L
 	else {
 //		try
 		{
-			l_iErrorCode= luaL_loadbuffer(L,caBuffer,tSize,caScriptName);
+			l_iErrorCode= load_chunk(L,caBuffer,tSize,caScriptName);
 		}
 //		catch(...) {
 //			l_iErrorCode= LUA_ERRSYNTAX;
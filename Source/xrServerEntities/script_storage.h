@@ -30,6 +30,9 @@ private:
 	lua_State					*m_virtual_machine	;
 	CScriptThread				*m_current_thread	;
 	BOOL						m_jit				;
+	bool						m_use_bytecode_cache;
+	u32							m_bytecode_cache_hits;
+	u32							m_bytecode_cache_misses;
 
 #ifdef DEBUG
 public:
@@ -45,6 +48,7 @@ protected:
 	static	int					vscript_log					(ScriptStorage::ELuaMessageType tLuaMessageType, LPCSTR caFormat, va_list marker);
 			bool				parse_namespace				(LPCSTR caNamespaceName, LPSTR b, u32 const b_size, LPSTR c, u32 const c_size);
 			bool				do_file						(LPCSTR	caScriptName, LPCSTR caNameSpaceName);
+			int					load_chunk					(lua_State *L, LPCSTR caBuffer, size_t tSize, LPCSTR caScriptName);
 			void				reinit						();
 
 public:
@@ -58,6 +62,8 @@ public:
 	IC		lua_State			*lua						();
 	IC		void				current_thread				(CScriptThread *thread);
 	IC		CScriptThread		*current_thread				() const;
+	IC		u32					bytecode_cache_hits			() const;
+	IC		u32					bytecode_cache_misses		() const;
 			bool				load_buffer					(lua_State *L, LPCSTR caBuffer, size_t tSize, LPCSTR caScriptName, LPCSTR caNameSpaceName = 0);
 			bool				load_file_into_namespace	(LPCSTR	caScriptName, LPCSTR caNamespaceName);
 			bool				namespace_loaded			(LPCSTR	caName, bool remove_from_stack = true);
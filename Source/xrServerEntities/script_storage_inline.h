@@ -23,3 +23,13 @@ IC	CScriptThread *CScriptStorage::current_thread	() const
 {
 	return					(m_current_thread);
 }
+
+IC	u32 CScriptStorage::bytecode_cache_hits			() const
+{
+	return					(m_bytecode_cache_hits);
+}
+
+IC	u32 CScriptStorage::bytecode_cache_misses		() const
+{
+	return					(m_bytecode_cache_misses);
+}
\ No newline at end of file